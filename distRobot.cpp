@@ -0,0 +1,313 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/svm_threaded.h>
+#include <dlib/image_processing.h>
+#include <dlib/data_io.h>
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "robotDataset.h"
+
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Trains the learnRobot detector with the training images sharded across several worker
+// processes on this machine.  Worker k loads only the images i with i%num_workers == k,
+// extracts their fHOG pyramids and serves the separation oracle for them through a
+// svm_struct_processing_node on port first_port+k.  The controller (this process) runs
+// the OCA solver through a svm_struct_controller_node that talks to the workers over
+// loopback TCP.  So no process ever holds the features of the whole training set, and the
+// workers can be pinned to different NUMA nodes (e.g. run this under numactl
+// --interleave or start each worker with its own policy).
+//
+// The controller and the workers talk over a unix pipe before the training starts: every
+// worker reports the overlap tester that fits the truth boxes of its shard, and the
+// controller sends back the one that fits all of them, which is what a single process
+// trainer would have found.
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+
+struct worker_process
+{
+    pid_t pid;
+    int to_worker;
+    int from_worker;
+};
+
+// ----------------------------------------------------------------------------------------
+
+static bool write_all (int fd, const void* data, size_t size)
+{
+    const char* buf = static_cast<const char*>(data);
+    while (size != 0)
+    {
+        const ssize_t n = write(fd, buf, size);
+        if (n <= 0)
+            return false;
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool read_all (int fd, void* data, size_t size)
+{
+    char* buf = static_cast<char*>(data);
+    while (size != 0)
+    {
+        const ssize_t n = read(fd, buf, size);
+        if (n <= 0)
+            return false;
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void configure_trainer (
+    structural_object_detection_trainer<image_scanner_type>& trainer
+)
+{
+    // The best config found by searchRobot, see learnRobot.cpp.
+    trainer.set_c(29.8787);
+    trainer.set_epsilon(0.058);
+    trainer.set_match_eps(0.00738);
+    trainer.set_add_left_right_flips(true);
+}
+
+static void configure_scanner (
+    image_scanner_type& scanner
+)
+{
+    scanner.set_detection_window_size(40, 60);
+}
+
+// ----------------------------------------------------------------------------------------
+
+static int run_worker (
+    const std::string& training_file,
+    unsigned long shard,
+    unsigned long num_shards,
+    unsigned short port,
+    unsigned long num_threads,
+    int from_controller,
+    int to_controller
+)
+{
+    // status, iou threshold, percent covered threshold
+    double report[3] = {0, 0, 0};
+    try
+    {
+        dlib::array<array2d<unsigned char> > images;
+        std::vector<std::vector<rectangle> > robot_boxes;
+        load_image_dataset_shard(images, robot_boxes, training_file, shard, num_shards);
+        upsample_image_dataset_if_small<pyramid_down<2> >(images, robot_boxes);
+
+        std::vector<std::vector<full_object_detection> > truth(robot_boxes.size());
+        for (unsigned long i = 0; i < robot_boxes.size(); ++i)
+            for (unsigned long j = 0; j < robot_boxes[i].size(); ++j)
+                truth[i].push_back(full_object_detection(robot_boxes[i][j]));
+        const std::vector<std::vector<rectangle> > no_ignore(images.size());
+
+        image_scanner_type scanner;
+        configure_scanner(scanner);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        configure_trainer(trainer);
+
+        // Set up the problem the way the trainer would.  The C, epsilon and nuclear
+        // norm settings are the controller's business.
+        structural_svm_object_detection_problem<image_scanner_type, dlib::array<array2d<unsigned char> > >
+            problem(trainer.get_scanner(), test_box_overlap(), true, images, truth, no_ignore,
+                test_box_overlap(), num_threads, trainer.get_add_left_right_flips());
+        problem.set_max_cache_size(trainer.get_max_cache_size());
+        problem.set_match_eps(trainer.get_match_eps());
+        problem.set_loss_per_missed_target(trainer.get_loss_per_missed_target());
+        problem.set_loss_per_false_alarm(trainer.get_loss_per_false_alarm());
+
+        report[0] = 1;
+        report[1] = problem.get_overlap_tester().get_iou_thresh();
+        report[2] = problem.get_overlap_tester().get_percent_covered_thresh();
+        if (!write_all(to_controller, report, sizeof(report)))
+            return 1;
+
+        double tester[2];
+        if (!read_all(from_controller, tester, sizeof(tester)))
+            return 1;
+        problem.set_overlap_tester(test_box_overlap(tester[0], tester[1]));
+
+        svm_struct_processing_node node(problem, port, num_threads);
+        const char ready = 1;
+        if (!write_all(to_controller, &ready, 1))
+            return 1;
+
+        // Serve until the controller closes its end of the pipe.
+        char c;
+        while (read(from_controller, &c, 1) > 0) {}
+        return 0;
+    }
+    catch (exception& e)
+    {
+        cout << "\nworker " << shard << ": exception thrown!" << endl;
+        cout << e.what() << endl;
+        if (report[0] == 0)
+            write_all(to_controller, report, sizeof(report));
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    if (argc != 4 && argc != 5)
+    {
+        cout << "Please use :   ./prog dir_training dir_testing num_workers [first_port]" << endl;
+        cout << endl;
+        cout << "Worker k listens on 127.0.0.1:first_port+k (first_port defaults to 12345)." << endl;
+        return 0;
+    }
+    const std::string robots_directory_training = argv[1];
+    const std::string robots_directory_testing = argv[2];
+    const std::string training_file = robots_directory_training+"/training.xml";
+    unsigned long num_workers = std::max(1l, atol(argv[3]));
+    const unsigned short first_port = argc == 5 ? atoi(argv[4]) : 12345;
+
+    // A worker that died shows up as a failed read or write rather than a SIGPIPE.
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<worker_process> workers;
+    try
+    {
+        image_dataset_metadata::dataset data;
+        image_dataset_metadata::load_image_dataset_metadata(data, training_file);
+        num_workers = std::min<unsigned long>(num_workers, data.images.size());
+        const unsigned long num_cores = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned long worker_threads = std::max<unsigned long>(1, num_cores/num_workers);
+        cout << "num training images: " << data.images.size() << " (x2 with flips)" << endl;
+        cout << "num workers:         " << num_workers << " with " << worker_threads << " oracle threads each" << endl;
+
+        // Start the workers before this process makes any threads.
+        for (unsigned long k = 0; k < num_workers; ++k)
+        {
+            int down[2], up[2];
+            if (::pipe(down) != 0 || ::pipe(up) != 0)
+                throw error("Unable to create the pipes to the worker processes.");
+
+            const pid_t pid = fork();
+            if (pid < 0)
+                throw error("Unable to start the worker processes.");
+            if (pid == 0)
+            {
+                for (unsigned long i = 0; i < workers.size(); ++i)
+                {
+                    close(workers[i].to_worker);
+                    close(workers[i].from_worker);
+                }
+                close(down[1]);
+                close(up[0]);
+                _exit(run_worker(training_file, k, num_workers, first_port+k, worker_threads, down[0], up[1]));
+            }
+            close(down[0]);
+            close(up[1]);
+            worker_process w = {pid, down[1], up[0]};
+            workers.push_back(w);
+        }
+
+        // The tightest overlap tester that fits every shard.
+        auto train_t0 = std::chrono::high_resolution_clock::now();
+        double tester[2] = {0, 0};
+        for (unsigned long k = 0; k < workers.size(); ++k)
+        {
+            double report[3];
+            if (!read_all(workers[k].from_worker, report, sizeof(report)) || report[0] == 0)
+                throw error("Worker " + cast_to_string(k) + " failed to load its shard.");
+            tester[0] = std::max(tester[0], report[1]);
+            tester[1] = std::max(tester[1], report[2]);
+        }
+        for (unsigned long k = 0; k < workers.size(); ++k)
+        {
+            char ready;
+            if (!write_all(workers[k].to_worker, tester, sizeof(tester)) ||
+                !read_all(workers[k].from_worker, &ready, 1))
+                throw error("Worker " + cast_to_string(k) + " failed to start its processing node.");
+        }
+        auto train_t1 = std::chrono::high_resolution_clock::now();
+
+
+        // **************** Training. ********************
+        image_scanner_type scanner;
+        configure_scanner(scanner);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        configure_trainer(trainer);
+        trainer.be_verbose();
+
+        svm_struct_controller_node controller;
+        controller.set_c(trainer.get_c());
+        controller.set_epsilon(trainer.get_epsilon());
+        controller.be_verbose();
+        configure_nuclear_norm_regularizer(trainer.get_scanner(), controller);
+        for (unsigned long k = 0; k < workers.size(); ++k)
+            controller.add_processing_node("127.0.0.1", first_port+k);
+
+        matrix<double,0,1> w;
+        controller(trainer.get_oca(), w);
+        auto train_t2 = std::chrono::high_resolution_clock::now();
+
+        object_detector<image_scanner_type> detector(trainer.get_scanner(),
+            test_box_overlap(tester[0], tester[1]), w);
+
+        // Closing the pipes tells the workers to exit.
+        for (unsigned long k = 0; k < workers.size(); ++k)
+        {
+            close(workers[k].to_worker);
+            close(workers[k].from_worker);
+            waitpid(workers[k].pid, 0, 0);
+        }
+        workers.clear();
+
+        cout << "shard loading: " << 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(train_t1-train_t0).count()
+             << "s, optimization: " << 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(train_t2-train_t1).count()
+             << "s" << endl;
+
+
+        // **************** Testing. ********************
+        dlib::array<array2d<unsigned char> > images_test;
+        std::vector<std::vector<rectangle> > robot_boxes_test;
+        load_robot_dataset(images_test, robot_boxes_test, robots_directory_testing+"/testing.xml",
+            "robot_testing.cache", std::max(1u, std::thread::hardware_concurrency()));
+        cout << "num testing images:  " << images_test.size() << endl;
+
+        cout << "testing results (precision, recall, average precision):  " << test_object_detection_function(detector, images_test, robot_boxes_test) << endl;
+
+        serialize("robot_detector.svm") << detector;
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+        for (unsigned long k = 0; k < workers.size(); ++k)
+        {
+            close(workers[k].to_worker);
+            close(workers[k].from_worker);
+            waitpid(workers[k].pid, 0, 0);
+        }
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,264 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_IMAGE_DATASET_CACHE_Hh_
+#define DLIB_IMAGE_DATASET_CACHE_Hh_
+
+#include "image_dataset_cache_abstract.h"
+#include "../mapped_file/mapped_file.h"
+#include "../misc_api/temporary_file_name.h"
+#include "../image_processing/generic_image.h"
+#include "../geometry.h"
+#include "../serialize.h"
+#include "../uintn.h"
+#include "../dir_nav.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        /*
+            File layout of a version 1 image dataset cache.  Everything is stored in the
+            native byte order of the machine that wrote it (checked via endian_check) and
+            every offset is in bytes from the start of the file.  The pixels of every
+            image start on an image_cache_alignment boundary, i.e. on a page.
+
+                image_cache_header
+                the key, key_size bytes
+                the boxes, as written by serialize(object_locations) then serialize(ignore)
+                image_cache_entry[num_images]
+                for each image: nr rows of nc pixels, with no padding between the rows
+        */
+
+        const static uint32 image_cache_alignment = 4096;
+        const static uint32 image_cache_version = 1;
+        const static uint32 image_cache_endian_check = 0x01020304;
+
+        struct image_cache_header
+        {
+            char magic[8];
+            uint32 endian_check;
+            uint32 version;
+            uint64 file_size;
+            uint32 alignment;
+            uint32 reserved;
+            uint64 num_images;
+            uint64 key_offset;
+            uint64 key_size;
+            uint64 boxes_offset;
+            uint64 boxes_size;
+            uint64 entries_offset;
+        };
+
+        struct image_cache_entry
+        {
+            uint64 nr;
+            uint64 nc;
+            uint64 pixels_offset;
+        };
+
+        inline uint64 image_cache_align (
+            uint64 offset
+        )
+        {
+            return (offset + image_cache_alignment-1)/image_cache_alignment*image_cache_alignment;
+        }
+
+        inline void image_cache_check_range (
+            uint64 offset,
+            uint64 size,
+            uint64 file_size,
+            const std::string& filename
+        )
+        {
+            if (offset > file_size || size > file_size - offset)
+                throw serialization_error("The image dataset cache " + filename + " is corrupt.");
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    void save_image_dataset_cache (
+        const array_type& images,
+        const std::vector<std::vector<rectangle> >& object_locations,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const std::string& filename,
+        const std::string& key
+    )
+    {
+        using namespace impl;
+        typedef typename image_traits<typename array_type::value_type>::pixel_type pixel_type;
+        COMPILE_TIME_ASSERT(sizeof(pixel_type) == 1 && pixel_traits<pixel_type>::grayscale);
+
+        // make sure requires clause is not broken
+        DLIB_ASSERT(images.size() == object_locations.size() && images.size() == ignore.size(),
+            "\t void save_image_dataset_cache()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t images.size():           " << images.size()
+            << "\n\t object_locations.size(): " << object_locations.size()
+            << "\n\t ignore.size():           " << ignore.size()
+            );
+
+        image_cache_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "DLIBIMGC", 8);
+        header.endian_check = image_cache_endian_check;
+        header.version = image_cache_version;
+        header.alignment = image_cache_alignment;
+        header.num_images = images.size();
+
+        std::ostringstream sout;
+        serialize(object_locations, sout);
+        serialize(ignore, sout);
+        const std::string boxes = sout.str();
+
+        header.key_offset = sizeof(header);
+        header.key_size = key.size();
+        header.boxes_offset = header.key_offset + header.key_size;
+        header.boxes_size = boxes.size();
+        header.entries_offset = header.boxes_offset + header.boxes_size;
+
+        std::vector<image_cache_entry> entries(images.size());
+        uint64 offset = image_cache_align(header.entries_offset + entries.size()*sizeof(image_cache_entry));
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            const_image_view<typename array_type::value_type> img(images[i]);
+            entries[i].nr = img.nr();
+            entries[i].nc = img.nc();
+            entries[i].pixels_offset = offset;
+            offset = image_cache_align(offset + entries[i].nr*entries[i].nc);
+        }
+        header.file_size = offset;
+
+        // Write to a temporary file and rename it so that other processes never see a
+        // partially written cache.  The temporary name is unique to this process and
+        // thread, so processes saving the same cache at once don't write into each
+        // other's file.
+        const std::string temp_filename = unique_temporary_file_name(filename);
+        {
+            std::ofstream fout(temp_filename.c_str(), std::ios::binary);
+            if (!fout)
+                throw serialization_error("Unable to open " + temp_filename + " for writing.");
+
+            std::vector<char> buf(image_cache_align(header.entries_offset + entries.size()*sizeof(image_cache_entry)), 0);
+            std::memcpy(&buf[0], &header, sizeof(header));
+            if (key.size() != 0)
+                std::memcpy(&buf[header.key_offset], key.data(), key.size());
+            if (boxes.size() != 0)
+                std::memcpy(&buf[header.boxes_offset], boxes.data(), boxes.size());
+            if (entries.size() != 0)
+                std::memcpy(&buf[header.entries_offset], &entries[0], entries.size()*sizeof(image_cache_entry));
+            fout.write(&buf[0], buf.size());
+
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                const_image_view<typename array_type::value_type> img(images[i]);
+                for (long r = 0; r < img.nr(); ++r)
+                    fout.write(reinterpret_cast<const char*>(&img[r][0]), img.nc());
+                const uint64 padding = image_cache_align(entries[i].nr*entries[i].nc) - entries[i].nr*entries[i].nc;
+                buf.assign(padding, 0);
+                if (padding != 0)
+                    fout.write(&buf[0], padding);
+            }
+
+            if (!fout)
+                throw serialization_error("Error writing image dataset cache to " + temp_filename + ".");
+        }
+        if (std::rename(temp_filename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temp_filename.c_str());
+            throw serialization_error("Unable to rename " + temp_filename + " to " + filename + ".");
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    bool load_image_dataset_cache (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        std::vector<std::vector<rectangle> >& ignore,
+        const std::string& filename,
+        const std::string& key
+    )
+    {
+        using namespace impl;
+        typedef typename image_traits<typename array_type::value_type>::pixel_type pixel_type;
+        COMPILE_TIME_ASSERT(sizeof(pixel_type) == 1 && pixel_traits<pixel_type>::grayscale);
+
+        if (!file_exists(filename))
+            return false;
+
+        mapped_file mf(filename);
+        const char* base = mf.data();
+        const uint64 size = mf.size();
+
+        image_cache_header header;
+        if (size < sizeof(header))
+            throw serialization_error("File " + filename + " is too small to be an image dataset cache.");
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, "DLIBIMGC", 8) != 0)
+            throw serialization_error("File " + filename + " is not an image dataset cache.");
+        if (header.endian_check != image_cache_endian_check)
+            throw serialization_error("The image dataset cache " + filename + " was written on a machine with a different byte order.");
+        if (header.version != image_cache_version)
+            throw serialization_error("Unsupported version found when loading the image dataset cache " + filename + ".");
+        if (header.file_size != size || header.alignment != image_cache_alignment)
+            throw serialization_error("The image dataset cache " + filename + " is corrupt.");
+
+        image_cache_check_range(header.key_offset, header.key_size, size, filename);
+        if (std::string(base + header.key_offset, header.key_size) != key)
+            return false;
+
+        image_cache_check_range(header.boxes_offset, header.boxes_size, size, filename);
+        std::vector<std::vector<rectangle> > temp_object_locations, temp_ignore;
+        std::istringstream sin(std::string(base + header.boxes_offset, header.boxes_size));
+        deserialize(temp_object_locations, sin);
+        deserialize(temp_ignore, sin);
+        if (temp_object_locations.size() != header.num_images || temp_ignore.size() != header.num_images)
+            throw serialization_error("The image dataset cache " + filename + " is corrupt.");
+
+        image_cache_check_range(header.entries_offset, header.num_images*sizeof(image_cache_entry), size, filename);
+        images.resize(header.num_images);
+        for (unsigned long i = 0; i < header.num_images; ++i)
+        {
+            image_cache_entry entry;
+            std::memcpy(&entry, base + header.entries_offset + i*sizeof(entry), sizeof(entry));
+            if (entry.nc != 0 && entry.nr > size/entry.nc)
+                throw serialization_error("The image dataset cache " + filename + " is corrupt.");
+            image_cache_check_range(entry.pixels_offset, entry.nr*entry.nc, size, filename);
+
+            image_view<typename array_type::value_type> img(images[i]);
+            img.set_size(entry.nr, entry.nc);
+            const char* pixels = base + entry.pixels_offset;
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                if (img.nc() != 0)
+                    std::memcpy(&img[r][0], pixels, img.nc());
+                pixels += img.nc();
+            }
+        }
+
+        temp_object_locations.swap(object_locations);
+        temp_ignore.swap(ignore);
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_IMAGE_DATASET_CACHE_Hh_
+
@@ -0,0 +1,85 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+#ifdef DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+
+#include "../geometry.h"
+#include <vector>
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    void save_image_dataset_cache (
+        const array_type& images,
+        const std::vector<std::vector<rectangle> >& object_locations,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const std::string& filename,
+        const std::string& key
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.  The pixels must be 8 bit grayscale
+              (e.g. unsigned char).
+            - images.size() == object_locations.size() == ignore.size()
+        ensures
+            - Writes images, object_locations and ignore to filename as an image dataset
+              cache, i.e. already decoded pixels that load_image_dataset_cache() reads back
+              much faster than load_image_dataset() can decode the original files.  Every
+              image starts on its own 4096 byte page of the file.
+            - key is stored along with the data.  Use it to identify where the data came
+              from and how it was preprocessed so that a stale cache is never used.
+            - The file is written under a temporary name unique to the calling process
+              and thread (see unique_temporary_file_name()) and then renamed to filename,
+              so other processes never see a partially written cache and several
+              processes can save the same cache at once.
+        throws
+            - serialization_error if the file can't be written.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename array_type
+        >
+    bool load_image_dataset_cache (
+        array_type& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        std::vector<std::vector<rectangle> >& ignore,
+        const std::string& filename,
+        const std::string& key
+    );
+    /*!
+        requires
+            - array_type == An array of images.  This is anything with an interface that
+              looks like std::vector<some generic image type> where a "generic image" is
+              anything that implements the generic image interface defined in
+              dlib/image_processing/generic_image.h.  The pixels must be 8 bit grayscale
+              (e.g. unsigned char).
+        ensures
+            - if (filename is an image dataset cache written by save_image_dataset_cache()
+              with the given key) then
+                - #images, #object_locations and #ignore are the images and boxes that were
+                  given to save_image_dataset_cache().
+                - returns true
+            - else if (filename doesn't exist or was saved with a different key) then
+                - returns false and leaves images, object_locations and ignore unmodified.
+            - The file is memory mapped (see mapped_file), so several processes loading the
+              same cache share its pages in the OS page cache.
+        throws
+            - serialization_error if the file exists but isn't a valid image dataset cache.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_IMAGE_DATASET_CACHE_ABSTRACT_Hh_
+
@@ -17,6 +17,7 @@
 #include <utility>
 #include <limits>
 #include "../image_transforms/image_pyramid.h"
+#include "../threads.h"
 
 
 namespace dlib
@@ -33,6 +34,7 @@ namespace dlib
             _have_parts = false;
             _filename = filename;
             _box_area_thresh = std::numeric_limits<double>::infinity();
+            _num_threads = 1;
         }
 
         image_dataset_file boxes_match_label(
@@ -69,6 +71,15 @@ namespace dlib
             return temp;
         }
 
+        image_dataset_file use_threads(
+            unsigned long num_threads
+        ) const
+        {
+            image_dataset_file temp(*this);
+            temp._num_threads = num_threads;
+            return temp;
+        }
+
         bool should_load_box (
             const image_dataset_metadata::box& box
         ) const
@@ -86,6 +97,7 @@ namespace dlib
         bool should_skip_empty_images() const { return _skip_empty_images; }
         bool should_boxes_have_parts() const { return _have_parts; }
         double box_area_thresh() const { return _box_area_thresh; }
+        unsigned long get_num_threads() const { return _num_threads; }
         const std::set<std::string>& get_selected_box_labels() const { return _labels; }
 
     private:
@@ -94,9 +106,34 @@ namespace dlib
         bool _skip_empty_images;
         bool _have_parts;
         double _box_area_thresh;
+        unsigned long _num_threads;
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename T>
+        void for_each_dataset_image (
+            unsigned long num_threads,
+            unsigned long num,
+            const T& funct
+        )
+        {
+            // Decoding dominates loading a dataset and each image decodes independently.
+            if (num_threads > 1)
+            {
+                parallel_for(num_threads, 0, num, funct);
+            }
+            else
+            {
+                for (unsigned long i = 0; i < num; ++i)
+                    funct(i);
+            }
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -123,10 +160,8 @@ namespace dlib
         locally_change_current_dir chdir(get_parent_directory(file(source.get_filename())));
 
 
-        typedef typename array_type::value_type image_type;
-
-
-        image_type img;
+        std::vector<unsigned long> to_load;
+        std::vector<double> min_rect_sizes;
         std::vector<rectangle> rects, ignored;
         for (unsigned long i = 0; i < data.images.size(); ++i)
         {
@@ -151,38 +186,45 @@ namespace dlib
 
             if (!source.should_skip_empty_images() || rects.size() != 0)
             {
-                load_image(img, data.images[i].filename);
-                if (rects.size() != 0)  
-                {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
-                    {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : rects)
-                            r = pyr.rect_down(r);
-                        for (auto&& r : ignored)
-                            r = pyr.rect_down(r);
-                    }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
-                    {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : rects)
-                            r = pyr.rect_down(r);
-                        for (auto&& r : ignored)
-                            r = pyr.rect_down(r);
-                    }
-                }
-                images.push_back(img);
+                to_load.push_back(i);
+                min_rect_sizes.push_back(min_rect_size);
                 object_locations.push_back(rects);
                 ignored_rects.push_back(ignored);
             }
         }
 
+        images.resize(to_load.size());
+        impl::for_each_dataset_image(source.get_num_threads(), to_load.size(), [&](long k)
+        {
+            load_image(images[k], data.images[to_load[k]].filename);
+            if (object_locations[k].size() != 0)  
+            {
+                double min_rect_size = min_rect_sizes[k];
+                // if shrinking the image would still result in the smallest box being
+                // bigger than the box area threshold then shrink the image.
+                while(min_rect_size/2/2 > source.box_area_thresh())
+                {
+                    pyramid_down<2> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (1.0/2.0)*(1.0/2.0);
+                    for (auto&& r : object_locations[k])
+                        r = pyr.rect_down(r);
+                    for (auto&& r : ignored_rects[k])
+                        r = pyr.rect_down(r);
+                }
+                while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
+                {
+                    pyramid_down<3> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (2.0/3.0)*(2.0/3.0);
+                    for (auto&& r : object_locations[k])
+                        r = pyr.rect_down(r);
+                    for (auto&& r : ignored_rects[k])
+                        r = pyr.rect_down(r);
+                }
+            }
+        });
+
         return ignored_rects;
     }
 
@@ -209,9 +251,8 @@ namespace dlib
         // file paths which are relative to this folder.
         locally_change_current_dir chdir(get_parent_directory(file(source.get_filename())));
 
-        typedef typename array_type::value_type image_type;
-
-        image_type img;
+        std::vector<unsigned long> to_load;
+        std::vector<double> min_rect_sizes;
         std::vector<mmod_rect> rects;
         for (unsigned long i = 0; i < data.images.size(); ++i)
         {
@@ -236,32 +277,39 @@ namespace dlib
 
             if (!source.should_skip_empty_images() || rects.size() != 0)
             {
-                load_image(img, data.images[i].filename);
-                if (rects.size() != 0)  
+                to_load.push_back(i);
+                min_rect_sizes.push_back(min_rect_size);
+                object_locations.push_back(rects);
+            }
+        }
+
+        images.resize(to_load.size());
+        impl::for_each_dataset_image(source.get_num_threads(), to_load.size(), [&](long k)
+        {
+            load_image(images[k], data.images[to_load[k]].filename);
+            if (object_locations[k].size() != 0)  
+            {
+                double min_rect_size = min_rect_sizes[k];
+                // if shrinking the image would still result in the smallest box being
+                // bigger than the box area threshold then shrink the image.
+                while(min_rect_size/2/2 > source.box_area_thresh())
                 {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
-                    {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : rects)
-                            r.rect = pyr.rect_down(r.rect);
-                    }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
-                    {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : rects)
-                            r.rect = pyr.rect_down(r.rect);
-                    }
+                    pyramid_down<2> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (1.0/2.0)*(1.0/2.0);
+                    for (auto&& r : object_locations[k])
+                        r.rect = pyr.rect_down(r.rect);
+                }
+                while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
+                {
+                    pyramid_down<3> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (2.0/3.0)*(2.0/3.0);
+                    for (auto&& r : object_locations[k])
+                        r.rect = pyr.rect_down(r.rect);
                 }
-                images.push_back(std::move(img));
-                object_locations.push_back(std::move(rects));
             }
-        }
+        });
     }
 
 // ----------------------------------------------------------------------------------------
@@ -329,7 +377,6 @@ namespace dlib
         std::vector<std::string>& parts_list
     )
     {
-        typedef typename array_type::value_type image_type;
         parts_list.clear();
         images.clear();
         object_locations.clear();
@@ -373,8 +420,9 @@ namespace dlib
         }
 
         std::vector<std::vector<rectangle> > ignored_rects;
+        std::vector<unsigned long> to_load;
+        std::vector<double> min_rect_sizes;
         std::vector<rectangle> ignored;
-        image_type img;
         std::vector<full_object_detection> object_dets;
         for (unsigned long i = 0; i < data.images.size(); ++i)
         {
@@ -409,49 +457,56 @@ namespace dlib
 
             if (!source.should_skip_empty_images() || object_dets.size() != 0)
             {
-                load_image(img, data.images[i].filename);
-                if (object_dets.size() != 0)  
+                to_load.push_back(i);
+                min_rect_sizes.push_back(min_rect_size);
+                object_locations.push_back(object_dets);
+                ignored_rects.push_back(ignored);
+            }
+        }
+
+        images.resize(to_load.size());
+        impl::for_each_dataset_image(source.get_num_threads(), to_load.size(), [&](long k)
+        {
+            load_image(images[k], data.images[to_load[k]].filename);
+            if (object_locations[k].size() != 0)  
+            {
+                double min_rect_size = min_rect_sizes[k];
+                // if shrinking the image would still result in the smallest box being
+                // bigger than the box area threshold then shrink the image.
+                while(min_rect_size/2/2 > source.box_area_thresh())
                 {
-                    // if shrinking the image would still result in the smallest box being
-                    // bigger than the box area threshold then shrink the image.
-                    while(min_rect_size/2/2 > source.box_area_thresh())
+                    pyramid_down<2> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (1.0/2.0)*(1.0/2.0);
+                    for (auto&& r : object_locations[k])
                     {
-                        pyramid_down<2> pyr;
-                        pyr(img);
-                        min_rect_size *= (1.0/2.0)*(1.0/2.0);
-                        for (auto&& r : object_dets)
-                        {
-                            r.get_rect() = pyr.rect_down(r.get_rect());
-                            for (unsigned long k = 0; k < r.num_parts(); ++k)
-                                r.part(k) = pyr.point_down(r.part(k));
-                        }
-                        for (auto&& r : ignored)
-                        {
-                            r = pyr.rect_down(r);
-                        }
+                        r.get_rect() = pyr.rect_down(r.get_rect());
+                        for (unsigned long p = 0; p < r.num_parts(); ++p)
+                            r.part(p) = pyr.point_down(r.part(p));
                     }
-                    while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
+                    for (auto&& r : ignored_rects[k])
                     {
-                        pyramid_down<3> pyr;
-                        pyr(img);
-                        min_rect_size *= (2.0/3.0)*(2.0/3.0);
-                        for (auto&& r : object_dets)
-                        {
-                            r.get_rect() = pyr.rect_down(r.get_rect());
-                            for (unsigned long k = 0; k < r.num_parts(); ++k)
-                                r.part(k) = pyr.point_down(r.part(k));
-                        }
-                        for (auto&& r : ignored)
-                        {
-                            r = pyr.rect_down(r);
-                        }
+                        r = pyr.rect_down(r);
+                    }
+                }
+                while(min_rect_size*(2.0/3.0)*(2.0/3.0) > source.box_area_thresh())
+                {
+                    pyramid_down<3> pyr;
+                    pyr(images[k]);
+                    min_rect_size *= (2.0/3.0)*(2.0/3.0);
+                    for (auto&& r : object_locations[k])
+                    {
+                        r.get_rect() = pyr.rect_down(r.get_rect());
+                        for (unsigned long p = 0; p < r.num_parts(); ++p)
+                            r.part(p) = pyr.point_down(r.part(p));
+                    }
+                    for (auto&& r : ignored_rects[k])
+                    {
+                        r = pyr.rect_down(r);
                     }
                 }
-                images.push_back(img);
-                object_locations.push_back(object_dets);
-                ignored_rects.push_back(ignored);
             }
-        }
+        });
 
 
         return ignored_rects;
@@ -37,6 +37,7 @@ namespace dlib
                   possible boxes B we have:
                     - #should_load_box(B) == true
                 - #box_area_thresh() == infinity
+                - #get_num_threads() == 1
         !*/
 
         const std::string& get_filename(
@@ -136,6 +137,26 @@ namespace dlib
                   load it in its native high resolution.  Setting the box_area_thresh()
                   allows you to control the resolution of the loaded images.
         !*/
+
+        image_dataset_file use_threads(
+            unsigned long num_threads
+        ) const;
+        /*!
+            ensures
+                - returns a copy of *this that is identical in all respects to *this except
+                  that #get_num_threads() == num_threads
+        !*/
+
+        unsigned long get_num_threads(
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads load_image_dataset() uses to decode (and
+                  shrink, see box_area_thresh()) the images.  The images and boxes it
+                  outputs are the same for any number of threads.  Note that
+                  load_image_dataset() temporarily changes the current working directory
+                  of the whole process while it runs.
+        !*/
     };
 
 // ----------------------------------------------------------------------------------------
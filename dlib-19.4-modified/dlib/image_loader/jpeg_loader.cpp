@@ -25,25 +25,49 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
 
     jpeg_loader::
-    jpeg_loader( const char* filename ) : height_( 0 ), width_( 0 ), output_components_(0)
+    jpeg_loader( const char* filename ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
     {
-        read_image( filename );
+        read_image( filename, jpeg_decode_options() );
     }
 
 // ----------------------------------------------------------------------------------------
 
     jpeg_loader::
-    jpeg_loader( const std::string& filename ) : height_( 0 ), width_( 0 ), output_components_(0)
+    jpeg_loader( const char* filename, const jpeg_decode_options& options ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
     {
-        read_image( filename.c_str() );
+        read_image( filename, options );
     }
 
 // ----------------------------------------------------------------------------------------
 
     jpeg_loader::
-    jpeg_loader( const dlib::file& f ) : height_( 0 ), width_( 0 ), output_components_(0)
+    jpeg_loader( const std::string& filename ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
     {
-        read_image( f.full_name().c_str() );
+        read_image( filename.c_str(), jpeg_decode_options() );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const std::string& filename, const jpeg_decode_options& options ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
+    {
+        read_image( filename.c_str(), options );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const dlib::file& f ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
+    {
+        read_image( f.full_name().c_str(), jpeg_decode_options() );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const dlib::file& f, const jpeg_decode_options& options ) : height_( 0 ), width_( 0 ), output_components_(0), scale_denom_(1)
+    {
+        read_image( f.full_name().c_str(), options );
     }
 
 // ----------------------------------------------------------------------------------------
@@ -86,12 +110,19 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
-    void jpeg_loader::read_image( const char* filename )
+    void jpeg_loader::read_image( const char* filename, const jpeg_decode_options& options )
     {
         if ( filename == NULL )
         {
             throw image_load_error("jpeg_loader: invalid filename, it is NULL");
         }
+        // make sure requires clause is not broken
+        DLIB_CASSERT(options.scale_denom == 1 || options.scale_denom == 2 ||
+                     options.scale_denom == 4 || options.scale_denom == 8,
+            "\t jpeg_loader::jpeg_loader()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t options.scale_denom: " << options.scale_denom
+            );
         FILE *fp = fopen( filename, "rb" );
         if ( !fp )
         {
@@ -123,6 +154,23 @@ namespace dlib
 
         jpeg_read_header(&cinfo, TRUE);
 
+        // libjpeg only has the luma channel to decode when the image is stored as YCbCr,
+        // for anything else we let it decode the colors and convert in get_image().
+        if (options.grayscale && (cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_GRAYSCALE))
+            cinfo.out_color_space = JCS_GRAYSCALE;
+
+        // Pick the largest allowed downscaling that still leaves the image at least
+        // min_nr by min_nc.  libjpeg does the downscaling in the IDCT, so it costs nothing.
+        scale_denom_ = options.scale_denom;
+        while (scale_denom_ > 1 &&
+               ((cinfo.image_height+scale_denom_-1)/scale_denom_ < options.min_nr ||
+                (cinfo.image_width+scale_denom_-1)/scale_denom_ < options.min_nc))
+        {
+            scale_denom_ /= 2;
+        }
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = scale_denom_;
+
         jpeg_start_decompress(&cinfo);
 
         height_ = cinfo.output_height;
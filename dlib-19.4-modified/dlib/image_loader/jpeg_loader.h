@@ -13,6 +13,20 @@
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    struct jpeg_decode_options
+    {
+        jpeg_decode_options() : grayscale(false), scale_denom(1), min_nr(0), min_nc(0) {}
+
+        bool grayscale;
+        unsigned long scale_denom;
+        unsigned long min_nr;
+        unsigned long min_nc;
+    };
+
+// ----------------------------------------------------------------------------------------
+
     class jpeg_loader : noncopyable
     {
     public:
@@ -20,11 +34,16 @@ namespace dlib
         jpeg_loader( const char* filename );
         jpeg_loader( const std::string& filename );
         jpeg_loader( const dlib::file& f );
+        jpeg_loader( const char* filename, const jpeg_decode_options& options );
+        jpeg_loader( const std::string& filename, const jpeg_decode_options& options );
+        jpeg_loader( const dlib::file& f, const jpeg_decode_options& options );
 
         bool is_gray() const;
         bool is_rgb() const;
         bool is_rgba() const;
 
+        unsigned long get_scale_denom() const { return scale_denom_; }
+
         template<typename T>
         void get_image( T& t_) const
         {
@@ -75,10 +94,11 @@ namespace dlib
             return &data[i*width_*output_components_];
         }
 
-        void read_image( const char* filename );
+        void read_image( const char* filename, const jpeg_decode_options& options );
         unsigned long height_; 
         unsigned long width_;
         unsigned long output_components_;
+        unsigned long scale_denom_;
         std::vector<unsigned char> data;
     };
 
@@ -95,6 +115,20 @@ namespace dlib
         jpeg_loader(file_name).get_image(image);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& options
+    )
+    {
+        jpeg_loader(file_name, options).get_image(image);
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -12,6 +12,58 @@
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    struct jpeg_decode_options
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the options for decoding a JPEG file at less than its
+                full resolution or without its colors.  libjpeg does both while decoding,
+                by skipping the chroma channels and by computing a smaller inverse DCT, so
+                they make decoding several times faster than decoding the full color image
+                and converting or downsampling it afterwards.
+        !*/
+
+        jpeg_decode_options(
+        );
+        /*!
+            ensures
+                - #grayscale == false
+                - #scale_denom == 1
+                - #min_nr == 0
+                - #min_nc == 0
+                  (i.e. decode the full color image, like the jpeg_loader constructors
+                  that take no options)
+        !*/
+
+        bool grayscale;
+        /*!
+            If true, and the JPEG file stores its colors as YCbCr (which almost all of them
+            do) or is grayscale, then only the luma channel is decoded and the jpeg_loader
+            contains a grayscale image.  Note that the luma of a pixel is a weighted sum of
+            its red, green and blue values, so it can differ somewhat from what
+            assign_pixel() makes of the color image.
+        !*/
+
+        unsigned long scale_denom;
+        /*!
+            Must be 1, 2, 4, or 8.  The image is decoded at 1/scale_denom of its size in
+            each dimension (rounded up), unless min_nr or min_nc say otherwise.
+        !*/
+
+        unsigned long min_nr;
+        unsigned long min_nc;
+        /*!
+            The smallest acceptable number of rows and columns of the decoded image.  The
+            scale 1/scale_denom is reduced to 1/(scale_denom/2), 1/(scale_denom/4), etc.
+            until the decoded image has at least min_nr rows and min_nc columns or the
+            scale reaches 1.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
     class jpeg_loader : noncopyable
     {
         /*!
@@ -65,6 +117,31 @@ namespace dlib
                   us from loading the given JPEG file.
         !*/
 
+        jpeg_loader( 
+            const char* filename,
+            const jpeg_decode_options& options
+        );
+        jpeg_loader( 
+            const std::string& filename,
+            const jpeg_decode_options& options
+        );
+        jpeg_loader( 
+            const dlib::file& f,
+            const jpeg_decode_options& options
+        );
+        /*!
+            requires
+                - options.scale_denom == 1, 2, 4, or 8
+            ensures
+                - loads the JPEG file with the given file name into this object, decoded
+                  as described by options (see jpeg_decode_options above).
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from loading the given JPEG file.
+        !*/
+
         ~jpeg_loader(
         );
         /*!
@@ -92,6 +169,16 @@ namespace dlib
                     - returns false
         !*/
 
+        unsigned long get_scale_denom(
+        ) const;
+        /*!
+            ensures
+                - returns the factor by which the image in this object was shrunk while
+                  decoding it.  That is, the image is 1/get_scale_denom() the size of the
+                  one in the file (rounded up).  This is always 1 unless the object was
+                  constructed with jpeg_decode_options.
+        !*/
+
         template<
             typename image_type 
             >
@@ -125,6 +212,25 @@ namespace dlib
             - performs: jpeg_loader(file_name).get_image(image);
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& options
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - options.scale_denom == 1, 2, 4, or 8
+        ensures
+            - performs: jpeg_loader(file_name, options).get_image(image);
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
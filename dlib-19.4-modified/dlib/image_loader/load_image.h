@@ -218,6 +218,53 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& jpeg_options
+    )
+    {
+#ifdef DLIB_JPEG_SUPPORT
+        if (image_file_type::read_type(file_name) == image_file_type::JPG)
+        {
+            load_jpeg(image, file_name, jpeg_options);
+            return;
+        }
+#endif
+        load_image(image, file_name);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    unsigned long load_image_downscaled (
+        image_type& image,
+        const std::string& file_name,
+        unsigned long min_nr,
+        unsigned long min_nc
+    )
+    {
+#ifdef DLIB_JPEG_SUPPORT
+        if (image_file_type::read_type(file_name) == image_file_type::JPG)
+        {
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            jpeg_decode_options options;
+            options.grayscale = pixel_traits<pixel_type>::grayscale;
+            options.scale_denom = 8;
+            options.min_nr = min_nr;
+            options.min_nc = min_nc;
+            jpeg_loader loader(file_name, options);
+            loader.get_image(image);
+            return loader.get_scale_denom();
+        }
+#endif
+        load_image(image, file_name);
+        return 1;
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
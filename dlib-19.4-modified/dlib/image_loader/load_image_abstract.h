@@ -30,6 +30,57 @@ namespace dlib
                 us from loading the given image file.
     !*/
 
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& jpeg_options
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - jpeg_options.scale_denom == 1, 2, 4, or 8
+        ensures
+            - if (file_name is a JPEG file and DLIB_JPEG_SUPPORT is #defined) then
+                - performs: load_jpeg(image, file_name, jpeg_options);
+            - else
+                - performs: load_image(image, file_name);
+        throws
+            - image_load_error
+                This exception is thrown if there is some error that prevents
+                us from loading the given image file.
+    !*/
+
+    template <typename image_type>
+    unsigned long load_image_downscaled (
+        image_type& image,
+        const std::string& file_name,
+        unsigned long min_nr,
+        unsigned long min_nc
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+        ensures
+            - Loads the image in file_name into image, like load_image(image, file_name),
+              except that JPEG files are decoded at the smallest size libjpeg can produce
+              cheaply (1/1, 1/2, 1/4, or 1/8 of the full size) that is still at least
+              min_nr rows by min_nc columns, or at full size if the full size image is
+              already smaller than that.  If image holds grayscale pixels then only the
+              luma channel of a JPEG file is decoded.  Other file formats are always
+              loaded at full size.
+            - returns the factor by which the image was shrunk.  That is, the image in
+              file_name is about returned value times as large as #image in each
+              dimension.  A point p in #image corresponds to roughly p*returned value in
+              the full size image.
+        throws
+            - image_load_error
+                This exception is thrown if there is some error that prevents
+                us from loading the given image file.
+    !*/
+
 }
 
 #endif // DLIB_LOAd_IMAGE_ABSTRACT_ 
@@ -18,7 +18,11 @@
 #include "image_processing/scan_image_boxes.h"
 #include "image_processing/scan_image_custom.h"
 #include "image_processing/remove_unobtainable_rectangles.h"
+#include "image_processing/select_separable_rank.h"
 #include "image_processing/scan_fhog_pyramid.h"
+#include "image_processing/fhog_detector_artifact.h"
+#include "image_processing/detection_stats.h"
+#include "image_processing/yuyv_image.h"
 #include "image_processing/shape_predictor.h"
 #include "image_processing/correlation_tracker.h"
 
@@ -0,0 +1,426 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_DETECTION_STATS_Hh_
+#define DLIB_DETECTION_STATS_Hh_
+
+#include "detection_stats_abstract.h"
+#include "../algs.h"
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <iostream>
+#include <iomanip>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct detection_level_stats
+    {
+        detection_level_stats(
+        ) : resize(0), histogram(0), resample(0), normalize(0), filter(0), num_candidates(0) {}
+
+        double resize;
+        double histogram;
+        double resample;
+        double normalize;
+        double filter;
+        unsigned long num_candidates;
+    };
+
+    struct detection_stats
+    {
+        detection_stats(
+        ) { clear(); }
+
+        void clear (
+        )
+        {
+            levels.clear();
+            image_nr = 0;
+            image_nc = 0;
+            pyramid_time = 0;
+            nms_time = 0;
+            total_time = 0;
+            num_candidates = 0;
+            num_detections = 0;
+        }
+
+        detection_level_stats& level (
+            unsigned long l
+        )
+        {
+            if (l >= levels.size())
+                levels.resize(l+1);
+            return levels[l];
+        }
+
+        std::vector<detection_level_stats> levels;
+        long image_nr;
+        long image_nc;
+        double pyramid_time;
+        double nms_time;
+        double total_time;
+        unsigned long num_candidates;
+        unsigned long num_detections;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class detection_stats_sink
+    {
+    public:
+        virtual ~detection_stats_sink() {}
+
+        virtual void record (
+            const detection_stats& stats
+        ) = 0;
+    };
+
+    namespace impl
+    {
+        inline detection_stats_sink*& detection_stats_sink_slot (
+        )
+        {
+            static thread_local detection_stats_sink* sink = 0;
+            return sink;
+        }
+
+        inline detection_stats*& active_detection_stats_slot (
+        )
+        {
+            static thread_local detection_stats* stats = 0;
+            return stats;
+        }
+    }
+
+    inline void set_detection_stats_sink (
+        detection_stats_sink* sink
+    )
+    {
+        impl::detection_stats_sink_slot() = sink;
+    }
+
+    inline detection_stats_sink* get_detection_stats_sink (
+    )
+    {
+        return impl::detection_stats_sink_slot();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        inline detection_stats* active_detection_stats (
+        )
+        /*!
+            ensures
+                - returns the record the detection running in this thread fills in, or 0
+                  if no sink is set.  Everything that times a stage checks this first, so
+                  a thread without a sink never reads the clock.
+        !*/
+        {
+            return active_detection_stats_slot();
+        }
+
+        class detection_stats_scope : noncopyable
+        {
+            /*!
+                Starts a record when a sink is set and no record is active in this thread
+                yet, so a load() inside a detection adds to the detection's record rather
+                than making its own.  finish() hands the record to the sink.
+            !*/
+        public:
+            detection_stats_scope (
+                long image_nr,
+                long image_nc
+            ) : owner(false)
+            {
+                if (get_detection_stats_sink() != 0 && active_detection_stats_slot() == 0)
+                {
+                    static thread_local detection_stats record;
+                    record.clear();
+                    record.image_nr = image_nr;
+                    record.image_nc = image_nc;
+                    active_detection_stats_slot() = &record;
+                    owner = true;
+                    start = std::chrono::steady_clock::now();
+                }
+            }
+
+            void finish (
+            )
+            {
+                if (!owner)
+                    return;
+                detection_stats& record = *active_detection_stats_slot();
+                record.total_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                active_detection_stats_slot() = 0;
+                owner = false;
+                get_detection_stats_sink()->record(record);
+            }
+
+            ~detection_stats_scope (
+            )
+            {
+                if (owner)
+                    active_detection_stats_slot() = 0;
+            }
+
+        private:
+            bool owner;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        class stage_stopwatch
+        {
+            /*!
+                Measures the time between calls to lap(), but only touches the clock if
+                constructed with active == true.
+            !*/
+        public:
+            explicit stage_stopwatch (
+                bool active_
+            ) : active(active_)
+            {
+                if (active)
+                    last = std::chrono::steady_clock::now();
+            }
+
+            double lap (
+            )
+            {
+                if (!active)
+                    return 0;
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                const double seconds = std::chrono::duration<double>(now - last).count();
+                last = now;
+                return seconds;
+            }
+
+        private:
+            bool active;
+            std::chrono::steady_clock::time_point last;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class latency_histogram
+    {
+    public:
+        latency_histogram(
+        ) : counts(num_buckets, 0) { clear(); }
+
+        void clear (
+        )
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+            n = 0;
+            sum = 0;
+            max_value = 0;
+        }
+
+        void add (
+            double seconds
+        )
+        {
+            counts[bucket(seconds)] += 1;
+            ++n;
+            sum += seconds;
+            max_value = std::max(max_value, seconds);
+        }
+
+        void merge (
+            const latency_histogram& item
+        )
+        {
+            for (unsigned long i = 0; i < counts.size(); ++i)
+                counts[i] += item.counts[i];
+            n += item.n;
+            sum += item.sum;
+            max_value = std::max(max_value, item.max_value);
+        }
+
+        unsigned long long count (
+        ) const { return n; }
+
+        double mean (
+        ) const { return n == 0 ? 0 : sum/n; }
+
+        double max (
+        ) const { return max_value; }
+
+        double percentile (
+            double p
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 <= p && p <= 100,
+                "\t double latency_histogram::percentile()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t p: " << p
+                );
+
+            if (n == 0)
+                return 0;
+            const unsigned long long rank = std::max<unsigned long long>(1, (unsigned long long)std::ceil(p/100*n));
+            unsigned long long seen = 0;
+            for (unsigned long i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                    return std::min(upper_edge(i), max_value);
+            }
+            return max_value;
+        }
+
+    private:
+        // Buckets are 1/8 of an octave wide starting at 100ns, which puts any reported
+        // percentile within 9% of the true one.  The last bucket takes everything above
+        // about 30 minutes.
+        const static unsigned long buckets_per_octave = 8;
+        const static unsigned long num_buckets = 34*buckets_per_octave;
+
+        static double lowest (
+        ) { return 1e-7; }
+
+        static unsigned long bucket (
+            double seconds
+        )
+        {
+            if (!(seconds > lowest()))
+                return 0;
+            const double b = std::ceil(std::log2(seconds/lowest())*buckets_per_octave);
+            return (unsigned long)std::min<double>(b, num_buckets-1);
+        }
+
+        static double upper_edge (
+            unsigned long b
+        )
+        {
+            return lowest()*std::pow(2.0, (double)b/buckets_per_octave);
+        }
+
+        std::vector<unsigned long long> counts;
+        unsigned long long n;
+        double sum;
+        double max_value;
+    };
+
+    inline std::ostream& operator<< (
+        std::ostream& out,
+        const latency_histogram& item
+    )
+    {
+        std::ios::fmtflags flags = out.flags();
+        const std::streamsize prec = out.precision();
+        out << std::fixed << std::setprecision(3)
+            << "n " << item.count() << "  mean " << 1000*item.mean() << "ms"
+            << "  p50 " << 1000*item.percentile(50) << "ms  p90 " << 1000*item.percentile(90)
+            << "ms  p99 " << 1000*item.percentile(99) << "ms  max " << 1000*item.max() << "ms";
+        out.flags(flags);
+        out.precision(prec);
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class detection_latency_histograms : public detection_stats_sink
+    {
+    public:
+        detection_latency_histograms(
+        ) : num_frames(0), num_candidates(0), num_detections(0) {}
+
+        virtual void record (
+            const detection_stats& stats
+        )
+        {
+            double resize = 0, histogram = 0, resample = 0, normalize = 0, filter = 0;
+            for (unsigned long i = 0; i < stats.levels.size(); ++i)
+            {
+                resize += stats.levels[i].resize;
+                histogram += stats.levels[i].histogram;
+                resample += stats.levels[i].resample;
+                normalize += stats.levels[i].normalize;
+                filter += stats.levels[i].filter;
+            }
+
+            std::lock_guard<std::mutex> lock(m);
+            hist_total.add(stats.total_time);
+            hist_pyramid.add(stats.pyramid_time);
+            hist_resize.add(resize);
+            hist_histogram.add(histogram);
+            hist_resample.add(resample);
+            hist_normalize.add(normalize);
+            hist_filter.add(filter);
+            hist_nms.add(stats.nms_time);
+            ++num_frames;
+            num_candidates += stats.num_candidates;
+            num_detections += stats.num_detections;
+        }
+
+        void clear (
+        )
+        {
+            std::lock_guard<std::mutex> lock(m);
+            hist_total.clear();
+            hist_pyramid.clear();
+            hist_resize.clear();
+            hist_histogram.clear();
+            hist_resample.clear();
+            hist_normalize.clear();
+            hist_filter.clear();
+            hist_nms.clear();
+            num_frames = 0;
+            num_candidates = 0;
+            num_detections = 0;
+        }
+
+        latency_histogram total     () const { std::lock_guard<std::mutex> lock(m); return hist_total; }
+        latency_histogram pyramid   () const { std::lock_guard<std::mutex> lock(m); return hist_pyramid; }
+        latency_histogram resize    () const { std::lock_guard<std::mutex> lock(m); return hist_resize; }
+        latency_histogram histogram () const { std::lock_guard<std::mutex> lock(m); return hist_histogram; }
+        latency_histogram resample  () const { std::lock_guard<std::mutex> lock(m); return hist_resample; }
+        latency_histogram normalize () const { std::lock_guard<std::mutex> lock(m); return hist_normalize; }
+        latency_histogram filter    () const { std::lock_guard<std::mutex> lock(m); return hist_filter; }
+        latency_histogram nms       () const { std::lock_guard<std::mutex> lock(m); return hist_nms; }
+
+        unsigned long long get_num_frames     () const { std::lock_guard<std::mutex> lock(m); return num_frames; }
+        unsigned long long get_num_candidates () const { std::lock_guard<std::mutex> lock(m); return num_candidates; }
+        unsigned long long get_num_detections () const { std::lock_guard<std::mutex> lock(m); return num_detections; }
+
+    private:
+        mutable std::mutex m;
+        latency_histogram hist_total, hist_pyramid, hist_resize, hist_histogram;
+        latency_histogram hist_resample, hist_normalize, hist_filter, hist_nms;
+        unsigned long long num_frames;
+        unsigned long long num_candidates;
+        unsigned long long num_detections;
+    };
+
+    inline std::ostream& operator<< (
+        std::ostream& out,
+        const detection_latency_histograms& item
+    )
+    {
+        out << "frames: " << item.get_num_frames() << "  candidates: " << item.get_num_candidates()
+            << "  detections: " << item.get_num_detections() << "\n";
+        out << "total:     " << item.total() << "\n";
+        out << "pyramid:   " << item.pyramid() << "\n";
+        out << "resize:    " << item.resize() << "\n";
+        out << "histogram: " << item.histogram() << "\n";
+        out << "resample:  " << item.resample() << "\n";
+        out << "normalize: " << item.normalize() << "\n";
+        out << "filter:    " << item.filter() << "\n";
+        out << "nms:       " << item.nms() << "\n";
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DETECTION_STATS_Hh_
+
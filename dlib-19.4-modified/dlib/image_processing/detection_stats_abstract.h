@@ -0,0 +1,283 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_DETECTION_STATS_ABSTRACT_Hh_
+#ifdef DLIB_DETECTION_STATS_ABSTRACT_Hh_
+
+#include <vector>
+#include <iostream>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct detection_level_stats
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the time, in seconds, a detection spent on each stage of
+                one level of the fHOG pyramid, and how many windows of the level scored
+                above the detection threshold.  The stages are
+                    - resize:    making the resized image an exact level is computed from
+                    - histogram: the gradient orientation histograms of an exact level
+                    - resample:  downsampling the histograms of the level before
+                    - normalize: turning the histograms into the 31 fHOG planes
+                    - filter:    running the detector's filters over the planes
+                Stages a level didn't go through are 0.
+        !*/
+
+        double resize;
+        double histogram;
+        double resample;
+        double normalize;
+        double filter;
+        unsigned long num_candidates;
+    };
+
+    struct detection_stats
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object describes one call to an object detector (or one
+                scan_fhog_pyramid::load() made outside of a detection).  All times are in
+                seconds.
+                    - levels[i] describes pyramid level i.  Detectors whose scanner doesn't
+                      report per level times leave levels empty.
+                    - image_nr, image_nc: the size of the image.
+                    - pyramid_time: the time spent building the feature pyramid.  This is
+                      the sum of the resize, histogram, resample and normalize times plus
+                      bookkeeping.
+                    - nms_time: the time spent in non-max suppression.
+                    - total_time: the time the whole call took.
+                    - num_candidates: the number of windows that scored above the
+                      detection threshold, i.e. the input of the non-max suppression.
+                    - num_detections: the number of detections that were returned.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #levels.size() == 0
+                - all the other fields are 0
+        !*/
+
+        detection_level_stats& level (
+            unsigned long l
+        );
+        /*!
+            ensures
+                - makes levels at least l+1 long and returns levels[l]
+        !*/
+
+        std::vector<detection_level_stats> levels;
+        long image_nr;
+        long image_nc;
+        double pyramid_time;
+        double nms_time;
+        double total_time;
+        unsigned long num_candidates;
+        unsigned long num_detections;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class detection_stats_sink
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is the interface for receiving detection_stats.  Implement record()
+                and register the object with set_detection_stats_sink() in every thread
+                that runs detections you want to hear about.  object_detector,
+                evaluate_detectors() and mapped_fhog_object_detector then call record()
+                once per image they process, and scan_fhog_pyramid::load() calls it for
+                every pyramid it builds outside of a detection (e.g. while training).
+
+                Threads without a sink don't measure anything, so the instrumentation
+                costs one thread local pointer check per stage when it is disabled.
+        !*/
+
+    public:
+        virtual ~detection_stats_sink() {}
+
+        virtual void record (
+            const detection_stats& stats
+        ) = 0;
+        /*!
+            ensures
+                - does whatever the sink does with stats.  stats is only valid during the
+                  call.  record() is called from the thread that ran the detection, so if
+                  one sink is registered in several threads it must be thread safe.
+        !*/
+    };
+
+    void set_detection_stats_sink (
+        detection_stats_sink* sink
+    );
+    /*!
+        ensures
+            - #get_detection_stats_sink() == sink for the calling thread.  Other threads
+              are not affected.  Pass 0 to turn the instrumentation off again.
+            - The caller keeps ownership of sink and must keep it alive while it is set.
+    !*/
+
+    detection_stats_sink* get_detection_stats_sink (
+    );
+    /*!
+        ensures
+            - returns the sink set in the calling thread, or 0 if there isn't one.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class latency_histogram
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object counts durations in logarithmically spaced buckets from 100ns
+                to about 30 minutes, 8 buckets per doubling, so percentiles can be read
+                off with at most 9% error using a fixed amount of memory.
+        !*/
+
+    public:
+        latency_histogram(
+        );
+        /*!
+            ensures
+                - #count() == 0
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #count() == 0
+        !*/
+
+        void add (
+            double seconds
+        );
+        /*!
+            ensures
+                - adds one duration to the histogram
+                - #count() == count() + 1
+        !*/
+
+        void merge (
+            const latency_histogram& item
+        );
+        /*!
+            ensures
+                - adds all the durations counted by item to *this
+        !*/
+
+        unsigned long long count (
+        ) const;
+        /*!
+            ensures
+                - returns the number of durations added
+        !*/
+
+        double mean (
+        ) const;
+        /*!
+            ensures
+                - returns the exact mean of the durations added, or 0 if count() == 0
+        !*/
+
+        double max (
+        ) const;
+        /*!
+            ensures
+                - returns the largest duration added, or 0 if count() == 0
+        !*/
+
+        double percentile (
+            double p
+        ) const;
+        /*!
+            requires
+                - 0 <= p <= 100
+            ensures
+                - returns the p-th percentile of the durations added, rounded up to the
+                  upper edge of its bucket (but never more than max()), or 0 if
+                  count() == 0.
+        !*/
+    };
+
+    std::ostream& operator<< (
+        std::ostream& out,
+        const latency_histogram& item
+    );
+    /*!
+        ensures
+            - prints the count, mean, 50th, 90th and 99th percentile and max of item in
+              milliseconds on one line
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class detection_latency_histograms : public detection_stats_sink
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a detection_stats_sink that keeps a latency_histogram of the total
+                time, the pyramid time, the nms time and of each stage summed over the
+                pyramid levels, along with the number of frames, candidates and
+                detections.  It is thread safe, so one object can be registered in all
+                the threads running detections.
+        !*/
+
+    public:
+        virtual void record (
+            const detection_stats& stats
+        );
+        /*!
+            ensures
+                - adds stats to the histograms and counts
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - resets all the histograms and counts
+        !*/
+
+        latency_histogram total     () const;
+        latency_histogram pyramid   () const;
+        latency_histogram resize    () const;
+        latency_histogram histogram () const;
+        latency_histogram resample  () const;
+        latency_histogram normalize () const;
+        latency_histogram filter    () const;
+        latency_histogram nms       () const;
+        /*!
+            ensures
+                - return copies of the histograms of the corresponding times
+        !*/
+
+        unsigned long long get_num_frames     () const;
+        unsigned long long get_num_candidates () const;
+        unsigned long long get_num_detections () const;
+        /*!
+            ensures
+                - return the number of records received and the sums of their
+                  num_candidates and num_detections
+        !*/
+    };
+
+    std::ostream& operator<< (
+        std::ostream& out,
+        const detection_latency_histograms& item
+    );
+    /*!
+        ensures
+            - prints the counts and one line per histogram of item
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DETECTION_STATS_ABSTRACT_Hh_
+
@@ -0,0 +1,635 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_FHOG_DETECTOR_ARTIFACT_Hh_
+#define DLIB_FHOG_DETECTOR_ARTIFACT_Hh_
+
+#include "fhog_detector_artifact_abstract.h"
+#include "scan_fhog_pyramid.h"
+#include "object_detector.h"
+#include "../mapped_file/mapped_file.h"
+#include "../uintn.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        /*
+            File layout of a version 2 fhog detector artifact.  Everything is stored in
+            the native byte order of the machine that wrote it (checked via endian_check)
+            and every offset is in bytes from the start of the file.  Every array
+            starts on a fhog_artifact_alignment boundary.
+
+                fhog_artifact_header, which includes the scanner configuration
+                fhog_artifact_level_plan[schedule_size]
+                power_law_size floats
+                feature extractor state, as written by its serialize() (nothing for
+                    default_fhog_feature_extractor)
+                fhog_artifact_bank[num_detectors]
+                for each bank:
+                    fhog_artifact_plane[num_planes]
+                    num_planes dense filters, filter_nr*filter_nc floats each
+                    for each plane: row filters, then column filters
+        */
+
+        const static uint32 fhog_artifact_alignment = 64;
+        const static uint32 fhog_artifact_version = 2;
+        const static uint32 fhog_artifact_endian_check = 0x01020304;
+
+        struct fhog_artifact_header
+        {
+            char magic[8];
+            uint32 endian_check;
+            uint32 version;
+            uint64 file_size;
+            uint32 alignment;
+            uint32 num_detectors;
+            uint32 num_planes;
+            uint32 filter_nr;
+            uint32 filter_nc;
+            uint32 reserved;
+            double overlap_iou_thresh;
+            double overlap_percent_covered_thresh;
+
+            // The scan_fhog_pyramid configuration.
+            uint64 cell_size;
+            uint64 padding;
+            uint64 window_width;
+            uint64 window_height;
+            uint64 max_pyramid_levels;
+            uint64 min_pyramid_layer_width;
+            uint64 min_pyramid_layer_height;
+            uint64 virtual_upsampling_max_width;
+            uint64 virtual_upsampling_max_height;
+            double nuclear_norm_regularization_strength;
+
+            // The fhog_pyramid_approximation.
+            uint32 exact;
+            uint32 downsample;
+            uint32 use_simd;
+            uint32 slow_downsampling;
+            uint64 hybrid_level;
+            uint64 exact_every;
+            uint64 schedule_offset;
+            uint64 schedule_size;
+            uint64 power_law_offset;
+            uint64 power_law_size;
+
+            uint64 extractor_offset;
+            uint64 extractor_size;
+            uint64 banks_offset;
+        };
+
+        struct fhog_artifact_level_plan
+        {
+            uint32 source;
+            uint32 reserved;
+            uint64 from;
+        };
+
+        struct fhog_artifact_bank
+        {
+            double thresh;
+            uint64 planes_offset;
+            uint64 dense_offset;
+            uint64 dense_stride;
+        };
+
+        struct fhog_artifact_plane
+        {
+            uint64 num_separable;
+            uint64 row_offset;
+            uint64 col_offset;
+            uint64 row_stride;
+            uint64 col_stride;
+        };
+
+        inline uint64 fhog_artifact_align (
+            uint64 offset
+        )
+        {
+            return (offset + fhog_artifact_alignment-1)/fhog_artifact_alignment*fhog_artifact_alignment;
+        }
+
+        inline uint64 fhog_artifact_stride (
+            long num_floats
+        )
+        {
+            return fhog_artifact_align(num_floats*sizeof(float))/sizeof(float);
+        }
+
+        inline uint64 fhog_artifact_append (
+            std::vector<char>& buf,
+            const void* data,
+            uint64 size
+        )
+        {
+            const uint64 offset = fhog_artifact_align(buf.size());
+            buf.resize(offset + size, 0);
+            if (data != 0 && size != 0)
+                std::memcpy(&buf[offset], data, size);
+            return offset;
+        }
+
+        template <typename EXP>
+        void fhog_artifact_write_floats (
+            std::vector<char>& buf,
+            uint64 offset,
+            const matrix_exp<EXP>& m
+        )
+        {
+            float* out = reinterpret_cast<float*>(&buf[offset]);
+            for (long r = 0; r < m.nr(); ++r)
+            {
+                for (long c = 0; c < m.nc(); ++c)
+                    *out++ = m(r,c);
+            }
+        }
+
+        struct mapped_fhog_filterbank
+        {
+            /*!
+                Has the same members as scan_fhog_pyramid::fhog_filterbank but every
+                filter is a view into the memory of a mapped artifact, so it can be given
+                directly to apply_filters_to_fhog() and detect_from_fhog_pyramid().
+            !*/
+
+            typedef matrix_op<op_pointer_to_mat<float> > filter_view;
+
+            unsigned long num_separable_filters() const
+            {
+                unsigned long num = 0;
+                for (unsigned long i = 0; i < row_filters.size(); ++i)
+                    num += row_filters[i].size();
+                return num;
+            }
+
+            std::vector<filter_view> filters;
+            std::vector<std::vector<filter_view> > row_filters, col_filters;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void save_fhog_detector_artifact (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const std::string& filename
+    )
+    {
+        using namespace impl;
+        typedef scan_fhog_pyramid<Pyramid_type,feature_extractor_type> scanner_type;
+        const scanner_type& scanner = detector.get_scanner();
+
+        const long num_planes = scanner.get_feature_extractor().get_num_planes();
+        const long nr = scanner.get_fhog_window_height();
+        const long nc = scanner.get_fhog_window_width();
+
+        std::vector<char> buf(sizeof(fhog_artifact_header), 0);
+        fhog_artifact_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "DLIBFHOG", 8);
+        header.endian_check = fhog_artifact_endian_check;
+        header.version = fhog_artifact_version;
+        header.alignment = fhog_artifact_alignment;
+        header.num_detectors = detector.num_detectors();
+        header.num_planes = num_planes;
+        header.filter_nr = nr;
+        header.filter_nc = nc;
+        header.overlap_iou_thresh = detector.get_overlap_tester().get_iou_thresh();
+        header.overlap_percent_covered_thresh = detector.get_overlap_tester().get_percent_covered_thresh();
+
+        header.cell_size = scanner.get_cell_size();
+        header.padding = scanner.get_padding();
+        header.window_width = scanner.get_detection_window_width();
+        header.window_height = scanner.get_detection_window_height();
+        header.max_pyramid_levels = scanner.get_max_pyramid_levels();
+        header.min_pyramid_layer_width = scanner.get_min_pyramid_layer_width();
+        header.min_pyramid_layer_height = scanner.get_min_pyramid_layer_height();
+        header.virtual_upsampling_max_width = scanner.get_virtual_upsampling_max_width();
+        header.virtual_upsampling_max_height = scanner.get_virtual_upsampling_max_height();
+        header.nuclear_norm_regularization_strength = scanner.get_nuclear_norm_regularization_strength();
+
+        const fhog_pyramid_approximation& approx = scanner.get_pyramid_approximation();
+        header.exact = approx.exact;
+        header.downsample = approx.downsample;
+        header.use_simd = approx.use_simd;
+        header.slow_downsampling = approx.slow_downsampling;
+        header.hybrid_level = approx.hybrid_level;
+        header.exact_every = approx.exact_every;
+        std::vector<fhog_artifact_level_plan> schedule(approx.schedule.size());
+        for (unsigned long i = 0; i < schedule.size(); ++i)
+        {
+            schedule[i].source = approx.schedule[i].source;
+            schedule[i].from = approx.schedule[i].from;
+        }
+        header.schedule_size = schedule.size();
+        header.schedule_offset = fhog_artifact_append(buf, schedule.size() ? &schedule[0] : 0,
+            schedule.size()*sizeof(fhog_artifact_level_plan));
+        header.power_law_size = approx.power_law_lambda.size();
+        header.power_law_offset = fhog_artifact_append(buf, approx.power_law_lambda.size() ? &approx.power_law_lambda[0] : 0,
+            approx.power_law_lambda.size()*sizeof(float));
+
+        std::ostringstream sout;
+        serialize(scanner.get_feature_extractor(), sout);
+        const std::string extractor_bytes = sout.str();
+        header.extractor_size = extractor_bytes.size();
+        header.extractor_offset = fhog_artifact_append(buf, extractor_bytes.data(), extractor_bytes.size());
+
+        std::vector<fhog_artifact_bank> banks(detector.num_detectors());
+        header.banks_offset = fhog_artifact_append(buf, 0, banks.size()*sizeof(fhog_artifact_bank));
+
+        for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+        {
+            const typename scanner_type::fhog_filterbank& fb = detector.get_processed_w(d).get_detect_argument();
+            banks[d].thresh = detector.get_processed_w(d).w(scanner.get_num_dimensions());
+
+            std::vector<fhog_artifact_plane> planes(num_planes);
+            banks[d].planes_offset = fhog_artifact_append(buf, 0, planes.size()*sizeof(fhog_artifact_plane));
+
+            banks[d].dense_stride = fhog_artifact_stride(nr*nc);
+            banks[d].dense_offset = fhog_artifact_append(buf, 0, num_planes*banks[d].dense_stride*sizeof(float));
+            for (long i = 0; i < num_planes; ++i)
+                fhog_artifact_write_floats(buf, banks[d].dense_offset + i*banks[d].dense_stride*sizeof(float), fb.filters[i]);
+
+            for (long i = 0; i < num_planes; ++i)
+            {
+                fhog_artifact_plane& p = planes[i];
+                p.num_separable = fb.row_filters[i].size();
+                p.row_stride = fhog_artifact_stride(nc);
+                p.col_stride = fhog_artifact_stride(nr);
+                p.row_offset = fhog_artifact_append(buf, 0, p.num_separable*p.row_stride*sizeof(float));
+                for (uint64 j = 0; j < p.num_separable; ++j)
+                    fhog_artifact_write_floats(buf, p.row_offset + j*p.row_stride*sizeof(float), fb.row_filters[i][j]);
+                p.col_offset = fhog_artifact_append(buf, 0, p.num_separable*p.col_stride*sizeof(float));
+                for (uint64 j = 0; j < p.num_separable; ++j)
+                    fhog_artifact_write_floats(buf, p.col_offset + j*p.col_stride*sizeof(float), fb.col_filters[i][j]);
+            }
+            if (planes.size() != 0)
+                std::memcpy(&buf[banks[d].planes_offset], &planes[0], planes.size()*sizeof(fhog_artifact_plane));
+        }
+        if (banks.size() != 0)
+            std::memcpy(&buf[header.banks_offset], &banks[0], banks.size()*sizeof(fhog_artifact_bank));
+
+        buf.resize(fhog_artifact_align(buf.size()), 0);
+        header.file_size = buf.size();
+        std::memcpy(&buf[0], &header, sizeof(header));
+
+        std::ofstream fout(filename.c_str(), std::ios::binary);
+        if (!fout)
+            throw serialization_error("Unable to open " + filename + " for writing.");
+        fout.write(&buf[0], buf.size());
+        if (!fout)
+            throw serialization_error("Error writing fhog detector artifact to " + filename + ".");
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type = default_fhog_feature_extractor
+        >
+    class mapped_fhog_object_detector : noncopyable
+    {
+    public:
+        typedef scan_fhog_pyramid<Pyramid_type,feature_extractor_type> image_scanner_type;
+        typedef Pyramid_type pyramid_type;
+
+        mapped_fhog_object_detector (
+        ) {}
+
+        explicit mapped_fhog_object_detector (
+            const std::string& filename
+        ) { load(filename); }
+
+        void load (
+            const std::string& filename
+        )
+        {
+            using namespace impl;
+            mapped_file temp(filename);
+            const char* base = temp.data();
+            const uint64 size = temp.size();
+
+            fhog_artifact_header header;
+            if (size < sizeof(header))
+                throw serialization_error("File " + filename + " is too small to be an fhog detector artifact.");
+            std::memcpy(&header, base, sizeof(header));
+            if (std::memcmp(header.magic, "DLIBFHOG", 8) != 0)
+                throw serialization_error("File " + filename + " is not an fhog detector artifact.");
+            if (header.endian_check != fhog_artifact_endian_check)
+                throw serialization_error("The fhog detector artifact " + filename + " was written on a machine with a different byte order.");
+            if (header.version != fhog_artifact_version)
+                throw serialization_error("Unsupported version found when loading the fhog detector artifact " + filename + ".");
+            if (header.file_size != size || header.alignment != fhog_artifact_alignment)
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+
+            image_scanner_type temp_scanner;
+            read_scanner_configuration(header, base, size, filename, temp_scanner);
+            if ((long)header.num_planes != temp_scanner.get_feature_extractor().get_num_planes() ||
+                header.filter_nr != temp_scanner.get_fhog_window_height() ||
+                header.filter_nc != temp_scanner.get_fhog_window_width())
+                throw serialization_error("The fhog detector artifact " + filename + " doesn't match its scanner configuration.");
+
+            const long nr = header.filter_nr;
+            const long nc = header.filter_nc;
+            if (header.num_detectors > size/sizeof(fhog_artifact_bank))
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+            check_range(header.banks_offset, header.num_detectors*sizeof(fhog_artifact_bank), size, filename);
+            std::vector<mapped_fhog_filterbank> temp_banks(header.num_detectors);
+            std::vector<double> temp_thresh(header.num_detectors);
+            for (unsigned long d = 0; d < header.num_detectors; ++d)
+            {
+                fhog_artifact_bank bank;
+                std::memcpy(&bank, base + header.banks_offset + d*sizeof(bank), sizeof(bank));
+                temp_thresh[d] = bank.thresh;
+
+                mapped_fhog_filterbank& fb = temp_banks[d];
+                check_filters(bank.dense_offset, header.num_planes, bank.dense_stride, nr*nc, size, filename);
+                check_range(bank.planes_offset, header.num_planes*sizeof(fhog_artifact_plane), size, filename);
+                fb.row_filters.resize(header.num_planes);
+                fb.col_filters.resize(header.num_planes);
+                for (unsigned long i = 0; i < header.num_planes; ++i)
+                {
+                    fb.filters.push_back(mat(float_ptr(base, bank.dense_offset) + i*bank.dense_stride, nr, nc));
+
+                    fhog_artifact_plane p;
+                    std::memcpy(&p, base + bank.planes_offset + i*sizeof(p), sizeof(p));
+                    check_filters(p.row_offset, p.num_separable, p.row_stride, nc, size, filename);
+                    check_filters(p.col_offset, p.num_separable, p.col_stride, nr, size, filename);
+                    for (uint64 j = 0; j < p.num_separable; ++j)
+                    {
+                        fb.row_filters[i].push_back(mat(float_ptr(base, p.row_offset) + j*p.row_stride, nc, 1));
+                        fb.col_filters[i].push_back(mat(float_ptr(base, p.col_offset) + j*p.col_stride, nr, 1));
+                    }
+                }
+            }
+
+            // Everything checked out so commit to the new state.
+            file.swap(temp);
+            scanner.copy_configuration(temp_scanner);
+            boxes_overlap = test_box_overlap(header.overlap_iou_thresh, header.overlap_percent_covered_thresh);
+            banks.swap(temp_banks);
+            thresh.swap(temp_thresh);
+        }
+
+        unsigned long num_detectors (
+        ) const { return banks.size(); }
+
+        const image_scanner_type& get_scanner (
+        ) const { return scanner; }
+
+        const test_box_overlap& get_overlap_tester (
+        ) const { return boxes_overlap; }
+
+        unsigned long num_separable_filters (
+            unsigned long idx = 0
+        ) const { return banks[idx].num_separable_filters(); }
+
+        bool is_memory_mapped (
+        ) const { return file.is_memory_mapped(); }
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& final_dets,
+            double adjust_threshold = 0
+        )
+        {
+            final_dets.clear();
+            if (banks.size() == 0)
+                return;
+
+            impl::detection_stats_scope stats_scope(num_rows(img), num_columns(img));
+            const unsigned long width = scanner.get_fhog_window_width();
+            const unsigned long height = scanner.get_fhog_window_height();
+            const unsigned long upsample = scanner.get_virtual_upsampling_factor(img);
+            impl::create_fhog_pyramid<pyramid_type>(img, scanner.get_feature_extractor(),
+                feats, scanner.get_cell_size(), height, width,
+                scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+                scanner.get_max_pyramid_levels(), scanner.get_pyramid_approximation(), upsample);
+
+            const unsigned long det_box_height = height - 2*scanner.get_padding();
+            const unsigned long det_box_width = width - 2*scanner.get_padding();
+            std::vector<std::pair<double, rectangle> > temp_dets;
+            std::vector<rect_detection> dets_accum;
+            for (unsigned long i = 0; i < banks.size(); ++i)
+            {
+                impl::detect_from_fhog_pyramid<pyramid_type>(feats, scanner.get_feature_extractor(),
+                    banks[i], thresh[i]+adjust_threshold, det_box_height, det_box_width,
+                    scanner.get_cell_size(), height, width, temp_dets);
+                impl::fhog_virtual_rects_down(temp_dets, upsample);
+
+                for (unsigned long j = 0; j < temp_dets.size(); ++j)
+                {
+                    rect_detection temp;
+                    temp.detection_confidence = temp_dets[j].first-thresh[i];
+                    temp.weight_index = i;
+                    temp.rect = temp_dets[j].second;
+                    dets_accum.push_back(temp);
+                }
+            }
+
+            // Do non-max suppression exactly like object_detector does.
+            detection_stats* stats = impl::active_detection_stats();
+            impl::stage_stopwatch nms_timer(stats != 0);
+            if (banks.size() > 1)
+                std::sort(dets_accum.rbegin(), dets_accum.rend());
+            for (unsigned long i = 0; i < dets_accum.size(); ++i)
+            {
+                if (overlaps_any_box(final_dets, dets_accum[i].rect))
+                    continue;
+
+                final_dets.push_back(dets_accum[i]);
+            }
+
+            if (stats)
+            {
+                stats->nms_time += nms_timer.lap();
+                stats->num_candidates += dets_accum.size();
+                stats->num_detections += final_dets.size();
+            }
+            stats_scope.finish();
+        }
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<std::pair<double, rectangle> >& final_dets,
+            double adjust_threshold = 0
+        )
+        {
+            std::vector<rect_detection> dets;
+            (*this)(img,dets,adjust_threshold);
+
+            final_dets.resize(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                final_dets[i] = std::make_pair(dets[i].detection_confidence,dets[i].rect);
+        }
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            double adjust_threshold = 0
+        )
+        {
+            std::vector<rect_detection> dets;
+            (*this)(img,dets,adjust_threshold);
+
+            std::vector<rectangle> final_dets(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                final_dets[i] = dets[i].rect;
+
+            return final_dets;
+        }
+
+    private:
+
+        static void read_scanner_configuration (
+            const impl::fhog_artifact_header& header,
+            const char* base,
+            uint64 file_size,
+            const std::string& filename,
+            image_scanner_type& scanner
+        )
+        /*!
+            Sets up scanner from the configuration in header.  Values the scanner's
+            setters would reject are reported as a corrupt file.
+        !*/
+        {
+            using namespace impl;
+            if (header.extractor_size != 0)
+            {
+                // Only feature extractors with state of their own take this path.
+                check_range(header.extractor_offset, header.extractor_size, file_size, filename);
+                feature_extractor_type fe;
+                std::istringstream sin(std::string(base + header.extractor_offset, header.extractor_size));
+                deserialize(fe, sin);
+                image_scanner_type temp(fe);
+                scanner.copy_configuration(temp);
+            }
+
+            fhog_pyramid_approximation approx;
+            approx.exact = header.exact != 0;
+            approx.downsample = static_cast<fhog_downsample_mode>(header.downsample);
+            approx.use_simd = header.use_simd != 0;
+            approx.slow_downsampling = header.slow_downsampling != 0;
+            approx.hybrid_level = header.hybrid_level;
+            approx.exact_every = header.exact_every;
+            if (header.schedule_size > file_size/sizeof(fhog_artifact_level_plan) ||
+                header.power_law_size > file_size/sizeof(float))
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+            check_range(header.schedule_offset, header.schedule_size*sizeof(fhog_artifact_level_plan), file_size, filename);
+            check_range(header.power_law_offset, header.power_law_size*sizeof(float), file_size, filename);
+            approx.schedule.resize(header.schedule_size);
+            for (unsigned long i = 0; i < approx.schedule.size(); ++i)
+            {
+                fhog_artifact_level_plan plan;
+                std::memcpy(&plan, base + header.schedule_offset + i*sizeof(plan), sizeof(plan));
+                approx.schedule[i].source = static_cast<fhog_level_source>(plan.source);
+                approx.schedule[i].from = plan.from;
+            }
+            approx.power_law_lambda.resize(header.power_law_size);
+            if (header.power_law_size != 0)
+                std::memcpy(&approx.power_law_lambda[0], base + header.power_law_offset, header.power_law_size*sizeof(float));
+
+            const bool virtual_upsampling = header.virtual_upsampling_max_width != 0 &&
+                                            header.virtual_upsampling_max_height != 0;
+            if (header.cell_size == 0 || header.window_width == 0 || header.window_height == 0 ||
+                header.max_pyramid_levels == 0 || header.min_pyramid_layer_width == 0 ||
+                header.min_pyramid_layer_height == 0 || !(header.nuclear_norm_regularization_strength >= 0) ||
+                header.downsample > (uint32)FHOG_DOWNSAMPLE_PROGRESSIVE || approx.exact_every == 0 ||
+                !is_valid_fhog_schedule(approx.schedule) ||
+                (approx.power_law_lambda.size() != 0 &&
+                 (long)approx.power_law_lambda.size() != scanner.get_feature_extractor().get_num_planes()) ||
+                (virtual_upsampling && header.cell_size%2 != 0))
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+
+            scanner.set_cell_size(header.cell_size);
+            scanner.set_padding(header.padding);
+            scanner.set_detection_window_size(header.window_width, header.window_height);
+            scanner.set_max_pyramid_levels(header.max_pyramid_levels);
+            scanner.set_min_pyramid_layer_size(header.min_pyramid_layer_width, header.min_pyramid_layer_height);
+            scanner.set_virtual_upsampling(header.virtual_upsampling_max_width, header.virtual_upsampling_max_height);
+            scanner.set_nuclear_norm_regularization_strength(header.nuclear_norm_regularization_strength);
+            scanner.set_pyramid_approximation(approx);
+        }
+
+        static void check_range (
+            uint64 offset,
+            uint64 length,
+            uint64 file_size,
+            const std::string& filename
+        )
+        {
+            if (offset > file_size || length > file_size - offset ||
+                offset%impl::fhog_artifact_alignment != 0)
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+        }
+
+        static void check_filters (
+            uint64 offset,
+            uint64 num_filters,
+            uint64 stride,
+            uint64 filter_size,
+            uint64 file_size,
+            const std::string& filename
+        )
+        /*!
+            Checks that num_filters filters of filter_size floats, each starting stride
+            floats after the previous one, fit in the file without overlapping.
+        !*/
+        {
+            if (stride < filter_size ||
+                (num_filters != 0 && stride > file_size/sizeof(float)/num_filters))
+                throw serialization_error("The fhog detector artifact " + filename + " is corrupt.");
+            check_range(offset, num_filters*stride*sizeof(float), file_size, filename);
+        }
+
+        static const float* float_ptr (
+            const char* base,
+            uint64 offset
+        ) { return reinterpret_cast<const float*>(base + offset); }
+
+        bool overlaps_any_box (
+            const std::vector<rect_detection>& rects,
+            const dlib::rectangle& rect
+        ) const
+        {
+            for (unsigned long i = 0; i < rects.size(); ++i)
+            {
+                if (boxes_overlap(rects[i].rect, rect))
+                    return true;
+            }
+            return false;
+        }
+
+        mapped_file file;
+        image_scanner_type scanner;
+        test_box_overlap boxes_overlap;
+        std::vector<impl::mapped_fhog_filterbank> banks;
+        std::vector<double> thresh;
+        array<array<array2d<float> > > feats;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FHOG_DETECTOR_ARTIFACT_Hh_
+
@@ -0,0 +1,201 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_FHOG_DETECTOR_ARTIFACT_ABSTRACT_Hh_
+#ifdef DLIB_FHOG_DETECTOR_ARTIFACT_ABSTRACT_Hh_
+
+#include "scan_fhog_pyramid_abstract.h"
+#include "object_detector_abstract.h"
+#include "../mapped_file/mapped_file_abstract.h"
+#include <string>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void save_fhog_detector_artifact (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - Writes detector to filename in a precompiled binary form that
+              mapped_fhog_object_detector can use directly from a memory mapping.
+              Unlike serialize(), the file holds the processed fhog filter banks (the
+              dense filters, the separable row and column filters produced by
+              build_fhog_filterbank(), and the detection thresholds) rather than the raw
+              weight vectors, so loading it doesn't need to redo any SVDs.
+            - The file starts with a versioned, fixed size header and every filter is
+              stored as a float array aligned to a 64 byte boundary.  The data is written
+              in the native byte order and the loader rejects files written with a
+              different one.
+            - The scanner configuration (window size, cell size, padding, pyramid
+              settings, virtual upsampling and pyramid approximation) is stored as plain
+              fields of the header, so loading it doesn't parse anything.  The feature
+              storage and pyramid cache directory are not saved, a loaded detector uses
+              the defaults.  Only a feature extractor with state of its own is written
+              with its serialize() routine.
+            - The Pyramid_type and feature_extractor_type are not recorded.  Like with
+              serialize(), the file must be loaded with the same scanner type it was
+              saved with.
+        throws
+            - serialization_error if the file can't be written.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type = default_fhog_feature_extractor
+        >
+    class mapped_fhog_object_detector : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a read-only stand-in for an
+                object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >
+                that runs straight out of a file written by save_fhog_detector_artifact().
+                The file is mapped with mapped_file and the filters are used in place, so
+                loading costs a handful of header checks regardless of the filter sizes,
+                and processes that load the same file share its memory through the OS
+                page cache.
+
+                It produces exactly the same detections as the object_detector the file
+                was saved from.
+
+            THREAD SAFETY
+                Like object_detector, concurrent calls to operator() on the same object
+                are not safe since it reuses an internal feature pyramid.  Use one
+                mapped_fhog_object_detector per thread.  They may all map the same file.
+        !*/
+
+    public:
+        typedef scan_fhog_pyramid<Pyramid_type,feature_extractor_type> image_scanner_type;
+        typedef Pyramid_type pyramid_type;
+
+        mapped_fhog_object_detector (
+        );
+        /*!
+            ensures
+                - #num_detectors() == 0
+        !*/
+
+        explicit mapped_fhog_object_detector (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - performs load(filename)
+        !*/
+
+        void load (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - maps the artifact in filename and makes *this use it.
+                - #num_detectors(), #get_scanner() and #get_overlap_tester() are the same
+                  as those of the object_detector that was saved, except that the
+                  scanner has the default feature storage and no pyramid cache directory.
+            throws
+                - dlib::error if the file can't be opened.
+                - serialization_error if the file isn't a valid artifact for this scanner
+                  type.  In particular files with the wrong magic number, written with a
+                  different byte order or by a different version of
+                  save_fhog_detector_artifact() are rejected.
+                If an exception is thrown *this is left unchanged.
+        !*/
+
+        unsigned long num_detectors (
+        ) const;
+        /*!
+            ensures
+                - returns the number of filter banks in the loaded artifact.
+        !*/
+
+        const image_scanner_type& get_scanner (
+        ) const;
+        /*!
+            ensures
+                - returns the scanner configuration stored in the artifact.  It is not
+                  loaded with any image.
+        !*/
+
+        const test_box_overlap& get_overlap_tester (
+        ) const;
+        /*!
+            ensures
+                - returns the overlap tester used for non-max suppression.
+        !*/
+
+        unsigned long num_separable_filters (
+            unsigned long idx = 0
+        ) const;
+        /*!
+            requires
+                - idx < num_detectors()
+            ensures
+                - returns the number of separable filters in the idx-th filter bank.
+        !*/
+
+        bool is_memory_mapped (
+        ) const;
+        /*!
+            ensures
+                - returns true if the filters are being used from an mmap()ed file rather
+                  than a heap copy of it.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by image_scanner_type::load().
+            ensures
+                - Performs object detection on img just like the corresponding
+                  object_detector::operator() does, with the same results.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<std::pair<double, rectangle> >& dets,
+            double adjust_threshold = 0
+        );
+        /*!
+            ensures
+                - Same as above, but the weight_index is dropped.  This makes the object
+                  usable with test_object_detection_function().
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            double adjust_threshold = 0
+        );
+        /*!
+            ensures
+                - Same as above, but only the rectangles are returned.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FHOG_DETECTOR_ARTIFACT_ABSTRACT_Hh_
+
@@ -8,6 +8,8 @@
 #include <vector>
 #include "box_overlap_testing.h"
 #include "full_object_detection.h"
+#include "detection_stats.h"
+#include "generic_image.h"
 
 namespace dlib
 {
@@ -430,6 +432,7 @@ namespace dlib
         double adjust_threshold
     ) 
     {
+        impl::detection_stats_scope stats_scope(num_rows(img), num_columns(img));
         scanner.load(img);
         std::vector<std::pair<double, rectangle> > dets;
         std::vector<rect_detection> dets_accum;
@@ -448,6 +451,8 @@ namespace dlib
         }
 
         // Do non-max suppression
+        detection_stats* stats = impl::active_detection_stats();
+        impl::stage_stopwatch nms_timer(stats != 0);
         final_dets.clear();
         if (w.size() > 1)
             std::sort(dets_accum.rbegin(), dets_accum.rend());
@@ -458,6 +463,14 @@ namespace dlib
 
             final_dets.push_back(dets_accum[i]);
         }
+
+        if (stats)
+        {
+            stats->nms_time += nms_timer.lap();
+            stats->num_candidates += dets_accum.size();
+            stats->num_detections += final_dets.size();
+        }
+        stats_scope.finish();
     }
 
 // ----------------------------------------------------------------------------------------
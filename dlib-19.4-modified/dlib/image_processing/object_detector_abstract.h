@@ -255,6 +255,9 @@ namespace dlib
                     - #dets[i].detection_confidence >= adjust_threshold
                   This means that, for example, you can obtain the maximum possible number
                   of detections by setting adjust_threshold equal to negative infinity.
+                - If a detection_stats_sink is set in the calling thread (see
+                  detection_stats_abstract.h) then one detection_stats record describing
+                  this call is given to it.
         !*/
 
         template <
@@ -9,6 +9,20 @@
 #include "../array.h"
 #include "../array2d.h"
 #include "object_detector.h"
+#include "detection_stats.h"
+#include "../misc_api/temporary_file_name.h"
+#include "../mapped_file/mapped_feature_store.h"
+#include "../general_hash/murmur_hash3.h"
+#include <cstring>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <typeinfo>
+#include <thread>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
 
 namespace dlib
 {
@@ -82,6 +96,689 @@ namespace dlib
     inline void serialize   (const default_fhog_feature_extractor&, std::ostream&) {}
     inline void deserialize (default_fhog_feature_extractor&, std::istream&) {}
 
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_feature_storage
+    {
+        FHOG_STORE_FLOAT32,
+        FHOG_STORE_FLOAT16,
+        FHOG_STORE_UINT8
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_downsample_mode
+    {
+        FHOG_DOWNSAMPLE_DIRECT,
+        FHOG_DOWNSAMPLE_PROGRESSIVE
+    };
+
+    inline std::string fhog_downsample_mode_name (
+        fhog_downsample_mode mode
+    )
+    {
+        return mode == FHOG_DOWNSAMPLE_DIRECT ? "Direct" : "Progressive";
+    }
+
+    enum fhog_level_source
+    {
+        FHOG_LEVEL_RECOMPUTE,
+        FHOG_LEVEL_RESAMPLE,
+        FHOG_LEVEL_SKIP
+    };
+
+    struct fhog_level_plan
+    {
+        fhog_level_plan(
+        ) : source(FHOG_LEVEL_RECOMPUTE), from(0) {}
+
+        fhog_level_plan(
+            fhog_level_source source_,
+            unsigned long from_ = 0
+        ) : source(source_), from(from_) {}
+
+        fhog_level_source source;
+        unsigned long from;
+    };
+
+    inline bool operator== (
+        const fhog_level_plan& a,
+        const fhog_level_plan& b
+    )
+    {
+        return a.source == b.source && (a.source != FHOG_LEVEL_RESAMPLE || a.from == b.from);
+    }
+
+    inline bool operator!= (
+        const fhog_level_plan& a,
+        const fhog_level_plan& b
+    ) { return !(a == b); }
+
+    inline bool is_valid_fhog_schedule (
+        const std::vector<fhog_level_plan>& schedule
+    )
+    {
+        for (unsigned long i = 0; i < schedule.size(); ++i)
+        {
+            switch (schedule[i].source)
+            {
+                case FHOG_LEVEL_RECOMPUTE:
+                    break;
+                case FHOG_LEVEL_RESAMPLE:
+                    if (schedule[i].from >= i || schedule[schedule[i].from].source == FHOG_LEVEL_SKIP)
+                        return false;
+                    break;
+                case FHOG_LEVEL_SKIP:
+                    if (i == 0)
+                        return false;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    inline std::string fhog_schedule_string (
+        const std::vector<fhog_level_plan>& schedule
+    )
+    {
+        std::ostringstream sout;
+        for (unsigned long i = 0; i < schedule.size(); ++i)
+        {
+            if (i != 0)
+                sout << " ";
+            if (schedule[i].source == FHOG_LEVEL_RECOMPUTE)
+                sout << "x";
+            else if (schedule[i].source == FHOG_LEVEL_SKIP)
+                sout << "-";
+            else
+                sout << schedule[i].from;
+        }
+        return sout.str();
+    }
+
+    inline void serialize (
+        const fhog_level_plan& item,
+        std::ostream& out
+    )
+    {
+        serialize((int)item.source, out);
+        serialize(item.from, out);
+    }
+
+    inline void deserialize (
+        fhog_level_plan& item,
+        std::istream& in
+    )
+    {
+        int source = 0;
+        deserialize(source, in);
+        deserialize(item.from, in);
+        item.source = static_cast<fhog_level_source>(source);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct fhog_pyramid_approximation
+    {
+        fhog_pyramid_approximation(
+        ) :
+            exact(false),
+            downsample(FHOG_DOWNSAMPLE_PROGRESSIVE),
+            use_simd(false),
+            slow_downsampling(false),
+            hybrid_level(7),
+            exact_every(3)
+        {}
+
+        bool exact;
+        fhog_downsample_mode downsample;
+        bool use_simd;
+        bool slow_downsampling;
+        unsigned long hybrid_level;
+        unsigned long exact_every;
+        std::vector<fhog_level_plan> schedule;
+        std::vector<float> power_law_lambda;
+    };
+
+    inline bool operator== (
+        const fhog_pyramid_approximation& a,
+        const fhog_pyramid_approximation& b
+    )
+    {
+        return a.exact == b.exact && a.downsample == b.downsample && a.use_simd == b.use_simd &&
+            a.slow_downsampling == b.slow_downsampling && a.hybrid_level == b.hybrid_level &&
+            a.exact_every == b.exact_every && a.schedule == b.schedule &&
+            a.power_law_lambda == b.power_law_lambda;
+    }
+
+    inline bool operator!= (
+        const fhog_pyramid_approximation& a,
+        const fhog_pyramid_approximation& b
+    ) { return !(a == b); }
+
+    inline void serialize (
+        const fhog_pyramid_approximation& item,
+        std::ostream& out
+    )
+    {
+        int version = 3;
+        serialize(version, out);
+        serialize(item.exact, out);
+        serialize((int)item.downsample, out);
+        serialize(item.use_simd, out);
+        serialize(item.slow_downsampling, out);
+        serialize(item.hybrid_level, out);
+        serialize(item.exact_every, out);
+        serialize(item.schedule, out);
+        serialize(item.power_law_lambda, out);
+    }
+
+    inline void deserialize (
+        fhog_pyramid_approximation& item,
+        std::istream& in
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version < 1 || version > 3)
+            throw serialization_error("Unsupported version found when deserializing a fhog_pyramid_approximation object.");
+
+        int downsample = 0;
+        deserialize(item.exact, in);
+        deserialize(downsample, in);
+        deserialize(item.use_simd, in);
+        deserialize(item.slow_downsampling, in);
+        deserialize(item.hybrid_level, in);
+        deserialize(item.exact_every, in);
+        // Version 1 had no per level schedule and version 2 no power law correction.
+        if (version >= 2)
+            deserialize(item.schedule, in);
+        else
+            item.schedule.clear();
+        if (version >= 3)
+            deserialize(item.power_law_lambda, in);
+        else
+            item.power_law_lambda.clear();
+        if (downsample != FHOG_DOWNSAMPLE_DIRECT && downsample != FHOG_DOWNSAMPLE_PROGRESSIVE)
+            throw serialization_error("Invalid downsample mode found when deserializing a fhog_pyramid_approximation object.");
+        if (item.exact_every == 0)
+            throw serialization_error("Invalid exact_every found when deserializing a fhog_pyramid_approximation object.");
+        if (!is_valid_fhog_schedule(item.schedule))
+            throw serialization_error("Invalid schedule found when deserializing a fhog_pyramid_approximation object.");
+        item.downsample = static_cast<fhog_downsample_mode>(downsample);
+    }
+
+    inline std::ostream& operator<< (
+        std::ostream& out,
+        const fhog_pyramid_approximation& item
+    )
+    {
+        if (item.exact)
+            out << "exact";
+        else if (item.schedule.size() != 0)
+            out << "scheduled simd=" << item.use_simd << " schedule=" << fhog_schedule_string(item.schedule);
+        else
+            out << "hack downsample=" << fhog_downsample_mode_name(item.downsample)
+                << " simd=" << item.use_simd << " slow_downsampling=" << item.slow_downsampling
+                << " hybrid_level=" << item.hybrid_level << " exact_every=" << item.exact_every;
+        if (!item.exact && item.power_law_lambda.size() != 0)
+            out << " power_law_planes=" << item.power_law_lambda.size();
+        return out;
+    }
+
+    inline std::vector<fhog_level_plan> fhog_pyramid_schedule (
+        const fhog_pyramid_approximation& approx,
+        unsigned long num_levels
+    )
+    {
+        std::vector<fhog_level_plan> schedule(num_levels);
+        if (approx.exact)
+            return schedule;
+        if (approx.schedule.size() != 0)
+        {
+            for (unsigned long i = 0; i < num_levels && i < approx.schedule.size(); ++i)
+                schedule[i] = approx.schedule[i];
+            return schedule;
+        }
+
+        // The hybrid_level/exact_every rule of the hack pyramid.  Direct resamples the
+        // last level extracted from an image, Progressive the level right before.
+        unsigned long ref = 0;
+        for (unsigned long i = 1; i < num_levels; ++i)
+        {
+            if (i >= 2 && ((i >= approx.hybrid_level) || (i % approx.exact_every == 0)))
+            {
+                ref = i;
+            }
+            else
+            {
+                schedule[i].source = FHOG_LEVEL_RESAMPLE;
+                schedule[i].from = approx.downsample == FHOG_DOWNSAMPLE_DIRECT ? ref : i-1;
+            }
+        }
+        return schedule;
+    }
+
+    namespace impl
+    {
+        inline float fhog_bits_to_float (uint32 x) { float f; std::memcpy(&f, &x, sizeof(f)); return f; }
+        inline uint32 float_to_fhog_bits (float f) { uint32 x; std::memcpy(&x, &f, sizeof(x)); return x; }
+
+        inline uint16 float_to_half (
+            float value
+        )
+        {
+            // IEEE round to nearest even, see F. Giesen's "float->half variants".
+            const uint32 f16max = (127 + 16) << 23;
+            const uint32 denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+            uint32 x = float_to_fhog_bits(value);
+            const uint32 sign = x & 0x80000000u;
+            x ^= sign;
+
+            uint16 o;
+            if (x >= f16max)
+            {
+                o = (x > (255u << 23)) ? 0x7e00 : 0x7c00;
+            }
+            else if (x < (113u << 23))
+            {
+                o = static_cast<uint16>(float_to_fhog_bits(fhog_bits_to_float(x) + fhog_bits_to_float(denorm_magic)) - denorm_magic);
+            }
+            else
+            {
+                const uint32 mant_odd = (x >> 13) & 1;
+                x += ((15u - 127u) << 23) + 0xfff;
+                x += mant_odd;
+                o = static_cast<uint16>(x >> 13);
+            }
+            return o | static_cast<uint16>(sign >> 16);
+        }
+
+        inline float half_to_float (
+            uint16 h
+        )
+        {
+            const uint32 shifted_exp = 0x7c00u << 13;
+            uint32 o = (h & 0x7fffu) << 13;
+            const uint32 exp = shifted_exp & o;
+            o += (127u - 15u) << 23;
+            if (exp == shifted_exp)
+            {
+                o += (128u - 16u) << 23;
+            }
+            else if (exp == 0)
+            {
+                o += 1u << 23;
+                o = float_to_fhog_bits(fhog_bits_to_float(o) - fhog_bits_to_float(113u << 23));
+            }
+            o |= (h & 0x8000u) << 16;
+            return fhog_bits_to_float(o);
+        }
+
+        inline void float_to_half (
+            const float* in,
+            uint16* out,
+            size_t n
+        )
+        {
+            size_t i = 0;
+#ifdef __F16C__
+            for (; i + 8 <= n; i += 8)
+                _mm_storeu_si128((__m128i*)(out+i), _mm256_cvtps_ph(_mm256_loadu_ps(in+i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+            for (; i < n; ++i)
+                out[i] = float_to_half(in[i]);
+        }
+
+        inline void half_to_float (
+            const uint16* in,
+            float* out,
+            size_t n
+        )
+        {
+            size_t i = 0;
+#ifdef __F16C__
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(in+i))));
+#endif
+            for (; i < n; ++i)
+                out[i] = half_to_float(in[i]);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        class compressed_fhog_pyramid
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds an fHOG pyramid (the array<array<array2d<float>>>
+                    made by create_fhog_pyramid()) in packed form, either in its own
+                    memory or in a mapped_feature_store.  With FHOG_STORE_FLOAT32 the
+                    values are kept as they are.  With FHOG_STORE_FLOAT16 every value is
+                    an IEEE half float.  With FHOG_STORE_UINT8 every plane of every level
+                    is quantized to 256 evenly spaced values between min(0,smallest value)
+                    and its largest value, so zero, and in particular the zero padding
+                    around each level, is always stored exactly.
+
+                CONVENTION
+                    - size() == levels.size()
+                    - The planes of level l are levels[l].num_planes consecutive nr*nc
+                      arrays of storage values starting at byte levels[l].start of
+                      buffer, or of the store if store is set.  Plane p of level l is
+                      dequantized with planes[levels[l].first_plane+p].
+                    - if (store) then
+                        - The levels are the consecutive sections of one block of the
+                          store starting at levels[0].start and record_bytes long.
+            !*/
+        public:
+            struct plane_info
+            {
+                float offset;
+                float scale;
+            };
+
+            struct level_view
+            {
+                const char* data;
+                long nr;
+                long nc;
+                fhog_feature_storage storage;
+                const plane_info* planes;
+
+                float operator() (
+                    unsigned long p,
+                    long r,
+                    long c
+                ) const
+                {
+                    const size_t idx = (p*nr + r)*nc + c;
+                    if (storage == FHOG_STORE_FLOAT32)
+                        return reinterpret_cast<const float*>(data)[idx];
+                    if (storage == FHOG_STORE_FLOAT16)
+                        return half_to_float(reinterpret_cast<const uint16*>(data)[idx]);
+                    return planes[p].offset + planes[p].scale*reinterpret_cast<const unsigned char*>(data)[idx];
+                }
+            };
+
+            compressed_fhog_pyramid (
+            ) : storage(FHOG_STORE_FLOAT16), record_bytes(0) {}
+
+            void clear (
+            )
+            {
+                levels.clear();
+                planes.clear();
+                std::vector<char>().swap(buffer);
+                store.reset();
+                record_bytes = 0;
+            }
+
+            unsigned long size (
+            ) const { return levels.size(); }
+
+            unsigned long num_planes (
+                unsigned long l
+            ) const { return levels[l].num_planes; }
+
+            rectangle get_rect (
+                unsigned long l
+            ) const { return rectangle(levels[l].nc, levels[l].nr); }
+
+            level_view get_level (
+                unsigned long l
+            ) const
+            {
+                const level_info& lev = levels[l];
+                level_view v;
+                v.data = level_data(l);
+                v.nr = lev.nr;
+                v.nc = lev.nc;
+                v.storage = storage;
+                v.planes = planes.size() != 0 ? &planes[lev.first_plane] : 0;
+                return v;
+            }
+
+            void compress (
+                const array<array<array2d<float> > >& feats,
+                const fhog_feature_storage storage_
+            )
+            {
+                clear();
+                storage = storage_;
+                const size_t value_size = storage == FHOG_STORE_FLOAT32 ? 4 : (storage == FHOG_STORE_FLOAT16 ? 2 : 1);
+
+                levels.resize(feats.size());
+                size_t total = 0;
+                unsigned long total_planes = 0;
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    level_info& lev = levels[l];
+                    lev.num_planes = feats[l].size();
+                    lev.nr = lev.num_planes != 0 ? feats[l][0].nr() : 0;
+                    lev.nc = lev.num_planes != 0 ? feats[l][0].nc() : 0;
+                    lev.start = total;
+                    lev.bytes = lev.num_planes*lev.nr*lev.nc*value_size;
+                    lev.first_plane = total_planes;
+                    // keep every level cache line aligned
+                    total += (lev.bytes + 63)/64*64;
+                    total_planes += lev.num_planes;
+                }
+
+                planes.resize(total_planes);
+                buffer.resize(total);
+
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    const level_info& lev = levels[l];
+                    const size_t plane_size = lev.nr*lev.nc;
+                    for (unsigned long p = 0; p < lev.num_planes; ++p)
+                    {
+                        const float* in = plane_size != 0 ? &feats[l][p][0][0] : 0;
+                        char* dest = &buffer[0] + lev.start + p*plane_size*value_size;
+                        plane_info& pl = planes[lev.first_plane + p];
+                        pl.offset = 0;
+                        pl.scale = 1;
+                        if (storage == FHOG_STORE_FLOAT32)
+                        {
+                            if (plane_size != 0)
+                                std::memcpy(dest, in, plane_size*sizeof(float));
+                            continue;
+                        }
+                        if (storage == FHOG_STORE_FLOAT16)
+                        {
+                            float_to_half(in, reinterpret_cast<uint16*>(dest), plane_size);
+                            continue;
+                        }
+
+                        float lo = 0, hi = 0;
+                        for (size_t i = 0; i < plane_size; ++i)
+                        {
+                            lo = std::min(lo, in[i]);
+                            hi = std::max(hi, in[i]);
+                        }
+                        pl.offset = lo;
+                        pl.scale = (hi-lo)/255;
+                        const float inv = pl.scale != 0 ? 1/pl.scale : 0;
+                        unsigned char* out = reinterpret_cast<unsigned char*>(dest);
+                        for (size_t i = 0; i < plane_size; ++i)
+                            out[i] = static_cast<unsigned char>(std::min((in[i]-lo)*inv + 0.5f, 255.0f));
+                    }
+                }
+            }
+
+            void move_to_store (
+                const std::shared_ptr<mapped_feature_store>& store_
+            )
+            {
+                // Lay the levels out as one block of page aligned sections so the whole
+                // pyramid can be prefetched with a single hint.
+                const uint64 page = mapped_feature_store::page_size;
+                uint64 total = 0;
+                for (unsigned long l = 0; l < levels.size(); ++l)
+                    total += (levels[l].bytes + page - 1)/page*page;
+
+                const uint64 base = store_->allocate(total);
+                uint64 offset = base;
+                for (unsigned long l = 0; l < levels.size(); ++l)
+                {
+                    if (levels[l].bytes != 0)
+                        store_->write(offset, &buffer[0] + levels[l].start, levels[l].bytes);
+                    levels[l].start = offset;
+                    offset += (levels[l].bytes + page - 1)/page*page;
+                }
+
+                std::vector<char>().swap(buffer);
+                store = store_;
+                record_bytes = total;
+            }
+
+            void decompress (
+                array<array<array2d<float> > >& feats
+            ) const
+            {
+                if (store && record_bytes != 0)
+                    store->note_access(levels[0].start, record_bytes);
+
+                if (feats.max_size() < levels.size())
+                    feats.set_max_size(levels.size());
+                feats.set_size(levels.size());
+                for (unsigned long l = 0; l < levels.size(); ++l)
+                {
+                    const level_info& lev = levels[l];
+                    const size_t plane_size = lev.nr*lev.nc;
+                    if (feats[l].max_size() < lev.num_planes)
+                        feats[l].set_max_size(lev.num_planes);
+                    feats[l].set_size(lev.num_planes);
+                    if (lev.bytes == 0)
+                    {
+                        for (unsigned long p = 0; p < lev.num_planes; ++p)
+                            feats[l][p].set_size(lev.nr, lev.nc);
+                        continue;
+                    }
+
+                    const char* data = level_data(l);
+                    for (unsigned long p = 0; p < lev.num_planes; ++p)
+                    {
+                        feats[l][p].set_size(lev.nr, lev.nc);
+                        float* out = &feats[l][p][0][0];
+                        if (storage == FHOG_STORE_FLOAT32)
+                        {
+                            std::memcpy(out, reinterpret_cast<const float*>(data) + p*plane_size, plane_size*sizeof(float));
+                        }
+                        else if (storage == FHOG_STORE_FLOAT16)
+                        {
+                            half_to_float(reinterpret_cast<const uint16*>(data) + p*plane_size, out, plane_size);
+                        }
+                        else
+                        {
+                            const plane_info& pl = planes[lev.first_plane + p];
+                            const unsigned char* in = reinterpret_cast<const unsigned char*>(data) + p*plane_size;
+                            // simple enough for the compiler to vectorize
+                            for (size_t i = 0; i < plane_size; ++i)
+                                out[i] = pl.offset + pl.scale*in[i];
+                        }
+                    }
+                }
+            }
+
+            friend void serialize (
+                const compressed_fhog_pyramid& item,
+                std::ostream& out
+            )
+            {
+                // The values are written as they are stored, so a compressed pyramid
+                // reads back exactly rather than being quantized a second time.
+                serialize((int)item.storage, out);
+                serialize(item.levels.size(), out);
+                for (unsigned long l = 0; l < item.levels.size(); ++l)
+                {
+                    const level_info& lev = item.levels[l];
+                    serialize(lev.nr, out);
+                    serialize(lev.nc, out);
+                    serialize(lev.num_planes, out);
+                    for (unsigned long p = 0; p < lev.num_planes; ++p)
+                    {
+                        serialize(item.planes[lev.first_plane+p].offset, out);
+                        serialize(item.planes[lev.first_plane+p].scale, out);
+                    }
+                    if (lev.bytes != 0)
+                        out.write(item.level_data(l), lev.bytes);
+                }
+                if (!out)
+                    throw serialization_error("Error serializing object of type compressed_fhog_pyramid");
+            }
+
+            friend void deserialize (
+                compressed_fhog_pyramid& item,
+                std::istream& in
+            )
+            {
+                item.clear();
+                int storage;
+                deserialize(storage, in);
+                if (storage != FHOG_STORE_FLOAT32 && storage != FHOG_STORE_FLOAT16 && storage != FHOG_STORE_UINT8)
+                    throw serialization_error("Invalid feature storage found while deserializing a compressed_fhog_pyramid.");
+                item.storage = (fhog_feature_storage)storage;
+                const size_t value_size = storage == FHOG_STORE_FLOAT32 ? 4 : (storage == FHOG_STORE_FLOAT16 ? 2 : 1);
+
+                unsigned long num_levels;
+                deserialize(num_levels, in);
+                item.levels.resize(num_levels);
+                for (unsigned long l = 0; l < num_levels; ++l)
+                {
+                    level_info& lev = item.levels[l];
+                    deserialize(lev.nr, in);
+                    deserialize(lev.nc, in);
+                    deserialize(lev.num_planes, in);
+                    if (lev.nr < 0 || lev.nc < 0)
+                        throw serialization_error("Invalid level size found while deserializing a compressed_fhog_pyramid.");
+                    lev.first_plane = item.planes.size();
+                    item.planes.resize(lev.first_plane + lev.num_planes);
+                    for (unsigned long p = 0; p < lev.num_planes; ++p)
+                    {
+                        deserialize(item.planes[lev.first_plane+p].offset, in);
+                        deserialize(item.planes[lev.first_plane+p].scale, in);
+                    }
+                    // Same layout as compress() makes.
+                    lev.start = item.buffer.size();
+                    lev.bytes = lev.num_planes*lev.nr*lev.nc*value_size;
+                    item.buffer.resize(lev.start + (lev.bytes + 63)/64*64);
+                    if (lev.bytes != 0 && !in.read(&item.buffer[lev.start], lev.bytes))
+                        throw serialization_error("Error deserializing object of type compressed_fhog_pyramid");
+                }
+            }
+
+        private:
+            struct level_info
+            {
+                long nr;
+                long nc;
+                unsigned long num_planes;
+                unsigned long first_plane;
+                uint64 start;
+                uint64 bytes;
+            };
+
+            const char* level_data (
+                unsigned long l
+            ) const
+            {
+                if (store)
+                    return store->data(levels[l].start, levels[l].bytes);
+                return buffer.size() != 0 ? &buffer[0] + levels[l].start : 0;
+            }
+
+            fhog_feature_storage storage;
+            std::vector<level_info> levels;
+            std::vector<plane_info> planes;
+            std::vector<char> buffer;
+            std::shared_ptr<mapped_feature_store> store;
+            uint64 record_bytes;
+        };
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -112,6 +809,10 @@ namespace dlib
             const image_type& img
         );
 
+        void load_left_right_flip (
+            const scan_fhog_pyramid& item
+        );
+
         inline bool is_loaded_with_image (
         ) const;
 
@@ -136,6 +837,7 @@ namespace dlib
             window_width = width;
             window_height = height;
             feats.clear();
+            packed.clear();
         }
 
         inline unsigned long get_detection_window_width (
@@ -155,6 +857,7 @@ namespace dlib
         {
             padding = new_padding;
             feats.clear();
+            packed.clear();
         }
 
         unsigned long get_padding (
@@ -170,9 +873,16 @@ namespace dlib
                 << "\n\t You can't have zero sized fHOG cells. "
                 << "\n\t this: " << this
                 );
+            DLIB_ASSERT(!uses_virtual_upsampling() || new_cell_size%2 == 0,
+                "\t void scan_fhog_pyramid::set_cell_size()"
+                << "\n\t Virtual upsampling needs an even cell size. "
+                << "\n\t new_cell_size: " << new_cell_size
+                << "\n\t this: " << this
+                );
 
             cell_size = new_cell_size;
             feats.clear();
+            packed.clear();
         }
 
         unsigned long get_cell_size (
@@ -316,6 +1026,12 @@ namespace dlib
             feature_vector_type& psi
         ) const;
 
+        void score_windows (
+            const feature_vector_type& w,
+            const std::vector<rectangle>& rects,
+            std::vector<double>& scores
+        ) const;
+
         full_object_detection get_full_object_detection (
             const rectangle& rect,
             const feature_vector_type& w
@@ -343,6 +1059,105 @@ namespace dlib
             nuclear_norm_regularization_strength = strength;
         }
 
+        fhog_feature_storage get_feature_storage (
+        ) const { return storage; }
+
+        void set_feature_storage (
+            fhog_feature_storage new_storage
+        )
+        {
+            storage = new_storage;
+            feats.clear();
+            packed.clear();
+        }
+
+        const fhog_pyramid_approximation& get_pyramid_approximation (
+        ) const { return approximation; }
+
+        void set_pyramid_approximation (
+            const fhog_pyramid_approximation& approx
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(approx.exact_every > 0 && is_valid_fhog_schedule(approx.schedule) &&
+                (approx.power_law_lambda.size() == 0 || approx.power_law_lambda.size() == fe.get_num_planes()),
+                "\t void scan_fhog_pyramid::set_pyramid_approximation()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t approx.exact_every: " << approx.exact_every
+                << "\n\t is_valid_fhog_schedule(approx.schedule): " << is_valid_fhog_schedule(approx.schedule)
+                << "\n\t approx.power_law_lambda.size(): " << approx.power_law_lambda.size()
+                << "\n\t get_feature_extractor().get_num_planes(): " << fe.get_num_planes()
+                << "\n\t this: " << this
+                );
+
+            approximation = approx;
+            feats.clear();
+            packed.clear();
+        }
+
+        const std::string& get_pyramid_cache_directory (
+        ) const { return cache_directory; }
+
+        void set_pyramid_cache_directory (
+            const std::string& directory
+        )
+        {
+            cache_directory = directory;
+        }
+
+        const std::shared_ptr<mapped_feature_store>& get_feature_store (
+        ) const { return store; }
+
+        void set_feature_store (
+            const std::shared_ptr<mapped_feature_store>& new_store
+        )
+        {
+            store = new_store;
+            feats.clear();
+            packed.clear();
+        }
+
+        void set_virtual_upsampling (
+            unsigned long max_width,
+            unsigned long max_height
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(max_width == 0 || max_height == 0 || cell_size%2 == 0,
+                "\t void scan_fhog_pyramid::set_virtual_upsampling()"
+                << "\n\t Virtual upsampling needs an even cell size. "
+                << "\n\t max_width:  " << max_width
+                << "\n\t max_height: " << max_height
+                << "\n\t get_cell_size(): " << cell_size
+                << "\n\t this: " << this
+                );
+
+            virtual_upsampling_max_width = max_width;
+            virtual_upsampling_max_height = max_height;
+            feats.clear();
+            packed.clear();
+        }
+
+        unsigned long get_virtual_upsampling_max_width (
+        ) const { return virtual_upsampling_max_width; }
+
+        unsigned long get_virtual_upsampling_max_height (
+        ) const { return virtual_upsampling_max_height; }
+
+        template <typename image_type>
+        unsigned long get_virtual_upsampling_factor (
+            const image_type& img
+        ) const
+        {
+            const long nr = num_rows(img);
+            const long nc = num_columns(img);
+            if (uses_virtual_upsampling() && nr*nc != 0 &&
+                (unsigned long)nc <= virtual_upsampling_max_width &&
+                (unsigned long)nr <= virtual_upsampling_max_height)
+                return 2;
+            return 1;
+        }
+
         unsigned long get_fhog_window_width (
         ) const 
         {
@@ -372,6 +1187,9 @@ namespace dlib
         );
 
     private:
+        bool uses_virtual_upsampling (
+        ) const { return virtual_upsampling_max_width != 0 && virtual_upsampling_max_height != 0; }
+
         inline void compute_fhog_window_size(
             unsigned long& width,
             unsigned long& height
@@ -403,8 +1221,51 @@ namespace dlib
 
         typedef array<array2d<float> > fhog_image;
 
+        const array<fhog_image>& get_pyramid (
+            array<fhog_image>& buffer
+        ) const
+        /*!
+            ensures
+                - returns the loaded pyramid at full precision.  That is feats itself or,
+                  if the pyramid is compressed, buffer after expanding the pyramid into
+                  it.  So the returned reference is only good while buffer isn't touched
+                  by anything else.
+        !*/
+        {
+            if (packed.size() == 0)
+                return feats;
+
+            packed.decompress(buffer);
+            return buffer;
+        }
+
+        bool keeps_float_pyramid (
+        ) const { return storage == FHOG_STORE_FLOAT32 && !store; }
+
+        void store_pyramid (
+            array<fhog_image>& pyr
+        )
+        {
+            if (keeps_float_pyramid())
+            {
+                packed.clear();
+                feats.swap(pyr);
+            }
+            else
+            {
+                feats.clear();
+                packed.compress(pyr, storage);
+                if (store)
+                    packed.move_to_store(store);
+            }
+        }
+
         feature_extractor_type fe;
         array<fhog_image> feats;
+        impl::compressed_fhog_pyramid packed;
+        fhog_feature_storage storage;
+        std::shared_ptr<mapped_feature_store> store;
+        std::string cache_directory;
         int cell_size;
         unsigned long padding; 
         unsigned long window_width;
@@ -413,6 +1274,12 @@ namespace dlib
         unsigned long min_pyramid_layer_width;
         unsigned long min_pyramid_layer_height;
         double nuclear_norm_regularization_strength;
+        fhog_pyramid_approximation approximation;
+        unsigned long virtual_upsampling_max_width;
+        unsigned long virtual_upsampling_max_height;
+        // The virtual upsampling factor of the loaded image.  The pyramid and the
+        // rectangles mapped to it are in the coordinates of the image upsampled by it.
+        unsigned long loaded_upsampling;
 
         void init()
         {
@@ -424,6 +1291,12 @@ namespace dlib
             min_pyramid_layer_width = 64;
             min_pyramid_layer_height = 64;
             nuclear_norm_regularization_strength = 0;
+            storage = FHOG_STORE_FLOAT32;
+            cache_directory = "";
+            approximation = fhog_pyramid_approximation();
+            virtual_upsampling_max_width = 0;
+            virtual_upsampling_max_height = 0;
+            loaded_upsampling = 1;
         }
 
     };
@@ -490,10 +1363,13 @@ namespace dlib
         std::ostream& out
     )
     {
-        int version = 1;
+        int version = 4;
         serialize(version, out);
         serialize(item.fe, out);
+        // At most one of these holds the loaded pyramid, depending on
+        // get_feature_storage().
         serialize(item.feats, out);
+        serialize(item.packed, out);
         serialize(item.cell_size, out);
         serialize(item.padding, out);
         serialize(item.window_width, out);
@@ -502,6 +1378,11 @@ namespace dlib
         serialize(item.min_pyramid_layer_width, out);
         serialize(item.min_pyramid_layer_height, out);
         serialize(item.nuclear_norm_regularization_strength, out);
+        serialize(item.approximation, out);
+        serialize(item.virtual_upsampling_max_width, out);
+        serialize(item.virtual_upsampling_max_height, out);
+        serialize(item.loaded_upsampling, out);
+        serialize((int)item.storage, out);
         serialize(item.get_num_dimensions(), out);
     }
 
@@ -515,11 +1396,15 @@ namespace dlib
     {
         int version = 0;
         deserialize(version, in);
-        if (version != 1)
+        if (version < 1 || version > 4)
             throw serialization_error("Unsupported version found when deserializing a scan_fhog_pyramid object.");
 
         deserialize(item.fe, in);
         deserialize(item.feats, in);
+        if (version >= 4)
+            deserialize(item.packed, in);
+        else
+            item.packed.clear();
         deserialize(item.cell_size, in);
         deserialize(item.padding, in);
         deserialize(item.window_width, in);
@@ -528,6 +1413,55 @@ namespace dlib
         deserialize(item.min_pyramid_layer_width, in);
         deserialize(item.min_pyramid_layer_height, in);
         deserialize(item.nuclear_norm_regularization_strength, in);
+        // Version 1 scanners were always run with the default approximation.
+        if (version >= 2)
+            deserialize(item.approximation, in);
+        else
+            item.approximation = fhog_pyramid_approximation();
+        // Scanners before version 3 never upsampled virtually.
+        if (version >= 3)
+        {
+            deserialize(item.virtual_upsampling_max_width, in);
+            deserialize(item.virtual_upsampling_max_height, in);
+            deserialize(item.loaded_upsampling, in);
+        }
+        else
+        {
+            item.virtual_upsampling_max_width = 0;
+            item.virtual_upsampling_max_height = 0;
+            item.loaded_upsampling = 1;
+        }
+        // Scanners before version 4 didn't save the feature storage.
+        if (version >= 4)
+        {
+            int storage;
+            deserialize(storage, in);
+            if (storage != FHOG_STORE_FLOAT32 && storage != FHOG_STORE_FLOAT16 && storage != FHOG_STORE_UINT8)
+                throw serialization_error("Invalid feature storage found when deserializing a scan_fhog_pyramid object.");
+            item.storage = (fhog_feature_storage)storage;
+        }
+        else
+        {
+            item.storage = FHOG_STORE_FLOAT32;
+        }
+        // The feature store isn't saved, so a pyramid that was in one comes back in
+        // memory, and one that wasn't goes into the store item uses, if any.
+        if (item.keeps_float_pyramid() && item.packed.size() != 0)
+        {
+            item.packed.decompress(item.feats);
+            item.packed.clear();
+        }
+        else if (item.store)
+        {
+            if (item.feats.size() != 0)
+            {
+                array<array<array2d<float> > > pyr;
+                pyr.swap(item.feats);
+                item.store_pyramid(pyr);
+            }
+            else if (item.packed.size() != 0)
+                item.packed.move_to_store(item.store);
+        }
 
         // When developing some feature extractor, it's easy to accidentally change its
         // number of dimensions and then try to deserialize data from an older version of
@@ -628,8 +1562,328 @@ namespace dlib
             HistStore(int nr, int nc) : cropHist(nr, nc) {}
             dlib::array2d<dlib::matrix<float,18,1> > cropHist;
         };
+
+        inline void apply_fhog_power_law (
+            array<array2d<float> >& planes,
+            const std::vector<float>& lambda,
+            float downscale,
+            unsigned long steps
+        )
+        /*!
+            ensures
+                - multiplies plane p of planes by pow(downscale, -lambda[p]*steps), the
+                  power law correction for features resampled from the level steps
+                  levels up that was extracted from an image.  Does nothing if lambda is
+                  empty.
+        !*/
+        {
+            for (unsigned long p = 0; p < planes.size() && p < lambda.size(); ++p)
+            {
+                // In double, so the hack and the scheduled pyramid round it the same.
+                const float factor = (float)std::pow((double)downscale, -(double)lambda[p]*steps);
+                array2d<float>& plane = planes[p];
+                for (long r = 0; r < plane.nr(); ++r)
+                {
+                    float* row = &plane[r][0];
+                    for (long c = 0; c < plane.nc(); ++c)
+                        row[c] *= factor;
+                }
+            }
+        }
+
+        inline rectangle fhog_virtual_rect_up (
+            const rectangle& rect,
+            unsigned long upsample
+        )
+        /*!
+            ensures
+                - returns rect in the coordinates of the image upsampled by upsample.
+        !*/
+        {
+            const long f = upsample;
+            return rectangle(rect.left()*f, rect.top()*f, (rect.right()+1)*f-1, (rect.bottom()+1)*f-1);
+        }
+
+        inline rectangle fhog_virtual_rect_down (
+            const rectangle& rect,
+            unsigned long upsample
+        )
+        /*!
+            ensures
+                - maps rect from the coordinates of the image upsampled by upsample back to
+                  the image, rounding to the nearest pixel.  The inverse of
+                  fhog_virtual_rect_up().
+        !*/
+        {
+            const double f = upsample;
+            return rectangle((long)std::floor(rect.left()/f + 0.5), (long)std::floor(rect.top()/f + 0.5),
+                (long)std::floor((rect.right()+1)/f + 0.5) - 1, (long)std::floor((rect.bottom()+1)/f + 0.5) - 1);
+        }
+
+        inline void fhog_virtual_rects_down (
+            std::vector<std::pair<double, rectangle> >& dets,
+            unsigned long upsample
+        )
+        {
+            if (upsample == 1)
+                return;
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                dets[i].second = fhog_virtual_rect_down(dets[i].second, upsample);
+        }
+
+        class fhog_level_histograms
+        {
+            /*!
+                The histograms of every level of a scheduled pyramid, so any later level
+                can be resampled from them.  The buffers are FRAME_ALIGNMENT aligned for
+                the extract_histo kernels and are kept from one call to the next.
+            !*/
+        public:
+            float* get (
+                unsigned long level,
+                long count
+            )
+            {
+                if (level >= buffers.size())
+                {
+                    buffers.resize(level+1);
+                    sizes.resize(level+1, 0);
+                }
+                if (sizes[level] < count)
+                {
+                    buffers[level] = storage<float>(count);
+                    sizes[level] = count;
+                }
+                return aligned(buffers[level].get());
+            }
+
+        private:
+            std::vector<std::unique_ptr<float[]> > buffers;
+            std::vector<long> sizes;
+        };
+
+        template <
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_scheduled_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            float downscale_num,
+            float downscale_den,
+            unsigned long upsample,
+            const fhog_pyramid_approximation& approx,
+            detection_stats* stats,
+            stage_stopwatch& stage_timer
+        )
+        /*!
+            requires
+                - feats.size() is the number of levels to build
+                - approx.schedule.size() != 0
+                - cell_size%upsample == 0
+            ensures
+                - builds the levels of feats the way approx.schedule says.  The level
+                  sizes are those of the hack pyramid, each downscale_num/downscale_den
+                  of the one before.  Skipped levels get fe.get_num_planes() empty
+                  planes, so no window is ever found on them.
+                - The pyramid is the one of img upsampled by upsample, without ever
+                  making that image.  A recomputed level bigger than img is computed from
+                  img resized to 1/upsample of the level with cells 1/upsample as big,
+                  which has the same cell grid.  The others are computed from img
+                  resized to the level, as usual.
+        !*/
+        {
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            static thread_local fhog_level_histograms level_hists;
+            static thread_local std::map<std::pair<int, int>, std::shared_ptr<HistStore> > cropHists;
+
+            // temp2 holds the last image a level was recomputed from, the next one is
+            // resized from it rather than from img.
+            array2d<pixel_type> temp1, temp2;
+            bool have_resized = false;
+            std::vector<int> level_cells_nr(feats.size()), level_cells_nc(feats.size());
+            // The recomputed level the histograms of each level were resampled from, for
+            // the power law correction.
+            std::vector<unsigned long> root_level(feats.size());
+            int pyr_nr = img.nr()*upsample;
+            int pyr_nc = img.nc()*upsample;
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                if (i != 0)
+                {
+                    pyr_nr = pyr_nr*downscale_num/downscale_den;
+                    pyr_nc = pyr_nc*downscale_num/downscale_den;
+                }
+                const bool fine = pyr_nr > img.nr() || pyr_nc > img.nc();
+                const int level_upsample = fine ? upsample : 1;
+                const int level_cell_size = cell_size/level_upsample;
+                const int image_nr = pyr_nr/level_upsample;
+                const int image_nc = pyr_nc/level_upsample;
+                const int cells_nr = (int)((float)image_nr/(float)level_cell_size + 0.5);
+                const int cells_nc = (int)((float)image_nc/(float)level_cell_size + 0.5);
+                level_cells_nr[i] = cells_nr;
+                level_cells_nc[i] = cells_nc;
+
+                const fhog_level_plan plan = i < approx.schedule.size() ? approx.schedule[i] : fhog_level_plan();
+                if (plan.source == FHOG_LEVEL_SKIP)
+                {
+                    if (feats[i].max_size() < fe.get_num_planes())
+                        feats[i].set_max_size(fe.get_num_planes());
+                    feats[i].set_size(fe.get_num_planes());
+                    for (unsigned long p = 0; p < feats[i].size(); ++p)
+                        feats[i][p].clear();
+                    continue;
+                }
+
+                std::pair<int, int> histKey = std::make_pair(cells_nr+2, cells_nc+2);
+                if (cropHists.find(histKey) == cropHists.end())
+                    cropHists[histKey] = std::shared_ptr<HistStore>(new HistStore(cells_nr+2, cells_nc+2));
+                dlib::array2d<dlib::matrix<float,18,1> > &cropHist = cropHists[histKey]->cropHist;
+                float* hist = level_hists.get(i, (long)cells_nr*cells_nc*HISTO_BIN_COUNT);
+
+                if (plan.source == FHOG_LEVEL_RECOMPUTE)
+                {
+                    root_level[i] = i;
+                    if (i == 0 && image_nr == img.nr() && image_nc == img.nc())
+                    {
+                        makeHist(img, cropHist, level_cell_size, filter_rows_padding, filter_cols_padding, hist);
+                    }
+                    else
+                    {
+                        // Levels get smaller, except that with upsample the first level
+                        // computed from img resized to the level can be bigger than
+                        // the last one computed at the finer cell size.
+                        set_image_size(temp1, image_nr, image_nc);
+                        if (have_resized && temp2.nr() >= image_nr && temp2.nc() >= image_nc)
+                            resize_image(temp2, temp1);
+                        else
+                            resize_image(img, temp1);
+                        swap(temp1, temp2);
+                        have_resized = true;
+                        if (stats) stats->level(i).resize += stage_timer.lap();
+                        makeHist(temp2, cropHist, level_cell_size, filter_rows_padding, filter_cols_padding, hist);
+                    }
+                    if (stats) stats->level(i).histogram += stage_timer.lap();
+                }
+                else
+                {
+                    const unsigned long k = plan.from;
+                    const float* src = level_hists.get(k, (long)level_cells_nr[k]*level_cells_nc[k]*HISTO_BIN_COUNT);
+                    if (approx.use_simd)
+                        simd_extract_histo(hist, src, cells_nc, cells_nr, 0, 0, level_cells_nc[k], level_cells_nr[k], level_cells_nc[k], level_cells_nr[k]);
+                    else
+                        scalar_extract_histo(hist, src, cells_nc, cells_nr, 0, 0, level_cells_nc[k], level_cells_nr[k], level_cells_nc[k], level_cells_nr[k]);
+                    fab2dlib_hist(cropHist, hist);
+                    root_level[i] = root_level[k];
+                    if (stats) stats->level(i).resample += stage_timer.lap();
+                }
+
+                fe(cropHist, feats[i], cells_nr, cells_nc, filter_rows_padding, filter_cols_padding);
+                if (plan.source == FHOG_LEVEL_RESAMPLE)
+                    apply_fhog_power_law(feats[i], approx.power_law_lambda, downscale_num/downscale_den, i-root_level[i]);
+                if (stats) stats->level(i).normalize += stage_timer.lap();
+            }
+        }
         // ################################################################################################################################
 
+        template <typename pyramid_type>
+        void fhog_pyramid_downscale (
+            const pyramid_type& pyr,
+            float& num,
+            float& den
+        )
+        /*!
+            ensures
+                - #num/#den == the factor pyr scales an image down by from one level to
+                  the next.  The hack pyramid steps its cell grid down by this factor.
+        !*/
+        {
+            const rectangle big(0,0,99999,99999);
+            num = pyr.rect_down(big).width();
+            den = big.width();
+        }
+
+        template <unsigned int N>
+        void fhog_pyramid_downscale (
+            const pyramid_down<N>&,
+            float& num,
+            float& den
+        )
+        {
+            num = N-1;
+            den = N;
+        }
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_virtually_upsampled_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long upsample,
+            const fhog_pyramid_approximation& approx,
+            detection_stats* stats,
+            stage_stopwatch& stage_timer
+        )
+        /*!
+            requires
+                - feats.size() is the number of levels of img upsampled by upsample
+                - cell_size%upsample == 0
+            ensures
+                - builds the pyramid of img upsampled by upsample, without ever making
+                  that image.  Levels bigger than img are extracted from img resized to
+                  1/upsample of their size with cells 1/upsample as big, which gives the
+                  same cell grid, and the others from img resized to them.
+        !*/
+        {
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            if (!approx.exact)
+            {
+                // The legacy rule only knows one cell size, so it runs as the schedule it
+                // is equivalent to.
+                float downscale_num, downscale_den;
+                fhog_pyramid_downscale(pyramid_type(), downscale_num, downscale_den);
+                fhog_pyramid_approximation scheduled = approx;
+                scheduled.schedule = fhog_pyramid_schedule(approx, feats.size());
+                create_scheduled_fhog_pyramid(img, fe, feats, cell_size, filter_rows_padding, filter_cols_padding,
+                    downscale_num, downscale_den, upsample, scheduled, stats, stage_timer);
+                return;
+            }
+
+            pyramid_type pyr;
+            array2d<pixel_type> temp;
+            rectangle level_rect = fhog_virtual_rect_up(get_rect(img), upsample);
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                if (i != 0)
+                    level_rect = pyr.rect_down(level_rect);
+                const bool fine = (long)level_rect.width() > img.nc() || (long)level_rect.height() > img.nr();
+                const unsigned long level_upsample = fine ? upsample : 1;
+                if (i == 0)
+                {
+                    fe(img, feats[0], cell_size/level_upsample, filter_rows_padding, filter_cols_padding);
+                }
+                else
+                {
+                    set_image_size(temp, level_rect.height()/level_upsample, level_rect.width()/level_upsample);
+                    resize_image(img, temp);
+                    if (stats) stats->level(i).resize += stage_timer.lap();
+                    fe(temp, feats[i], cell_size/level_upsample, filter_rows_padding, filter_cols_padding);
+                }
+                if (stats) stats->level(i).histogram += stage_timer.lap();
+            }
+        }
+
         template <
             typename pyramid_type,
             typename image_type,
@@ -644,7 +1898,9 @@ namespace dlib
             int filter_cols_padding,
             unsigned long min_pyramid_layer_width,
             unsigned long min_pyramid_layer_height,
-            unsigned long max_pyramid_levels
+            unsigned long max_pyramid_levels,
+            const fhog_pyramid_approximation& approx,
+            unsigned long upsample = 1
         )
         {
             // std::cerr << "img.nr()=" << img.nr() << " img.nc()=" << img.nc() << "\n";
@@ -659,10 +1915,15 @@ namespace dlib
             
 
 
-            auto total_t0 = std::chrono::high_resolution_clock::now();
+            // Per level stage times go to the record of the detection running in this
+            // thread, if a detection_stats_sink is set.
+            detection_stats* stats = active_detection_stats();
+            stage_stopwatch stage_timer(stats != 0), pyramid_timer(stats != 0);
 
             unsigned long levels = 0;
-            rectangle rect = get_rect(img);
+            // With upsample the pyramid is the one of img upsampled by it (see
+            // scan_fhog_pyramid::set_virtual_upsampling()).
+            rectangle rect = fhog_virtual_rect_up(get_rect(img), upsample);
 
             // figure out how many pyramid levels we should be using based on the image size
             pyramid_type pyr;
@@ -677,22 +1938,62 @@ namespace dlib
                 feats.set_max_size(levels);
             feats.set_size(levels);
 
+            if (upsample != 1)
+            {
+                create_virtually_upsampled_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size,
+                    filter_rows_padding, filter_cols_padding, upsample, approx, stats, stage_timer);
+                if (stats) stats->pyramid_time += pyramid_timer.lap();
+                return;
+            }
+
             //std::cerr << "levels=" << levels << "\n";
 
             //std::cerr << "levels = " << levels << "\n";
 
+            if (approx.exact)
+            {
+                // dlib's own pyramid: every level is extracted from a resized image.
+                fe(img, feats[0], cell_size, filter_rows_padding, filter_cols_padding);
+                if (stats) stats->level(0).histogram += stage_timer.lap();
+
+                DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
+                    "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
+                    "indicated number of planes.");
+
+                typedef typename image_traits<image_type>::pixel_type pixel_type;
+                array2d<pixel_type> temp1, temp2;
+                for (unsigned long i = 1; i < feats.size(); ++i)
+                {
+                    if (i == 1)
+                        pyr(img, temp1);
+                    else
+                        pyr(temp2, temp1);
+                    if (stats) stats->level(i).resize += stage_timer.lap();
+                    fe(temp1, feats[i], cell_size, filter_rows_padding, filter_cols_padding);
+                    if (stats) stats->level(i).histogram += stage_timer.lap();
+                    swap(temp1, temp2);
+                }
+
+                if (stats) stats->pyramid_time += pyramid_timer.lap();
+                return;
+            }
+
             // ############################################################# HACK #############################################################
-            #define USE_HACK 1
-            //std::string downsample_type = "Direct";
-            std::string downsample_type = "Progressive";
-            bool useSimd = false;
-            bool useSlowDownsampling = false;
-            #define DOWNSCALE 4.f/5.f
-            //4/5 11/12
+            const bool useSimd = approx.use_simd;
+            const bool useSlowDownsampling = approx.slow_downsampling;
+            float downscale_num, downscale_den;
+            fhog_pyramid_downscale(pyr, downscale_num, downscale_den);
+
+            if (approx.schedule.size() != 0)
+            {
+                create_scheduled_fhog_pyramid(img, fe, feats, cell_size, filter_rows_padding, filter_cols_padding,
+                    downscale_num, downscale_den, 1, approx, stats, stage_timer);
+                if (stats) stats->pyramid_time += pyramid_timer.lap();
+                return;
+            }
             #define USE_HOG_DISPLAY 0
             #define USE_IMG_DISPLAY 0
 
-            #if USE_HACK
 
             static thread_local HogBackend fabHog;
             static thread_local std::map<std::pair<int, int>, std::shared_ptr<HistStore> > cropHists;
@@ -702,6 +2003,7 @@ namespace dlib
             // compute histogram once for large img
             dlib::array2d<dlib::matrix<float,18,1> > hist(cells_nr+2, cells_nc+2);
             makeHist(img, hist, cell_size, filter_rows_padding, filter_cols_padding, fabHog.histo());
+            if (stats) stats->level(0).histogram += stage_timer.lap();
 
             // auto interim_t2 = std::chrono::high_resolution_clock::now();
 
@@ -713,7 +2015,6 @@ namespace dlib
             int pyr_nr = img.nr();
             int pyr_nc = img.nc();
 
-            #endif
 
 
             // bool itsTestTime = (img.nc() < 1000);
@@ -733,45 +2034,28 @@ namespace dlib
 
 
             // build our feature pyramid
-            #if USE_HACK
                 // auto feHog_t0 = std::chrono::high_resolution_clock::now();
 
                 fe(hist, feats[0], cells_nr, cells_nc, filter_rows_padding, filter_cols_padding);
+                if (stats) stats->level(0).normalize += stage_timer.lap();
 
-                // auto feHog_t1 = std::chrono::high_resolution_clock::now();
-
-                // auto feHog_time = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(feHog_t1-feHog_t0).count();
-
-                // avgFeHogTime[0] += feHog_time;
-
-                #if USE_HOG_DISPLAY
-                    winhogfab.set_title(downsample_type+" FabHog lvl 0");
-                    winhogfab.set_image(draw_fhog(feats[0]));
-                    std::this_thread::sleep_for(std::chrono::milliseconds(4000));
-                #endif
-
-                #if USE_IMG_DISPLAY
-                    winimg.set_title(downsample_type+" Img lvl 0");
-                    winimg.set_image(img);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(4000));
-                #endif
-            #else
-                // auto fe_t0 = std::chrono::high_resolution_clock::now();
-
-                fe(img, feats[0], cell_size, filter_rows_padding, filter_cols_padding);
-
-                // auto fe_t1 = std::chrono::high_resolution_clock::now();
+                // auto feHog_t1 = std::chrono::high_resolution_clock::now();
 
-                // auto fe_time = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(fe_t1-fe_t0).count();
+                // auto feHog_time = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(feHog_t1-feHog_t0).count();
 
-                // avgFeTime[0] += fe_time;
+                // avgFeHogTime[0] += feHog_time;
 
                 #if USE_HOG_DISPLAY
-                    winhogfab.set_title(downsample_type+" DlibHog lvl 0");
+                    winhogfab.set_title(fhog_downsample_mode_name(approx.downsample)+" FabHog lvl 0");
                     winhogfab.set_image(draw_fhog(feats[0]));
                     std::this_thread::sleep_for(std::chrono::milliseconds(4000));
                 #endif
-            #endif
+
+                #if USE_IMG_DISPLAY
+                    winimg.set_title(fhog_downsample_mode_name(approx.downsample)+" Img lvl 0");
+                    winimg.set_image(img);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(4000));
+                #endif
             
             DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
                 "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
@@ -793,9 +2077,8 @@ namespace dlib
 
                 //std::cerr << ">> " << feats[1].size() << " " << feats[1][0].size() << " " << cell_size << "\n";
 
-                #if USE_HACK
-                    pyr_nr = pyr_nr*DOWNSCALE;
-                    pyr_nc = pyr_nc*DOWNSCALE;
+                    pyr_nr = pyr_nr*downscale_num/downscale_den;
+                    pyr_nc = pyr_nc*downscale_num/downscale_den;
                     const int pyr_cells_nr = (int)((float)pyr_nr/(float)cell_size + 0.5);
                     const int pyr_cells_nc = (int)((float)pyr_nc/(float)cell_size + 0.5);
                     // std::cerr << pyr_cells_nc << " " << pyr_cells_nr << " " << cells_nc << " " << cells_nr << " " << cells_nc << " " << cells_nr << "\n";
@@ -831,7 +2114,10 @@ namespace dlib
                     // auto feHog_t0 = std::chrono::high_resolution_clock::now();
 
                     fab2dlib_hist(cropHist, fabHog.extract());
+                    if (stats) stats->level(1).resample += stage_timer.lap();
                     fe(cropHist, feats[1], pyr_cells_nr, pyr_cells_nc, filter_rows_padding, filter_cols_padding);
+                    apply_fhog_power_law(feats[1], approx.power_law_lambda, downscale_num/downscale_den, 1);
+                    if (stats) stats->level(1).normalize += stage_timer.lap();
 
                     // auto feHog_t1 = std::chrono::high_resolution_clock::now();
 
@@ -840,7 +2126,7 @@ namespace dlib
                     // avgFeHogTime[1] += feHog_time;
 
                     #if USE_HOG_DISPLAY
-                        winhogfab.set_title(downsample_type+" FabHog lvl 1");
+                        winhogfab.set_title(fhog_downsample_mode_name(approx.downsample)+" FabHog lvl 1");
                         winhogfab.set_image(draw_fhog(feats[1]));
                         std::this_thread::sleep_for(std::chrono::milliseconds(4000));
                     #endif
@@ -854,47 +2140,15 @@ namespace dlib
                         //resize_image(img, temp1, interpolate_quadratic());
                         //resize_image(img, temp1, interpolate_nearest_neighbor());
                         swap(temp1,temp2);
+                        if (stats) stats->level(1).resize += stage_timer.lap();
                     }
 
                     //std::cerr << ">> " << feats[1].size() << " " << feats[1][0].size() << " " << pyr_cells_nr << " " << pyr_cells_nc << "\n";
-                #else
-                    //auto t0 = std::chrono::high_resolution_clock::now();
-                    pyr(img, temp1);
-
-                    // auto fe_t0 = std::chrono::high_resolution_clock::now();
-
-                    //auto t1 = std::chrono::high_resolution_clock::now();
-                    fe(temp1, feats[1], cell_size,filter_rows_padding,filter_cols_padding);
-
-                    // auto fe_t1 = std::chrono::high_resolution_clock::now();
-
-                    // auto fe_time = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(fe_t1-fe_t0).count();
-
-                    // avgFeTime[1] += fe_time;
-
-                    //auto t2 = std::chrono::high_resolution_clock::now();
-                    swap(temp1,temp2);
-
-                    #if USE_HOG_DISPLAY
-                        winhogfab.set_title(downsample_type+" DlibHog lvl 1");
-                        winhogfab.set_image(draw_fhog(feats[1]));
-                        std::this_thread::sleep_for(std::chrono::milliseconds(4000));
-                    #endif
 
-                    // auto pyrTime = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
-                    // auto feTime = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count();
-
-                    // std::cerr << ">0> level 1\n";
-                    // std::cerr << "pyramid time: " << pyrTime << "\n";
-                    // std::cerr << "extraction time: " << feTime << "\n";
-                    // std::cerr << ">1> " << temp2.nc() << " " << temp2.nr() << "\n";
-                    // std::cerr << ">3> " << feats[1].size() << " " << feats[1][0].size() << " " << cell_size << " " << filter_rows_padding << " " << filter_cols_padding << "\n";
-                #endif
-
-                #if USE_HACK
                     int ref_cells_nr = cells_nr;
                     int ref_cells_nc = cells_nc;
-                #endif
+                    // Both modes resample from the last level extracted from an image.
+                    unsigned long ref_level = 0;
 
                 bool firstPassHybrid = true;
 
@@ -906,11 +2160,10 @@ namespace dlib
 
                     //std::cerr << ">>> " << feats[i].size() << " " << feats[i][0].size() << " " << cell_size << "\n";
 
-                    #if USE_HACK
                         const int old_pyr_cells_nr = (int)((float)pyr_nr/(float)cell_size + 0.5);
                         const int old_pyr_cells_nc = (int)((float)pyr_nc/(float)cell_size + 0.5);
-                        pyr_nr = pyr_nr*DOWNSCALE;
-                        pyr_nc = pyr_nc*DOWNSCALE;
+                        pyr_nr = pyr_nr*downscale_num/downscale_den;
+                        pyr_nc = pyr_nc*downscale_num/downscale_den;
                         const int pyr_cells_nr = (int)((float)pyr_nr/(float)cell_size + 0.5);
                         const int pyr_cells_nc = (int)((float)pyr_nc/(float)cell_size + 0.5);
 
@@ -923,13 +2176,14 @@ namespace dlib
                             //resize_image(temp2, temp1, interpolate_quadratic());
                             //resize_image(temp2, temp1, interpolate_nearest_neighbor());
                             swap(temp1,temp2);
+                            if (stats) stats->level(i).resize += stage_timer.lap();
                         }
 
-                        int hybridLevel = 7;
+                        const unsigned long hybridLevel = approx.hybrid_level;
 
                         //if (i % hybridLevel == 0) // hybrid hack
                         //if (i >= hybridLevel)
-                        if ((i >= hybridLevel) || (i % 3 == 0))
+                        if ((i >= hybridLevel) || (i % approx.exact_every == 0))
                         //if ((i >= hybridLevel) || (i % 8 == 0))
                         {
                             if (!useSlowDownsampling)
@@ -951,6 +2205,7 @@ namespace dlib
                                     //resize_image(temp2, temp1, interpolate_nearest_neighbor());
                                 }
                                 swap(temp1,temp2);
+                                if (stats) stats->level(i).resize += stage_timer.lap();
                             }
 
                             std::pair<int, int> histKey = std::make_pair(pyr_cells_nr+2, pyr_cells_nc+2);
@@ -966,24 +2221,27 @@ namespace dlib
                             
 
                             //dlib::array2d<dlib::matrix<float,18,1> > cropHist(pyr_cells_nr+2, pyr_cells_nc+2);
-                            if (downsample_type == "Direct")
+                            if (approx.downsample == FHOG_DOWNSAMPLE_DIRECT)
                             {
                                 makeHist(temp2, cropHist, cell_size, filter_rows_padding, filter_cols_padding, fabHog.histo());
                             }
-                            else if (downsample_type == "Progressive")
+                            else if (approx.downsample == FHOG_DOWNSAMPLE_PROGRESSIVE)
                             {
                                 makeHist(temp2, cropHist, cell_size, filter_rows_padding, filter_cols_padding, fabHog.extract());
                             }
+                            if (stats) stats->level(i).histogram += stage_timer.lap();
                             fe(cropHist, feats[i], pyr_cells_nr, pyr_cells_nc, filter_rows_padding, filter_cols_padding);
+                            if (stats) stats->level(i).normalize += stage_timer.lap();
 
                             ref_cells_nr = pyr_cells_nr;
                             ref_cells_nc = pyr_cells_nc;
+                            ref_level = i;
                         }
                         else
                         {
                             // auto feDown_t0 = std::chrono::high_resolution_clock::now();
 
-                            if (downsample_type == "Direct")
+                            if (approx.downsample == FHOG_DOWNSAMPLE_DIRECT)
                             {
                                 if (useSimd)
                                 {
@@ -996,7 +2254,7 @@ namespace dlib
                                     scalar_extract_histo(fabHog.extract(), fabHog.histo(), pyr_cells_nc, pyr_cells_nr, 0, 0, ref_cells_nc, ref_cells_nr, ref_cells_nc, ref_cells_nr);
                                 }
                             }
-                            else if (downsample_type == "Progressive")
+                            else if (approx.downsample == FHOG_DOWNSAMPLE_PROGRESSIVE)
                             {
                                 if (useSimd)
                                 {
@@ -1030,7 +2288,10 @@ namespace dlib
                             
                             //dlib::array2d<dlib::matrix<float,18,1> > cropHist(pyr_cells_nr+2, pyr_cells_nc+2);
                             fab2dlib_hist(cropHist, fabHog.extract());
+                            if (stats) stats->level(i).resample += stage_timer.lap();
                             fe(cropHist, feats[i], pyr_cells_nr, pyr_cells_nc, filter_rows_padding, filter_cols_padding);
+                            apply_fhog_power_law(feats[i], approx.power_law_lambda, downscale_num/downscale_den, i-ref_level);
+                            if (stats) stats->level(i).normalize += stage_timer.lap();
 
                             // auto feHog_t1 = std::chrono::high_resolution_clock::now();
 
@@ -1041,51 +2302,18 @@ namespace dlib
 
 
                         #if USE_HOG_DISPLAY
-                            winhogfab.set_title(downsample_type+" FabHog lvl "+std::to_string(i));
+                            winhogfab.set_title(fhog_downsample_mode_name(approx.downsample)+" FabHog lvl "+std::to_string(i));
                             winhogfab.set_image(draw_fhog(feats[i]));
                             std::this_thread::sleep_for(std::chrono::milliseconds(4000));
                         #endif
 
                         #if USE_IMG_DISPLAY
-				            winimg.set_title(downsample_type+" Img lvl "+std::to_string(i));
+				            winimg.set_title(fhog_downsample_mode_name(approx.downsample)+" Img lvl "+std::to_string(i));
 				            winimg.set_image(temp2);
 				            std::this_thread::sleep_for(std::chrono::milliseconds(4000));
 				        #endif
 
                         //std::cerr << ">>> " << feats[i].size() << " " << feats[i][0].size() << " " << pyr_cells_nr << " " << pyr_cells_nc << "\n";
-                    #else
-                        //auto t0 = std::chrono::high_resolution_clock::now();
-                        pyr(temp2, temp1);
-                        
-                        // auto fe_t0 = std::chrono::high_resolution_clock::now();
-
-                        //auto t1 = std::chrono::high_resolution_clock::now();
-                        fe(temp1, feats[i], cell_size,filter_rows_padding,filter_cols_padding);
-
-                        // auto fe_t1 = std::chrono::high_resolution_clock::now();
-
-                        // auto fe_time = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(fe_t1-fe_t0).count();
-
-                        // avgFeTime[i] += fe_time;
-
-                        //auto t2 = std::chrono::high_resolution_clock::now();
-                        swap(temp1,temp2);
-
-                        #if USE_HOG_DISPLAY
-                            winhogfab.set_title(downsample_type+" DlibHog lvl "+std::to_string(i));
-                            winhogfab.set_image(draw_fhog(feats[i]));
-                            std::this_thread::sleep_for(std::chrono::milliseconds(4000));
-                        #endif
-
-                        // auto pyrTime = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
-                        // auto feTime = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count();
-
-                        // std::cerr << ">0> level " << i << "\n"; 
-                        // std::cerr << "pyramid time: " << pyrTime << "\n";
-                        // std::cerr << "extraction time: " << feTime << "\n";
-                        // std::cerr << ">1> " << temp2.nc() << " " << temp2.nr() << "\n";
-                        // std::cerr << ">3> " << feats[i].size() << " " << feats[i][0].size() << " " << cell_size << " " << filter_rows_padding << " " << filter_cols_padding << "\n";
-                    #endif
                 }
             }
 
@@ -1106,35 +2334,167 @@ namespace dlib
             //     std::cerr << "Hog feature time " << i << ": " << (avgFeHogTime[i]/divByFe) << "\n";
             // }
 
-            auto total_t1 = std::chrono::high_resolution_clock::now();
+            if (stats) stats->pyramid_time += pyramid_timer.lap();
+        }
 
-            auto totalTime = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(total_t1-total_t0).count();
+    // ------------------------------------------------------------------------------------
 
-            static double meanTime = 0.0;
-            static double divBy = 0.0;
-            // static bool testTime = false;
-            // if (!testTime)
-            // {
-            //     if (img.nc() < 1000)
-            //     {
-            //         testTime = true;
-            //         meanTime = 0.0;
-            //         divBy = 0.0;
-            //     }
-            // }
-            if (img.nc() == 640)
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        std::string fhog_pyramid_cache_key (
+            const image_type& img_,
+            const feature_extractor_type& fe,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            const unsigned long min_pyramid_layer_width,
+            const unsigned long min_pyramid_layer_height,
+            const unsigned long max_pyramid_levels,
+            const fhog_pyramid_approximation& approx,
+            const unsigned long upsample = 1
+        )
+        {
+            const_image_view<image_type> img(img_);
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+
+            // Everything that affects the pyramid except the pixels themselves.
+            std::ostringstream sout;
+            sout << "fhog pyramid cache 3|" << typeid(pyramid_type).name() << "|"
+                 << typeid(feature_extractor_type).name() << "|" << typeid(pixel_type).name() << "|"
+                 << img.nr() << "x" << img.nc() << "|" << cell_size << "|"
+                 << filter_rows_padding << "x" << filter_cols_padding << "|"
+                 << min_pyramid_layer_width << "x" << min_pyramid_layer_height << "|"
+                 << max_pyramid_levels << "|" << upsample << "|";
+            // Serialized rather than printed, since operator<< only summarizes some of
+            // the settings (e.g. the number of power law exponents, not their values).
+            serialize(approx, sout);
+            serialize(fe, sout);
+            const std::string config = sout.str();
+
+            // The rows are hashed from a copy since not every image type keeps the pixels
+            // of a row next to each other (e.g. yuyv_luma_image).
+            std::pair<uint64,uint64> h = murmur_hash3_128bit(config.data(), config.size());
+            std::vector<pixel_type> pixels(img.nc());
+            for (long r = 0; r < img.nr(); ++r)
             {
-                #if USE_HACK
-                    std::cerr << "hack time: " << totalTime << "\n";
-                    meanTime += totalTime;
-                    divBy += 1.0;
-                    std::cerr << "avg hack time: " << meanTime/divBy << "\n";
-                #else
-                    std::cerr << "dlib time: " << totalTime << "\n";
-                    meanTime += totalTime;
-                    divBy += 1.0;
-                    std::cerr << "avg dlib time: " << meanTime/divBy << "\n";
-                #endif
+                for (long c = 0; c < img.nc(); ++c)
+                    pixels[c] = img[r][c];
+                const std::pair<uint64,uint64> row = murmur_hash3_128bit(pixels.data(), img.nc()*sizeof(pixel_type));
+                const std::pair<uint64,uint64> a = murmur_hash3_128bit_3(h.first, row.first, r);
+                const std::pair<uint64,uint64> b = murmur_hash3_128bit_3(h.second, row.second, r);
+                h = std::make_pair(a.first, b.second);
+            }
+
+            std::ostringstream name;
+            name << std::hex << std::setfill('0') << std::setw(16) << h.first << std::setw(16) << h.second;
+            return name.str();
+        }
+
+        inline bool read_cached_fhog_pyramid (
+            const std::string& filename,
+            const std::string& key,
+            array<array<array2d<float> > >& feats
+        )
+        /*!
+            ensures
+                - if (filename is a pyramid written by write_cached_fhog_pyramid() for
+                  key) then
+                    - #feats == that pyramid
+                    - returns true
+                - else
+                    - returns false
+        !*/
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            if (!fin)
+                return false;
+
+            char magic[8];
+            uint32 endian_check = 0;
+            char stored_key[32];
+            uint64 levels = 0;
+            fin.read(magic, sizeof(magic));
+            fin.read((char*)&endian_check, sizeof(endian_check));
+            fin.read(stored_key, sizeof(stored_key));
+            fin.read((char*)&levels, sizeof(levels));
+            if (!fin || std::memcmp(magic, "DLIBFPC1", 8) != 0 || endian_check != 0x01020304 ||
+                key.size() != sizeof(stored_key) || key.compare(0, key.size(), stored_key, sizeof(stored_key)) != 0 ||
+                levels > 1000)
+                return false;
+
+            if (feats.max_size() < levels)
+                feats.set_max_size(levels);
+            feats.set_size(levels);
+            for (unsigned long l = 0; l < levels; ++l)
+            {
+                uint64 dims[3];
+                fin.read((char*)dims, sizeof(dims));
+                if (!fin || dims[0] > 10000 || dims[1] > 100000 || dims[2] > 100000)
+                    return false;
+                if (feats[l].max_size() < dims[0])
+                    feats[l].set_max_size(dims[0]);
+                feats[l].set_size(dims[0]);
+                for (unsigned long p = 0; p < dims[0]; ++p)
+                {
+                    feats[l][p].set_size(dims[1], dims[2]);
+                    if (feats[l][p].size() != 0)
+                        fin.read((char*)&feats[l][p][0][0], feats[l][p].size()*sizeof(float));
+                }
+            }
+            return static_cast<bool>(fin);
+        }
+
+        inline void write_cached_fhog_pyramid (
+            const std::string& filename,
+            const std::string& key,
+            const array<array<array2d<float> > >& feats
+        )
+        /*!
+            ensures
+                - atomically replaces filename with feats.  That is, the data is written
+                  to a temporary file which is then renamed, so concurrent readers and
+                  writers of the same entry never see a partial file.
+            throws
+                - dlib::error if the file can't be written.
+        !*/
+        {
+            const std::string temp = unique_temporary_file_name(filename);
+
+            {
+                std::ofstream fout(temp.c_str(), std::ios::binary);
+                const uint32 endian_check = 0x01020304;
+                const uint64 levels = feats.size();
+                fout.write("DLIBFPC1", 8);
+                fout.write((const char*)&endian_check, sizeof(endian_check));
+                fout.write(key.data(), key.size());
+                fout.write((const char*)&levels, sizeof(levels));
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    const uint64 dims[3] = { feats[l].size(),
+                        feats[l].size() != 0 ? (uint64)feats[l][0].nr() : 0,
+                        feats[l].size() != 0 ? (uint64)feats[l][0].nc() : 0 };
+                    fout.write((const char*)dims, sizeof(dims));
+                    for (unsigned long p = 0; p < feats[l].size(); ++p)
+                    {
+                        if (feats[l][p].size() != 0)
+                            fout.write((const char*)&feats[l][p][0][0], feats[l][p].size()*sizeof(float));
+                    }
+                }
+                if (!fout)
+                {
+                    fout.close();
+                    std::remove(temp.c_str());
+                    throw error("Unable to write fHOG pyramid cache file " + temp + ".");
+                }
+            }
+
+            if (std::rename(temp.c_str(), filename.c_str()) != 0)
+            {
+                std::remove(temp.c_str());
+                throw error("Unable to write fHOG pyramid cache file " + filename + ".");
             }
         }
     }
@@ -1153,11 +2513,125 @@ namespace dlib
         const image_type& img
     )
     {
+        impl::detection_stats_scope stats_scope(num_rows(img), num_columns(img));
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+
+        static thread_local array<fhog_image> temp;
+        array<fhog_image>& pyr = keeps_float_pyramid() ? feats : temp;
+        loaded_upsampling = get_virtual_upsampling_factor(img);
+
+        if (cache_directory.size() == 0)
+        {
+            impl::create_fhog_pyramid<Pyramid_type>(img, fe, pyr, cell_size, height,
+                width, min_pyramid_layer_width, min_pyramid_layer_height,
+                max_pyramid_levels, approximation, loaded_upsampling);
+        }
+        else
+        {
+            const std::string key = impl::fhog_pyramid_cache_key<Pyramid_type>(img, fe,
+                cell_size, height, width, min_pyramid_layer_width,
+                min_pyramid_layer_height, max_pyramid_levels, approximation, loaded_upsampling);
+            const std::string filename = cache_directory + "/" + key + ".fhog";
+            if (!impl::read_cached_fhog_pyramid(filename, key, pyr))
+            {
+                impl::create_fhog_pyramid<Pyramid_type>(img, fe, pyr, cell_size, height,
+                    width, min_pyramid_layer_width, min_pyramid_layer_height,
+                    max_pyramid_levels, approximation, loaded_upsampling);
+                // The pyramid is already extracted, so a failed write (a full disk, a
+                // removed directory) only means the next load() misses the cache too.
+                try
+                {
+                    impl::write_cached_fhog_pyramid(filename, key, pyr);
+                }
+                catch (error&)
+                {
+                }
+            }
+        }
+
+        if (keeps_float_pyramid())
+            packed.clear();
+        else
+            store_pyramid(temp);
+        stats_scope.finish();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    load_left_right_flip (
+        const scan_fhog_pyramid& item
+    )
+    {
+        // The plane permutation below is specific to the 31 plane fHOG layout.
+        COMPILE_TIME_ASSERT((is_same_type<feature_extractor_type,default_fhog_feature_extractor>::value));
+
+        // make sure requires clause is not broken
+        DLIB_ASSERT(item.is_loaded_with_image() && this != &item,
+            "\t void scan_fhog_pyramid::load_left_right_flip()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t item.is_loaded_with_image(): " << item.is_loaded_with_image()
+            << "\n\t this: " << this
+            );
+
         unsigned long width, height;
         compute_fhog_window_size(width,height);
-        impl::create_fhog_pyramid<Pyramid_type>(img, fe, feats, cell_size, height,
-            width, min_pyramid_layer_width, min_pyramid_layer_height,
-            max_pyramid_levels);
+        // Every level is laid out as hog_nc real columns preceded by (width-1)/2 and
+        // followed by width/2 zero padding columns.  Mirroring the cell grid maps real
+        // column off+x to off+hog_nc-1-x and leaves the padding where it is.
+        const long off = (width-1)/2;
+
+        // Under a horizontal flip a gradient at angle t moves to angle 180-t.  So signed
+        // bin o goes to (9-o)%18, unsigned bin o goes to (9-o)%9, and the four texture
+        // features, which are indexed by which neighbouring block normalized them, swap
+        // their left and right blocks.
+        long perm[31];
+        for (long o = 0; o < 18; ++o)
+            perm[o] = (27-o)%18;
+        for (long o = 0; o < 9; ++o)
+            perm[18+o] = 18 + (9-o)%9;
+        perm[27] = 29; perm[28] = 30;
+        perm[29] = 27; perm[30] = 28;
+
+        array<fhog_image> src_buffer;
+        const array<fhog_image>& src_feats = item.get_pyramid(src_buffer);
+        static thread_local array<fhog_image> temp;
+        array<fhog_image>& dst_feats = keeps_float_pyramid() ? feats : temp;
+        if (dst_feats.max_size() < src_feats.size())
+            dst_feats.set_max_size(src_feats.size());
+        dst_feats.set_size(src_feats.size());
+        for (unsigned long l = 0; l < src_feats.size(); ++l)
+        {
+            const fhog_image& src = src_feats[l];
+            fhog_image& dst = dst_feats[l];
+            if (dst.max_size() < src.size())
+                dst.set_max_size(src.size());
+            dst.set_size(src.size());
+            for (unsigned long o = 0; o < src.size(); ++o)
+            {
+                const array2d<float>& in = src[o];
+                array2d<float>& out = dst[perm[o]];
+                out.set_size(in.nr(), in.nc());
+                assign_all_pixels(out, 0);
+                const long hog_nc = in.nc() - width + 1;
+                for (long r = 0; r < in.nr(); ++r)
+                {
+                    for (long c = 0; c < hog_nc; ++c)
+                        out[r][off+hog_nc-1-c] = in[r][off+c];
+                }
+            }
+        }
+
+        loaded_upsampling = item.loaded_upsampling;
+        if (keeps_float_pyramid())
+            packed.clear();
+        else
+            store_pyramid(temp);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1170,7 +2644,7 @@ namespace dlib
     is_loaded_with_image (
     ) const
     {
-        return feats.size() != 0;
+        return feats.size() != 0 || packed.size() != 0;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1192,6 +2666,11 @@ namespace dlib
         min_pyramid_layer_width = item.min_pyramid_layer_width;
         min_pyramid_layer_height = item.min_pyramid_layer_height;
         nuclear_norm_regularization_strength = item.nuclear_norm_regularization_strength;
+        approximation = item.approximation;
+        virtual_upsampling_max_width = item.virtual_upsampling_max_width;
+        virtual_upsampling_max_height = item.virtual_upsampling_max_height;
+        storage = item.storage;
+        cache_directory = item.cache_directory;
         fe = item.fe;
     }
 
@@ -1305,10 +2784,13 @@ namespace dlib
 
             array2d<float> saliency_image;
             pyramid_type pyr;
+            detection_stats* stats = active_detection_stats();
+            stage_stopwatch stage_timer(stats != 0);
 
             // for all pyramid levels
             for (unsigned long l = 0; l < feats.size(); ++l)
             {
+                const unsigned long num_dets = dets.size();
                 const rectangle area = apply_filters_to_fhog(w, feats[l], saliency_image);
 
                 // now search the saliency image for any detections
@@ -1326,6 +2808,13 @@ namespace dlib
                         }
                     }
                 }
+
+                if (stats)
+                {
+                    detection_level_stats& level = stats->level(l);
+                    level.filter += stage_timer.lap();
+                    level.num_candidates += dets.size() - num_dets;
+                }
             }
 
             std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
@@ -1376,8 +2865,13 @@ namespace dlib
         unsigned long width, height;
         compute_fhog_window_size(width,height);
 
-        impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
+        // A compressed pyramid is expanded into a per-thread buffer that is only used
+        // for the duration of this call.  That way the trainer's threads don't contend
+        // with each other and each holds at most one full precision pyramid.
+        static thread_local array<fhog_image> buffer;
+        impl::detect_from_fhog_pyramid<pyramid_type>(get_pyramid(buffer), fe, w, thresh,
             height-2*padding, width-2*padding, cell_size, height, width, dets);
+        impl::fhog_virtual_rects_down(dets, loaded_upsampling);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1406,12 +2900,15 @@ namespace dlib
     void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
     get_mapped_rect_and_metadata (
         const unsigned long number_pyramid_levels,
-        const rectangle& rect,
+        const rectangle& image_rect,
         rectangle& mapped_rect,
         rectangle& fhog_rect,
         unsigned long& best_level
     ) const
     {
+        // The pyramid is that of the image upsampled by loaded_upsampling.
+        const unsigned long upsample = is_loaded_with_image() ? loaded_upsampling : 1;
+        const rectangle rect = impl::fhog_virtual_rect_up(image_rect, upsample);
         pyramid_type pyr;
         best_level = 0;
         double best_match_score = -1;
@@ -1440,6 +2937,7 @@ namespace dlib
                 break;
         }
         mapped_rect = pyr.rect_up(fe.feats_to_image(shrink_rect(fhog_rect,padding), cell_size,height,width),best_level);
+        mapped_rect = impl::fhog_virtual_rect_down(mapped_rect, upsample);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1487,6 +2985,29 @@ namespace dlib
         rectangle mapped_rect;
         unsigned long best_level;
         rectangle fhog_rect;
+        if (packed.size() != 0)
+        {
+            // Only one window is needed so read it straight out of the compressed
+            // pyramid rather than expanding the whole thing.
+            get_mapped_rect_and_metadata(packed.size(), obj.get_rect(), mapped_rect, fhog_rect, best_level);
+            const rectangle rect = packed.get_rect(best_level);
+            const impl::compressed_fhog_pyramid::level_view level = packed.get_level(best_level);
+            long i = 0;
+            for (unsigned long ii = 0; ii < packed.num_planes(best_level); ++ii)
+            {
+                for (long r = fhog_rect.top(); r <= fhog_rect.bottom(); ++r)
+                {
+                    for (long c = fhog_rect.left(); c <= fhog_rect.right(); ++c)
+                    {
+                        if (rect.contains(c,r))
+                            psi(i) += level(ii, r, c);
+                        ++i;
+                    }
+                }
+            }
+            return;
+        }
+
         get_mapped_rect_and_metadata(feats.size(), obj.get_rect(), mapped_rect, fhog_rect, best_level);
 
 
@@ -1506,6 +3027,99 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    score_windows (
+        const feature_vector_type& w,
+        const std::vector<rectangle>& rects,
+        std::vector<double>& scores
+    ) const
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_loaded_with_image() &&
+                    w.size() >= get_num_dimensions(),
+            "\t void scan_fhog_pyramid::score_windows()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+            << "\n\t w.size():               " << w.size()
+            << "\n\t get_num_dimensions():   " << get_num_dimensions()
+            << "\n\t this: " << this
+            );
+
+        // Same as get_feature_vector() followed by a dot product with w, but without
+        // copying each window into a feature vector first.
+        scores.resize(rects.size());
+        const unsigned long num_levels = (packed.size() != 0) ? packed.size() : feats.size();
+        for (unsigned long k = 0; k < rects.size(); ++k)
+        {
+            rectangle mapped_rect;
+            unsigned long best_level;
+            rectangle fhog_rect;
+            get_mapped_rect_and_metadata(num_levels, rects[k], mapped_rect, fhog_rect, best_level);
+
+            double score = 0;
+            long i = 0;
+            if (packed.size() != 0)
+            {
+                const rectangle rect = packed.get_rect(best_level);
+                const impl::compressed_fhog_pyramid::level_view level = packed.get_level(best_level);
+                for (unsigned long ii = 0; ii < packed.num_planes(best_level); ++ii)
+                {
+                    for (long r = fhog_rect.top(); r <= fhog_rect.bottom(); ++r)
+                    {
+                        for (long c = fhog_rect.left(); c <= fhog_rect.right(); ++c)
+                        {
+                            if (rect.contains(c,r))
+                                score += w(i)*level(ii, r, c);
+                            ++i;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                const fhog_image& level = feats[best_level];
+                const rectangle rect = get_rect(level[0]);
+                if (rect.contains(fhog_rect))
+                {
+                    // The usual case, no need to check every cell.
+                    const long width = fhog_rect.width();
+                    for (unsigned long ii = 0; ii < level.size(); ++ii)
+                    {
+                        for (long r = fhog_rect.top(); r <= fhog_rect.bottom(); ++r)
+                        {
+                            const float* row = &level[ii][r][fhog_rect.left()];
+                            for (long c = 0; c < width; ++c)
+                                score += w(i+c)*row[c];
+                            i += width;
+                        }
+                    }
+                }
+                else
+                {
+                    for (unsigned long ii = 0; ii < level.size(); ++ii)
+                    {
+                        for (long r = fhog_rect.top(); r <= fhog_rect.bottom(); ++r)
+                        {
+                            for (long c = fhog_rect.left(); c <= fhog_rect.right(); ++c)
+                            {
+                                if (rect.contains(c,r))
+                                    score += w(i)*level[ii][r][c];
+                                ++i;
+                            }
+                        }
+                    }
+                }
+            }
+            scores[k] = score;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1685,6 +3299,92 @@ namespace dlib
                                                                  detector_weights);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type
+        >
+    std::vector<float> estimate_fhog_power_law (
+        const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const image_array_type& images
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(images.size() > 0,
+            "\t std::vector<float> estimate_fhog_power_law()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t images.size(): " << images.size()
+            );
+
+        const feature_extractor_type& fe = scanner.get_feature_extractor();
+        const unsigned long num_planes = fe.get_num_planes();
+        const unsigned long height = scanner.get_fhog_window_height();
+        const unsigned long width = scanner.get_fhog_window_width();
+        float downscale_num, downscale_den;
+        impl::fhog_pyramid_downscale(Pyramid_type(), downscale_num, downscale_den);
+
+        // Every level is built twice, once recomputed from a resized image and once
+        // resampled straight from level 0, and the plane sums of both are added up over
+        // all the images.
+        fhog_pyramid_approximation recomputed = scanner.get_pyramid_approximation();
+        recomputed.exact = false;
+        recomputed.power_law_lambda.clear();
+        recomputed.schedule.assign(1, fhog_level_plan());
+        fhog_pyramid_approximation resampled = recomputed;
+
+        std::vector<std::vector<double> > sum_recomputed, sum_resampled;
+        array<array<array2d<float> > > feats_recomputed, feats_resampled;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            const unsigned long upsample = scanner.get_virtual_upsampling_factor(images[i]);
+            impl::create_fhog_pyramid<Pyramid_type>(images[i], fe, feats_recomputed, scanner.get_cell_size(),
+                height, width, scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+                scanner.get_max_pyramid_levels(), recomputed, upsample);
+            const unsigned long levels = feats_recomputed.size();
+            resampled.schedule.assign(levels, fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0));
+            resampled.schedule[0] = fhog_level_plan();
+            impl::create_fhog_pyramid<Pyramid_type>(images[i], fe, feats_resampled, scanner.get_cell_size(),
+                height, width, scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+                scanner.get_max_pyramid_levels(), resampled, upsample);
+
+            if (sum_recomputed.size() < levels)
+            {
+                sum_recomputed.resize(levels, std::vector<double>(num_planes, 0));
+                sum_resampled.resize(levels, std::vector<double>(num_planes, 0));
+            }
+            for (unsigned long l = 1; l < levels; ++l)
+            {
+                for (unsigned long p = 0; p < num_planes; ++p)
+                {
+                    sum_recomputed[l][p] += sum(matrix_cast<double>(mat(feats_recomputed[l][p])));
+                    sum_resampled[l][p] += sum(matrix_cast<double>(mat(feats_resampled[l][p])));
+                }
+            }
+        }
+
+        // The resampled level l is off from the recomputed one by about s^-lambda, s being
+        // its scale relative to level 0.  Fit lambda by least squares on the log of that
+        // ratio, through the origin since level 0 itself is exact.
+        std::vector<float> lambda(num_planes, 0);
+        for (unsigned long p = 0; p < num_planes; ++p)
+        {
+            double xy = 0, xx = 0;
+            for (unsigned long l = 1; l < sum_recomputed.size(); ++l)
+            {
+                if (sum_recomputed[l][p] <= 0 || sum_resampled[l][p] <= 0)
+                    continue;
+                const double x = l*std::log((double)downscale_num/downscale_den);
+                xy += x*std::log(sum_recomputed[l][p]/sum_resampled[l][p]);
+                xx += x*x;
+            }
+            if (xx != 0)
+                lambda[p] = -xy/xx;
+        }
+        return lambda;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1711,6 +3411,66 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename image_type
+        >
+    void load_left_right_flip (
+        scan_fhog_pyramid<Pyramid_type>& scanner,
+        const scan_fhog_pyramid<Pyramid_type>& loaded_scanner,
+        const image_type& 
+    )
+    {
+        scanner.load_left_right_flip(loaded_scanner);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    bool use_feature_store (
+        scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const std::shared_ptr<mapped_feature_store>& store
+    )
+    {
+        scanner.set_feature_store(store);
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void clear_training_settings (
+        scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner
+    )
+    {
+        scanner.set_feature_storage(FHOG_STORE_FLOAT32);
+        scanner.set_pyramid_cache_directory("");
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void score_detection_windows (
+        const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const matrix<double,0,1>& w,
+        const std::vector<rectangle>& rects,
+        std::vector<double>& scores
+    )
+    {
+        scanner.score_windows(w, rects, scores);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1758,7 +3518,10 @@ namespace dlib
         if (detectors.size() == 0)
             return;
 
+        impl::detection_stats_scope stats_scope(num_rows(img), num_columns(img));
+
         const unsigned long cell_size = detectors[0].get_scanner().get_cell_size();
+        const unsigned long upsample = detectors[0].get_scanner().get_virtual_upsampling_factor(img);
 
         // Find the maximum sized filters and also most extreme pyramiding settings used.
         unsigned long max_filter_width = 0;
@@ -1767,6 +3530,7 @@ namespace dlib
         unsigned long min_pyramid_layer_height = std::numeric_limits<unsigned long>::max();
         unsigned long max_pyramid_levels = 0;
         bool all_cell_sizes_the_same = true;
+        const fhog_pyramid_approximation& approximation = detectors[0].get_scanner().get_pyramid_approximation();
         for (unsigned long i = 0; i < detectors.size(); ++i)
         {
             const scanner_type& scanner = detectors[i].get_scanner();
@@ -1775,7 +3539,8 @@ namespace dlib
             max_pyramid_levels = std::max(max_pyramid_levels, scanner.get_max_pyramid_levels());
             min_pyramid_layer_width = std::min(min_pyramid_layer_width, scanner.get_min_pyramid_layer_width());
             min_pyramid_layer_height = std::min(min_pyramid_layer_height, scanner.get_min_pyramid_layer_height());
-            if (cell_size != scanner.get_cell_size())
+            if (cell_size != scanner.get_cell_size() || approximation != scanner.get_pyramid_approximation() ||
+                upsample != scanner.get_virtual_upsampling_factor(img))
                 all_cell_sizes_the_same = false;
         }
 
@@ -1790,19 +3555,21 @@ namespace dlib
             impl::create_fhog_pyramid<pyramid_type>(img,
                 detectors[0].get_scanner().get_feature_extractor(), feats, cell_size,
                 max_filter_height, max_filter_width, min_pyramid_layer_width,
-                min_pyramid_layer_height, max_pyramid_levels);
+                min_pyramid_layer_height, max_pyramid_levels, approximation, upsample);
         }
 
         std::vector<std::pair<double, rectangle> > temp_dets;
         for (unsigned long i = 0; i < detectors.size(); ++i)
         {
             const scanner_type& scanner = detectors[i].get_scanner();
+            const unsigned long scanner_upsample = scanner.get_virtual_upsampling_factor(img);
             if (!all_cell_sizes_the_same)
             {
                 impl::create_fhog_pyramid<pyramid_type>(img,
                     scanner.get_feature_extractor(), feats, scanner.get_cell_size(),
                     max_filter_height, max_filter_width, min_pyramid_layer_width,
-                    min_pyramid_layer_height, max_pyramid_levels);
+                    min_pyramid_layer_height, max_pyramid_levels, scanner.get_pyramid_approximation(),
+                    scanner_upsample);
             }
 
             const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
@@ -1817,6 +3584,7 @@ namespace dlib
                     detectors[i].get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
                     det_box_height, det_box_width, cell_size, max_filter_height,
                     max_filter_width, temp_dets);
+                impl::fhog_virtual_rects_down(temp_dets, scanner_upsample);
 
                 for (unsigned long j = 0; j < temp_dets.size(); ++j)
                 {
@@ -1831,6 +3599,8 @@ namespace dlib
 
 
         // Do non-max suppression
+        detection_stats* stats = impl::active_detection_stats();
+        impl::stage_stopwatch nms_timer(stats != 0);
         if (detectors.size() > 1)
             std::sort(dets_accum.rbegin(), dets_accum.rend());
         for (unsigned long i = 0; i < dets_accum.size(); ++i)
@@ -1841,6 +3611,14 @@ namespace dlib
 
             dets.push_back(dets_accum[i]);
         }
+
+        if (stats)
+        {
+            stats->nms_time += nms_timer.lap();
+            stats->num_candidates += dets_accum.size();
+            stats->num_detections += dets.size();
+        }
+        stats_scope.finish();
     }
 
 // ----------------------------------------------------------------------------------------
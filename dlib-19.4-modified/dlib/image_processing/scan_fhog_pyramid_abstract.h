@@ -6,6 +6,8 @@
 #include <vector>
 #include "../image_transforms/fhog_abstract.h"
 #include "object_detector_abstract.h"
+#include "../mapped_file/mapped_feature_store_abstract.h"
+#include <memory>
 
 namespace dlib
 {
@@ -35,6 +37,75 @@ namespace dlib
               cell.  The resulting image is then returned.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename image_type
+        >
+    void load_left_right_flip (
+        scan_fhog_pyramid<Pyramid_type>& scanner,
+        const scan_fhog_pyramid<Pyramid_type>& loaded_scanner,
+        const image_type& img
+    );
+    /*!
+        requires
+            - loaded_scanner.is_loaded_with_image() == true
+            - img is the image loaded_scanner was loaded with
+        ensures
+            - Overload of the generic load_left_right_flip() used by the
+              structural_svm_object_detection_problem.  It performs
+              scanner.load_left_right_flip(loaded_scanner) rather than flipping img and
+              extracting its features again.
+    !*/
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    bool use_feature_store (
+        scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const std::shared_ptr<mapped_feature_store>& store
+    );
+    /*!
+        ensures
+            - Overload of the generic use_feature_store() used by the
+              structural_svm_object_detection_problem.  It performs
+              scanner.set_feature_store(store) and returns true.
+    !*/
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void clear_training_settings (
+        scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner
+    );
+    /*!
+        ensures
+            - Overload of the generic clear_training_settings() used by the
+              structural_object_detection_trainer.
+            - #scanner.get_feature_storage() == FHOG_STORE_FLOAT32
+            - #scanner.get_pyramid_cache_directory() == ""
+    !*/
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void score_detection_windows (
+        const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const matrix<double,0,1>& w,
+        const std::vector<rectangle>& rects,
+        std::vector<double>& scores
+    );
+    /*!
+        ensures
+            - Overload of the generic score_detection_windows() used by the
+              structural_svm_object_detection_problem.  It performs
+              scanner.score_windows(w, rects, scores).
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -191,6 +262,200 @@ namespace dlib
         feature extractor.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_feature_storage
+    {
+        FHOG_STORE_FLOAT32,
+        FHOG_STORE_FLOAT16,
+        FHOG_STORE_UINT8
+    };
+    /*!
+        This enum selects how scan_fhog_pyramid keeps the fHOG pyramid of the image it
+        is loaded with.  See scan_fhog_pyramid::set_feature_storage() for details.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_downsample_mode
+    {
+        FHOG_DOWNSAMPLE_DIRECT,
+        FHOG_DOWNSAMPLE_PROGRESSIVE
+    };
+
+    std::string fhog_downsample_mode_name (
+        fhog_downsample_mode mode
+    );
+    /*!
+        ensures
+            - returns "Direct" or "Progressive"
+    !*/
+
+    enum fhog_level_source
+    {
+        FHOG_LEVEL_RECOMPUTE,
+        FHOG_LEVEL_RESAMPLE,
+        FHOG_LEVEL_SKIP
+    };
+
+    struct fhog_level_plan
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object says how one level of a scheduled fHOG pyramid is made (see
+                fhog_pyramid_approximation::schedule):
+                    - FHOG_LEVEL_RECOMPUTE: the histograms are extracted from a resized
+                      image.
+                    - FHOG_LEVEL_RESAMPLE: the histograms of level from are downsampled
+                      to the size of this level.
+                    - FHOG_LEVEL_SKIP: the level is left empty, so nothing is detected
+                      at its scale.
+        !*/
+
+        fhog_level_plan(
+        );
+        /*!
+            ensures
+                - source == FHOG_LEVEL_RECOMPUTE
+                - from == 0
+        !*/
+
+        fhog_level_plan(
+            fhog_level_source source,
+            unsigned long from = 0
+        );
+        /*!
+            ensures
+                - #source == source
+                - #from == from
+        !*/
+
+        fhog_level_source source;
+        unsigned long from;
+    };
+
+    bool operator== (const fhog_level_plan& a, const fhog_level_plan& b);
+    bool operator!= (const fhog_level_plan& a, const fhog_level_plan& b);
+    void serialize (const fhog_level_plan& item, std::ostream& out);
+    void deserialize (fhog_level_plan& item, std::istream& in);
+    /*!
+        provides comparison and serialization support.  from only matters to the
+        comparison for FHOG_LEVEL_RESAMPLE.
+    !*/
+
+    bool is_valid_fhog_schedule (
+        const std::vector<fhog_level_plan>& schedule
+    );
+    /*!
+        ensures
+            - returns true if every level of schedule can be built, i.e. schedule[0] is
+              not FHOG_LEVEL_SKIP and every FHOG_LEVEL_RESAMPLE level i has from < i and
+              schedule[from] is not FHOG_LEVEL_SKIP.  An empty schedule is valid.
+    !*/
+
+    std::string fhog_schedule_string (
+        const std::vector<fhog_level_plan>& schedule
+    );
+    /*!
+        ensures
+            - returns schedule as one token per level separated by spaces: "x" for
+              FHOG_LEVEL_RECOMPUTE, the from level for FHOG_LEVEL_RESAMPLE and "-" for
+              FHOG_LEVEL_SKIP.  E.g. "x 0 1 x -".
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct fhog_pyramid_approximation
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object selects how scan_fhog_pyramid builds the fHOG pyramid of an
+                image.  If exact is true every level is extracted from a resized image,
+                which is dlib's original scheme.  Otherwise level 0 is extracted from
+                the image and level i > 0 is either
+                    - extracted from a resized image, if i >= hybrid_level or
+                      i % exact_every == 0, or
+                    - made by downsampling the orientation histograms: from the last
+                      extracted level for FHOG_DOWNSAMPLE_DIRECT or from level i-1 for
+                      FHOG_DOWNSAMPLE_PROGRESSIVE.
+                use_simd selects the SIMD histogram downsampling kernels and
+                slow_downsampling resizes the image for every level, used or not (the
+                original research code's reference mode).  The histograms are scaled by
+                the ratio of the Pyramid_type, e.g. 4/5 for pyramid_down<5>.
+
+                The default values are the settings the paper's code shipped with.
+                Lower hybrid levels and exact_every values are more accurate and slower.
+
+                If schedule isn't empty (and exact is false) it replaces the rule above:
+                level i is made as schedule[i] says, and levels past the end of schedule
+                are recomputed.  Only use_simd still applies.  Scheduled pyramids keep
+                their histograms in buffers sized to the image, so they work for images
+                of any size.  fhog_tune finds a schedule for a detector and a CPU.
+
+                If power_law_lambda isn't empty (and exact is false) it holds one
+                exponent per feature plane, and plane p of every level made by
+                downsampling histograms is multiplied by s^-power_law_lambda[p] after
+                normalization, s being the scale of the level relative to the extracted
+                level its histograms came from (Dollar et al.'s power law).  This pulls
+                the downsampled levels toward what extracting them from a resized image
+                gives.  estimate_fhog_power_law() fits the exponents on a set of images.
+        !*/
+
+        fhog_pyramid_approximation(
+        );
+        /*!
+            ensures
+                - exact == false
+                - downsample == FHOG_DOWNSAMPLE_PROGRESSIVE
+                - use_simd == false
+                - slow_downsampling == false
+                - hybrid_level == 7
+                - exact_every == 3
+                - schedule.size() == 0
+                - power_law_lambda.size() == 0
+        !*/
+
+        bool exact;
+        fhog_downsample_mode downsample;
+        bool use_simd;
+        bool slow_downsampling;
+        unsigned long hybrid_level;
+        unsigned long exact_every;
+        std::vector<fhog_level_plan> schedule;
+        std::vector<float> power_law_lambda;
+    };
+
+    bool operator== (const fhog_pyramid_approximation& a, const fhog_pyramid_approximation& b);
+    bool operator!= (const fhog_pyramid_approximation& a, const fhog_pyramid_approximation& b);
+    void serialize (const fhog_pyramid_approximation& item, std::ostream& out);
+    void deserialize (fhog_pyramid_approximation& item, std::istream& in);
+    /*!
+        provides comparison and serialization support
+    !*/
+
+    std::ostream& operator<< (
+        std::ostream& out,
+        const fhog_pyramid_approximation& item
+    );
+    /*!
+        ensures
+            - prints all the settings of item on one line
+    !*/
+
+    std::vector<fhog_level_plan> fhog_pyramid_schedule (
+        const fhog_pyramid_approximation& approx,
+        unsigned long num_levels
+    );
+    /*!
+        ensures
+            - returns the schedule, num_levels long, of the pyramid approx describes:
+              approx.schedule padded with FHOG_LEVEL_RECOMPUTE if it isn't empty, all
+              FHOG_LEVEL_RECOMPUTE if approx.exact, and otherwise the levels the
+              hybrid_level, exact_every and downsample rule picks.  A copy of approx
+              with schedule set to this builds the same pyramid, unless
+              approx.slow_downsampling or approx.exact.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -218,6 +483,11 @@ namespace dlib
                 - get_min_pyramid_layer_width()  == 64
                 - get_min_pyramid_layer_height() == 64
                 - get_nuclear_norm_regularization_strength() == 0
+                - get_feature_storage() == FHOG_STORE_FLOAT32
+                - get_pyramid_cache_directory() == ""
+                - get_pyramid_approximation() == fhog_pyramid_approximation()
+                - get_virtual_upsampling_max_width()  == 0
+                - get_virtual_upsampling_max_height() == 0
 
             WHAT THIS OBJECT REPRESENTS
                 This object is a tool for running a fixed sized sliding window classifier
@@ -276,6 +546,39 @@ namespace dlib
                 - #is_loaded_with_image() == true
                 - This object is ready to run a classifier over img to detect object
                   locations.  Call detect() to do this.
+                - img may also be a yuyv_luma_image (see yuyv_image_abstract.h), in which
+                  case the luma of the camera frame is read in place and the result is
+                  the same as loading a copy of it.
+                - If a detection_stats_sink is set in the calling thread then the time
+                  spent on each stage of each pyramid level is recorded.  Outside of a
+                  detection the sink receives one record per call.
+        !*/
+
+        void load_left_right_flip (
+            const scan_fhog_pyramid& item
+        );
+        /*!
+            requires
+                - feature_extractor_type == default_fhog_feature_extractor
+                - item.is_loaded_with_image() == true
+                - item and *this have the same configuration (e.g. because one was
+                  set up with copy_configuration() from the other).
+                - &item != this
+            ensures
+                - Loads *this with the fHOG pyramid of the left-right mirror image of
+                  whatever image item was loaded with, without extracting any features
+                  again.  Every pyramid level of item has its cell columns reversed and
+                  its planes permuted the way a horizontal flip permutes them: signed
+                  orientation bin o becomes (9-o)%18, unsigned bin o becomes (9-o)%9
+                  and the texture planes 27,28 swap with 29,30.
+                - #is_loaded_with_image() == true
+                - The result is the same as load(flip_image_left_right(img)) up to two
+                  approximations.  First, a gradient lying exactly between two
+                  orientation bins (e.g. a perfectly vertical one) is always snapped to
+                  the lower bin, so its mirror doesn't land where a real flip would put
+                  it.  Second, the cell grid of a level is anchored to the left edge of
+                  the image.  So if the level's width isn't a multiple of the cell size
+                  the grid of the real flipped image is shifted by a fraction of a cell.
         !*/
 
         const feature_extractor_type& get_feature_extractor(
@@ -415,6 +718,8 @@ namespace dlib
         /*!
             requires
                 - new_cell_size > 0
+                - if (get_virtual_upsampling_max_width() != 0 && get_virtual_upsampling_max_height() != 0) then
+                    - new_cell_size is even
             ensures
                 - #get_cell_size() == new_cell_size
                 - #is_loaded_with_image() == false
@@ -617,6 +922,27 @@ namespace dlib
                   gets mapped to for feature extraction.
         !*/
 
+        void score_windows (
+            const feature_vector_type& w,
+            const std::vector<rectangle>& rects,
+            std::vector<double>& scores
+        ) const;
+        /*!
+            requires
+                - is_loaded_with_image() == true
+                - w.size() >= get_num_dimensions()
+            ensures
+                - #scores.size() == rects.size()
+                - for all valid i:
+                    - #scores[i] == dot(psi, w), where psi is the vector
+                      get_feature_vector(full_object_detection(rects[i]), psi) adds to a
+                      zero vector.  So for the rectangles detect() outputs these are the
+                      scores it gives them, up to rounding.
+                - This is much faster than calling get_feature_vector() for each
+                  rectangle since the windows are read straight out of the feature
+                  pyramid.
+        !*/
+
         full_object_detection get_full_object_detection (
             const rectangle& rect,
             const feature_vector_type& w
@@ -637,6 +963,11 @@ namespace dlib
                   not all possible rectangles can be represented.  Therefore, this function
                   allows you to supply a rectangle and obtain the nearest possible
                   candidate object location rectangle.
+                - If this object is loaded with an image that get_virtual_upsampling_factor()
+                  upsamples, rect and the returned rectangle are in the coordinates of that
+                  image, like everything else detect() and get_feature_vector() deal with,
+                  and the candidate locations are the ones of the virtually upsampled
+                  pyramid.  Otherwise they are the normal candidate locations.
         !*/
 
         double get_nuclear_norm_regularization_strength (
@@ -672,6 +1003,213 @@ namespace dlib
                 - #get_nuclear_norm_regularization_strength() == strength
         !*/
 
+        fhog_feature_storage get_feature_storage (
+        ) const;
+        /*!
+            ensures
+                - returns the form in which load() keeps the fHOG pyramid of an image:
+                    - FHOG_STORE_FLOAT32: as 32 bit floats.  This is the normal mode and
+                      is what you want for running a detector.
+                    - FHOG_STORE_FLOAT16: as IEEE half precision floats, which halves
+                      its memory use.  
+                    - FHOG_STORE_UINT8: as 8 bit values, each plane of each pyramid level
+                      linearly quantized between its smallest and largest value, which
+                      quarters its memory use.
+                - The two compressed modes exist for structural_object_detection_trainer,
+                  which keeps one loaded scanner per training image for the whole
+                  training run.  Those pyramids usually dominate its memory use, so
+                  compressing them lets you train on correspondingly larger datasets.
+                  detect() expands the pyramid into a per-thread buffer on every call
+                  (using F16C instructions when available) and get_feature_vector()
+                  reads the compressed values directly, so compression costs some
+                  speed and some precision in the features.  FLOAT16 keeps about 3
+                  significant decimal digits while UINT8 rounds each value to within
+                  1/510th of its plane's range.
+        !*/
+
+        void set_feature_storage (
+            fhog_feature_storage storage
+        );
+        /*!
+            ensures
+                - #get_feature_storage() == storage
+                - #is_loaded_with_image() == false
+                - Note that copy_configuration() copies this setting, so it applies to
+                  all the scanners structural_object_detection_trainer loads.  The
+                  detectors the trainer returns are set back to FHOG_STORE_FLOAT32 (see
+                  clear_training_settings()), so they don't compress and expand every
+                  image they are run on.  The setting is also saved by serialize(),
+                  along with a loaded pyramid in its compressed form, so a deserialized
+                  scanner has the same features.
+        !*/
+
+        const fhog_pyramid_approximation& get_pyramid_approximation (
+        ) const;
+        /*!
+            ensures
+                - returns the settings load() builds the fHOG pyramid with.
+        !*/
+
+        void set_pyramid_approximation (
+            const fhog_pyramid_approximation& approx
+        );
+        /*!
+            requires
+                - approx.exact_every > 0
+                - is_valid_fhog_schedule(approx.schedule) == true
+                - approx.power_law_lambda.size() == 0 or
+                  approx.power_law_lambda.size() == get_feature_extractor().get_num_planes()
+            ensures
+                - #get_pyramid_approximation() == approx
+                - #is_loaded_with_image() == false
+                - This setting is copied by copy_configuration() and saved by
+                  serialize(), so a detector keeps the settings it was tuned for.
+                  Scanners saved before the setting existed load with the default
+                  fhog_pyramid_approximation, which is what they were built with.
+        !*/
+
+        void set_virtual_upsampling (
+            unsigned long max_width,
+            unsigned long max_height
+        );
+        /*!
+            requires
+                - if (max_width != 0 && max_height != 0) then
+                    - get_cell_size() is even
+            ensures
+                - #get_virtual_upsampling_max_width() == max_width
+                - #get_virtual_upsampling_max_height() == max_height
+                - #is_loaded_with_image() == false
+                - If both are non-zero, load() treats every image no larger than
+                  max_width by max_height as if it had been upsampled 2x before being
+                  loaded, without ever making the bigger image.  The pyramid levels that
+                  would be bigger than the image are extracted from the image itself with
+                  a cell size of get_cell_size()/2, and every level from the image size
+                  down with the normal cell size.  So the detector scans the same scales
+                  and uses the same filters as one run on the upsampled image, while the
+                  gradients and histograms of the finest levels cost what the original
+                  image does.  detect(), get_feature_vector() and
+                  get_best_matching_rect() take and return rectangles in the coordinates
+                  of the image that was loaded, so a detector trained this way is trained
+                  and run on the original images.
+                - The features are not identical to those of a real upsampled image, whose
+                  interpolated gradients spread each edge over more orientation bins.
+                  Compare both on your data before switching a detector over.
+                - This setting is copied by copy_configuration() and saved by serialize().
+                  Scanners saved before it existed load with it disabled.
+        !*/
+
+        unsigned long get_virtual_upsampling_max_width (
+        ) const;
+        /*!
+            ensures
+                - returns the largest image width load() upsamples virtually.  See
+                  set_virtual_upsampling().
+        !*/
+
+        unsigned long get_virtual_upsampling_max_height (
+        ) const;
+        /*!
+            ensures
+                - returns the largest image height load() upsamples virtually.  See
+                  set_virtual_upsampling().
+        !*/
+
+        template <
+            typename image_type
+            >
+        unsigned long get_virtual_upsampling_factor (
+            const image_type& img
+        ) const;
+        /*!
+            ensures
+                - if (get_virtual_upsampling_max_width() != 0 &&
+                      get_virtual_upsampling_max_height() != 0 && img is not empty &&
+                      num_columns(img) <= get_virtual_upsampling_max_width() &&
+                      num_rows(img) <= get_virtual_upsampling_max_height()) then
+                    - returns 2, the factor load(img) upsamples img by.
+                - else
+                    - returns 1
+        !*/
+
+        const std::string& get_pyramid_cache_directory (
+        ) const;
+        /*!
+            ensures
+                - if (get_pyramid_cache_directory() != "") then
+                    - load() keeps a persistent cache of fHOG pyramids in this directory.
+                      Before extracting features, load() looks for a file named after a
+                      128 bit hash of the image's pixels and size, its pixel type, the
+                      Pyramid_type, the feature extractor's type and serialized state, the
+                      cell size, the fHOG window size (which sets the zero padding of each
+                      level), the minimum layer size, the maximum number of levels, the
+                      virtual upsampling factor and the serialized pyramid approximation
+                      settings, power law exponents included.  If the file exists its
+                      pyramid is used, otherwise the pyramid is extracted and written to
+                      the file.
+                      Changing any of those inputs therefore simply makes load() miss the
+                      cache rather than return stale features.  
+                    - Since copy_configuration() copies this setting, it also applies to
+                      the scanners structural_object_detection_trainer loads.  So repeated
+                      training runs on the same images, e.g. while searching over C or
+                      epsilon, only pay for feature extraction the first time.  The
+                      detectors the trainer returns don't use the cache (see
+                      clear_training_settings()).
+                    - Entries are written to a temporary file unique to the writing
+                      process and thread and then renamed, so any number of threads or
+                      processes can share a directory.  Nothing is ever evicted.  
+                - else
+                    - load() always extracts the features.
+        !*/
+
+        void set_pyramid_cache_directory (
+            const std::string& directory
+        );
+        /*!
+            requires
+                - directory is "" or the name of an existing, writable directory.
+            ensures
+                - #get_pyramid_cache_directory() == directory
+                - The setting is not saved by serialize().  Note that a detector returned
+                  by structural_object_detection_trainer inherits it and so caches the
+                  pyramid of every image it's run on.  That's handy for evaluating it on a
+                  fixed test set, but for a stream of new images build a detector from a
+                  scanner without the cache, e.g. 
+                    object_detector<S>(scanner, det.get_overlap_tester(), det.get_w()).
+                - If load() can't write a cache file it carries on with the pyramid it
+                  extracted, as if the cache had been missed.
+        !*/
+
+        const std::shared_ptr<mapped_feature_store>& get_feature_store (
+        ) const;
+        /*!
+            ensures
+                - returns the store load() puts the fHOG pyramid in, or a null pointer
+                  if the pyramid is kept in memory.  When a store is set, load() appends
+                  the pyramid, encoded according to get_feature_storage(), to the store
+                  as one block of page aligned sections, one per pyramid level, and keeps
+                  only their location.  detect() and get_feature_vector() then read it
+                  through the store's memory mapping.  Every detect() call also tells
+                  the store which block it is reading so the store can prefetch the
+                  block that usually gets read next.
+                - Several scanners can share one store, even when they are loaded from
+                  different threads.
+        !*/
+
+        void set_feature_store (
+            const std::shared_ptr<mapped_feature_store>& store
+        );
+        /*!
+            ensures
+                - #get_feature_store() == store
+                - #is_loaded_with_image() == false
+                - Unlike the rest of the configuration, the store is not copied by
+                  copy_configuration() nor saved by serialize().  It is meant for
+                  structural_object_detection_trainer::set_feature_store_file(), which
+                  gives each of its scanners the store itself, and shouldn't follow the
+                  scanner into a trained detector.
+        !*/
+
     };
 
 // ----------------------------------------------------------------------------------------
@@ -696,6 +1234,34 @@ namespace dlib
         provides deserialization support 
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type
+        >
+    std::vector<float> estimate_fhog_power_law (
+        const scan_fhog_pyramid<Pyramid_type,feature_extractor_type>& scanner,
+        const image_array_type& images
+    );
+    /*!
+        requires
+            - image_array_type == an implementation of array/array_kernel_abstract.h and
+              it must contain image objects which can be passed to scanner.load()
+            - images.size() > 0
+        ensures
+            - Builds the fHOG pyramid of every image twice with the settings of scanner,
+              once with every level extracted from a resized image and once with every
+              level downsampled from the histograms of level 0, and fits, per feature
+              plane, the power law exponent lambda for which the downsampled level l
+              matches the extracted one on average once multiplied by s^-lambda, s being
+              the scale of level l.
+            - returns the exponents, one per plane (i.e. a vector of
+              scanner.get_feature_extractor().get_num_planes() values), ready to be
+              assigned to fhog_pyramid_approximation::power_law_lambda.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
@@ -720,9 +1286,11 @@ namespace dlib
               faster than running each detector individually because it computes the HOG
               features only once and then reuses them for each detector.  However, it is
               important to note that this speedup is only possible if all the detectors use
-              the same cell_size parameter that determines how HOG features are computed.
-              If different cell_size values are used then this function will not be any
-              faster than running the detectors individually.
+              the same cell_size parameter and pyramid approximation settings that
+              determine how HOG features are computed.  If they differ then this function
+              will not be any faster than running the detectors individually.  The same
+              goes for detectors that virtually upsample img by different factors (see
+              scan_fhog_pyramid::get_virtual_upsampling_factor()).
             - This function applies non-max suppression individually to the output of each
               detector.  Therefore, the output is the same as if you ran each detector
               individually and then concatenated the results. 
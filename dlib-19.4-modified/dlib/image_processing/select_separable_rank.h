@@ -0,0 +1,342 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SELECT_SEPARABLE_RANK_Hh_
+#define DLIB_SELECT_SEPARABLE_RANK_Hh_
+
+#include "select_separable_rank_abstract.h"
+#include "scan_fhog_pyramid.h"
+#include "../svm/evaluate_object_detection_function.h"
+#include <vector>
+#include <algorithm>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct separable_rank_selection_report
+    {
+        separable_rank_selection_report(
+        ) :
+            baseline_ap(0),
+            ap(0),
+            baseline_num_filters(0),
+            num_filters(0),
+            baseline_seconds(0),
+            seconds(0),
+            num_evaluations(0)
+        {}
+
+        double baseline_ap;
+        double ap;
+        unsigned long baseline_num_filters;
+        unsigned long num_filters;
+        double baseline_seconds;
+        double seconds;
+        unsigned long num_evaluations;
+        std::vector<unsigned long> plane_ranks;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct plane_svd
+        {
+            matrix<double> u, w, v;
+            unsigned long full_rank;
+        };
+
+        template <
+            typename Pyramid_type,
+            typename feature_extractor_type
+            >
+        object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > truncate_filter_ranks (
+            const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+            const std::vector<plane_svd>& planes,
+            const std::vector<unsigned long>& ranks,
+            const unsigned long weight_index
+        )
+        /*!
+            requires
+                - planes.size() == ranks.size() == the number of fhog planes in detector
+                - planes[i] holds the rsorted SVD of plane i of detector.get_w(weight_index)
+            ensures
+                - returns a copy of detector where plane i of the weight_index-th filter
+                  has been replaced by its best rank ranks[i] approximation.
+        !*/
+        {
+            const unsigned long width = detector.get_scanner().get_fhog_window_width();
+            const unsigned long height = detector.get_scanner().get_fhog_window_height();
+            const long size = width*height;
+
+            std::vector<matrix<double,0,1> > detector_weights;
+            for (unsigned long j = 0; j < detector.num_detectors(); ++j)
+            {
+                matrix<double,0,1> weights = detector.get_w(j);
+
+                if (j == weight_index)
+                {
+                    matrix<double> f;
+                    for (unsigned long i = 0; i < planes.size(); ++i)
+                    {
+                        f = zeros_matrix<double>(height, width);
+                        for (unsigned long k = 0; k < ranks[i]; ++k)
+                            f += colm(planes[i].u,k)*planes[i].w(k)*trans(colm(planes[i].v,k));
+
+                        set_rowm(weights,range(i*size, (i+1)*size-1)) = reshape_to_column_vector(f);
+                    }
+                }
+                detector_weights.push_back(weights);
+            }
+
+            return object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >(detector.get_scanner(),
+                                                                     detector.get_overlap_tester(),
+                                                                     detector_weights);
+        }
+
+        template <
+            typename object_detector_type,
+            typename image_array_type,
+            typename truth_type
+            >
+        double timed_average_precision (
+            const object_detector_type& detector,
+            const image_array_type& images,
+            const std::vector<std::vector<truth_type> >& truth_dets,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& overlap_tester,
+            double& seconds
+        )
+        {
+            // One thread so the times of the candidates can be compared with each other.
+            // Unlike test_object_detection_function() this doesn't print anything, which
+            // matters since the search makes many evaluations.
+            const object_detection_evaluation eval = evaluate_object_detection_function(
+                detector, images, truth_dets, ignore, 1, overlap_tester);
+            seconds = eval.wall_seconds;
+            return eval.accuracy(2);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type,
+        typename truth_type
+        >
+    object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > select_separable_rank (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<truth_type> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const double max_ap_drop,
+        separable_rank_selection_report& report,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const bool refine_per_plane = true,
+        const unsigned long weight_index = 0
+    )
+    {
+        typedef object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > detector_type;
+
+        // make sure requires clause is not broken
+        DLIB_ASSERT(max_ap_drop >= 0 && images.size() == truth_dets.size() &&
+                    images.size() == ignore.size(),
+            "\t object_detector select_separable_rank()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t max_ap_drop:       " << max_ap_drop
+            << "\n\t images.size():     " << images.size()
+            << "\n\t truth_dets.size(): " << truth_dets.size()
+            << "\n\t ignore.size():     " << ignore.size()
+        );
+        DLIB_ASSERT(weight_index < detector.num_detectors(),
+            "\t object_detector select_separable_rank()"
+            << "\n\t Invalid arguments were given to this function. "
+            << "\n\t weight_index:             " << weight_index
+            << "\n\t detector.num_detectors(): " << detector.num_detectors()
+            );
+        DLIB_ASSERT(detector.get_w(weight_index).size() >= detector.get_scanner().get_num_dimensions() ,
+            "\t object_detector select_separable_rank()"
+            << "\n\t Invalid arguments were given to this function. "
+            << "\n\t detector.get_w(weight_index).size():         " << detector.get_w(weight_index).size()
+            << "\n\t detector.get_scanner().get_num_dimensions(): " << detector.get_scanner().get_num_dimensions()
+            );
+
+        const unsigned long width = detector.get_scanner().get_fhog_window_width();
+        const unsigned long height = detector.get_scanner().get_fhog_window_height();
+        const long num_planes = detector.get_scanner().get_feature_extractor().get_num_planes();
+        const long size = width*height;
+        const matrix<double,0,1>& weights = detector.get_w(weight_index);
+
+        // Decompose every plane once.  The rank of a plane is then just the number of
+        // leading singular triplets we keep, and full_rank matches what
+        // build_fhog_filterbank() would have kept for the untouched filter.
+        std::vector<impl::plane_svd> planes(num_planes);
+        std::vector<double> ratios;
+        for (long i = 0; i < num_planes; ++i)
+        {
+            matrix<double> f = reshape(rowm(weights, range(i*size, (i+1)*size-1)), height, width);
+            impl::plane_svd& p = planes[i];
+            svd3(f, p.u,p.w,p.v);
+            matrix<double> w2 = p.w;
+            rsort_columns(p.u,p.w);
+            rsort_columns(p.v,w2);
+
+            const double thresh = std::max(1e-4, max(p.w)*0.001);
+            p.full_rank = 0;
+            while (p.full_rank < (unsigned long)p.w.size() && p.w(p.full_rank) >= thresh)
+                ++p.full_rank;
+
+            for (unsigned long k = 0; k < p.full_rank; ++k)
+                ratios.push_back(p.w(k)/p.w(0));
+        }
+        std::sort(ratios.begin(), ratios.end());
+        ratios.erase(std::unique(ratios.begin(), ratios.end()), ratios.end());
+
+        // Level m of the global search drops every component whose singular value,
+        // relative to the largest one in its plane, is among the m smallest such ratios.
+        // This is the same family of filters threshold_filter_singular_values() produces.
+        std::vector<unsigned long> ranks(num_planes);
+        auto ranks_for_level = [&](unsigned long m)
+        {
+            for (long i = 0; i < num_planes; ++i)
+            {
+                ranks[i] = 0;
+                for (unsigned long k = 0; k < planes[i].full_rank; ++k)
+                {
+                    if (m == 0 || planes[i].w(k)/planes[i].w(0) > ratios[m-1])
+                        ++ranks[i];
+                }
+            }
+        };
+
+        report = separable_rank_selection_report();
+
+        detector_type best = detector;
+        report.baseline_ap = impl::timed_average_precision(best, images, truth_dets, ignore, overlap_tester, report.baseline_seconds);
+        report.baseline_num_filters = num_separable_filters(detector, weight_index);
+        report.num_evaluations = 1;
+        const double min_ap = report.baseline_ap - max_ap_drop;
+
+        ranks_for_level(0);
+        std::vector<unsigned long> best_ranks = ranks;
+        double best_ap = report.baseline_ap;
+        double best_seconds = report.baseline_seconds;
+
+        auto try_ranks = [&]()
+        {
+            detector_type cand = impl::truncate_filter_ranks(detector, planes, ranks, weight_index);
+            double secs;
+            const double ap = impl::timed_average_precision(cand, images, truth_dets, ignore, overlap_tester, secs);
+            ++report.num_evaluations;
+            if (ap < min_ap)
+                return false;
+
+            best = cand;
+            best_ranks = ranks;
+            best_ap = ap;
+            best_seconds = secs;
+            return true;
+        };
+
+        // Bisect on the global level.  Accuracy usually degrades monotonically as more
+        // components are removed, but every accepted detector has been measured so the
+        // constraint holds even when it doesn't.
+        unsigned long lo = 0, hi = ratios.size()+1;
+        while (hi - lo > 1)
+        {
+            const unsigned long mid = (lo + hi)/2;
+            ranks_for_level(mid);
+            if (try_ranks())
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        // Then greedily shave single components off individual planes, always trying
+        // the globally weakest remaining component first.  A plane is frozen as soon as
+        // removing its next component breaks the accuracy constraint.
+        if (refine_per_plane)
+        {
+            std::vector<bool> frozen(num_planes, false);
+            while (true)
+            {
+                long pick = -1;
+                double pick_ratio = 0;
+                for (long i = 0; i < num_planes; ++i)
+                {
+                    if (frozen[i] || best_ranks[i] == 0)
+                        continue;
+                    const double r = planes[i].w(best_ranks[i]-1)/planes[i].w(0);
+                    if (pick == -1 || r < pick_ratio)
+                    {
+                        pick = i;
+                        pick_ratio = r;
+                    }
+                }
+                if (pick == -1)
+                    break;
+
+                ranks = best_ranks;
+                --ranks[pick];
+                if (!try_ranks())
+                    frozen[pick] = true;
+            }
+        }
+
+        report.ap = best_ap;
+        report.seconds = best_seconds;
+        report.plane_ranks = best_ranks;
+        report.num_filters = num_separable_filters(best, weight_index);
+        return best;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type,
+        typename truth_type
+        >
+    object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > select_separable_rank (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<truth_type> >& truth_dets,
+        const double max_ap_drop,
+        separable_rank_selection_report& report,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const bool refine_per_plane = true,
+        const unsigned long weight_index = 0
+    )
+    {
+        std::vector<std::vector<rectangle> > ignore(images.size());
+        return select_separable_rank(detector, images, truth_dets, ignore, max_ap_drop,
+                                     report, overlap_tester, refine_per_plane, weight_index);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::ostream& operator<< (
+        std::ostream& out,
+        const separable_rank_selection_report& item
+    )
+    {
+        out << "average precision: " << item.baseline_ap << " -> " << item.ap << "\n";
+        out << "separable filters: " << item.baseline_num_filters << " -> " << item.num_filters << "\n";
+        out << "validation time:   " << item.baseline_seconds << "s -> " << item.seconds << "s\n";
+        out << "evaluations:       " << item.num_evaluations << "\n";
+        out << "plane ranks:      ";
+        for (unsigned long i = 0; i < item.plane_ranks.size(); ++i)
+            out << " " << item.plane_ranks[i];
+        out << "\n";
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SELECT_SEPARABLE_RANK_Hh_
+
@@ -0,0 +1,129 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_SELECT_SEPARABLE_RANK_ABSTRACT_Hh_
+#ifdef DLIB_SELECT_SEPARABLE_RANK_ABSTRACT_Hh_
+
+#include "scan_fhog_pyramid_abstract.h"
+#include "../svm/evaluate_object_detection_function_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct separable_rank_selection_report
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object summarizes what select_separable_rank() did to a detector.
+                All accuracy and timing numbers are measured on the validation set given
+                to select_separable_rank().
+        !*/
+
+        double baseline_ap;         // average precision of the input detector
+        double ap;                  // average precision of the returned detector
+        unsigned long baseline_num_filters; // num_separable_filters() of the input detector
+        unsigned long num_filters;  // num_separable_filters() of the returned detector
+        double baseline_seconds;    // wall time to run the input detector over the validation set
+        double seconds;             // wall time to run the returned detector over the validation set
+        unsigned long num_evaluations; // number of passes made over the validation set
+
+        // plane_ranks[i] == the number of separable filters kept in fhog plane i
+        std::vector<unsigned long> plane_ranks;
+    };
+
+    std::ostream& operator<< (
+        std::ostream& out,
+        const separable_rank_selection_report& item
+    );
+    /*!
+        ensures
+            - prints a human readable summary of item to out.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type,
+        typename truth_type
+        >
+    object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > select_separable_rank (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<truth_type> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const double max_ap_drop,
+        separable_rank_selection_report& report,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const bool refine_per_plane = true,
+        const unsigned long weight_index = 0
+    );
+    /*!
+        requires
+            - truth_type == rectangle or full_object_detection
+            - is_learning_problem(images,truth_dets) == true
+            - ignore.size() == images.size()
+            - max_ap_drop >= 0
+            - weight_index < detector.num_detectors()
+            - detector.get_w(weight_index).size() >= detector.get_scanner().get_num_dimensions()
+              (i.e. the detector must have been populated with a HOG filter)
+        ensures
+            - This function is an automatic replacement for picking the argument to
+              threshold_filter_singular_values() by hand.  It removes as many separable
+              filter components as it can from the weight_index-th filter of detector
+              while keeping the average precision on the given validation set within
+              max_ap_drop of the original detector's.
+            - The search first bisects over the global singular value threshold, i.e. over
+              the detectors threshold_filter_singular_values() would produce.  Then, if
+              refine_per_plane == true, it greedily lowers the rank of individual fhog
+              planes one component at a time, weakest component first, until no plane can
+              lose another component without violating the accuracy constraint.
+            - Each candidate is scored with evaluate_object_detection_function(detector,
+              images, truth_dets, ignore, 1, overlap_tester), which has the same accuracy
+              as test_object_detection_function() but prints nothing.  So the cost of
+              this function is report.num_evaluations single threaded passes over the
+              validation set.
+            - The search assumes accuracy falls off roughly monotonically as components
+              are removed.  It is therefore not guaranteed to find the smallest possible
+              detector, however, the returned detector always satisfies:
+                - report.ap >= report.baseline_ap - max_ap_drop
+            - Only average precision is constrained.  Removing filter components shifts
+              the detection scores, so precision and recall at a fixed adjust_threshold
+              may change more than the average precision does.
+            - #report contains the accuracy, number of separable filters, validation time,
+              and per-plane ranks of both the input and the returned detector.
+            - returns the compressed detector.  Filters other than the weight_index-th
+              one are left unchanged.
+    !*/
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type,
+        typename image_array_type,
+        typename truth_type
+        >
+    object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> > select_separable_rank (
+        const object_detector<scan_fhog_pyramid<Pyramid_type,feature_extractor_type> >& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<truth_type> >& truth_dets,
+        const double max_ap_drop,
+        separable_rank_selection_report& report,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const bool refine_per_plane = true,
+        const unsigned long weight_index = 0
+    );
+    /*!
+        ensures
+            - returns select_separable_rank(detector, images, truth_dets, ignore,
+              max_ap_drop, report, overlap_tester, refine_per_plane, weight_index)
+              where ignore is a set of empty ignore lists, one for each image.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SELECT_SEPARABLE_RANK_ABSTRACT_Hh_
+
@@ -0,0 +1,275 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_YUYV_IMAGE_Hh_
+#define DLIB_YUYV_IMAGE_Hh_
+
+#include "yuyv_image_abstract.h"
+#include "generic_image.h"
+#include "../algs.h"
+#include "../error.h"
+#include "../image_transforms/interpolation.h"
+#include "../mapped_file/mapped_file.h"
+#include <string>
+#include <sstream>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_luma_row
+    {
+        /*!
+            CONVENTION
+                - data points to the Y sample of column 0 of the row.  The Y sample of
+                  column c is data[2*c].
+        !*/
+    public:
+        explicit yuyv_luma_row (
+            const unsigned char* data_
+        ) : data(data_) {}
+
+        const unsigned char& operator[] (
+            long col
+        ) const { return data[2*col]; }
+
+    private:
+        const unsigned char* data;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_luma_image
+    {
+        /*!
+            CONVENTION
+                - _data points to the first byte of the frame, the Y sample of pixel (0,0).
+                - _row_bytes == the distance in bytes between the starts of two rows.
+        !*/
+    public:
+        typedef unsigned char type;
+        typedef default_memory_manager mem_manager_type;
+
+        yuyv_luma_image (
+        ) : _data(0), _row_bytes(0), _nr(0), _nc(0) {}
+
+        yuyv_luma_image (
+            const void* frame,
+            long nr_,
+            long nc_,
+            long row_bytes = 0
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(nr_ >= 0 && nc_ >= 0 && nc_%2 == 0 && row_bytes >= 0 &&
+                        (row_bytes == 0 || row_bytes >= 2*nc_) &&
+                        (frame != 0 || nr_*nc_ == 0),
+                "\t yuyv_luma_image::yuyv_luma_image()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t nr_:       " << nr_
+                << "\n\t nc_:       " << nc_
+                << "\n\t row_bytes: " << row_bytes
+                << "\n\t frame:     " << frame
+                );
+
+            _data = static_cast<const unsigned char*>(frame);
+            _nr = nr_;
+            _nc = nc_;
+            _row_bytes = row_bytes == 0 ? 2*nc_ : row_bytes;
+        }
+
+        long nr() const { return _nr; }
+        long nc() const { return _nc; }
+        unsigned long size () const { return static_cast<unsigned long>(_nr*_nc); }
+        long width_step() const { return _row_bytes; }
+        const unsigned char* frame() const { return _data; }
+
+        yuyv_luma_row operator[] (
+            long row
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 <= row && row < nr(),
+                "\t yuyv_luma_row yuyv_luma_image::operator[](row)"
+                << "\n\t you have asked for an out of bounds row "
+                << "\n\t row:  " << row
+                << "\n\t nr(): " << nr()
+                << "\n\t this: " << this
+                );
+
+            return yuyv_luma_row(_data + _row_bytes*row);
+        }
+
+    private:
+        const unsigned char* _data;
+        long _row_bytes;
+        long _nr;
+        long _nc;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+// Define the global functions that make yuyv_luma_image a read-only "generic image"
+// according to generic_image.h.  There is deliberately no image_data() or width_step(),
+// since the pixels aren't contiguous, so code that needs them (sub_image(), toMat(),
+// ...) doesn't compile rather than reading the chroma bytes as pixels.
+    template <>
+    struct image_traits<yuyv_luma_image>
+    {
+        typedef unsigned char pixel_type;
+    };
+
+    inline long num_rows( const yuyv_luma_image& img) { return img.nr(); }
+    inline long num_columns( const yuyv_luma_image& img) { return img.nc(); }
+
+// ----------------------------------------------------------------------------------------
+
+    template <>
+    class const_image_view<yuyv_luma_image>
+    {
+        /*!
+            The rows of a yuyv_luma_image aren't arrays of pixels, so unlike the general
+            const_image_view this one hands out a yuyv_luma_row for each row.  Everything
+            that only indexes a const_image_view with [row][column] (the fHOG feature
+            extraction, resize_image(), mat() and so assign_image()) therefore reads the Y
+            samples in place.
+        !*/
+    public:
+        typedef unsigned char pixel_type;
+
+        const_image_view(
+            const yuyv_luma_image& img
+        ) : _img(img) {}
+
+        long nr() const { return _img.nr(); }
+        long nc() const { return _img.nc(); }
+        unsigned long size() const { return _img.size(); }
+        yuyv_luma_row operator[] (long row) const { return _img[row]; }
+
+    private:
+        const yuyv_luma_image _img;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    typename enable_if<is_grayscale_image<image_type> >::type resize_image (
+        const yuyv_luma_image& in_img_,
+        image_type& out_img_,
+        interpolate_bilinear
+    )
+    {
+        // The same bilinear resize as for a grayscale image of the same pixel type, so
+        // the pyramid of a frame doesn't depend on whether it was copied out first.
+        const_image_view<yuyv_luma_image> in_img(in_img_);
+        image_view<image_type> out_img(out_img_);
+        impl::resize_grayscale_image_bilinear(in_img, out_img);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_frame_file : noncopyable
+    {
+        /*!
+            CONVENTION
+                - if (is_open()) then
+                    - file holds size() frames of 2*nr()*nc() bytes each, back to back.
+                - else
+                    - _nr == _nc == 0
+                    - _num_frames == 0
+        !*/
+    public:
+
+        yuyv_frame_file (
+        ) : _nr(0), _nc(0), _num_frames(0) {}
+
+        yuyv_frame_file (
+            const std::string& filename,
+            long nr_,
+            long nc_
+        ) : _nr(0), _nc(0), _num_frames(0)
+        {
+            open(filename, nr_, nc_);
+        }
+
+        void open (
+            const std::string& filename,
+            long nr_,
+            long nc_
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_CASSERT(nr_ > 0 && nc_ > 0 && nc_%2 == 0,
+                "\t void yuyv_frame_file::open()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t nr_: " << nr_
+                << "\n\t nc_: " << nc_
+                );
+
+            close();
+            file.open(filename);
+            const size_t frame_bytes = 2*nr_*nc_;
+            if (file.size() % frame_bytes != 0)
+            {
+                std::ostringstream sout;
+                sout << "The file " << filename << " of " << file.size() << " bytes doesn't hold a whole "
+                     << "number of " << nc_ << "x" << nr_ << " YUYV frames.";
+                file.close();
+                throw error(sout.str());
+            }
+            _nr = nr_;
+            _nc = nc_;
+            _num_frames = file.size()/frame_bytes;
+        }
+
+        void close (
+        )
+        {
+            file.close();
+            _nr = 0;
+            _nc = 0;
+            _num_frames = 0;
+        }
+
+        bool is_open (
+        ) const { return file.is_open(); }
+
+        long nr (
+        ) const { return _nr; }
+
+        long nc (
+        ) const { return _nc; }
+
+        unsigned long size (
+        ) const { return _num_frames; }
+
+        const yuyv_luma_image operator[] (
+            unsigned long idx
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(idx < size(),
+                "\t yuyv_luma_image yuyv_frame_file::operator[](idx)"
+                << "\n\t you have asked for an out of bounds frame "
+                << "\n\t idx:    " << idx
+                << "\n\t size(): " << size()
+                << "\n\t this:   " << this
+                );
+
+            return yuyv_luma_image(file.data() + idx*2*_nr*_nc, _nr, _nc);
+        }
+
+    private:
+        mapped_file file;
+        long _nr;
+        long _nc;
+        unsigned long _num_frames;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_YUYV_IMAGE_Hh_
+
@@ -0,0 +1,322 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_YUYV_IMAGE_ABSTRACT_Hh_
+#ifdef DLIB_YUYV_IMAGE_ABSTRACT_Hh_
+
+#include "generic_image.h"
+#include "../image_transforms/interpolation_abstract.h"
+#include "../mapped_file/mapped_file_abstract.h"
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_luma_row
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is one row of a yuyv_luma_image.  It is what
+                yuyv_luma_image::operator[] returns in place of the pixel pointer other
+                images return, since the Y samples of a row are every other byte.
+        !*/
+
+    public:
+
+        explicit yuyv_luma_row (
+            const unsigned char* data
+        );
+        /*!
+            ensures
+                - #(*this)[c] == data[2*c]
+        !*/
+
+        const unsigned char& operator[] (
+            long col
+        ) const;
+        /*!
+            ensures
+                - returns the Y sample of column col of the row.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_luma_image
+    {
+        /*!
+            INITIAL VALUE
+                - nr() == 0
+                - nc() == 0
+                - frame() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a read-only grayscale image over the luma of a packed 4:2:2
+                YUYV frame, the V4L2_PIX_FMT_YUYV layout most USB cameras deliver:
+                    Y0 U0 Y1 V0  Y2 U1 Y3 V1 ...
+                So the pixel at (r,c) is byte 2*c of row r.  Nothing is copied, the object
+                only points into the frame buffer, which must outlive it.
+
+                It implements the interface defined in generic_image.h, with
+                unsigned char pixels, except that it can't be resized or written to.  Its
+                rows aren't arrays of pixels, so dlib reads it through a specialization of
+                const_image_view whose operator[] returns a yuyv_luma_row.  That means it
+                can be given to everything that only reads images through
+                const_image_view, in particular scan_fhog_pyramid::load(),
+                object_detector, evaluate_detectors(), extract_fhog_features(),
+                resize_image(), pyramid_down and assign_image(), which all read the Y
+                samples in place.  Functions that need image_data(), a pointer to
+                contiguous pixels, don't compile with it.
+
+                This lets a detector run straight on a camera's mmap()ed V4L2 buffers,
+                without first copying the luma into an array2d.
+        !*/
+
+    public:
+        typedef unsigned char type;
+        typedef default_memory_manager mem_manager_type;
+
+        yuyv_luma_image (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        yuyv_luma_image (
+            const void* frame,
+            long nr,
+            long nc,
+            long row_bytes = 0
+        );
+        /*!
+            requires
+                - nr >= 0
+                - nc >= 0
+                - nc is even
+                - row_bytes == 0 or row_bytes >= 2*nc
+                - if (nr*nc != 0) then
+                    - frame points to a YUYV frame of nr rows, each starting row_bytes
+                      after the previous one (or 2*nc after it if row_bytes == 0).
+            ensures
+                - #nr() == nr
+                - #nc() == nc
+                - #frame() == frame
+                - if (row_bytes == 0) then
+                    - #width_step() == 2*nc
+                - else
+                    - #width_step() == row_bytes
+                      (V4L2 reports this as bytesperline, which some drivers pad)
+        !*/
+
+        long nr (
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows in this image
+        !*/
+
+        long nc (
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns in this image
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns nr()*nc()
+        !*/
+
+        long width_step (
+        ) const;
+        /*!
+            ensures
+                - returns the distance in bytes between the starts of two rows of the
+                  frame.
+        !*/
+
+        const unsigned char* frame (
+        ) const;
+        /*!
+            ensures
+                - returns a pointer to the first byte of the frame, the Y sample of pixel
+                  (0,0).
+        !*/
+
+        yuyv_luma_row operator[] (
+            long row
+        ) const;
+        /*!
+            requires
+                - 0 <= row < nr()
+            ensures
+                - returns row number row of the image.  (*this)[r][c] is the Y sample of
+                  pixel (r,c), for 0 <= c < nc().
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <>
+    struct image_traits<yuyv_luma_image>
+    {
+        typedef unsigned char pixel_type;
+    };
+
+    long num_rows (const yuyv_luma_image& img);
+    long num_columns (const yuyv_luma_image& img);
+    /*!
+        These return img.nr() and img.nc().  There is no image_data() or width_step()
+        for a yuyv_luma_image because its pixels aren't contiguous, so functions that
+        need them, such as sub_image() or toMat(), don't compile with it.
+    !*/
+
+    template <>
+    class const_image_view<yuyv_luma_image>;
+    /*!
+        The const_image_view of a yuyv_luma_image.  It has the interface of the general
+        const_image_view except that operator[] returns a yuyv_luma_row.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void resize_image (
+        const yuyv_luma_image& in_img,
+        image_type& out_img,
+        interpolate_bilinear
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h and has grayscale pixels.
+        ensures
+            - Resizes in_img to the size of out_img with the same bilinear interpolation
+              resize_image() uses for two grayscale images.  So the result is identical to
+              resizing a copy of in_img's luma, and so is the fHOG pyramid
+              scan_fhog_pyramid::load() builds from in_img.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_frame_file : noncopyable
+    {
+        /*!
+            INITIAL VALUE
+                - is_open() == false
+                - size() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a source of YUYV frames recorded to a file, meant for
+                testing and benchmarking code that runs on camera frames without a
+                camera.  The file holds raw frames of the same size back to back, with
+                no header, as written by e.g.
+                    v4l2-ctl --set-fmt-video=width=320,height=240,pixelformat=YUYV --stream-mmap --stream-to=frames.yuyv
+                    ffmpeg -i video.mp4 -s 320x240 -pix_fmt yuyv422 -f rawvideo frames.yuyv
+                The file is memory mapped (see mapped_file), so, like a V4L2 mmap()
+                buffer, each frame is handed out as a yuyv_luma_image over the mapped
+                bytes without being copied.
+        !*/
+
+    public:
+
+        yuyv_frame_file (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        yuyv_frame_file (
+            const std::string& filename,
+            long nr,
+            long nc
+        );
+        /*!
+            ensures
+                - performs open(filename, nr, nc)
+        !*/
+
+        void open (
+            const std::string& filename,
+            long nr,
+            long nc
+        );
+        /*!
+            requires
+                - nr > 0
+                - nc > 0
+                - nc is even
+            ensures
+                - closes any file this object had open and then opens filename as a
+                  sequence of nc by nr YUYV frames.
+                - #is_open() == true
+                - #nr() == nr
+                - #nc() == nc
+                - #size() == the number of frames in the file
+            throws
+                - dlib::error if the file can't be opened or its size isn't a multiple
+                  of the 2*nr*nc bytes of a frame.  If this happens #is_open() == false.
+        !*/
+
+        void close (
+        );
+        /*!
+            ensures
+                - #is_open() == false
+                - #size() == 0
+                - Every yuyv_luma_image previously obtained from this object becomes
+                  invalid.
+        !*/
+
+        bool is_open (
+        ) const;
+        /*!
+            ensures
+                - returns true if a file of frames is open.
+        !*/
+
+        long nr (
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows of each frame.
+        !*/
+
+        long nc (
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns of each frame.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of frames in the file.
+        !*/
+
+        const yuyv_luma_image operator[] (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - returns the luma of frame idx of the file.  It stays valid until this
+                  object is closed or destroyed.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_YUYV_IMAGE_ABSTRACT_Hh_
+
@@ -26,6 +26,8 @@ static_assert(FRAME_ALIGNMENT%SIMD_VECTOR_SIZE==0,
 static_assert(FRAME_WIDTH%FRAME_ALIGNMENT==0,
               "FRAME_WIDTH must be a multiple of FRAME_ALIGNMENT");
 
+// HISTO_CELL_SIZE is the cell size the HogBackend frame buffers are sized for and the
+// default of the MA_to_histo kernels, which work with any cell size.
 enum { HISTO_CELL_SIZE       =8,
        HISTO_BIN_WIDTH_SHIFT =5,
        HISTO_BIN_WIDTH       =1<<HISTO_BIN_WIDTH_SHIFT,
@@ -147,7 +149,8 @@ scalar_MA_to_histo(float *histo_out_aligned,
                    const uint8_t *m_in_aligned,
                    const uint8_t *a_in_aligned,
                    int width,
-                   int height);
+                   int height,
+                   int cell_size=HISTO_CELL_SIZE);
 
 SIMD_SECTION
 void
@@ -155,7 +158,8 @@ simd_MA_to_histo(float *histo_out_aligned,
                  const uint8_t *m_in_aligned,
                  const uint8_t *a_in_aligned,
                  int width,
-                 int height);
+                 int height,
+                 int cell_size=HISTO_CELL_SIZE);
 
 //----------------------------------------------------------------------------
 
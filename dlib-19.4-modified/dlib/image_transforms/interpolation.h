@@ -760,6 +760,102 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
+    namespace impl
+    {
+        template <
+            typename in_image_view_type,
+            typename out_image_view_type
+            >
+        void resize_grayscale_image_bilinear (
+            const in_image_view_type& in_img,
+            out_image_view_type& out_img
+        )
+        {
+            // The body of the grayscale resize_image() below.  It only indexes the views
+            // with [row][column], so image types whose const_image_view isn't a plain
+            // row pointer (e.g. yuyv_luma_image) can use it too.
+            if (out_img.nr() <= 1 || out_img.nc() <= 1)
+            {
+                assign_all_pixels(out_img, 0);
+                return;
+            }
+
+            typedef typename out_image_view_type::pixel_type T;
+            const double x_scale = (in_img.nc()-1)/(double)std::max<long>((out_img.nc()-1),1);
+            const double y_scale = (in_img.nr()-1)/(double)std::max<long>((out_img.nr()-1),1);
+            double y = -y_scale;
+            for (long r = 0; r < out_img.nr(); ++r)
+            {
+                y += y_scale;
+                const long top    = static_cast<long>(std::floor(y));
+                const long bottom = std::min(top+1, in_img.nr()-1);
+                const double tb_frac = y - top;
+                double x = -4*x_scale;
+
+                const simd4f _tb_frac = tb_frac;
+                const simd4f _inv_tb_frac = 1-tb_frac;
+                const simd4f _x_scale = 4*x_scale;
+                simd4f _x(x, x+x_scale, x+2*x_scale, x+3*x_scale);
+                long c = 0;
+                for (;; c+=4)
+                {
+                    _x += _x_scale;
+                    simd4i left = simd4i(_x);
+
+                    simd4f _lr_frac = _x-left;
+                    simd4f _inv_lr_frac = 1-_lr_frac; 
+                    simd4i right = left+1;
+
+                    simd4f tlf = _inv_tb_frac*_inv_lr_frac;
+                    simd4f trf = _inv_tb_frac*_lr_frac;
+                    simd4f blf = _tb_frac*_inv_lr_frac;
+                    simd4f brf = _tb_frac*_lr_frac;
+
+                    int32 fleft[4];
+                    int32 fright[4];
+                    left.store(fleft);
+                    right.store(fright);
+
+                    if (fright[3] >= in_img.nc())
+                        break;
+                    simd4f tl(in_img[top][fleft[0]],     in_img[top][fleft[1]],     in_img[top][fleft[2]],     in_img[top][fleft[3]]);
+                    simd4f tr(in_img[top][fright[0]],    in_img[top][fright[1]],    in_img[top][fright[2]],    in_img[top][fright[3]]);
+                    simd4f bl(in_img[bottom][fleft[0]],  in_img[bottom][fleft[1]],  in_img[bottom][fleft[2]],  in_img[bottom][fleft[3]]);
+                    simd4f br(in_img[bottom][fright[0]], in_img[bottom][fright[1]], in_img[bottom][fright[2]], in_img[bottom][fright[3]]);
+
+                    simd4i out = simd4i(tlf*tl + trf*tr + blf*bl + brf*br);
+                    int32 fout[4];
+                    out.store(fout);
+
+                    out_img[r][c]   = static_cast<T>(fout[0]);
+                    out_img[r][c+1] = static_cast<T>(fout[1]);
+                    out_img[r][c+2] = static_cast<T>(fout[2]);
+                    out_img[r][c+3] = static_cast<T>(fout[3]);
+                }
+                x = -x_scale + c*x_scale;
+                for (; c < out_img.nc(); ++c)
+                {
+                    x += x_scale;
+                    const long left   = static_cast<long>(std::floor(x));
+                    const long right  = std::min(left+1, in_img.nc()-1);
+                    const float lr_frac = x - left;
+
+                    float tl = 0, tr = 0, bl = 0, br = 0;
+
+                    assign_pixel(tl, in_img[top][left]);
+                    assign_pixel(tr, in_img[top][right]);
+                    assign_pixel(bl, in_img[bottom][left]);
+                    assign_pixel(br, in_img[bottom][right]);
+
+                    float temp = (1-tb_frac)*((1-lr_frac)*tl + lr_frac*tr) + 
+                        tb_frac*((1-lr_frac)*bl + lr_frac*br);
+
+                    assign_pixel(out_img[r][c], temp);
+                }
+            }
+        }
+    }
+
     template <
         typename image_type
         >
@@ -778,86 +874,7 @@ namespace dlib
 
         const_image_view<image_type> in_img(in_img_);
         image_view<image_type> out_img(out_img_);
-
-        if (out_img.nr() <= 1 || out_img.nc() <= 1)
-        {
-            assign_all_pixels(out_img, 0);
-            return;
-        }
-
-        typedef typename image_traits<image_type>::pixel_type T;
-        const double x_scale = (in_img.nc()-1)/(double)std::max<long>((out_img.nc()-1),1);
-        const double y_scale = (in_img.nr()-1)/(double)std::max<long>((out_img.nr()-1),1);
-        double y = -y_scale;
-        for (long r = 0; r < out_img.nr(); ++r)
-        {
-            y += y_scale;
-            const long top    = static_cast<long>(std::floor(y));
-            const long bottom = std::min(top+1, in_img.nr()-1);
-            const double tb_frac = y - top;
-            double x = -4*x_scale;
-
-            const simd4f _tb_frac = tb_frac;
-            const simd4f _inv_tb_frac = 1-tb_frac;
-            const simd4f _x_scale = 4*x_scale;
-            simd4f _x(x, x+x_scale, x+2*x_scale, x+3*x_scale);
-            long c = 0;
-            for (;; c+=4)
-            {
-                _x += _x_scale;
-                simd4i left = simd4i(_x);
-
-                simd4f _lr_frac = _x-left;
-                simd4f _inv_lr_frac = 1-_lr_frac; 
-                simd4i right = left+1;
-
-                simd4f tlf = _inv_tb_frac*_inv_lr_frac;
-                simd4f trf = _inv_tb_frac*_lr_frac;
-                simd4f blf = _tb_frac*_inv_lr_frac;
-                simd4f brf = _tb_frac*_lr_frac;
-
-                int32 fleft[4];
-                int32 fright[4];
-                left.store(fleft);
-                right.store(fright);
-
-                if (fright[3] >= in_img.nc())
-                    break;
-                simd4f tl(in_img[top][fleft[0]],     in_img[top][fleft[1]],     in_img[top][fleft[2]],     in_img[top][fleft[3]]);
-                simd4f tr(in_img[top][fright[0]],    in_img[top][fright[1]],    in_img[top][fright[2]],    in_img[top][fright[3]]);
-                simd4f bl(in_img[bottom][fleft[0]],  in_img[bottom][fleft[1]],  in_img[bottom][fleft[2]],  in_img[bottom][fleft[3]]);
-                simd4f br(in_img[bottom][fright[0]], in_img[bottom][fright[1]], in_img[bottom][fright[2]], in_img[bottom][fright[3]]);
-
-                simd4i out = simd4i(tlf*tl + trf*tr + blf*bl + brf*br);
-                int32 fout[4];
-                out.store(fout);
-
-                out_img[r][c]   = static_cast<T>(fout[0]);
-                out_img[r][c+1] = static_cast<T>(fout[1]);
-                out_img[r][c+2] = static_cast<T>(fout[2]);
-                out_img[r][c+3] = static_cast<T>(fout[3]);
-            }
-            x = -x_scale + c*x_scale;
-            for (; c < out_img.nc(); ++c)
-            {
-                x += x_scale;
-                const long left   = static_cast<long>(std::floor(x));
-                const long right  = std::min(left+1, in_img.nc()-1);
-                const float lr_frac = x - left;
-
-                float tl = 0, tr = 0, bl = 0, br = 0;
-
-                assign_pixel(tl, in_img[top][left]);
-                assign_pixel(tr, in_img[top][right]);
-                assign_pixel(bl, in_img[bottom][left]);
-                assign_pixel(br, in_img[bottom][right]);
-
-                float temp = (1-tb_frac)*((1-lr_frac)*tl + lr_frac*tr) + 
-                    tb_frac*((1-lr_frac)*bl + lr_frac*br);
-
-                assign_pixel(out_img[r][c], temp);
-            }
-        }
+        impl::resize_grayscale_image_bilinear(in_img, out_img);
     }
 
 // ----------------------------------------------------------------------------------------
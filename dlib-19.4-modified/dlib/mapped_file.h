@@ -0,0 +1,9 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FILe_
+#define DLIB_MAPPED_FILe_
+
+#include "mapped_file/mapped_file.h"
+#include "mapped_file/mapped_feature_store.h"
+
+#endif // DLIB_MAPPED_FILe_
+
@@ -0,0 +1,216 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FEATURE_STORE_Hh_
+#define DLIB_MAPPED_FEATURE_STORE_Hh_
+
+#include "mapped_feature_store_abstract.h"
+#include "../algs.h"
+#include "../platform.h"
+#include "../error.h"
+#include "../uintn.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+
+#ifdef POSIX
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_feature_store : noncopyable
+    {
+        /*!
+            CONVENTION
+                - allocated == size()
+                - On POSIX systems:
+                    - fd is the open file.
+                    - maps contains every mapping of the file ever made, each one
+                      larger than the one before.  They are only released by the
+                      destructor so pointers handed out by data() stay valid.
+                - Otherwise:
+                    - blocks[offset] holds the contents of the block allocated at offset.
+                - next[offset] == the block some thread read right after the block at
+                  offset, the last time that happened.
+        !*/
+
+    public:
+
+        const static uint64 page_size = 4096;
+
+        explicit mapped_feature_store (
+            const std::string& filename_
+        ) : filename(filename_), allocated(0)
+        {
+#ifdef POSIX
+            fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (fd == -1)
+                throw error("Unable to create feature store file " + filename + ".");
+#else
+            std::FILE* f = std::fopen(filename.c_str(), "wb");
+            if (f == 0)
+                throw error("Unable to create feature store file " + filename + ".");
+            std::fclose(f);
+#endif
+        }
+
+        ~mapped_feature_store (
+        )
+        {
+#ifdef POSIX
+            for (unsigned long i = 0; i < maps.size(); ++i)
+                munmap(maps[i].first, maps[i].second);
+            ::close(fd);
+#endif
+            std::remove(filename.c_str());
+        }
+
+        const std::string& get_filename (
+        ) const { return filename; }
+
+        uint64 size (
+        ) const
+        {
+            std::lock_guard<std::mutex> lock(m);
+            return allocated;
+        }
+
+        uint64 allocate (
+            uint64 num_bytes
+        )
+        {
+            std::lock_guard<std::mutex> lock(m);
+            const uint64 offset = allocated;
+            allocated += (num_bytes + page_size - 1)/page_size*page_size;
+#ifndef POSIX
+            blocks[offset].resize(num_bytes);
+#endif
+            return offset;
+        }
+
+        void write (
+            uint64 offset,
+            const void* data,
+            uint64 num_bytes
+        )
+        {
+#ifdef POSIX
+            const char* p = static_cast<const char*>(data);
+            while (num_bytes != 0)
+            {
+                const ssize_t n = ::pwrite(fd, p, num_bytes, offset);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    throw error("Unable to write to feature store file " + filename + ".");
+                p += n;
+                offset += n;
+                num_bytes -= n;
+            }
+#else
+            std::lock_guard<std::mutex> lock(m);
+            std::map<uint64,std::vector<char> >::iterator i = --blocks.upper_bound(offset);
+            std::memcpy(&i->second[offset - i->first], data, num_bytes);
+#endif
+        }
+
+        const char* data (
+            uint64 offset,
+            uint64 num_bytes
+        ) const
+        {
+            std::lock_guard<std::mutex> lock(m);
+            return data_locked(offset, num_bytes);
+        }
+
+        void note_access (
+            uint64 offset,
+            uint64 num_bytes
+        ) const
+        {
+            // The last block read by each thread.  The store pointer guards against
+            // mixing up the blocks of different stores.
+            static thread_local const mapped_feature_store* last_store = 0;
+            static thread_local uint64 last_offset = 0;
+
+            const char* ahead = 0;
+            uint64 ahead_bytes = 0;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (last_store == this && last_offset != offset)
+                    next[last_offset] = std::make_pair(offset, num_bytes);
+
+                std::map<uint64,std::pair<uint64,uint64> >::const_iterator i = next.find(offset);
+                if (i != next.end())
+                {
+                    ahead = data_locked(i->second.first, i->second.second);
+                    ahead_bytes = i->second.second;
+                }
+            }
+            last_store = this;
+            last_offset = offset;
+
+#ifdef POSIX
+            if (ahead != 0)
+                madvise(const_cast<char*>(ahead), ahead_bytes, MADV_WILLNEED);
+#else
+            (void)ahead_bytes;
+#endif
+        }
+
+    private:
+
+        const char* data_locked (
+            uint64 offset,
+            uint64 num_bytes
+        ) const
+        {
+#ifdef POSIX
+            if (maps.size() == 0 || maps.back().second < offset + num_bytes)
+            {
+                // Map more than is needed right now.  Growing the mapping
+                // geometrically means the file gets mapped only O(log(size)) times
+                // even if reads are interleaved with writes.  Mapping past the end of
+                // the file is fine so long as nobody touches those pages.
+                uint64 len = std::max<uint64>(offset + num_bytes, maps.size() != 0 ? 2*maps.back().second : 0);
+                len = (len + page_size - 1)/page_size*page_size;
+                void* p = mmap(0, len, PROT_READ, MAP_SHARED, fd, 0);
+                if (p == MAP_FAILED)
+                    throw error("Unable to map feature store file " + filename + ".");
+                maps.push_back(std::make_pair(static_cast<char*>(p), len));
+            }
+            return maps.back().first + offset;
+#else
+            (void)num_bytes;
+            std::map<uint64,std::vector<char> >::const_iterator i = --blocks.upper_bound(offset);
+            return &i->second[0] + (offset - i->first);
+#endif
+        }
+
+        const std::string filename;
+        uint64 allocated;
+        mutable std::mutex m;
+        mutable std::map<uint64,std::pair<uint64,uint64> > next;
+#ifdef POSIX
+        int fd;
+        mutable std::vector<std::pair<char*,uint64> > maps;
+#else
+        std::map<uint64,std::vector<char> > blocks;
+#endif
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FEATURE_STORE_Hh_
+
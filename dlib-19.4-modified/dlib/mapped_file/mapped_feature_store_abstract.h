@@ -0,0 +1,136 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MAPPED_FEATURE_STORE_ABSTRACT_Hh_
+#ifdef DLIB_MAPPED_FEATURE_STORE_ABSTRACT_Hh_
+
+#include "../uintn.h"
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_feature_store : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is an append-only scratch file for large blocks of
+                precomputed features, e.g. the fHOG pyramids of every image in a
+                training set.  Blocks are written once, then read back through a
+                read-only memory mapping, so they live in the OS page cache rather
+                than in the process' heap and the OS is free to evict them when memory
+                runs short.  This lets a program work on far more feature data than
+                fits in RAM, at the price of disk reads for whatever isn't cached.
+
+                Every block starts on a page boundary so that the blocks of different
+                images never share pages.
+
+                On systems without mmap() the blocks are instead kept in memory, which
+                keeps the interface working but gives no memory savings.
+
+            THREAD SAFETY
+                All member functions may be called concurrently.  However, a block
+                must be completely written by write() before anyone reads it.
+        !*/
+
+    public:
+
+        const static uint64 page_size = 4096;
+
+        explicit mapped_feature_store (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - creates filename, truncating it if it already exists, and uses it to
+                  hold the blocks.
+                - #size() == 0
+                - #get_filename() == filename
+            throws
+                - dlib::error if the file can't be created.
+        !*/
+
+        ~mapped_feature_store (
+        );
+        /*!
+            ensures
+                - unmaps and deletes the file.  Any pointers obtained from data()
+                  become invalid.
+        !*/
+
+        const std::string& get_filename (
+        ) const;
+        /*!
+            ensures
+                - returns the name of the file backing this store.
+        !*/
+
+        uint64 size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bytes allocated so far.  This is the size the
+                  file will have once all allocated blocks have been written.
+        !*/
+
+        uint64 allocate (
+            uint64 num_bytes
+        );
+        /*!
+            ensures
+                - reserves a block of num_bytes bytes and returns its offset in the
+                  file.  The offset is a multiple of page_size.
+                - #size() == size() + num_bytes rounded up to a multiple of page_size
+        !*/
+
+        void write (
+            uint64 offset,
+            const void* data,
+            uint64 num_bytes
+        );
+        /*!
+            requires
+                - [offset, offset+num_bytes) lies inside a block returned by allocate().
+            ensures
+                - copies num_bytes bytes from data into the file at offset.
+            throws
+                - dlib::error if the write fails (e.g. the disk is full).
+        !*/
+
+        const char* data (
+            uint64 offset,
+            uint64 num_bytes
+        ) const;
+        /*!
+            requires
+                - [offset, offset+num_bytes) has been completely written by write().
+            ensures
+                - returns a pointer to the num_bytes bytes at offset.  The pointer
+                  remains valid for the lifetime of *this.
+            throws
+                - dlib::error if the file can't be mapped.
+        !*/
+
+        void note_access (
+            uint64 offset,
+            uint64 num_bytes
+        ) const;
+        /*!
+            requires
+                - [offset, offset+num_bytes) has been completely written by write().
+            ensures
+                - Tells the store that the calling thread is about to read the given
+                  block.  The store remembers which block each thread read after it
+                  the last time around and asks the OS to start reading that one in
+                  (i.e. madvise(MADV_WILLNEED)).  So when the blocks are visited in the
+                  same order over and over, as a training algorithm's passes over its
+                  data are, each read overlaps with the disk read of the next one.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FEATURE_STORE_ABSTRACT_Hh_
+
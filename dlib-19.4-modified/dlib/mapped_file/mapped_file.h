@@ -0,0 +1,170 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FILE_KERNEl_1_
+#define DLIB_MAPPED_FILE_KERNEl_1_
+
+#include "mapped_file_abstract.h"
+#include "../algs.h"
+#include "../platform.h"
+#include "../error.h"
+#include <string>
+#include <fstream>
+#include <cstdlib>
+
+#ifdef POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file : noncopyable
+    {
+        /*!
+            INITIAL VALUE
+                - ptr == 0
+                - length == 0
+                - owned == 0
+
+            CONVENTION
+                - if (the file is open) then
+                    - ptr points to the first of length bytes of file contents
+                    - if (owned != 0) then
+                        - the contents were read into owned, an over-allocated heap
+                          buffer, and ptr is owned rounded up to a page boundary.
+                    - else
+                        - ptr is the address returned by mmap()
+                - is_open() == (ptr != 0)
+        !*/
+
+    public:
+
+        mapped_file (
+        ) : ptr(0), length(0), owned(0) {}
+
+        explicit mapped_file (
+            const std::string& filename
+        ) : ptr(0), length(0), owned(0) { open(filename); }
+
+        ~mapped_file (
+        ) { close(); }
+
+        void open (
+            const std::string& filename
+        )
+        {
+            close();
+#ifdef POSIX
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd == -1)
+                throw error("Unable to open " + filename + " for reading.");
+
+            struct stat info;
+            if (fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                throw error("Unable to stat " + filename + ".");
+            }
+
+            length = info.st_size;
+            if (length != 0)
+            {
+                void* p = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    ::close(fd);
+                    ptr = static_cast<const char*>(p);
+                    return;
+                }
+            }
+            ::close(fd);
+#endif
+            read_into_buffer(filename);
+        }
+
+        void close (
+        )
+        {
+#ifdef POSIX
+            if (ptr != 0 && owned == 0)
+                munmap(const_cast<char*>(ptr), length);
+#endif
+            delete [] owned;
+            ptr = 0;
+            length = 0;
+            owned = 0;
+        }
+
+        bool is_open (
+        ) const { return ptr != 0; }
+
+        bool is_memory_mapped (
+        ) const { return ptr != 0 && owned == 0; }
+
+        const char* data (
+        ) const { return ptr; }
+
+        size_t size (
+        ) const { return length; }
+
+        void swap (
+            mapped_file& item
+        )
+        {
+            exchange(ptr, item.ptr);
+            exchange(length, item.length);
+            exchange(owned, item.owned);
+        }
+
+    private:
+
+        const static size_t page_size = 4096;
+
+        void read_into_buffer (
+            const std::string& filename
+        )
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            if (!fin)
+                throw error("Unable to open " + filename + " for reading.");
+
+            fin.seekg(0, std::ios::end);
+            const size_t size = fin.tellg();
+            fin.seekg(0, std::ios::beg);
+
+            // Keep the same alignment guarantee as mmap() so callers can lay their
+            // files out for SIMD loads without caring which path was taken.
+            owned = new char[size + page_size];
+            char* aligned = owned + (page_size - reinterpret_cast<size_t>(owned)%page_size)%page_size;
+            fin.read(aligned, size);
+            if (!fin)
+            {
+                delete [] owned;
+                owned = 0;
+                throw error("Unable to read " + filename + ".");
+            }
+
+            ptr = aligned;
+            length = size;
+        }
+
+        const char* ptr;
+        size_t length;
+        char* owned;
+    };
+
+    inline void swap (
+        mapped_file& a,
+        mapped_file& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FILE_KERNEl_1_
+
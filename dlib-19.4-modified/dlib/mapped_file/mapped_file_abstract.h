@@ -0,0 +1,133 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MAPPED_FILE_KERNEl_ABSTRACT_
+#ifdef DLIB_MAPPED_FILE_KERNEl_ABSTRACT_
+
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file : noncopyable
+    {
+        /*!
+            INITIAL VALUE
+                - is_open() == false
+                - size() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object gives read-only access to the contents of a file as one
+                contiguous block of memory.  On POSIX systems the file is mapped with
+                mmap() so that several processes opening the same file share its pages
+                in the OS page cache and nothing is read until it is touched.  When
+                mmap() isn't available, or fails, the file is instead read into a heap
+                buffer.  Either way data() is aligned to at least a 4096 byte boundary.
+        !*/
+
+    public:
+
+        mapped_file (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        explicit mapped_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - performs open(filename)
+            throws
+                - dlib::error if the file can't be opened or read
+        !*/
+
+        ~mapped_file (
+        );
+        /*!
+            ensures
+                - performs close()
+        !*/
+
+        void open (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - closes any file this object had open and then opens filename.
+                - #is_open() == true
+                - #size() == the size of the file in bytes
+                - #data() points to the contents of the file
+            throws
+                - dlib::error if the file can't be opened or read.  If this happens
+                  #is_open() == false.
+        !*/
+
+        void close (
+        );
+        /*!
+            ensures
+                - releases the mapping or buffer held by this object.  Any pointers
+                  previously obtained from data() become invalid.
+                - #is_open() == false
+                - #size() == 0
+        !*/
+
+        bool is_open (
+        ) const;
+        /*!
+            ensures
+                - returns true if this object currently holds the contents of a file.
+        !*/
+
+        bool is_memory_mapped (
+        ) const;
+        /*!
+            ensures
+                - returns true if the file is open and data() points into an mmap()ed
+                  region rather than a heap copy of the file.
+        !*/
+
+        const char* data (
+        ) const;
+        /*!
+            ensures
+                - if (is_open()) then
+                    - returns a pointer to the size() bytes of the file.  The pointer is
+                      aligned to at least 4096 bytes.
+                - else
+                    - returns 0
+        !*/
+
+        size_t size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bytes in the open file.
+        !*/
+
+        void swap (
+            mapped_file& item
+        );
+        /*!
+            ensures
+                - swaps *this and item
+        !*/
+    };
+
+    inline void swap (
+        mapped_file& a,
+        mapped_file& b
+    ) { a.swap(b); }
+    /*!
+        provides a global swap function
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FILE_KERNEl_ABSTRACT_
+
@@ -0,0 +1,49 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_TEMPORARY_FILE_NAME_Hh_
+#define DLIB_TEMPORARY_FILE_NAME_Hh_
+
+#include "temporary_file_name_abstract.h"
+#include "../platform.h"
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+#ifdef POSIX
+#include <unistd.h>
+#endif
+#ifdef WIN32
+#include <process.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::string unique_temporary_file_name (
+        const std::string& filename
+    )
+    {
+        // The process id tells apart writers in different processes, whose thread ids
+        // can hash to the same value, and the counter two files of the same thread.
+        static std::atomic<unsigned long> counter(0);
+        std::ostringstream sout;
+        sout << filename << ".tmp.";
+#if defined(POSIX)
+        sout << getpid();
+#elif defined(WIN32)
+        sout << _getpid();
+#endif
+        sout << "." << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id())
+             << "." << counter++;
+        return sout.str();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_TEMPORARY_FILE_NAME_Hh_
+
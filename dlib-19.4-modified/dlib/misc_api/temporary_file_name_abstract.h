@@ -0,0 +1,29 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_TEMPORARY_FILE_NAME_ABSTRACT_Hh_
+#ifdef DLIB_TEMPORARY_FILE_NAME_ABSTRACT_Hh_
+
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    std::string unique_temporary_file_name (
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - returns a name for a temporary file next to filename (i.e. filename followed
+              by a suffix) that no other call, in this or any other process running on
+              the machine, returns at the same time.  Write a file there and rename() it
+              to filename to replace filename atomically, even when several threads or
+              processes write the same filename concurrently.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_TEMPORARY_FILE_NAME_ABSTRACT_Hh_
+
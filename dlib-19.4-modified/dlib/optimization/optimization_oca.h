@@ -6,6 +6,7 @@
 #include "optimization_oca_abstract.h"
 
 #include "../matrix.h"
+#include "../serialize.h"
 #include "optimization_solve_qp_using_smo.h"
 #include <vector>
 #include "../sequence.h"
@@ -49,6 +50,88 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    class oca;
+
+    template <typename matrix_type>
+    class oca_warm_start
+    {
+        /*!
+            CONVENTION
+                - planes.size() == bs.size() == alpha.size()
+                - if (planes.size() != 0) then
+                    - sum(alpha) == c and the planes were produced by a solve with
+                      C == c.
+                - w == the solution of the last solve, or empty if there wasn't one.
+        !*/
+    public:
+        typedef typename matrix_type::type scalar_type;
+
+        oca_warm_start() : c(0) {}
+
+        void clear (
+        )
+        {
+            forget_cutting_planes();
+            w.set_size(0,1);
+        }
+
+        void forget_cutting_planes (
+        )
+        {
+            planes.clear();
+            bs.clear();
+            alpha.set_size(0,1);
+            c = 0;
+        }
+
+        unsigned long num_cutting_planes (
+        ) const { return planes.size(); }
+
+        const matrix_type& get_solution (
+        ) const { return w; }
+
+        friend void serialize (
+            const oca_warm_start& item,
+            std::ostream& out
+        )
+        {
+            int version = 1;
+            dlib::serialize(version, out);
+            dlib::serialize(item.planes, out);
+            dlib::serialize(item.bs, out);
+            dlib::serialize(item.alpha, out);
+            dlib::serialize(item.c, out);
+            dlib::serialize(item.w, out);
+        }
+
+        friend void deserialize (
+            oca_warm_start& item,
+            std::istream& in 
+        )
+        {
+            int version = 0;
+            dlib::deserialize(version, in);
+            if (version != 1)
+                throw serialization_error("Unexpected version found while deserializing dlib::oca_warm_start.");
+            dlib::deserialize(item.planes, in);
+            dlib::deserialize(item.bs, in);
+            dlib::deserialize(item.alpha, in);
+            dlib::deserialize(item.c, in);
+            dlib::deserialize(item.w, in);
+        }
+
+    private:
+        friend class oca;
+
+        std::vector<matrix_type> planes;
+        std::vector<scalar_type> bs;
+        matrix_type alpha;
+        scalar_type c;
+        matrix_type w;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     class oca
@@ -120,6 +203,21 @@ namespace dlib
             return oca_impl(problem, w, empty_prior, false, num_nonnegative, force_weight_to_1, 0);
         }
 
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            oca_warm_start<matrix_type>& warm_start,
+            unsigned long num_nonnegative = 0,
+            unsigned long force_weight_to_1 = std::numeric_limits<unsigned long>::max()
+        ) const
+        {
+            matrix_type empty_prior;
+            return oca_impl(problem, w, empty_prior, false, num_nonnegative, force_weight_to_1, 0, &warm_start);
+        }
+
         template <
             typename matrix_type
             >
@@ -170,7 +268,8 @@ namespace dlib
             bool have_prior,
             unsigned long num_nonnegative,
             unsigned long force_weight_to_1,
-            const double lasso_lambda
+            const double lasso_lambda,
+            oca_warm_start<matrix_type>* warm_start = 0
         ) const
         {
             const unsigned long num_dims = problem.get_num_dimensions();
@@ -232,8 +331,37 @@ namespace dlib
                 d.set_size(num_nonnegative);
             d = lasso_lambda*ones_matrix(d);
 
+            if (warm_start && warm_start->w.size() == (long)num_dims)
+            {
+                w = warm_start->w;
+
+                // The cutting planes are lower bounds on R(w), which doesn't depend on C,
+                // so they stay valid when C changes.  Scaling alpha keeps sum(alpha) == C
+                // and gives the QP a feasible starting point close to the old one.
+                for (unsigned long i = 0; i < warm_start->planes.size(); ++i)
+                {
+                    new_plane = warm_start->planes[i];
+                    planes.add(planes.size(), new_plane);
+                    bs.push_back(warm_start->bs[i]);
+                    miss_count.push_back(0);
+                }
+                if (planes.size() != 0)
+                {
+                    alpha = warm_start->alpha*(C/warm_start->c);
+                    K.set_size(planes.size(), planes.size());
+                    for (long i = 0; i < K.nr(); ++i)
+                    {
+                        for (long j = i; j < K.nc(); ++j)
+                        {
+                            K(i,j) = dot(planes[i], planes[j]);
+                            K(j,i) = K(i,j);
+                        }
+                    }
+                }
+            }
+
             scalar_type R_lower_bound;
-            if (problem.risk_has_lower_bound(R_lower_bound))
+            if (planes.size() == 0 && problem.risk_has_lower_bound(R_lower_bound))
             {
                 // The flat lower bounding plane is always good to have if we know
                 // what it is.
@@ -390,6 +518,17 @@ namespace dlib
             if (force_weight_to_1 < (unsigned long)w.size())
                 w(force_weight_to_1) = 1;
 
+            if (warm_start)
+            {
+                warm_start->planes.resize(planes.size());
+                for (unsigned long i = 0; i < planes.size(); ++i)
+                    warm_start->planes[i] = planes[i];
+                warm_start->bs = bs;
+                warm_start->alpha = alpha;
+                warm_start->c = C;
+                warm_start->w = w;
+            }
+
             return cur_obj;
         }
 
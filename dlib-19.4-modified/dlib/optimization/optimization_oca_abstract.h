@@ -122,6 +122,92 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename matrix_type
+        >
+    class oca_warm_start
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds what oca learned about a problem during one solve so
+                that the next solve of a closely related problem can start from there
+                instead of from scratch.  That is the solution w and the cutting planes,
+                i.e. the lower bounds on R(w), oca had collected.
+
+                The typical use is solving the same problem for a sequence of C values
+                (a regularization path).  Since R(w) doesn't depend on C, the cutting
+                planes of one solve remain valid lower bounds for the next, and with the
+                previous solution as the starting point each subsequent solve usually
+                needs only a few calls to get_risk().
+
+                It is only valid to carry the cutting planes over to a problem whose
+                R(w) is the same function as (or bounded below by) the one they were
+                collected on.  If only the solution is still a good starting point, call
+                forget_cutting_planes().
+        !*/
+    public:
+
+        oca_warm_start (
+        );
+        /*!
+            ensures
+                - #num_cutting_planes() == 0
+                - #get_solution().size() == 0
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #num_cutting_planes() == 0
+                - #get_solution().size() == 0
+        !*/
+
+        void forget_cutting_planes (
+        );
+        /*!
+            ensures
+                - #num_cutting_planes() == 0
+                - #get_solution() == get_solution()
+        !*/
+
+        unsigned long num_cutting_planes (
+        ) const;
+        /*!
+            ensures
+                - returns the number of cutting planes the next solve will start with.
+        !*/
+
+        const matrix_type& get_solution (
+        ) const;
+        /*!
+            ensures
+                - returns the solution found by the last solve that used this object, or
+                  an empty vector if there hasn't been one.
+        !*/
+
+    };
+
+    template <typename matrix_type>
+    void serialize (
+        const oca_warm_start<matrix_type>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support 
+    !*/
+
+    template <typename matrix_type>
+    void deserialize (
+        oca_warm_start<matrix_type>& item,
+        std::istream& in 
+    );
+    /*!
+        provides deserialization support 
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     class oca
@@ -211,6 +297,32 @@ namespace dlib
                           values of 0.
         !*/
 
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            oca_warm_start<matrix_type>& warm_start,
+            unsigned long num_nonnegative = 0,
+            unsigned long force_weight_to_1 = std::numeric_limits<unsigned long>::max()
+        ) const;
+        /*!
+            requires
+                - problem.get_c() > 0
+                - problem.get_num_dimensions() > 0
+                - The cutting planes in warm_start, if any, were collected on a problem
+                  with the same R(w) (see oca_warm_start).
+            ensures
+                - This function is identical to the operator() above except that:
+                    - if (warm_start.get_solution().size() == problem.get_num_dimensions()) then
+                        - The optimization starts from warm_start.get_solution() and with
+                          warm_start's cutting planes rather than from w == 0 with no
+                          cutting planes.
+                    - #warm_start holds the solution #w and the cutting planes in use
+                      when the optimization stopped, ready for the next call.
+        !*/
+
         template <
             typename matrix_type
             >
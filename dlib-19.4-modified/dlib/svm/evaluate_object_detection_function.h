@@ -0,0 +1,322 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_Hh_
+#define DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_Hh_
+
+#include "evaluate_object_detection_function_abstract.h"
+#include "cross_validate_object_detection_trainer.h"
+#include "../image_processing/detection_stats.h"
+#include "../threads.h"
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct object_detection_evaluation
+    {
+        object_detection_evaluation(
+        ) :
+            correct_hits(0),
+            total_hits(0),
+            total_true_targets(0),
+            latency_mean(0),
+            latency_p50(0),
+            latency_p95(0),
+            latency_p99(0),
+            latency_max(0),
+            pyramid_seconds(0),
+            resize_seconds(0),
+            histogram_seconds(0),
+            resample_seconds(0),
+            normalize_seconds(0),
+            filter_seconds(0),
+            nms_seconds(0),
+            wall_seconds(0),
+            images_per_second(0),
+            num_threads(0)
+        {
+            accuracy = 0;
+        }
+
+        matrix<double,1,3> accuracy;
+        unsigned long correct_hits;
+        unsigned long total_hits;
+        unsigned long total_true_targets;
+
+        std::vector<double> image_seconds;
+        double latency_mean;
+        double latency_p50;
+        double latency_p95;
+        double latency_p99;
+        double latency_max;
+
+        double pyramid_seconds;
+        double resize_seconds;
+        double histogram_seconds;
+        double resample_seconds;
+        double normalize_seconds;
+        double filter_seconds;
+        double nms_seconds;
+
+        double wall_seconds;
+        double images_per_second;
+        unsigned long num_threads;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class detection_stats_capture : public detection_stats_sink, noncopyable
+        {
+            /*!
+                Registers itself as the detection_stats_sink of the thread that
+                constructs it, keeps the last record it receives, passes every record on
+                to the sink the evaluation was started with, and puts the thread's
+                previous sink back when it is destroyed.
+            !*/
+        public:
+            explicit detection_stats_capture (
+                detection_stats_sink* next_
+            ) : next(next_), previous(get_detection_stats_sink()), has_record(false)
+            {
+                set_detection_stats_sink(this);
+            }
+
+            ~detection_stats_capture (
+            )
+            {
+                set_detection_stats_sink(previous);
+            }
+
+            virtual void record (
+                const detection_stats& stats
+            )
+            {
+                last = stats;
+                has_record = true;
+                if (next)
+                    next->record(stats);
+            }
+
+            detection_stats_sink* next;
+            detection_stats_sink* previous;
+            detection_stats last;
+            bool has_record;
+        };
+
+        inline double nearest_rank_percentile (
+            const std::vector<double>& sorted,
+            double p
+        )
+        {
+            if (sorted.size() == 0)
+                return 0;
+            const double rank = std::ceil(p/100*sorted.size());
+            const unsigned long idx = rank < 1 ? 0 : (unsigned long)rank - 1;
+            return sorted[std::min<unsigned long>(idx, sorted.size()-1)];
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<full_object_detection> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_CASSERT( is_learning_problem(images,truth_dets) == true &&
+                        ignore.size() == images.size() &&
+                        num_threads > 0,
+                    "\t object_detection_evaluation evaluate_object_detection_function()"
+                    << "\n\t invalid inputs were given to this function"
+                    << "\n\t is_learning_problem(images,truth_dets): " << is_learning_problem(images,truth_dets)
+                    << "\n\t ignore.size(): " << ignore.size()
+                    << "\n\t images.size(): " << images.size()
+                    << "\n\t num_threads:   " << num_threads
+                    );
+
+        const unsigned long num_images = images.size();
+        std::vector<std::vector<std::pair<double,rectangle> > > hits(num_images);
+        std::vector<detection_stats> stats(num_images);
+
+        object_detection_evaluation eval;
+        eval.num_threads = std::min(num_threads, std::max<unsigned long>(num_images, 1));
+        eval.image_seconds.assign(num_images, 0);
+
+        // Each worker runs its own copy of the detector and pulls the next image off a
+        // shared counter, so slow images don't leave the other threads idle.  Everything
+        // a worker produces is stored by image index and merged in image order below,
+        // which makes the result independent of the scheduling.
+        detection_stats_sink* const caller_sink = get_detection_stats_sink();
+        std::atomic<unsigned long> next_image(0);
+        const auto wall_t0 = std::chrono::steady_clock::now();
+        {
+            thread_pool tp(eval.num_threads);
+            parallel_for(tp, 0, eval.num_threads, [&](long)
+            {
+                object_detector_type det(detector);
+                impl::detection_stats_capture capture(caller_sink);
+                for (unsigned long i = next_image++; i < num_images; i = next_image++)
+                {
+                    capture.has_record = false;
+                    const auto t0 = std::chrono::steady_clock::now();
+                    det(images[i], hits[i], adjust_threshold);
+                    const auto t1 = std::chrono::steady_clock::now();
+                    eval.image_seconds[i] = std::chrono::duration<double>(t1-t0).count();
+                    if (capture.has_record)
+                        stats[i] = capture.last;
+                }
+            }, 1);
+        }
+        eval.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_t0).count();
+
+        std::vector<std::pair<double,bool> > all_dets;
+        unsigned long missing_detections = 0;
+        for (unsigned long i = 0; i < num_images; ++i)
+        {
+            eval.correct_hits += impl::number_of_truth_hits(truth_dets[i], ignore[i], hits[i], overlap_tester, all_dets, missing_detections);
+            eval.total_true_targets += truth_dets[i].size();
+
+            eval.pyramid_seconds += stats[i].pyramid_time;
+            eval.nms_seconds += stats[i].nms_time;
+            for (unsigned long l = 0; l < stats[i].levels.size(); ++l)
+            {
+                const detection_level_stats& level = stats[i].levels[l];
+                eval.resize_seconds += level.resize;
+                eval.histogram_seconds += level.histogram;
+                eval.resample_seconds += level.resample;
+                eval.normalize_seconds += level.normalize;
+                eval.filter_seconds += level.filter;
+            }
+        }
+        std::sort(all_dets.rbegin(), all_dets.rend());
+        eval.total_hits = all_dets.size();
+
+        const double precision = eval.total_hits == 0 ? 1 : (double)eval.correct_hits/eval.total_hits;
+        const double recall = eval.total_true_targets == 0 ? 1 : (double)eval.correct_hits/eval.total_true_targets;
+        eval.accuracy = precision, recall, average_precision(all_dets, missing_detections);
+
+        std::vector<double> sorted(eval.image_seconds);
+        std::sort(sorted.begin(), sorted.end());
+        for (unsigned long i = 0; i < sorted.size(); ++i)
+            eval.latency_mean += sorted[i];
+        if (sorted.size() != 0)
+        {
+            eval.latency_mean /= sorted.size();
+            eval.latency_max = sorted.back();
+        }
+        eval.latency_p50 = impl::nearest_rank_percentile(sorted, 50);
+        eval.latency_p95 = impl::nearest_rank_percentile(sorted, 95);
+        eval.latency_p99 = impl::nearest_rank_percentile(sorted, 99);
+        if (eval.wall_seconds > 0)
+            eval.images_per_second = num_images/eval.wall_seconds;
+
+        return eval;
+    }
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<rectangle> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        // convert into a list of regular rectangles.
+        std::vector<std::vector<full_object_detection> > rects(truth_dets.size());
+        for (unsigned long i = 0; i < truth_dets.size(); ++i)
+        {
+            for (unsigned long j = 0; j < truth_dets[i].size(); ++j)
+            {
+                rects[i].push_back(full_object_detection(truth_dets[i][j]));
+            }
+        }
+
+        return evaluate_object_detection_function(detector, images, rects, ignore, num_threads, overlap_tester, adjust_threshold);
+    }
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<rectangle> >& truth_dets,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        std::vector<std::vector<rectangle> > ignore(images.size());
+        return evaluate_object_detection_function(detector, images, truth_dets, ignore, num_threads, overlap_tester, adjust_threshold);
+    }
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<full_object_detection> >& truth_dets,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        std::vector<std::vector<rectangle> > ignore(images.size());
+        return evaluate_object_detection_function(detector, images, truth_dets, ignore, num_threads, overlap_tester, adjust_threshold);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::ostream& operator<< (
+        std::ostream& out,
+        const object_detection_evaluation& item
+    )
+    {
+        out << "precision, recall, average precision: " << item.accuracy;
+        out << "hits:              " << item.correct_hits << " correct of " << item.total_hits
+            << ", " << item.total_true_targets << " true targets\n";
+        out << "image latency:     mean " << 1000*item.latency_mean << "ms  p50 " << 1000*item.latency_p50
+            << "ms  p95 " << 1000*item.latency_p95 << "ms  p99 " << 1000*item.latency_p99
+            << "ms  max " << 1000*item.latency_max << "ms\n";
+        out << "stage totals:      pyramid " << item.pyramid_seconds << "s (resize " << item.resize_seconds
+            << "s, histogram " << item.histogram_seconds << "s, resample " << item.resample_seconds
+            << "s, normalize " << item.normalize_seconds << "s)  filter " << item.filter_seconds
+            << "s  nms " << item.nms_seconds << "s\n";
+        out << "throughput:        " << item.images_per_second << " images/s on " << item.num_threads
+            << " threads (" << item.wall_seconds << "s wall)\n";
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_Hh_
+
@@ -0,0 +1,172 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_ABSTRACT_Hh_
+#ifdef DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_ABSTRACT_Hh_
+
+#include <vector>
+#include <iostream>
+#include "../matrix.h"
+#include "../geometry.h"
+#include "../image_processing/full_object_detection_abstract.h"
+#include "../image_processing/box_overlap_testing_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct object_detection_evaluation
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is what evaluate_object_detection_function() returns.  It
+                holds the accuracy of a detector on a labeled image set along with how
+                long the detector took.  All times are in seconds.
+        !*/
+
+        // precision, recall and average precision, exactly as test_object_detection_function()
+        // returns them for the same detector and images.
+        matrix<double,1,3> accuracy;
+        unsigned long correct_hits;       // detections that matched a truth box
+        unsigned long total_hits;         // detections not matching only ignore boxes
+        unsigned long total_true_targets; // the number of truth boxes
+
+        // image_seconds[i] == the time the detector took on images[i].  The latency fields
+        // are the mean, nearest rank percentiles and maximum of image_seconds.
+        std::vector<double> image_seconds;
+        double latency_mean;
+        double latency_p50;
+        double latency_p95;
+        double latency_p99;
+        double latency_max;
+
+        // The stage times of detection_stats (see detection_stats_abstract.h) summed over
+        // all images and pyramid levels.  They stay 0 for detectors that don't report
+        // detection_stats.
+        double pyramid_seconds;
+        double resize_seconds;
+        double histogram_seconds;
+        double resample_seconds;
+        double normalize_seconds;
+        double filter_seconds;
+        double nms_seconds;
+
+        double wall_seconds;        // wall time of the whole evaluation
+        double images_per_second;   // images.size()/wall_seconds
+        unsigned long num_threads;  // the number of threads that ran the detector
+    };
+
+    std::ostream& operator<< (
+        std::ostream& out,
+        const object_detection_evaluation& item
+    );
+    /*!
+        ensures
+            - prints a human readable summary of item to out.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<full_object_detection> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - All the requirements of test_object_detection_function() (see
+              cross_validate_object_detection_trainer_abstract.h).
+            - object_detector_type is copyable.
+            - num_threads > 0
+        ensures
+            - Runs detector over images using num_threads threads and returns an
+              object_detection_evaluation E describing the accuracy and speed of the
+              detector.  Each thread runs its own copy of detector.
+            - E.accuracy is identical to what test_object_detection_function() returns
+              for the same arguments, regardless of num_threads, since the detections are
+              merged in image order.  Unlike test_object_detection_function() this
+              function prints nothing.
+            - E.num_threads == min(num_threads, max(images.size(),1))
+            - If a detection_stats_sink is set in the calling thread then it receives
+              the detection_stats of every image, from the worker threads.  So it must be
+              thread safe.
+    !*/
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<rectangle> >& truth_dets,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - All the requirements of the above evaluate_object_detection_function() routine.
+        ensures
+            - converts all the rectangles in truth_dets into full_object_detection objects
+              via full_object_detection's rectangle constructor.  Then invokes
+              evaluate_object_detection_function() on the full_object_detections and
+              returns the results.
+    !*/
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<rectangle> >& truth_dets,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - All the requirements of the above evaluate_object_detection_function() routine.
+        ensures
+            - This function simply invokes evaluate_object_detection_function() with all
+              the given arguments and an empty set of ignore rectangles and returns the
+              results.
+    !*/
+
+    template <
+        typename object_detector_type,
+        typename image_array_type
+        >
+    object_detection_evaluation evaluate_object_detection_function (
+        const object_detector_type& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<full_object_detection> >& truth_dets,
+        const unsigned long num_threads,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - All the requirements of the above evaluate_object_detection_function() routine.
+        ensures
+            - This function simply invokes evaluate_object_detection_function() with all
+              the given arguments and an empty set of ignore rectangles and returns the
+              results.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_EVALUATE_OBJECT_DETECTION_FUNCTION_ABSTRACT_Hh_
+
@@ -10,6 +10,7 @@
 #include "../image_processing/object_detector.h"
 #include "../image_processing/box_overlap_testing.h"
 #include "../image_processing/full_object_detection.h"
+#include <algorithm>
 
 
 namespace dlib
@@ -30,6 +31,76 @@ namespace dlib
         // whatever is appropriate.
     }
 
+// ----------------------------------------------------------------------------------------
+
+    class structural_object_detection_training_state
+    {
+    public:
+
+        structural_object_detection_training_state (
+        ) : match_eps(0), loss_per_missed_target(0), loss_per_false_alarm(0) {}
+
+        void clear (
+        )
+        {
+            warm_start.clear();
+            samples.clear();
+            overlap_tester = test_box_overlap();
+            match_eps = 0;
+            loss_per_missed_target = 0;
+            loss_per_false_alarm = 0;
+        }
+
+        unsigned long num_samples (
+        ) const { return samples.size(); }
+
+        const matrix<double,0,1>& get_solution (
+        ) const { return warm_start.get_solution(); }
+
+        friend void serialize (
+            const structural_object_detection_training_state& item,
+            std::ostream& out
+        )
+        {
+            int version = 1;
+            serialize(version, out);
+            serialize(item.warm_start, out);
+            serialize(item.samples, out);
+            serialize(item.overlap_tester, out);
+            serialize(item.match_eps, out);
+            serialize(item.loss_per_missed_target, out);
+            serialize(item.loss_per_false_alarm, out);
+        }
+
+        friend void deserialize (
+            structural_object_detection_training_state& item,
+            std::istream& in 
+        )
+        {
+            int version = 0;
+            deserialize(version, in);
+            if (version != 1)
+                throw serialization_error("Unexpected version found while deserializing dlib::structural_object_detection_training_state.");
+            deserialize(item.warm_start, in);
+            deserialize(item.samples, in);
+            deserialize(item.overlap_tester, in);
+            deserialize(item.match_eps, in);
+            deserialize(item.loss_per_missed_target, in);
+            deserialize(item.loss_per_false_alarm, in);
+        }
+
+    private:
+        template <typename image_scanner_type>
+        friend class structural_object_detection_trainer;
+
+        oca_warm_start<matrix<double,0,1> > warm_start;
+        std::vector<object_detection_sample_summary> samples;
+        test_box_overlap overlap_tester;
+        double match_eps;
+        double loss_per_missed_target;
+        double loss_per_false_alarm;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -60,9 +131,14 @@ namespace dlib
             eps = 0.1;
             num_threads = 2;
             max_cache_size = 5;
+            compact_cache = false;
             match_eps = 0.5;
             loss_per_missed_target = 1;
             loss_per_false_alarm = 1;
+            add_left_right_flips = false;
+            feature_store_file = "";
+            max_window_cache_size = 0;
+            window_cache_rescan_interval = 10;
 
             scanner.copy_configuration(scanner_);
 
@@ -146,6 +222,52 @@ namespace dlib
             return max_cache_size; 
         }
 
+        void set_compact_cache (
+            bool enabled
+        )
+        {
+            compact_cache = enabled;
+        }
+
+        bool get_compact_cache (
+        ) const
+        {
+            return compact_cache;
+        }
+
+        void set_max_window_cache_size (
+            unsigned long max_size
+        )
+        {
+            max_window_cache_size = max_size;
+        }
+
+        unsigned long get_max_window_cache_size (
+        ) const
+        {
+            return max_window_cache_size;
+        }
+
+        void set_window_cache_rescan_interval (
+            unsigned long num_iterations
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num_iterations > 0,
+                "\t void structural_object_detection_trainer::set_window_cache_rescan_interval()"
+                << "\n\t num_iterations must be greater than 0"
+                << "\n\t this: " << this
+                );
+
+            window_cache_rescan_interval = num_iterations;
+        }
+
+        unsigned long get_window_cache_rescan_interval (
+        ) const
+        {
+            return window_cache_rescan_interval;
+        }
+
         void be_verbose (
         )
         {
@@ -158,6 +280,32 @@ namespace dlib
             verbose = false;
         }
 
+        void set_add_left_right_flips (
+            bool enabled
+        )
+        {
+            add_left_right_flips = enabled;
+        }
+
+        bool get_add_left_right_flips (
+        ) const
+        {
+            return add_left_right_flips;
+        }
+
+        void set_feature_store_file (
+            const std::string& filename
+        )
+        {
+            feature_store_file = filename;
+        }
+
+        const std::string& get_feature_store_file (
+        ) const
+        {
+            return feature_store_file;
+        }
+
         void set_oca (
             const oca& item
         )
@@ -314,18 +462,387 @@ namespace dlib
             return train_impl(images, truth_dets, ignore, ignore_overlap_tester);
         }
 
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            const std::vector<const image_scanner_type*>& loaded_scanners
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(loaded_scanners.size() == (add_left_right_flips ? 2 : 1)*images.size() &&
+                        images.size() != 0 && 
+                        loaded_scanners[0]->get_num_dimensions() == get_scanner().get_num_dimensions(),
+                "\t trained_function_type structural_object_detection_trainer::train()"
+                << "\n\t invalid inputs were given to this function"
+                << "\n\t images.size():          " << images.size()
+                << "\n\t loaded_scanners.size(): " << loaded_scanners.size()
+                << "\n\t add_left_right_flips:   " << add_left_right_flips
+                );
+
+            return train_impl(images, truth_object_detections, ignore, ignore_overlap_tester, &loaded_scanners);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            const std::vector<const image_scanner_type*>& loaded_scanners
+        ) const
+        {
+            std::vector<std::vector<full_object_detection> > truth_dets(truth_object_detections.size());
+            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
+            {
+                for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
+                {
+                    truth_dets[i].push_back(full_object_detection(truth_object_detections[i][j]));
+                }
+            }
+
+            return train(images, truth_dets, ignore, ignore_overlap_tester, loaded_scanners);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections
+        ) const
+        {
+            std::vector<std::vector<rectangle> > empty_ignore(images.size());
+            return train_path_impl(Cs, images, truth_object_detections, empty_ignore, test_box_overlap());
+        }
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const
+        {
+            return train_path_impl(Cs, images, truth_object_detections, ignore, ignore_overlap_tester);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections
+        ) const
+        {
+            std::vector<std::vector<rectangle> > empty_ignore(images.size());
+            return train_path(Cs, images, truth_object_detections, empty_ignore, test_box_overlap());
+        }
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const
+        {
+            std::vector<std::vector<full_object_detection> > truth_dets(truth_object_detections.size());
+            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
+            {
+                for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
+                {
+                    truth_dets[i].push_back(full_object_detection(truth_object_detections[i][j]));
+                }
+            }
+
+            return train_path_impl(Cs, images, truth_dets, ignore, ignore_overlap_tester);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            structural_object_detection_training_state& state
+        ) const
+        {
+            return train_incremental_impl(images, truth_object_detections, ignore, ignore_overlap_tester, state);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            structural_object_detection_training_state& state
+        ) const
+        {
+            std::vector<std::vector<full_object_detection> > truth_dets(truth_object_detections.size());
+            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
+            {
+                for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
+                {
+                    truth_dets[i].push_back(full_object_detection(truth_object_detections[i][j]));
+                }
+            }
+
+            return train_incremental_impl(images, truth_dets, ignore, ignore_overlap_tester, state);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            structural_object_detection_training_state& state
+        ) const
+        {
+            std::vector<std::vector<rectangle> > empty_ignore(images.size());
+            return train_incremental(images, truth_object_detections, empty_ignore, test_box_overlap(), state);
+        }
+
     private:
 
         template <
             typename image_array_type
             >
         const trained_function_type train_impl (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            const std::vector<const image_scanner_type*>* loaded_scanners = 0
+        ) const
+        {
+            check_training_data(images, truth_object_detections, ignore);
+
+            if (loaded_scanners)
+            {
+                structural_svm_object_detection_problem<image_scanner_type,image_array_type > 
+                    svm_prob(*loaded_scanners, overlap_tester, auto_overlap_tester, images,
+                        truth_object_detections, ignore, ignore_overlap_tester, num_threads);
+                return solve(svm_prob);
+            }
+            else
+            {
+                structural_svm_object_detection_problem<image_scanner_type,image_array_type > 
+                    svm_prob(scanner, overlap_tester, auto_overlap_tester, images,
+                        truth_object_detections, ignore, ignore_overlap_tester, num_threads,
+                        add_left_right_flips, feature_store_file);
+                return solve(svm_prob);
+            }
+        }
+
+        const trained_function_type make_detector (
+            const test_box_overlap& tester,
+            const matrix<double,0,1>& w
+        ) const
+        {
+            // The detector gets the scanner's configuration minus the settings that are
+            // only there to load the training images, like a compressed feature storage.
+            image_scanner_type detection_scanner;
+            detection_scanner.copy_configuration(scanner);
+            clear_training_settings(detection_scanner);
+            return object_detector<image_scanner_type>(detection_scanner, tester, w);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type solve (
+            structural_svm_object_detection_problem<image_scanner_type,image_array_type>& svm_prob
+        ) const
+        {
+            configure_problem(svm_prob);
+            matrix<double,0,1> w;
+
+            // Run the optimizer to find the optimal w.
+            solver(svm_prob,w);
+
+            // report the results of the training.
+            return make_detector(svm_prob.get_overlap_tester(), w);
+        }
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path_impl (
+            const std::vector<double>& Cs,
             const image_array_type& images,
             const std::vector<std::vector<full_object_detection> >& truth_object_detections,
             const std::vector<std::vector<rectangle> >& ignore,
             const test_box_overlap& ignore_overlap_tester
         ) const
         {
+#ifdef ENABLE_ASSERTS
+            // make sure requires clause is not broken
+            DLIB_ASSERT(Cs.size() != 0,
+                "\t std::vector<trained_function_type> structural_object_detection_trainer::train_path()"
+                << "\n\t Cs must not be empty"
+                );
+            for (unsigned long i = 0; i < Cs.size(); ++i)
+            {
+                DLIB_ASSERT(Cs[i] > 0,
+                    "\t std::vector<trained_function_type> structural_object_detection_trainer::train_path()"
+                    << "\n\t invalid inputs were given to this function"
+                    << "\n\t Cs["<<i<<"]: " << Cs[i]
+                    );
+            }
+#endif
+            check_training_data(images, truth_object_detections, ignore);
+
+            structural_svm_object_detection_problem<image_scanner_type,image_array_type > 
+                svm_prob(scanner, overlap_tester, auto_overlap_tester, images,
+                    truth_object_detections, ignore, ignore_overlap_tester, num_threads,
+                    add_left_right_flips, feature_store_file);
+            configure_problem(svm_prob);
+
+            // Solve for the smallest C first.  The solution of a smaller C is the more
+            // regularized one and makes a good starting point for the next larger C.
+            std::vector<std::pair<double,unsigned long> > order(Cs.size());
+            for (unsigned long i = 0; i < Cs.size(); ++i)
+                order[i] = std::make_pair(Cs[i], i);
+            std::sort(order.begin(), order.end());
+
+            std::vector<trained_function_type> detectors(Cs.size());
+            oca_warm_start<matrix<double,0,1> > warm_start;
+            matrix<double,0,1> w;
+            for (unsigned long i = 0; i < order.size(); ++i)
+            {
+                svm_prob.set_c(order[i].first);
+                solver(svm_prob, w, warm_start);
+                // The nuclear norm part of the risk is scaled by 1/C so cutting planes
+                // that include it don't carry over to another C.
+                if (svm_prob.num_nuclear_norm_regularizers() != 0)
+                    warm_start.forget_cutting_planes();
+                detectors[order[i].second] = make_detector(svm_prob.get_overlap_tester(), w);
+            }
+            return detectors;
+        }
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental_impl (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            structural_object_detection_training_state& state
+        ) const
+        {
+            check_training_data(images, truth_object_detections, ignore);
+
+            const bool have_state = state.num_samples() != 0;
+            // make sure requires clause is not broken
+            DLIB_ASSERT(!have_state || 
+                        (state.get_solution().size() == get_scanner().get_num_dimensions()+1 &&
+                         state.match_eps == match_eps &&
+                         state.loss_per_missed_target == loss_per_missed_target &&
+                         state.loss_per_false_alarm == loss_per_false_alarm),
+                "\t trained_function_type structural_object_detection_trainer::train_incremental()"
+                << "\n\t The state doesn't come from a trainer configured like this one."
+                << "\n\t state.get_solution().size():          " << state.get_solution().size()
+                << "\n\t get_scanner().get_num_dimensions()+1: " << get_scanner().get_num_dimensions()+1
+                << "\n\t state.match_eps: " << state.match_eps << "  match_eps: " << match_eps
+                << "\n\t state.loss_per_missed_target: " << state.loss_per_missed_target 
+                << "  loss_per_missed_target: " << loss_per_missed_target
+                << "\n\t state.loss_per_false_alarm: " << state.loss_per_false_alarm
+                << "  loss_per_false_alarm: " << loss_per_false_alarm
+                );
+
+            structural_svm_object_detection_problem<image_scanner_type,image_array_type > 
+                svm_prob(scanner, overlap_tester, auto_overlap_tester, images,
+                    truth_object_detections, ignore, ignore_overlap_tester, num_threads,
+                    add_left_right_flips, feature_store_file);
+            configure_problem(svm_prob);
+
+            if (have_state)
+            {
+                // The automatic overlap tester has to allow the truth boxes of the old
+                // images as well as those of the new ones.
+                if (auto_overlap_tester)
+                {
+                    const test_box_overlap tester = svm_prob.get_overlap_tester();
+                    svm_prob.set_overlap_tester(test_box_overlap(
+                            std::max(tester.get_iou_thresh(), state.overlap_tester.get_iou_thresh()),
+                            std::max(tester.get_percent_covered_thresh(), state.overlap_tester.get_percent_covered_thresh())));
+                }
+                svm_prob.set_summarized_samples(state.samples);
+            }
+            // The old cutting planes came from running the separation oracle on the old
+            // images, whose loss can be larger than what their summaries give.  So they
+            // don't bound the new risk from below and only the old solution is reused,
+            // as the starting point.  This also covers the nuclear norm part of the risk,
+            // which depends on C.
+            state.warm_start.forget_cutting_planes();
+
+            matrix<double,0,1> w;
+            solver(svm_prob, w, state.warm_start);
+            state.warm_start.forget_cutting_planes();
+
+            svm_prob.summarize_samples(w, state.samples);
+            state.overlap_tester = svm_prob.get_overlap_tester();
+            state.match_eps = match_eps;
+            state.loss_per_missed_target = loss_per_missed_target;
+            state.loss_per_false_alarm = loss_per_false_alarm;
+
+            return make_detector(svm_prob.get_overlap_tester(), w);
+        }
+
+        template <
+            typename image_array_type
+            >
+        void configure_problem (
+            structural_svm_object_detection_problem<image_scanner_type,image_array_type>& svm_prob
+        ) const
+        {
+            if (verbose)
+                svm_prob.be_verbose();
+
+            svm_prob.set_c(C);
+            svm_prob.set_epsilon(eps);
+            svm_prob.set_max_cache_size(max_cache_size);
+            svm_prob.set_compact_cache(compact_cache);
+            svm_prob.set_max_window_cache_size(max_window_cache_size);
+            svm_prob.set_window_cache_rescan_interval(window_cache_rescan_interval);
+            svm_prob.set_match_eps(match_eps);
+            svm_prob.set_loss_per_missed_target(loss_per_missed_target);
+            svm_prob.set_loss_per_false_alarm(loss_per_false_alarm);
+            configure_nuclear_norm_regularizer(scanner, svm_prob);
+        }
+
+        template <
+            typename image_array_type
+            >
+        void check_training_data (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore
+        ) const
+        {
 #ifdef ENABLE_ASSERTS
             // make sure requires clause is not broken
             DLIB_ASSERT(is_learning_problem(images,truth_object_detections) == true && images.size() == ignore.size(),
@@ -353,28 +870,6 @@ namespace dlib
                 }
             }
 #endif
-
-            structural_svm_object_detection_problem<image_scanner_type,image_array_type > 
-                svm_prob(scanner, overlap_tester, auto_overlap_tester, images,
-                    truth_object_detections, ignore, ignore_overlap_tester, num_threads);
-
-            if (verbose)
-                svm_prob.be_verbose();
-
-            svm_prob.set_c(C);
-            svm_prob.set_epsilon(eps);
-            svm_prob.set_max_cache_size(max_cache_size);
-            svm_prob.set_match_eps(match_eps);
-            svm_prob.set_loss_per_missed_target(loss_per_missed_target);
-            svm_prob.set_loss_per_false_alarm(loss_per_false_alarm);
-            configure_nuclear_norm_regularizer(scanner, svm_prob);
-            matrix<double,0,1> w;
-
-            // Run the optimizer to find the optimal w.
-            solver(svm_prob,w);
-
-            // report the results of the training.
-            return object_detector<image_scanner_type>(scanner, svm_prob.get_overlap_tester(), w);
         }
 
         image_scanner_type scanner;
@@ -387,9 +882,14 @@ namespace dlib
         bool verbose;
         unsigned long num_threads;
         unsigned long max_cache_size;
+        bool compact_cache;
+        unsigned long max_window_cache_size;
+        unsigned long window_cache_rescan_interval;
         double loss_per_missed_target;
         double loss_per_false_alarm;
         bool auto_overlap_tester;
+        bool add_left_right_flips;
+        std::string feature_store_file;
 
     }; 
 
@@ -12,6 +12,75 @@
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    class structural_object_detection_training_state
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds what structural_object_detection_trainer::train_incremental()
+                needs to go on training a detector after more labeled images come in,
+                without reloading the images it was trained on before.  That is the last
+                solution of the solver and an object_detection_sample_summary of every
+                training sample.  It can be
+                saved to disk with serialize() between training runs.
+
+                The summaries take about max_cache_size+2 times the size of the weight
+                vector per sample, which for fHOG detectors is a few tens of KB per
+                image, so far less than keeping the images or their features around.
+        !*/
+
+    public:
+
+        structural_object_detection_training_state (
+        );
+        /*!
+            ensures
+                - #num_samples() == 0
+                - #get_solution().size() == 0
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #num_samples() == 0
+                - #get_solution().size() == 0
+        !*/
+
+        unsigned long num_samples (
+        ) const;
+        /*!
+            ensures
+                - returns the number of training samples summarized in this object.
+                  With left-right flips each image counts twice.
+        !*/
+
+        const matrix<double,0,1>& get_solution (
+        ) const;
+        /*!
+            ensures
+                - returns the weight vector (including the threshold) of the last
+                  detector trained with this state.
+        !*/
+    };
+
+    void serialize (
+        const structural_object_detection_training_state& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support 
+    !*/
+
+    void deserialize (
+        structural_object_detection_training_state& item,
+        std::istream& in 
+    );
+    /*!
+        provides deserialization support 
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -54,6 +123,7 @@ namespace dlib
                 - #get_epsilon() == 0.1
                 - #get_num_threads() == 2
                 - #get_max_cache_size() == 5
+                - #get_compact_cache() == false
                 - #get_match_eps() == 0.5
                 - #get_loss_per_missed_target() == 1
                 - #get_loss_per_false_alarm() == 1
@@ -63,6 +133,10 @@ namespace dlib
                   (note that only the "configuration" of scanner is copied.
                   I.e. the copy is done using copy_configuration())
                 - #auto_set_overlap_tester() == true
+                - #get_add_left_right_flips() == false
+                - #get_feature_store_file() == ""
+                - #get_max_window_cache_size() == 0
+                - #get_window_cache_rescan_interval() == 10
         !*/
 
         const image_scanner_type& get_scanner (
@@ -165,6 +239,65 @@ namespace dlib
                   memory (where scanner is the scanner given to this object's constructor).
         !*/
 
+        void set_compact_cache (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_compact_cache() == enabled
+        !*/
+
+        bool get_compact_cache (
+        ) const;
+        /*!
+            ensures
+                - returns true if the cache elements (see get_max_cache_size()) are stored
+                  as floats with long runs of zeros left out.  Then each one takes at most
+                  about sizeof(float)*scanner.get_num_dimensions() memory and less when
+                  the detections it holds are few, so a bigger cache fits in the same RAM.
+                  The cached feature vectors are rounded to float precision.
+        !*/
+
+        void set_max_window_cache_size (
+            unsigned long max_size
+        );
+        /*!
+            ensures
+                - #get_max_window_cache_size() == max_size
+        !*/
+
+        unsigned long get_max_window_cache_size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of best scoring windows per training sample the
+                  separation oracle keeps, to score only those instead of scanning the
+                  whole image pyramid while they look like all the windows that matter.
+                  Convergence is always checked with full scans, so the trained detector
+                  is as accurate whatever this is set to.  See
+                  structural_svm_object_detection_problem::get_max_window_cache_size()
+                  for the details.  A value of 0 disables the window cache.
+                - The window cache is only used if get_max_cache_size() != 0.
+        !*/
+
+        void set_window_cache_rescan_interval (
+            unsigned long num_iterations
+        );
+        /*!
+            requires
+                - num_iterations > 0
+            ensures
+                - #get_window_cache_rescan_interval() == num_iterations
+        !*/
+
+        unsigned long get_window_cache_rescan_interval (
+        ) const;
+        /*!
+            ensures
+                - returns the largest number of iterations a window cache is used for
+                  before the image pyramid it comes from is scanned in full again.
+        !*/
+
         void be_verbose (
         );
         /*!
@@ -180,6 +313,59 @@ namespace dlib
                 - this object will not print anything to standard out
         !*/
 
+        void set_add_left_right_flips (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_add_left_right_flips() == enabled
+        !*/
+
+        bool get_add_left_right_flips (
+        ) const;
+        /*!
+            ensures
+                - returns true if train() trains on the left-right mirror image of every
+                  training image in addition to the images themselves.  This has the same
+                  effect as calling add_image_left_right_flips() on the training data
+                  beforehand, but the mirrored images are never materialized.  Instead
+                  their features are obtained with load_left_right_flip() (see
+                  structural_svm_object_detection_problem_abstract.h), which for
+                  scan_fhog_pyramid mirrors the already extracted fHOG pyramid rather than
+                  extracting a new one.  Because that mirroring is only approximate, the
+                  learned detector may differ slightly from one trained on explicitly
+                  flipped images.
+        !*/
+
+        void set_feature_store_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - #get_feature_store_file() == filename
+        !*/
+
+        const std::string& get_feature_store_file (
+        ) const;
+        /*!
+            ensures
+                - if (get_feature_store_file() != "") then
+                    - train() writes the features of the training images to a
+                      mapped_feature_store in this file and reads them back through a
+                      memory mapping instead of holding them in RAM, so the training set
+                      can be much larger than the available memory.  The OS page cache
+                      keeps as much of it in memory as fits, and the store prefetches
+                      the features of the image the optimizer is going to visit next.
+                      The file should therefore be on a fast local disk.  It is deleted
+                      when train() returns.
+                    - This only works with image scanners that support it, e.g.
+                      scan_fhog_pyramid.  See use_feature_store() in
+                      structural_svm_object_detection_problem_abstract.h.
+                    - The trained detector is the same as without a feature store.
+                - else
+                    - train() keeps the features of all training images in RAM.
+        !*/
+
         void set_oca (
             const oca& item
         );
@@ -298,6 +484,9 @@ namespace dlib
                 - returns a function F with the following properties:
                     - F(new_image) == A prediction of what objects are present in new_image.  This
                       is a set of rectangles indicating their positions.
+                    - F.get_scanner() has the configuration of get_scanner() after
+                      clear_training_settings() was applied to it.  So settings that only
+                      help with loading the training images don't slow down F.
         !*/
 
         template <
@@ -354,6 +543,9 @@ namespace dlib
                 - returns a function F with the following properties:
                     - F(new_image) == A prediction of what objects are present in new_image.  This
                       is a set of rectangles indicating their positions.
+                    - F.get_scanner() has the configuration of get_scanner() after
+                      clear_training_settings() was applied to it.  So settings that only
+                      help with loading the training images don't slow down F.
         !*/
 
         template <
@@ -379,6 +571,229 @@ namespace dlib
                   Therefore, this version of train() is a convenience function for for the 
                   case where you don't have any movable components of the detection templates.
         !*/
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            const std::vector<const image_scanner_type*>& loaded_scanners
+        ) const;
+        /*!
+            requires
+                - is_learning_problem(images, truth_object_detections) == true
+                - ignore.size() == images.size()
+                - if (get_add_left_right_flips()) then
+                    - loaded_scanners.size() == 2*images.size()
+                - else
+                    - loaded_scanners.size() == images.size()
+                - loaded_scanners holds scanners configured like get_scanner() and
+                  loaded as required by the loaded_scanners constructor of
+                  structural_svm_object_detection_problem.
+                - for all valid i, j:
+                    - truth_object_detections[i][j].num_parts() == get_scanner().get_num_movable_components_per_detection_template()
+                    - all_parts_in_rect(truth_object_detections[i][j]) == true
+            ensures
+                - This function is identical to the train() above taking an ignore
+                  argument, except that it doesn't load any images.  It trains on the
+                  already loaded scanners instead, which it only reads.  So several
+                  trainers, possibly with different settings and running in different
+                  threads, can share one set of loaded scanners.
+                - get_feature_store_file() is not used since no features are loaded.
+                - images is still used for its size and, when flips are added, the
+                  image dimensions.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            const std::vector<const image_scanner_type*>& loaded_scanners
+        ) const;
+        /*!
+            requires
+                - get_scanner().get_num_movable_components_per_detection_template() == 0
+                - the requirements of the above train() are met.
+            ensures
+                - This function is identical to the above train(), except that it converts
+                  each element of truth_object_detections into a full_object_detection by
+                  passing it to full_object_detection's constructor taking only a rectangle.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const;
+        /*!
+            requires
+                - Cs.size() > 0
+                - for all valid i: Cs[i] > 0
+                - the requirements of the train() taking the same arguments, except for
+                  Cs, are met.
+            ensures
+                - Trains one object_detector for each value of C in Cs.  That is, returns
+                  a vector D such that D.size() == Cs.size() and D[i] solves the problem
+                  train() solves when get_c() is Cs[i], to the same get_epsilon().  The
+                  separation oracle of object detection is approximate, so D[i] need not
+                  have the same weights as what train() returns, but its objective is no
+                  worse than that one's by more than Cs[i]*get_epsilon().
+                - Unlike calling train() once per C, the images are loaded only once and
+                  the solves are warm started: C values are visited in increasing order
+                  and each solve starts from the previous solution and its still valid
+                  cutting planes (see oca_warm_start).  So a whole sweep over C typically
+                  costs a small multiple of a single call to train().
+                - If the scanner adds nuclear norm regularizers the cutting planes don't
+                  carry over between values of C, only the previous solution does.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections
+        ) const;
+        /*!
+            ensures
+                - returns train_path(Cs, images, truth_object_detections, ignore) where
+                  ignore contains images.size() empty vectors.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const;
+        /*!
+            requires
+                - get_scanner().get_num_movable_components_per_detection_template() == 0
+            ensures
+                - This function is identical to the above train_path(), except that it
+                  converts each element of truth_object_detections into a
+                  full_object_detection by passing it to full_object_detection's
+                  constructor taking only a rectangle.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const std::vector<trained_function_type> train_path (
+            const std::vector<double>& Cs,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections
+        ) const;
+        /*!
+            requires
+                - get_scanner().get_num_movable_components_per_detection_template() == 0
+            ensures
+                - returns train_path(Cs, images, truth_object_detections, ignore) where
+                  ignore contains images.size() empty vectors.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            structural_object_detection_training_state& state
+        ) const;
+        /*!
+            requires
+                - the requirements of the train() taking the same arguments, except for
+                  state, are met.
+                - if (state.num_samples() != 0) then
+                    - state was produced by train_incremental() of a trainer with the same
+                      scanner configuration, get_match_eps(), get_loss_per_missed_target()
+                      and get_loss_per_false_alarm() as this one.
+            ensures
+                - if (state.num_samples() == 0) then
+                    - Trains a detector on images just like train() does, and records the
+                      state of the training in #state.
+                - else
+                    - Trains a detector on images and, through their summaries in state,
+                      all the images state was trained on before.  Only images are
+                      loaded and scanned and the solver starts from the previous
+                      solution, so when few images are added this takes a small fraction
+                      of the time of training on all of them again.
+                    - The old images are represented by the labelings their separation
+                      oracle produced when they were last trained on (see
+                      object_detection_sample_summary).  The loss of an old image is
+                      taken to be the largest loss among those labelings, which can be
+                      smaller than its real loss once the solution moves.  The solver
+                      converges to within get_epsilon() of the optimum of that
+                      approximate problem, not of training on all the images from
+                      scratch, since the old images are never rescanned.  So the result
+                      is an approximation of a full retrain, and a good one only when the
+                      new images are a small fraction of the total.  An occasional full
+                      retrain resets it.
+                    - if (auto_set_overlap_tester() == true) then the overlap tester
+                      is made loose enough for the truth boxes of the old images as well
+                      as those of images.
+                    - get_c() and get_epsilon() may differ from the previous call.
+                - #state.num_samples() == state.num_samples() + the number of samples
+                  made from images (2*images.size() if get_add_left_right_flips(),
+                  images.size() otherwise).
+                - returns the trained detector.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            structural_object_detection_training_state& state
+        ) const;
+        /*!
+            requires
+                - get_scanner().get_num_movable_components_per_detection_template() == 0
+            ensures
+                - This function is identical to the above train_incremental(), except that
+                  it converts each element of truth_object_detections into a
+                  full_object_detection by passing it to full_object_detection's
+                  constructor taking only a rectangle.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        const trained_function_type train_incremental (
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            structural_object_detection_training_state& state
+        ) const;
+        /*!
+            requires
+                - get_scanner().get_num_movable_components_per_detection_template() == 0
+            ensures
+                - returns train_incremental(images, truth_object_detections, ignore,
+                  test_box_overlap(), state) where ignore contains images.size() empty
+                  vectors.
+        !*/
     }; 
 
 // ----------------------------------------------------------------------------------------
@@ -11,10 +11,168 @@
 #include "../array.h"
 #include "../image_processing/full_object_detection.h"
 #include "../image_processing/box_overlap_testing.h"
+#include "../image_transforms/interpolation.h"
+#include "../mapped_file/mapped_feature_store.h"
+#include <memory>
+#include <algorithm>
 
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <
+            typename image_scanner_type,
+            typename image_type
+            >
+        typename enable_if_c<sizeof(typename image_traits<image_type>::pixel_type) != 0>::type
+        load_flipped_image (
+            image_scanner_type& scanner,
+            const image_type& img,
+            int
+        )
+        {
+            image_type flipped;
+            flip_image_left_right(img, flipped);
+            scanner.load(flipped);
+        }
+
+        template <
+            typename image_scanner_type,
+            typename image_type
+            >
+        void load_flipped_image (
+            image_scanner_type& ,
+            const image_type& ,
+            long
+        )
+        {
+            // Images that scanners with custom feature extractors read in their own way
+            // have no image_traits and so can't be flipped.  This overload only keeps
+            // them compiling when left-right flips aren't asked for.
+            DLIB_CASSERT(false,
+                "\t void load_left_right_flip()"
+                << "\n\t The image type isn't a generic image, so it can't be flipped left to right."
+                );
+        }
+    }
+
+    template <
+        typename image_scanner_type,
+        typename image_type
+        >
+    void load_left_right_flip (
+        image_scanner_type& scanner,
+        const image_scanner_type& ,
+        const image_type& img
+    )
+    {
+        impl::load_flipped_image(scanner, img, 0);
+    }
+
+    template <
+        typename image_scanner_type
+        >
+    bool use_feature_store (
+        image_scanner_type& ,
+        const std::shared_ptr<mapped_feature_store>& 
+    )
+    {
+        return false;
+    }
+
+    template <
+        typename image_scanner_type
+        >
+    void clear_training_settings (
+        image_scanner_type& 
+    )
+    {
+    }
+
+    template <
+        typename image_scanner_type
+        >
+    void score_detection_windows (
+        const image_scanner_type& scanner,
+        const matrix<double,0,1>& w,
+        const std::vector<rectangle>& rects,
+        std::vector<double>& scores
+    )
+    {
+        matrix<double,0,1> psi(scanner.get_num_dimensions());
+        scores.resize(rects.size());
+        for (unsigned long i = 0; i < rects.size(); ++i)
+        {
+            psi = 0;
+            scanner.get_feature_vector(scanner.get_full_object_detection(rects[i], w), psi);
+            scores[i] = dot(psi, rowm(w, range(0, psi.size()-1)));
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct detection_window_cache
+        {
+            detection_window_cache() : floor(0), num_uses(0) {}
+
+            // The best windows of the last full scan and their scores in it.  All the
+            // other windows scored below floor.
+            std::vector<rectangle> rects;
+            std::vector<double> scores;
+            double floor;
+            // Number of times the cache was used since the last full scan.
+            unsigned long num_uses;
+        };
+
+        inline bool compare_detection_scores (
+            const std::pair<double, rectangle>& a,
+            const std::pair<double, rectangle>& b
+        )
+        {
+            return a.first < b.first;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct object_detection_sample_summary
+    {
+        matrix<double,0,1> truth_psi;
+        std::vector<double> loss;
+        std::vector<matrix<double,0,1> > psi;
+    };
+
+    inline void serialize (
+        const object_detection_sample_summary& item,
+        std::ostream& out
+    )
+    {
+        int version = 1;
+        serialize(version, out);
+        serialize(item.truth_psi, out);
+        serialize(item.loss, out);
+        serialize(item.psi, out);
+    }
+
+    inline void deserialize (
+        object_detection_sample_summary& item,
+        std::istream& in 
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version != 1)
+            throw serialization_error("Unexpected version found while deserializing dlib::object_detection_sample_summary.");
+        deserialize(item.truth_psi, in);
+        deserialize(item.loss, in);
+        deserialize(item.psi, in);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -34,64 +192,67 @@ namespace dlib
             const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
             const std::vector<std::vector<rectangle> >& ignore_,
             const test_box_overlap& ignore_overlap_tester_,
+            unsigned long num_threads = 2,
+            const bool add_left_right_flips = false,
+            const std::string& feature_store_file = ""
+        ) :
+            structural_svm_problem_threaded<matrix<double,0,1> >(num_threads),
+            boxes_overlap(overlap_tester),
+            images(images_),
+            truth_object_detections(truth_object_detections_),
+            ignore(ignore_),
+            ignore_overlap_tester(ignore_overlap_tester_),
+            match_eps(0.5),
+            loss_per_false_alarm(1),
+            loss_per_missed_target(1),
+            max_window_cache_size(0),
+            window_cache_rescan_interval(10)
+        {
+            check_and_prepare_truth(scanner, add_left_right_flips);
+
+            initialize_scanners(scanner, num_threads, add_left_right_flips, feature_store_file);
+
+            if (auto_overlap_tester)
+            {
+                auto_configure_overlap_tester();
+            }
+        }
+
+        structural_svm_object_detection_problem(
+            const std::vector<const image_scanner_type*>& loaded_scanners_,
+            const test_box_overlap& overlap_tester,
+            const bool auto_overlap_tester,
+            const image_array_type& images_,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_,
+            const test_box_overlap& ignore_overlap_tester_,
             unsigned long num_threads = 2
         ) :
             structural_svm_problem_threaded<matrix<double,0,1> >(num_threads),
             boxes_overlap(overlap_tester),
+            loaded_scanners(loaded_scanners_),
             images(images_),
             truth_object_detections(truth_object_detections_),
             ignore(ignore_),
             ignore_overlap_tester(ignore_overlap_tester_),
             match_eps(0.5),
             loss_per_false_alarm(1),
-            loss_per_missed_target(1)
+            loss_per_missed_target(1),
+            max_window_cache_size(0),
+            window_cache_rescan_interval(10)
         {
-#ifdef ENABLE_ASSERTS
             // make sure requires clause is not broken
-            DLIB_ASSERT(is_learning_problem(images_, truth_object_detections_) && 
-                        ignore_.size() == images_.size() &&
-                         scanner.get_num_detection_templates() > 0,
+            DLIB_ASSERT(images_.size() != 0 && 
+                        (loaded_scanners_.size() == images_.size() || 
+                         loaded_scanners_.size() == 2*images_.size()),
                 "\t structural_svm_object_detection_problem::structural_svm_object_detection_problem()"
                 << "\n\t Invalid inputs were given to this function "
-                << "\n\t scanner.get_num_detection_templates(): " << scanner.get_num_detection_templates()
-                << "\n\t is_learning_problem(images_,truth_object_detections_): " << is_learning_problem(images_,truth_object_detections_)
-                << "\n\t ignore.size(): " << ignore.size() 
-                << "\n\t images.size(): " << images.size() 
+                << "\n\t loaded_scanners_.size(): " << loaded_scanners_.size() 
+                << "\n\t images_.size():          " << images_.size() 
                 << "\n\t this: " << this
                 );
-            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
-            {
-                for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
-                {
-                    DLIB_ASSERT(truth_object_detections[i][j].num_parts() == scanner.get_num_movable_components_per_detection_template(),
-                        "\t trained_function_type structural_object_detection_trainer::train()"
-                        << "\n\t invalid inputs were given to this function"
-                        << "\n\t truth_object_detections["<<i<<"]["<<j<<"].num_parts():          " << 
-                            truth_object_detections[i][j].num_parts()
-                        << "\n\t scanner.get_num_movable_components_per_detection_template(): " << 
-                            scanner.get_num_movable_components_per_detection_template()
-                        << "\n\t all_parts_in_rect(truth_object_detections["<<i<<"]["<<j<<"]): " << all_parts_in_rect(truth_object_detections[i][j])
-                    );
-                }
-            }
-#endif
-            // The purpose of the max_num_dets member variable is to give us a reasonable
-            // upper limit on the number of detections we can expect from a single image.
-            // This is used in the separation_oracle to put a hard limit on the number of
-            // detections we will consider.  We do this purely for computational reasons
-            // since otherwise we can end up wasting large amounts of time on certain
-            // pathological cases during optimization which ultimately do not influence the
-            // result.  Therefore, we force the separation oracle to only consider the
-            // max_num_dets strongest detections.
-            max_num_dets = 0;
-            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
-            {
-                if (truth_object_detections[i].size() > max_num_dets)
-                    max_num_dets = truth_object_detections[i].size();
-            }
-            max_num_dets = max_num_dets*3 + 10;
 
-            initialize_scanners(scanner, num_threads);
+            check_and_prepare_truth(*loaded_scanners[0], loaded_scanners.size() != images.size());
 
             if (auto_overlap_tester)
             {
@@ -105,6 +266,13 @@ namespace dlib
             return boxes_overlap;
         }
 
+        void set_overlap_tester (
+            const test_box_overlap& tester
+        )
+        {
+            boxes_overlap = tester;
+        }
+
         void set_match_eps (
             double eps
         )
@@ -168,18 +336,197 @@ namespace dlib
             loss_per_false_alarm = loss;
         }
 
+        void set_max_window_cache_size (
+            unsigned long max_size
+        )
+        {
+            max_window_cache_size = max_size;
+            window_caches.clear();
+            window_caches.resize(loaded_scanners.size());
+        }
+
+        unsigned long get_max_window_cache_size (
+        ) const
+        {
+            return max_window_cache_size;
+        }
+
+        void set_window_cache_rescan_interval (
+            unsigned long num_iterations
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num_iterations > 0, 
+                "\t void structural_svm_object_detection_problem::set_window_cache_rescan_interval()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t num_iterations: " << num_iterations
+                << "\n\t this: " << this
+                );
+
+            window_cache_rescan_interval = num_iterations;
+        }
+
+        unsigned long get_window_cache_rescan_interval (
+        ) const
+        {
+            return window_cache_rescan_interval;
+        }
+
+        void set_summarized_samples (
+            const std::vector<object_detection_sample_summary>& samples
+        )
+        {
+#ifdef ENABLE_ASSERTS
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                DLIB_ASSERT(samples[i].truth_psi.size() == get_num_dimensions() &&
+                            samples[i].loss.size() == samples[i].psi.size(),
+                    "\t void structural_svm_object_detection_problem::set_summarized_samples()"
+                    << "\n\t Invalid inputs were given to this function "
+                    << "\n\t samples["<<i<<"].truth_psi.size(): " << samples[i].truth_psi.size()
+                    << "\n\t get_num_dimensions():          " << get_num_dimensions()
+                    << "\n\t samples["<<i<<"].loss.size():      " << samples[i].loss.size()
+                    << "\n\t samples["<<i<<"].psi.size():       " << samples[i].psi.size()
+                    << "\n\t this: " << this
+                    );
+                for (unsigned long j = 0; j < samples[i].psi.size(); ++j)
+                {
+                    DLIB_ASSERT(samples[i].psi[j].size() == get_num_dimensions(),
+                        "\t void structural_svm_object_detection_problem::set_summarized_samples()"
+                        << "\n\t Invalid inputs were given to this function "
+                        << "\n\t samples["<<i<<"].psi["<<j<<"].size(): " << samples[i].psi[j].size()
+                        << "\n\t get_num_dimensions():         " << get_num_dimensions()
+                        << "\n\t this: " << this
+                        );
+                }
+            }
+#endif
+            summarized_samples = samples;
+        }
+
+        unsigned long num_summarized_samples (
+        ) const
+        {
+            return summarized_samples.size();
+        }
+
+        void summarize_samples (
+            const matrix<double,0,1>& w,
+            std::vector<object_detection_sample_summary>& summaries
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(w.size() == get_num_dimensions(),
+                "\t void structural_svm_object_detection_problem::summarize_samples()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t w.size():             " << w.size()
+                << "\n\t get_num_dimensions(): " << get_num_dimensions()
+                << "\n\t this: " << this
+                );
+
+            summaries.resize(get_num_samples());
+            for (unsigned long i = 0; i < loaded_scanners.size(); ++i)
+            {
+                object_detection_sample_summary& summary = summaries[i];
+                get_truth_joint_feature_vector(i, summary.truth_psi);
+                this->get_cached_separation_oracle_outputs(i, summary.loss, summary.psi);
+
+                // Make sure the labeling that is most violated at w is in there, whether
+                // or not the cache is in use.
+                double loss;
+                matrix<double,0,1> psi;
+                separation_oracle(i, w, loss, psi);
+                bool have_it = false;
+                for (unsigned long j = 0; j < summary.psi.size() && !have_it; ++j)
+                    have_it = (summary.loss[j] == loss && summary.psi[j] == psi);
+                if (!have_it)
+                {
+                    summary.loss.push_back(loss);
+                    summary.psi.push_back(psi);
+                }
+            }
+            for (unsigned long i = 0; i < summarized_samples.size(); ++i)
+                summaries[loaded_scanners.size()+i] = summarized_samples[i];
+        }
+
     private:
 
-        void auto_configure_overlap_tester(
+        void check_and_prepare_truth (
+            const image_scanner_type& scanner,
+            const bool add_left_right_flips
         )
         {
-            std::vector<std::vector<rectangle> > mapped_rects(truth_object_detections.size());
+#ifdef ENABLE_ASSERTS
+            // make sure requires clause is not broken
+            DLIB_ASSERT(is_learning_problem(images, truth_object_detections) && 
+                        ignore.size() == images.size() &&
+                         scanner.get_num_detection_templates() > 0,
+                "\t structural_svm_object_detection_problem::structural_svm_object_detection_problem()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t scanner.get_num_detection_templates(): " << scanner.get_num_detection_templates()
+                << "\n\t is_learning_problem(images,truth_object_detections): " << is_learning_problem(images,truth_object_detections)
+                << "\n\t ignore.size(): " << ignore.size() 
+                << "\n\t images.size(): " << images.size() 
+                << "\n\t this: " << this
+                );
             for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
             {
-                mapped_rects[i].resize(truth_object_detections[i].size());
                 for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
                 {
-                    mapped_rects[i][j] = scanners[i].get_best_matching_rect(truth_object_detections[i][j].get_rect());
+                    DLIB_ASSERT(truth_object_detections[i][j].num_parts() == scanner.get_num_movable_components_per_detection_template(),
+                        "\t trained_function_type structural_object_detection_trainer::train()"
+                        << "\n\t invalid inputs were given to this function"
+                        << "\n\t truth_object_detections["<<i<<"]["<<j<<"].num_parts():          " << 
+                            truth_object_detections[i][j].num_parts()
+                        << "\n\t scanner.get_num_movable_components_per_detection_template(): " << 
+                            scanner.get_num_movable_components_per_detection_template()
+                        << "\n\t all_parts_in_rect(truth_object_detections["<<i<<"]["<<j<<"]): " << all_parts_in_rect(truth_object_detections[i][j])
+                    );
+                }
+            }
+#endif
+            // The purpose of the max_num_dets member variable is to give us a reasonable
+            // upper limit on the number of detections we can expect from a single image.
+            // This is used in the separation_oracle to put a hard limit on the number of
+            // detections we will consider.  We do this purely for computational reasons
+            // since otherwise we can end up wasting large amounts of time on certain
+            // pathological cases during optimization which ultimately do not influence the
+            // result.  Therefore, we force the separation oracle to only consider the
+            // max_num_dets strongest detections.
+            max_num_dets = 0;
+            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
+            {
+                if (truth_object_detections[i].size() > max_num_dets)
+                    max_num_dets = truth_object_detections[i].size();
+            }
+            max_num_dets = max_num_dets*3 + 10;
+
+            if (add_left_right_flips)
+            {
+                flipped_truth_object_detections.resize(images.size());
+                flipped_ignore.resize(images.size());
+                for (unsigned long i = 0; i < images.size(); ++i)
+                {
+                    const rectangle window = get_rect(images[i]);
+                    for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
+                        flipped_truth_object_detections[i].push_back(flip_left_right(truth_object_detections[i][j], window));
+                    for (unsigned long j = 0; j < ignore[i].size(); ++j)
+                        flipped_ignore[i].push_back(impl::flip_rect_left_right(ignore[i][j], window));
+                }
+            }
+        }
+
+        void auto_configure_overlap_tester(
+        )
+        {
+            std::vector<std::vector<rectangle> > mapped_rects(loaded_scanners.size());
+            for (unsigned long i = 0; i < loaded_scanners.size(); ++i)
+            {
+                const std::vector<full_object_detection>& truth = get_truth(i);
+                mapped_rects[i].resize(truth.size());
+                for (unsigned long j = 0; j < truth.size(); ++j)
+                {
+                    mapped_rects[i][j] = loaded_scanners[i]->get_best_matching_rect(truth[j].get_rect());
                 }
             }
 
@@ -190,14 +537,14 @@ namespace dlib
         virtual long get_num_dimensions (
         ) const 
         {
-            return scanners[0].get_num_dimensions() + 
+            return loaded_scanners[0]->get_num_dimensions() + 
                 1;// for threshold
         }
 
         virtual long get_num_samples (
         ) const 
         {
-            return images.size();
+            return loaded_scanners.size() + summarized_samples.size();
         }
 
         virtual void get_truth_joint_feature_vector (
@@ -205,18 +552,25 @@ namespace dlib
             feature_vector_type& psi 
         ) const 
         {
-            const image_scanner_type& scanner = scanners[idx];
+            if (idx >= (long)loaded_scanners.size())
+            {
+                psi = summarized_samples[idx-loaded_scanners.size()].truth_psi;
+                return;
+            }
+
+            const image_scanner_type& scanner = *loaded_scanners[idx];
+            const std::vector<full_object_detection>& truth_dets = get_truth(idx);
 
             psi.set_size(get_num_dimensions());
             std::vector<rectangle> mapped_rects;
 
             psi = 0;
-            for (unsigned long i = 0; i < truth_object_detections[idx].size(); ++i)
+            for (unsigned long i = 0; i < truth_dets.size(); ++i)
             {
-                mapped_rects.push_back(scanner.get_best_matching_rect(truth_object_detections[idx][i].get_rect()));
-                scanner.get_feature_vector(truth_object_detections[idx][i], psi);
+                mapped_rects.push_back(scanner.get_best_matching_rect(truth_dets[i].get_rect()));
+                scanner.get_feature_vector(truth_dets[i], psi);
             }
-            psi(scanner.get_num_dimensions()) = -1.0*truth_object_detections[idx].size();
+            psi(scanner.get_num_dimensions()) = -1.0*truth_dets.size();
 
             // check if any of the boxes overlap.  If they do then it is impossible for
             // us to learn to correctly classify this sample
@@ -258,8 +612,8 @@ namespace dlib
             // truth rectangles.
             for (unsigned long i = 0; i < mapped_rects.size(); ++i)
             {
-                const double area = (truth_object_detections[idx][i].get_rect().intersect(mapped_rects[i])).area();
-                const double total_area = (truth_object_detections[idx][i].get_rect() + mapped_rects[i]).area();
+                const double area = (truth_dets[i].get_rect().intersect(mapped_rects[i])).area();
+                const double total_area = (truth_dets[i].get_rect() + mapped_rects[i]).area();
                 if (area/total_area <= match_eps)
                 {
                     using namespace std;
@@ -283,9 +637,9 @@ namespace dlib
                     sout << "image index              "<< idx << endl;
                     sout << "match_eps:               "<< match_eps << endl;
                     sout << "best possible match:     "<< area/total_area << endl;
-                    sout << "truth rect:              "<< truth_object_detections[idx][i].get_rect() << endl;
-                    sout << "truth rect width/height: "<< truth_object_detections[idx][i].get_rect().width()/(double)truth_object_detections[idx][i].get_rect().height() << endl;
-                    sout << "truth rect area:         "<< truth_object_detections[idx][i].get_rect().area() << endl;
+                    sout << "truth rect:              "<< truth_dets[i].get_rect() << endl;
+                    sout << "truth rect width/height: "<< truth_dets[i].get_rect().width()/(double)truth_dets[i].get_rect().height() << endl;
+                    sout << "truth rect area:         "<< truth_dets[i].get_rect().area() << endl;
                     sout << "nearest detection template rect:              "<< mapped_rects[i] << endl;
                     sout << "nearest detection template rect width/height: "<< mapped_rects[i].width()/(double)mapped_rects[i].height() << endl;
                     sout << "nearest detection template rect area:         "<< mapped_rects[i].area() << endl;
@@ -302,25 +656,32 @@ namespace dlib
             feature_vector_type& psi
         ) const 
         {
-            const image_scanner_type& scanner = scanners[idx];
+            if (idx >= (long)loaded_scanners.size())
+            {
+                summarized_separation_oracle(summarized_samples[idx-loaded_scanners.size()], current_solution, loss, psi);
+                return;
+            }
+
+            const image_scanner_type& scanner = *loaded_scanners[idx];
+            const std::vector<full_object_detection>& truth_dets = get_truth(idx);
 
             std::vector<std::pair<double, rectangle> > dets;
             const double thresh = current_solution(scanner.get_num_dimensions());
 
 
-            scanner.detect(current_solution, dets, thresh-loss_per_false_alarm);
+            detect(idx, scanner, current_solution, thresh-loss_per_false_alarm, dets);
 
 
             // The loss will measure the number of incorrect detections.  A detection is
             // incorrect if it doesn't hit a truth rectangle or if it is a duplicate detection
             // on a truth rectangle.
-            loss = truth_object_detections[idx].size()*loss_per_missed_target;
+            loss = truth_dets.size()*loss_per_missed_target;
 
             // Measure the loss augmented score for the detections which hit a truth rect.
-            std::vector<double> truth_score_hits(truth_object_detections[idx].size(), 0);
+            std::vector<double> truth_score_hits(truth_dets.size(), 0);
 
             // keep track of which truth boxes we have hit so far.
-            std::vector<bool> hit_truth_table(truth_object_detections[idx].size(), false);
+            std::vector<bool> hit_truth_table(truth_dets.size(), false);
 
             std::vector<rectangle> final_dets;
             // The point of this loop is to fill out the truth_score_hits array. 
@@ -329,7 +690,7 @@ namespace dlib
                 if (overlaps_any_box(boxes_overlap, final_dets, dets[i].second))
                     continue;
 
-                const std::pair<double,unsigned int> truth = find_best_match(truth_object_detections[idx], dets[i].second);
+                const std::pair<double,unsigned int> truth = find_best_match(truth_dets, dets[i].second);
 
                 final_dets.push_back(dets[i].second);
 
@@ -366,7 +727,7 @@ namespace dlib
                 if (overlaps_any_box(boxes_overlap, final_dets, dets[i].second))
                     continue;
 
-                const std::pair<double,unsigned int> truth = find_best_match(truth_object_detections[idx], dets[i].second);
+                const std::pair<double,unsigned int> truth = find_best_match(truth_dets, dets[i].second);
 
                 const double truth_match = truth.first;
                 if (truth_match > match_eps)
@@ -423,14 +784,125 @@ namespace dlib
         }
 
 
+        void detect (
+            const long idx,
+            const image_scanner_type& scanner,
+            const matrix_type& w,
+            const double thresh,
+            std::vector<std::pair<double, rectangle> >& dets
+        ) const
+        /*!
+            ensures
+                - performs scanner.detect(w, dets, thresh), but only scores the windows
+                  cached for the idx-th sample while the cache doesn't look stale.
+        !*/
+        {
+            if (max_window_cache_size == 0)
+            {
+                scanner.detect(w, dets, thresh);
+                return;
+            }
+
+            impl::detection_window_cache& cache = window_caches[idx];
+            if (!separation_oracle_must_be_exact() && cache.rects.size() != 0 &&
+                cache.num_uses < window_cache_rescan_interval)
+            {
+                // The windows that aren't cached scored below cache.floor in the last
+                // full scan.  If they moved by as much as the cached ones and could now
+                // reach thresh then the cache is stale.  Scoring goes in batches so a
+                // stale cache is usually noticed before all of it has been scored.
+                const unsigned long batch_size = 64;
+                std::vector<rectangle> batch;
+                std::vector<double> scores;
+                dets.clear();
+                double max_change = 0;
+                for (unsigned long i = 0; i < cache.rects.size() && cache.floor + max_change < thresh; i += batch_size)
+                {
+                    const unsigned long end = std::min<unsigned long>(i+batch_size, cache.rects.size());
+                    batch.assign(cache.rects.begin()+i, cache.rects.begin()+end);
+                    score_detection_windows(scanner, w, batch, scores);
+                    for (unsigned long j = 0; j < scores.size(); ++j)
+                    {
+                        max_change = std::max(max_change, std::abs(scores[j]-cache.scores[i+j]));
+                        if (scores[j] >= thresh)
+                            dets.push_back(std::make_pair(scores[j], batch[j]));
+                    }
+                }
+
+                if (cache.floor + max_change < thresh)
+                {
+                    ++cache.num_uses;
+                    std::sort(dets.rbegin(), dets.rend(), impl::compare_detection_scores);
+                    return;
+                }
+            }
+
+            // Scan with some slack below thresh so the cache stays usable while w moves a
+            // bit.
+            const double cache_thresh = thresh - loss_per_false_alarm;
+            scanner.detect(w, dets, cache_thresh);
+
+            const unsigned long num = std::min<unsigned long>(dets.size(), max_window_cache_size);
+            cache.floor = (num < dets.size()) ? dets[num].first : cache_thresh;
+            cache.num_uses = 0;
+            cache.rects.resize(num);
+            cache.scores.resize(num);
+            for (unsigned long i = 0; i < num; ++i)
+            {
+                cache.rects[i] = dets[i].second;
+                cache.scores[i] = dets[i].first;
+            }
+
+            while (dets.size() != 0 && dets.back().first < thresh)
+                dets.pop_back();
+        }
+
+        static void summarized_separation_oracle (
+            const object_detection_sample_summary& sample,
+            const matrix_type& current_solution,
+            scalar_type& loss,
+            feature_vector_type& psi
+        )
+        /*!
+            ensures
+                - Finds the most violated labeling of a sample that is only known by its
+                  summary.  The candidates are the truth, which has a loss of 0, and the
+                  labelings recorded in the summary.
+        !*/
+        {
+            unsigned long best = sample.psi.size();
+            double best_score = dot(sample.truth_psi, current_solution);
+            for (unsigned long i = 0; i < sample.psi.size(); ++i)
+            {
+                const double score = sample.loss[i] + dot(sample.psi[i], current_solution);
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = i;
+                }
+            }
+
+            if (best == sample.psi.size())
+            {
+                loss = 0;
+                psi = sample.truth_psi;
+            }
+            else
+            {
+                loss = sample.loss[best];
+                psi = sample.psi[best];
+            }
+        }
+
         bool overlaps_ignore_box (
             const long idx,
             const dlib::rectangle& rect
         ) const
         {
-            for (unsigned long i = 0; i < ignore[idx].size(); ++i)
+            const std::vector<rectangle>& ignore_rects = get_ignore(idx);
+            for (unsigned long i = 0; i < ignore_rects.size(); ++i)
             {
-                if (ignore_overlap_tester(ignore[idx][i], rect))
+                if (ignore_overlap_tester(ignore_rects[i], rect))
                     return true;
             }
             return false;
@@ -471,6 +943,42 @@ namespace dlib
             return std::make_pair(match,best_idx);
         }
 
+        const std::vector<full_object_detection>& get_truth (
+            unsigned long idx
+        ) const
+        {
+            if (idx < images.size())
+                return truth_object_detections[idx];
+            else
+                return flipped_truth_object_detections[idx-images.size()];
+        }
+
+        const std::vector<rectangle>& get_ignore (
+            unsigned long idx
+        ) const
+        {
+            if (idx < images.size())
+                return ignore[idx];
+            else
+                return flipped_ignore[idx-images.size()];
+        }
+
+        static full_object_detection flip_left_right (
+            const full_object_detection& obj,
+            const rectangle& window
+        )
+        {
+            std::vector<point> parts(obj.num_parts());
+            for (unsigned long i = 0; i < parts.size(); ++i)
+            {
+                if (obj.part(i) == OBJECT_PART_NOT_PRESENT)
+                    parts[i] = OBJECT_PART_NOT_PRESENT;
+                else
+                    parts[i] = point(window.right()-(obj.part(i).x()-window.left()), obj.part(i).y());
+            }
+            return full_object_detection(impl::flip_rect_left_right(obj.get_rect(), window), parts);
+        }
+
         struct init_scanners_helper
         {
             init_scanners_helper (
@@ -490,35 +998,93 @@ namespace dlib
             }
         };
 
+        struct init_flipped_scanners_helper
+        {
+            init_flipped_scanners_helper (
+                array<image_scanner_type>& scanners_,
+                const image_array_type& images_
+            ) :
+                scanners(scanners_),
+                images(images_)
+            {}
+
+            array<image_scanner_type>& scanners;
+            const image_array_type& images;
+
+            void operator() (long i ) const
+            {
+                load_left_right_flip(scanners[images.size()+i], scanners[i], images[i]);
+            }
+        };
+
         void initialize_scanners (
             const image_scanner_type& scanner,
-            unsigned long num_threads
+            unsigned long num_threads,
+            const bool add_left_right_flips,
+            const std::string& feature_store_file
         )
         {
-            scanners.set_max_size(images.size());
-            scanners.set_size(images.size());
+            const unsigned long num = add_left_right_flips ? 2*images.size() : images.size();
+            scanners.set_max_size(num);
+            scanners.set_size(num);
 
             for (unsigned long i = 0; i < scanners.size(); ++i)
                 scanners[i].copy_configuration(scanner);
 
+            if (feature_store_file.size() != 0)
+            {
+                std::shared_ptr<mapped_feature_store> store(new mapped_feature_store(feature_store_file));
+                for (unsigned long i = 0; i < scanners.size(); ++i)
+                {
+                    // Scanners without store support simply keep their features in RAM.
+                    if (!use_feature_store(scanners[i], store))
+                        break;
+                }
+            }
+
             // now load the images into all the scanners
-            parallel_for(num_threads, 0, scanners.size(), init_scanners_helper(scanners, images));
+            parallel_for(num_threads, 0, images.size(), init_scanners_helper(scanners, images));
+
+            // The mirrored samples go after the originals.  Scanners that know how are
+            // allowed to derive them from the already loaded originals.
+            if (add_left_right_flips)
+                parallel_for(num_threads, 0, images.size(), init_flipped_scanners_helper(scanners, images));
+
+            loaded_scanners.resize(scanners.size());
+            for (unsigned long i = 0; i < scanners.size(); ++i)
+                loaded_scanners[i] = &scanners[i];
         }
 
 
         test_box_overlap boxes_overlap;
 
-        mutable array<image_scanner_type> scanners;
+        // The scanners the problem is solved over.  They either point into scanners
+        // or into a set of scanners the caller loaded and shares with other problems.
+        array<image_scanner_type> scanners;
+        std::vector<const image_scanner_type*> loaded_scanners;
+
+        // Samples that aren't loaded but are represented by their summaries.  They come
+        // after the loaded ones.
+        std::vector<object_detection_sample_summary> summarized_samples;
 
         const image_array_type& images;
         const std::vector<std::vector<full_object_detection> >& truth_object_detections;
         const std::vector<std::vector<rectangle> >& ignore;
         const test_box_overlap ignore_overlap_tester;
 
+        std::vector<std::vector<full_object_detection> > flipped_truth_object_detections;
+        std::vector<std::vector<rectangle> > flipped_ignore;
+
         unsigned long max_num_dets;
         double match_eps;
         double loss_per_false_alarm;
         double loss_per_missed_target;
+
+        // Per sample caches of the best scoring windows, used by detect() to skip most
+        // of the full scans.
+        unsigned long max_window_cache_size;
+        unsigned long window_cache_rescan_interval;
+        mutable std::vector<impl::detection_window_cache> window_caches;
     };
 
 // ----------------------------------------------------------------------------------------
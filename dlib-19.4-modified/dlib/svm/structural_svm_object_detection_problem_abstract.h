@@ -8,10 +8,146 @@
 #include <sstream>
 #include "../image_processing/full_object_detection_abstract.h"
 #include "../image_processing/box_overlap_testing.h"
+#include "../mapped_file/mapped_feature_store_abstract.h"
+#include <memory>
 
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type,
+        typename image_type
+        >
+    void load_left_right_flip (
+        image_scanner_type& scanner,
+        const image_scanner_type& loaded_scanner,
+        const image_type& img
+    );
+    /*!
+        requires
+            - loaded_scanner has been loaded with img
+            - scanner has the same configuration as loaded_scanner
+            - image_type implements the generic image interface defined in
+              dlib/image_processing/generic_image.h, or there is an overload of this
+              function for image_scanner_type.
+        ensures
+            - #scanner is loaded with the left-right mirror image of img.  This generic
+              version simply flips img with flip_image_left_right() and calls
+              scanner.load() on the result.
+            - This function is the hook structural_svm_object_detection_problem uses to
+              create mirrored training samples.  Image scanners that can derive the
+              features of a mirrored image from loaded_scanner more cheaply than by
+              extracting them again should provide an overload of this function in their
+              own namespace, as scan_fhog_pyramid does.
+    !*/
+
+    template <
+        typename image_scanner_type
+        >
+    bool use_feature_store (
+        image_scanner_type& scanner,
+        const std::shared_ptr<mapped_feature_store>& store
+    );
+    /*!
+        ensures
+            - This function is the hook structural_svm_object_detection_problem uses to
+              keep the features of its training images out of RAM.  It is called on
+              each scanner before it is loaded.  Scanners that can keep the features of
+              the image they are loaded with in a mapped_feature_store should provide
+              an overload of this function in their own namespace which makes scanner
+              use store and returns true, as scan_fhog_pyramid does.
+            - This generic version does nothing and returns false.
+    !*/
+
+    template <
+        typename image_scanner_type
+        >
+    void clear_training_settings (
+        image_scanner_type& scanner
+    );
+    /*!
+        ensures
+            - This function is the hook structural_object_detection_trainer uses on the
+              scanner configuration it puts into the object_detectors it returns.
+              Scanners with settings that only make sense while loading training images
+              (e.g. ones that trade detection speed or accuracy for training memory)
+              should provide an overload of this function in their own namespace which
+              sets them back to their defaults, as scan_fhog_pyramid does.
+            - This generic version does nothing.
+    !*/
+
+    template <
+        typename image_scanner_type
+        >
+    void score_detection_windows (
+        const image_scanner_type& scanner,
+        const matrix<double,0,1>& w,
+        const std::vector<rectangle>& rects,
+        std::vector<double>& scores
+    );
+    /*!
+        requires
+            - scanner.is_loaded_with_image() == true
+            - w.size() >= scanner.get_num_dimensions()
+            - all the rects were output by scanner.detect()
+        ensures
+            - This function is the hook structural_svm_object_detection_problem uses to
+              score the windows in its window cache (see set_max_window_cache_size()).
+            - #scores.size() == rects.size()
+            - for all valid i:
+                - #scores[i] == the score scanner.detect(w,...) gives rects[i], i.e. the
+                  dot product of w with the feature vector get_feature_vector() gives
+                  for rects[i].
+            - This generic version calls get_feature_vector() for every rectangle.
+              Scanners that can score a window without building its feature vector
+              should provide an overload in their own namespace, as scan_fhog_pyramid
+              does.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct object_detection_sample_summary
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object stands in for a training sample of a
+                structural_svm_object_detection_problem whose image isn't loaded.  It
+                holds the joint feature vector of the sample's truth, truth_psi, and a
+                few labelings of the sample with their losses and joint feature vectors,
+                loss[i] and psi[i].  These are the labelings the separation oracle
+                returned for the sample while training, i.e. the ones that mattered.
+
+                Using a summary in place of the sample restricts the separation oracle to
+                these labelings, so the risk of the sample is underestimated for weight
+                vectors far from where the labelings were found.  Close to there the
+                summary is accurate.
+
+                loss.size() == psi.size() must hold.
+        !*/
+
+        matrix<double,0,1> truth_psi;
+        std::vector<double> loss;
+        std::vector<matrix<double,0,1> > psi;
+    };
+
+    void serialize (
+        const object_detection_sample_summary& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support 
+    !*/
+
+    void deserialize (
+        object_detection_sample_summary& item,
+        std::istream& in 
+    );
+    /*!
+        provides deserialization support 
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -55,7 +191,9 @@ namespace dlib
             const std::vector<std::vector<full_object_detection> >& truth_object_detections,
             const std::vector<std::vector<rectangle> >& ignore,
             const test_box_overlap& ignore_overlap_tester,
-            unsigned long num_threads = 2
+            unsigned long num_threads = 2,
+            const bool add_left_right_flips = false,
+            const std::string& feature_store_file = ""
         );
         /*!
             requires
@@ -90,6 +228,8 @@ namespace dlib
                   available processing cores on your machine.
                 - #get_loss_per_missed_target() == 1
                 - #get_loss_per_false_alarm() == 1
+                - #get_max_window_cache_size() == 0
+                - #get_window_cache_rescan_interval() == 10
                 - for all valid i:
                     - Within images[i] any detections that match against a rectangle in
                       ignore[i], according to ignore_overlap_tester, are ignored.  That is,
@@ -99,6 +239,69 @@ namespace dlib
                       in your dataset that you are unsure you want to detect or otherwise
                       don't care if the detector gets or doesn't then you can mark them
                       with ignore rectangles and the optimizer will simply ignore them. 
+                - if (add_left_right_flips == true) then
+                    - The problem also contains the left-right mirror image of every
+                      sample, with its truth and ignore rectangles flipped accordingly.
+                      That is, the result is what you would get by first calling
+                      add_image_left_right_flips() on the training data, except that the
+                      mirrored scanners are loaded with load_left_right_flip() and so
+                      may be derived from the already loaded originals instead of from
+                      flipped copies of the images.  Since load_left_right_flip() is
+                      allowed to approximate, the trained result isn't necessarily
+                      bit-for-bit identical to training on explicitly flipped images.
+                    - Object parts, if any, are mirrored in place and keep their
+                      indices.
+                - if (feature_store_file != "") then
+                    - The features of every sample are written to a mapped_feature_store
+                      in the file feature_store_file, by way of use_feature_store(), and
+                      read back through a memory mapping by the separation oracle.  So
+                      they are held by the OS page cache rather than by this object,
+                      which lets it train on more feature data than fits in RAM.  The
+                      learned parameters are the same either way.
+                    - The file is deleted when this object is destroyed.
+                    - If image_scanner_type doesn't support a store, i.e. the generic
+                      use_feature_store() is used, the features are kept in RAM as
+                      usual.
+        !*/
+
+        structural_svm_object_detection_problem(
+            const std::vector<const image_scanner_type*>& loaded_scanners,
+            const test_box_overlap& overlap_tester,
+            const bool auto_overlap_tester,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            const test_box_overlap& ignore_overlap_tester,
+            unsigned long num_threads = 2
+        );
+        /*!
+            requires
+                - is_learning_problem(images, truth_object_detections)
+                - ignore.size() == images.size()
+                - loaded_scanners.size() == images.size() ||
+                  loaded_scanners.size() == 2*images.size()
+                - All the scanners in loaded_scanners have the same configuration,
+                  get_num_detection_templates() > 0, and:
+                    - for all i < images.size(): loaded_scanners[i] has been loaded
+                      with images[i].
+                    - for all i >= images.size(): loaded_scanners[i] has been loaded
+                      with the left-right mirror image of images[i-images.size()], e.g.
+                      by load_left_right_flip().
+                - The const member functions of the scanners can safely be called from
+                  several threads at once (scan_fhog_pyramid's can).
+                - The scanners remain valid and unmodified for the lifetime of *this.
+                - for all valid i, j:
+                    - truth_object_detections[i][j].num_parts() == loaded_scanners[0]->get_num_movable_components_per_detection_template()
+                    - all_parts_in_rect(truth_object_detections[i][j]) == true
+            ensures
+                - Sets up the same learning problem as the constructor above does with
+                  add_left_right_flips == (loaded_scanners.size() == 2*images.size()),
+                  except that the samples are the given, already loaded scanners rather
+                  than scanners this object loads itself.  Nothing is copied, so any
+                  number of problems may share one set of loaded scanners, e.g. to try
+                  many values of C side by side while paying for feature extraction and
+                  feature memory only once.  The scanners are only used through const
+                  member functions.
         !*/
 
         test_box_overlap get_overlap_tester (
@@ -108,6 +311,14 @@ namespace dlib
                 - returns the overlap tester used by this object.  
         !*/
 
+        void set_overlap_tester (
+            const test_box_overlap& tester
+        );
+        /*!
+            ensures
+                - #get_overlap_tester() == tester
+        !*/
+
         void set_match_eps (
             double eps
         );
@@ -166,6 +377,104 @@ namespace dlib
                 - #get_loss_per_false_alarm() == loss
         !*/
 
+        unsigned long get_max_window_cache_size (
+        ) const;
+        /*!
+            ensures
+                - The separation oracle has to scan the whole feature pyramid of a sample,
+                  although the windows that matter to it change slowly from one iteration
+                  to the next.  So each full scan keeps the get_max_window_cache_size()
+                  best scoring windows of the sample and the following iterations only
+                  score those, with score_detection_windows().  That is, until the cache
+                  looks stale: the windows left out of it scored below the last cached one
+                  in the full scan, and if they could have risen by as much as the cached
+                  windows did since and reached the oracle's detection threshold, the
+                  sample is scanned in full again.  It is also scanned in full after
+                  get_window_cache_rescan_interval() uses of its cache.
+                - The cached scans are only an approximation of the separation oracle,
+                  but every iteration that can end the optimization uses full scans.  So,
+                  like with the cache of separation oracle outputs, the solution is still
+                  within get_epsilon() of optimal.  Since any iteration can end it when
+                  get_max_cache_size() == 0, the window cache is only used along with
+                  the cache of separation oracle outputs.
+                - The cache holds a rectangle and a score per window, so its memory use
+                  is negligible.
+                - returns the number of windows cached per sample.  0 means the window
+                  cache is disabled.
+        !*/
+
+        void set_max_window_cache_size (
+            unsigned long max_size
+        );
+        /*!
+            ensures
+                - #get_max_window_cache_size() == max_size
+        !*/
+
+        unsigned long get_window_cache_rescan_interval (
+        ) const;
+        /*!
+            ensures
+                - returns the largest number of iterations the window cache of a sample is
+                  used for before its pyramid is scanned in full again.
+        !*/
+
+        void set_window_cache_rescan_interval (
+            unsigned long num_iterations
+        );
+        /*!
+            requires
+                - num_iterations > 0
+            ensures
+                - #get_window_cache_rescan_interval() == num_iterations
+        !*/
+
+        void set_summarized_samples (
+            const std::vector<object_detection_sample_summary>& samples
+        );
+        /*!
+            requires
+                - The problem hasn't been solved yet.
+                - for all valid i:
+                    - samples[i].truth_psi.size() == get_num_dimensions()
+                    - samples[i].loss.size() == samples[i].psi.size()
+                    - all the samples[i].psi have get_num_dimensions() elements.
+                - samples were made by summarize_samples() of a problem with the same
+                  scanner configuration, overlap tester and losses as this one.
+            ensures
+                - Adds samples to the problem.  They come after the samples of the loaded
+                  images, so #get_num_samples() == (number of loaded scanners) + samples.size().
+                  This lets the images a detector was trained on earlier take part in
+                  training again without reloading them (see
+                  structural_object_detection_trainer::train_incremental()).
+                - #num_summarized_samples() == samples.size()
+        !*/
+
+        unsigned long num_summarized_samples (
+        ) const;
+        /*!
+            ensures
+                - returns the number of samples that were added by
+                  set_summarized_samples().
+        !*/
+
+        void summarize_samples (
+            const matrix<double,0,1>& w,
+            std::vector<object_detection_sample_summary>& summaries
+        ) const;
+        /*!
+            requires
+                - w.size() == get_num_dimensions()
+                - w is the solution this problem was solved for, or close to it.
+            ensures
+                - #summaries.size() == get_num_samples()
+                - Summarizes every sample of this problem, in order.  The summary of a
+                  sample whose image is loaded holds the labelings in its separation
+                  oracle cache plus the result of running the separation oracle at w.
+                  The summaries given to set_summarized_samples() are copied as they
+                  are.
+        !*/
+
     };
 
 // ----------------------------------------------------------------------------------------
@@ -25,6 +25,124 @@ namespace dlib
             long nc;
             double regularization_strength;
         };
+
+    // ----------------------------------------------------------------------------------------
+
+        class compact_column_vector
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds a dense column vector in less memory.  The values are
+                    stored as floats and long runs of zeros aren't stored at all.  So it
+                    holds the psi vectors in the separation oracle cache when
+                    structural_svm_problem::get_compact_cache() == true.
+            !*/
+        public:
+
+            compact_column_vector (
+            ) : dims(0) {}
+
+            template <typename T, typename MM, typename L>
+            void assign (
+                const matrix<T,0,1,MM,L>& v
+            )
+            {
+                // Zero runs shorter than this are cheaper to store than to skip.
+                const long min_zero_run = 8;
+
+                dims = v.size();
+                runs.clear();
+                values.clear();
+                long i = 0;
+                while (i < dims)
+                {
+                    while (i < dims && v(i) == 0)
+                        ++i;
+                    if (i == dims)
+                        break;
+
+                    // find the end of this run, i.e. the next min_zero_run zeros in a row
+                    const long begin = i;
+                    long end = i;
+                    for (long num_zeros = 0; i < dims && num_zeros < min_zero_run; ++i)
+                    {
+                        if (v(i) == 0)
+                        {
+                            ++num_zeros;
+                        }
+                        else
+                        {
+                            num_zeros = 0;
+                            end = i+1;
+                        }
+                    }
+
+                    runs.push_back(std::make_pair(begin, end-begin));
+                    for (long j = begin; j < end; ++j)
+                        values.push_back(v(j));
+                    i = end;
+                }
+
+                // make sure the vectors don't use more RAM than is necessary
+                std::vector<std::pair<long,long> >(runs).swap(runs);
+                std::vector<float>(values).swap(values);
+            }
+
+            // Only dense column vectors are ever stored in this object.
+            template <typename T>
+            void assign (
+                const T& 
+            ) {}
+
+            template <typename T, typename MM, typename L>
+            void get (
+                matrix<T,0,1,MM,L>& v
+            ) const
+            {
+                v.set_size(dims);
+                v = 0;
+                const float* val = values.size() != 0 ? &values[0] : 0;
+                for (unsigned long r = 0; r < runs.size(); ++r)
+                {
+                    const long begin = runs[r].first;
+                    const long len = runs[r].second;
+                    for (long j = 0; j < len; ++j)
+                        v(begin+j) = val[j];
+                    val += len;
+                }
+            }
+
+            template <typename T>
+            void get (
+                T& 
+            ) const {}
+
+            template <typename T, typename MM, typename L>
+            T dot (
+                const matrix<T,0,1,MM,L>& w
+            ) const
+            {
+                const float* val = values.size() != 0 ? &values[0] : 0;
+                const T* wp = w.size() != 0 ? &w(0) : 0;
+                T sum = 0;
+                for (unsigned long r = 0; r < runs.size(); ++r)
+                {
+                    const T* wr = wp + runs[r].first;
+                    const long len = runs[r].second;
+                    // plain loop over contiguous memory so the compiler vectorizes it
+                    for (long j = 0; j < len; ++j)
+                        sum += val[j]*wr[j];
+                    val += len;
+                }
+                return sum;
+            }
+
+        private:
+            long dims;
+            // (first index, length) of each stored run, in order, and their values
+            std::vector<std::pair<long,long> > runs;
+            std::vector<float> values;
+        };
     }
 
 // ----------------------------------------------------------------------------------------
@@ -37,7 +155,7 @@ namespace dlib
     public:
 
         cache_element_structural_svm (
-        ) : prob(0), sample_idx(0), last_true_risk_computed(std::numeric_limits<double>::infinity()) {}
+        ) : prob(0), sample_idx(0), compact(false), last_true_risk_computed(std::numeric_limits<double>::infinity()) {}
 
         typedef typename structural_svm_problem::scalar_type scalar_type;
         typedef typename structural_svm_problem::matrix_type matrix_type;
@@ -55,9 +173,11 @@ namespace dlib
         {
             prob = prob_;
             sample_idx = idx;
+            compact = prob->get_compact_cache() && is_matrix<feature_vector_type>::value;
 
             loss.clear();
             psi.clear();
+            compact_psi.clear();
             lru_count.clear();
 
             if (prob->get_max_cache_size() != 0)
@@ -105,7 +225,7 @@ namespace dlib
                 // figure out which element in the cache is the best (i.e. has the biggest risk)
                 for (unsigned long i = 0; i < loss.size(); ++i)
                 {
-                    const scalar_type risk = loss[i] + dot(psi[i], current_solution) - dot_true_psi;
+                    const scalar_type risk = loss[i] + cached_dot(i, current_solution) - dot_true_psi;
                     if (risk > best_risk)
                     {
                         best_risk = risk;
@@ -125,7 +245,7 @@ namespace dlib
                     if ((best_risk + saved_current_risk_gap > last_true_risk_computed &&
                         best_risk >= 0) || use_only_cache)
                     {
-                        out_psi = psi[best_idx];
+                        get_cached_psi(best_idx, out_psi);
                         lru_count[best_idx] = max_lru_count + 1;
                         return;
                     }
@@ -160,7 +280,7 @@ namespace dlib
             // element from the cache.
             else if (last_true_risk_computed < best_risk) 
             {
-                out_psi = psi[best_idx];
+                get_cached_psi(best_idx, out_psi);
                 out_loss = loss[best_idx];
                 lru_count[best_idx] = max_lru_count + 1;
             }
@@ -172,7 +292,10 @@ namespace dlib
 
                 // save our new data in the cache
                 loss[i] = out_loss;
-                psi[i]  = out_psi;
+                if (compact)
+                    compact_psi[i].assign(out_psi);
+                else
+                    psi[i]  = out_psi;
 
                 const long max_use = max(mat(lru_count));
                 // Make sure this new cache entry has the best lru count since we have used
@@ -184,7 +307,15 @@ namespace dlib
                 // In this case we just append the new psi into the cache.
 
                 loss.push_back(out_loss);
-                psi.push_back(out_psi);
+                if (compact)
+                {
+                    compact_psi.push_back(impl::compact_column_vector());
+                    compact_psi.back().assign(out_psi);
+                }
+                else
+                {
+                    psi.push_back(out_psi);
+                }
                 long max_use = 1;
                 if (lru_count.size() != 0)
                     max_use = max(mat(lru_count)) + 1;
@@ -192,7 +323,48 @@ namespace dlib
             }
         }
 
+        void get_cached_outputs (
+            std::vector<scalar_type>& loss_,
+            std::vector<feature_vector_type>& psi_
+        ) const
+        {
+            loss_ = loss;
+            if (compact)
+            {
+                psi_.resize(compact_psi.size());
+                for (unsigned long i = 0; i < compact_psi.size(); ++i)
+                    compact_psi[i].get(psi_[i]);
+            }
+            else
+            {
+                psi_ = psi;
+            }
+        }
+
     private:
+
+        scalar_type cached_dot (
+            unsigned long i,
+            const matrix_type& current_solution
+        ) const
+        {
+            if (compact)
+                return compact_psi[i].dot(current_solution);
+            else
+                return dot(psi[i], current_solution);
+        }
+
+        void get_cached_psi (
+            unsigned long i,
+            feature_vector_type& out_psi
+        ) const
+        {
+            if (compact)
+                compact_psi[i].get(out_psi);
+            else
+                out_psi = psi[i];
+        }
+
         // Do nothing if T isn't actually a sparse vector
         template <typename T> void compact_sparse_vector( T& ) const { }
 
@@ -218,10 +390,13 @@ namespace dlib
         const structural_svm_problem* prob;
 
         long sample_idx;
+        bool compact;
 
         mutable feature_vector_type true_psi;
         mutable std::vector<scalar_type> loss;
         mutable std::vector<feature_vector_type> psi;
+        // used instead of psi when compact == true
+        mutable std::vector<impl::compact_column_vector> compact_psi;
         mutable std::vector<long> lru_count;
         mutable double last_true_risk_computed;
     };
@@ -265,6 +440,7 @@ namespace dlib
             skip_cache(true),
             count_below_eps(0),
             max_cache_size(5),
+            compact_cache(false),
             converged(false),
             nuclear_norm_part(0),
             cache_based_eps(std::numeric_limits<scalar_type>::infinity()),
@@ -330,6 +506,21 @@ namespace dlib
         unsigned long get_max_cache_size (
         ) const { return max_cache_size; }
 
+        void set_compact_cache (
+            bool enabled
+        )
+        {
+            if (enabled != compact_cache)
+            {
+                // The cache has to be rebuilt in the new format.
+                compact_cache = enabled;
+                cache.clear();
+            }
+        }
+
+        bool get_compact_cache (
+        ) const { return compact_cache; }
+
         void be_verbose (
         ) 
         {
@@ -358,6 +549,12 @@ namespace dlib
                 );
 
             C = C_; 
+
+            // Whatever convergence a previous solve reached was for the old C.  The
+            // cached separation oracle outputs are still valid though, so they are kept.
+            converged = false;
+            skip_cache = true;
+            count_below_eps = 0;
         }
 
         void add_nuclear_norm_regularizer (
@@ -621,6 +818,42 @@ namespace dlib
                                                 psi);
         }
 
+        bool separation_oracle_must_be_exact (
+        ) const
+        /*!
+            ensures
+                - returns true if the results of the separation oracle calls made in the
+                  current iteration may decide that the optimization has converged.  So
+                  a separation_oracle() that speeds itself up with approximations must
+                  solve the problem exactly when this is true.
+        !*/
+        {
+            return skip_cache || max_cache_size == 0;
+        }
+
+        void get_cached_separation_oracle_outputs (
+            const long idx,
+            std::vector<scalar_type>& loss,
+            std::vector<feature_vector_type>& psi
+        ) const
+        /*!
+            ensures
+                - #loss and #psi are the separation oracle outputs for the idx-th sample
+                  currently held in the cache.  They are empty if the cache hasn't been
+                  filled yet (or is disabled).
+        !*/
+        {
+            if (idx < (long)cache.size())
+            {
+                cache[idx].get_cached_outputs(loss, psi);
+            }
+            else
+            {
+                loss.clear();
+                psi.clear();
+            }
+        }
+
         std::vector<impl::nuclear_norm_regularizer> nuclear_norm_regularizers;
 
         mutable scalar_type saved_current_risk_gap;
@@ -634,6 +867,7 @@ namespace dlib
         mutable bool skip_cache;
         mutable int count_below_eps;
         unsigned long max_cache_size;
+        bool compact_cache;
         mutable bool converged;
         mutable double nuclear_norm_part;
         scalar_type cache_based_eps;
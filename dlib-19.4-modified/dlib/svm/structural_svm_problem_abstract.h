@@ -31,6 +31,7 @@ namespace dlib
                 - get_epsilon() == 0.001
                 - get_max_iterations() == 10000
                 - get_max_cache_size() == 5
+                - get_compact_cache() == false
                 - get_c() == 1
                 - get_cache_based_epsilon() == std::numeric_limits<scalar_type>::infinity()
                   (I.e. the cache based epsilon feature is disabled)
@@ -197,6 +198,30 @@ namespace dlib
                   if the separation oracle is cheap to evaluate. 
         !*/
 
+        void set_compact_cache (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_compact_cache() == enabled
+                - if (enabled != get_compact_cache()) then
+                    - the separation oracle cache is emptied so it can be rebuilt in the
+                      new format.
+        !*/
+
+        bool get_compact_cache (
+        ) const;
+        /*!
+            ensures
+                - returns true if the joint feature vectors in the separation oracle cache
+                  are stored in compact form.  That is, as floats and with long runs of
+                  zeros left out.  This only applies when feature_vector_type is a dense
+                  column vector.  It uses less than half the memory, which allows a larger
+                  get_max_cache_size(), and the cached vectors are scanned faster.  The
+                  price is that the feature vectors given back from the cache are rounded
+                  to float precision.
+        !*/
+
         void add_nuclear_norm_regularizer (
             long first_dimension,
             long rows,
@@ -278,6 +303,10 @@ namespace dlib
                 - C > 0
             ensures
                 - #get_c() == C
+                - The next optimization of this problem starts out like the first one
+                  did, by calling the separation oracle on every sample, so it can be
+                  solved again for the new C.  The cache of separation oracle outputs
+                  (see get_max_cache_size()) is kept since it doesn't depend on C.
         !*/
 
     // --------------------------------
@@ -6,6 +6,7 @@
 #include "structural_svm_problem_threaded_abstract.h"
 #include "../algs.h"
 #include <vector>
+#include <algorithm>
 #include "structural_svm_problem.h"
 #include "../matrix.h"
 #include "sparse_vector.h"
@@ -52,53 +53,72 @@ namespace dlib
                 scalar_type& total_loss_,
                 bool buffer_subgradients_locally_
             ) : self(self_), w(w_), subgradient(subgradient_), total_loss(total_loss_),
-                buffer_subgradients_locally(buffer_subgradients_locally_){}
+                buffer_subgradients_locally(buffer_subgradients_locally_), next(0) {}
+
+            bool get_next_sample (
+                long& idx
+            )
+            {
+                auto_mutex lock(self.queue_mutex);
+                if (next == (long)self.sample_order.size())
+                    return false;
+                idx = self.sample_order[next++];
+                return true;
+            }
 
             void call_oracle (
-                long begin,
-                long end
+                long thread_idx
             ) 
             {
-                // If we are only going to call the separation oracle once then don't run
-                // the slightly more complex for loop version of this code.  Or if we just
-                // don't want to run the complex buffering one.  The code later on decides
-                // if we should do the buffering based on how long it takes to execute.  We
-                // do this because, when the subgradient is really high dimensional it can
-                // take a lot of time to add them together.  So we might want to avoid
-                // doing that.
-                if (end-begin <= 1 || !buffer_subgradients_locally)
+                // Every thread keeps taking the most expensive of the samples nobody has
+                // taken yet until there are none left.  So the threads all finish at about
+                // the same time even when the oracle costs of the samples are very
+                // different, which a fixed split of the samples can't guarantee.  The
+                // code later on decides if we should buffer the subgradients locally based
+                // on how long it takes to execute.  We do this because, when the
+                // subgradient is really high dimensional it can take a lot of time to add
+                // them together.  So we might want to avoid doing that.
+                scalar_type loss = 0;
+                matrix_type faccum;
+                if (buffer_subgradients_locally)
                 {
-                    scalar_type loss;
-                    feature_vector_type ftemp;
-                    for (long i = begin; i < end; ++i)
-                    {
-                        self.separation_oracle_cached(i, w, loss, ftemp);
-
-                        auto_mutex lock(self.accum_mutex);
-                        total_loss += loss;
-                        add_to(subgradient, ftemp);
-                    }
-                }
-                else
-                {
-                    scalar_type loss = 0;
-                    matrix_type faccum(subgradient.size(),1);
+                    faccum.set_size(subgradient.size(),1);
                     faccum = 0;
+                }
 
-                    feature_vector_type ftemp;
-
-                    for (long i = begin; i < end; ++i)
+                feature_vector_type ftemp;
+                uint64 busy_time = 0;
+                long i;
+                while (get_next_sample(i))
+                {
+                    scalar_type loss_temp;
+                    const uint64 start_time = self.ts.get_timestamp();
+                    self.separation_oracle_cached(i, w, loss_temp, ftemp);
+                    const uint64 stop_time = self.ts.get_timestamp();
+                    // Only this thread touches sample i during this call.
+                    self.sample_cost[i] = stop_time-start_time;
+                    busy_time += stop_time-start_time;
+
+                    if (buffer_subgradients_locally)
                     {
-                        scalar_type loss_temp;
-                        self.separation_oracle_cached(i, w, loss_temp, ftemp);
                         loss += loss_temp;
                         add_to(faccum, ftemp);
                     }
+                    else
+                    {
+                        auto_mutex lock(self.accum_mutex);
+                        total_loss += loss_temp;
+                        add_to(subgradient, ftemp);
+                    }
+                }
 
-                    auto_mutex lock(self.accum_mutex);
+                auto_mutex lock(self.accum_mutex);
+                if (buffer_subgradients_locally)
+                {
                     total_loss += loss;
                     add_to(subgradient, faccum);
                 }
+                self.thread_busy_time[thread_idx] = busy_time;
             }
 
             const structural_svm_problem_threaded& self;
@@ -106,6 +126,26 @@ namespace dlib
             matrix_type& subgradient;
             scalar_type& total_loss;
             bool buffer_subgradients_locally;
+            long next;
+        };
+
+        struct compare_sample_cost
+        {
+            compare_sample_cost (
+                const std::vector<uint64>& cost_
+            ) : cost(cost_) {}
+
+            bool operator() (
+                long a,
+                long b
+            ) const
+            {
+                if (cost[a] != cost[b])
+                    return cost[a] > cost[b];
+                return a < b;
+            }
+
+            const std::vector<uint64>& cost;
         };
 
 
@@ -128,8 +168,28 @@ namespace dlib
                 buffer_subgradients_locally = !buffer_subgradients_locally;
             }
 
+            // Hand out the samples in order of how long their oracle calls took last time,
+            // most expensive first.  Before the first call they go in index order.
+            const long num = this->get_num_samples();
+            if (sample_cost.size() != (unsigned long)num)
+            {
+                sample_cost.assign(num, 0);
+                sample_order.resize(num);
+                for (long i = 0; i < num; ++i)
+                    sample_order[i] = i;
+            }
+            else
+            {
+                std::sort(sample_order.begin(), sample_order.end(), compare_sample_cost(sample_cost));
+            }
+
+            const long num_workers = std::max<long>(1, tp.num_threads_in_pool());
+            thread_busy_time.assign(num_workers, 0);
+
             binder b(*this, w, subgradient, total_loss, buffer_subgradients_locally);
-            parallel_for_blocked(tp, 0, this->get_num_samples(), b, &binder::call_oracle);
+            for (long i = 0; i < num_workers; ++i)
+                tp.add_task(b, &binder::call_oracle, i);
+            tp.wait_for_all_tasks();
 
             const uint64 stop_time = ts.get_timestamp();
 
@@ -138,10 +198,24 @@ namespace dlib
             else
                 without_buffer_time.add(stop_time-start_time);
 
+            if (this->verbose && num_workers > 1)
+            {
+                using namespace std;
+                // The fraction of the call each thread spent inside the separation oracle.
+                const double wall_time = std::max<uint64>(1, stop_time-start_time);
+                cout << "oracle thread utilization:";
+                for (long i = 0; i < num_workers; ++i)
+                    cout << " " << static_cast<int>(100*thread_busy_time[i]/wall_time + 0.5) << "%";
+                cout << endl;
+            }
         }
 
         mutable thread_pool tp;
         mutable mutex accum_mutex;
+        mutable mutex queue_mutex;
+        mutable std::vector<uint64> sample_cost;
+        mutable std::vector<long> sample_order;
+        mutable std::vector<uint64> thread_busy_time;
         mutable timestamper ts;
         mutable running_stats<double> with_buffer_time;
         mutable running_stats<double> without_buffer_time;
@@ -32,7 +32,16 @@ namespace dlib
                 particular, it must be safe to call separation_oracle() concurrently from
                 different threads.  However, it is guaranteed that different threads will
                 never make concurrent calls to separation_oracle() using the same idx value
-                (i.e. the first argument).  
+                (i.e. the first argument).
+
+                The samples are not split among the threads ahead of time.  Instead, each
+                thread keeps taking the next sample nobody has taken yet, and the samples
+                are handed out in order of how long their separation_oracle() calls took
+                the previous time, most expensive first.  So samples with very different
+                oracle costs still keep all the threads busy until the end.  If the problem
+                is verbose and uses more than one thread then every evaluation of all the
+                samples also prints the percentage of its time each thread spent inside
+                the separation oracle.
         !*/
 
         typedef matrix_type_ matrix_type;
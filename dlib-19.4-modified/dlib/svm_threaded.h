@@ -14,6 +14,7 @@
 #include "svm/structural_svm_distributed.h"
 #include "svm/structural_svm_object_detection_problem.h"
 #include "svm/structural_object_detection_trainer.h"
+#include "svm/evaluate_object_detection_function.h"
 #include "svm/structural_svm_sequence_labeling_problem.h"
 #include "svm/structural_sequence_labeling_trainer.h"
 
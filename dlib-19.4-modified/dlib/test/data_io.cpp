@@ -8,6 +8,8 @@
 #include "create_iris_datafile.h"
 #include <vector>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
 
 namespace  
 {
@@ -205,6 +207,92 @@ namespace
         }
 
 
+        void test_image_dataset_cache()
+        {
+            print_spinner();
+            dlib::rand rnd;
+
+            // Images of assorted sizes, including an empty one and ones whose pixels span
+            // several pages of the file.
+            dlib::array<array2d<unsigned char> > images(5);
+            images[0].set_size(7,13);
+            images[2].set_size(1,1);
+            images[3].set_size(100,61);
+            images[4].set_size(64,64);
+            std::vector<std::vector<rectangle> > boxes(images.size()), ignore(images.size());
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                for (long r = 0; r < images[i].nr(); ++r)
+                    for (long c = 0; c < images[i].nc(); ++c)
+                        images[i][r][c] = rnd.get_random_8bit_number();
+                for (unsigned long j = 0; j < i; ++j)
+                    boxes[i].push_back(rectangle(rnd.get_random_32bit_number()%50, j, 60+j, 70));
+                if (i%2 == 1)
+                    ignore[i].push_back(rectangle(1,2,3,4));
+            }
+
+            const std::string filename = "image_dataset_cache_test.dat";
+            std::remove(filename.c_str());
+
+            dlib::array<array2d<unsigned char> > images2;
+            std::vector<std::vector<rectangle> > boxes2, ignore2;
+            DLIB_TEST(load_image_dataset_cache(images2, boxes2, ignore2, filename, "key") == false);
+
+            save_image_dataset_cache(images, boxes, ignore, filename, "key");
+            // Saving again replaces the file, which must work even with the old one
+            // still mapped by a reader.
+            {
+                mapped_file mf(filename);
+                save_image_dataset_cache(images, boxes, ignore, filename, "key");
+            }
+
+            DLIB_TEST(load_image_dataset_cache(images2, boxes2, ignore2, filename, "other key") == false);
+            DLIB_TEST(images2.size() == 0 && boxes2.size() == 0 && ignore2.size() == 0);
+
+            DLIB_TEST(load_image_dataset_cache(images2, boxes2, ignore2, filename, "key") == true);
+            DLIB_TEST(images2.size() == images.size());
+            for (unsigned long i = 0; i < images.size(); ++i)
+                DLIB_TEST(mat(images2[i]) == mat(images[i]));
+            DLIB_TEST(boxes2 == boxes);
+            DLIB_TEST(ignore2 == ignore);
+
+            // The cache can also be read into other image types with 8 bit pixels.
+            std::vector<matrix<unsigned char> > images3;
+            DLIB_TEST(load_image_dataset_cache(images3, boxes2, ignore2, filename, "key") == true);
+            DLIB_TEST(images3.size() == images.size());
+            for (unsigned long i = 0; i < images.size(); ++i)
+                DLIB_TEST(images3[i] == mat(images[i]));
+
+            // A truncated file is an error, not a cache miss.
+            const std::string data = read_whole_file(filename);
+            {
+                std::ofstream fout(filename.c_str(), std::ios::binary);
+                fout.write(data.data(), data.size()/2);
+            }
+            bool error = false;
+            try
+            {
+                load_image_dataset_cache(images2, boxes2, ignore2, filename, "key");
+            }
+            catch (serialization_error&)
+            {
+                error = true;
+            }
+            DLIB_TEST(error);
+
+            std::remove(filename.c_str());
+        }
+
+        static std::string read_whole_file (
+            const std::string& filename
+        )
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            std::ostringstream sout;
+            sout << fin.rdbuf();
+            return sout.str();
+        }
+
         void perform_test (
         )
         {
@@ -212,6 +300,7 @@ namespace
             create_iris_datafile();
 
             test_sparse_to_dense();
+            test_image_dataset_cache();
 
             run_test<std::map<unsigned int, double> >();
             run_test<std::map<unsigned int, float> >();
@@ -3,6 +3,7 @@
 
 #include "tester.h"
 #include <dlib/image_transforms.h>
+#include <dlib/image_processing.h>
 #include <vector>
 #include <sstream>
 #include <dlib/compress_stream.h>
@@ -153,11 +154,90 @@ namespace
         }
 
 
+        void test_load_left_right_flip()
+        {
+            print_spinner();
+            // A smooth, asymmetric image with some noise, 128 pixels wide so the cell grid
+            // of the only pyramid level fits the image exactly.
+            dlib::rand rnd;
+            array2d<unsigned char> img(96,128);
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                {
+                    const double val = 128 + 60*std::sin(r*0.21+c*0.13) + 40*std::cos(c*0.31-r*0.07) + 10*rnd.get_random_gaussian();
+                    img[r][c] = static_cast<unsigned char>(std::max(0.0, std::min(255.0, val)));
+                }
+            }
+            array2d<unsigned char> flipped;
+            flip_image_left_right(img, flipped);
+
+            typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type;
+            image_scanner_type scanner, mirrored, reference;
+            scanner.set_detection_window_size(32,32);
+            scanner.set_max_pyramid_levels(1);
+            mirrored.copy_configuration(scanner);
+            reference.copy_configuration(scanner);
+            scanner.load(img);
+            mirrored.load_left_right_flip(scanner);
+            reference.load(flipped);
+
+            // Compare the features of every window, plane by plane, with those extracted
+            // from the flipped image.  The feature vector holds the planes one after
+            // another.
+            const long dims = scanner.get_num_dimensions();
+            const long plane_size = dims/31;
+            matrix<double,31,1> diff, mass, unflipped_diff;
+            diff = 0;
+            mass = 0;
+            unflipped_diff = 0;
+            matrix<double,0,1> psi_mirrored(dims), psi_reference(dims), psi_unflipped(dims);
+            for (long y = 0; y+32 <= img.nr(); y += 4)
+            {
+                for (long x = 0; x+32 <= img.nc(); x += 4)
+                {
+                    const full_object_detection det(rectangle(x,y,x+31,y+31));
+                    psi_mirrored = 0;
+                    psi_reference = 0;
+                    psi_unflipped = 0;
+                    mirrored.get_feature_vector(det, psi_mirrored);
+                    reference.get_feature_vector(det, psi_reference);
+                    scanner.get_feature_vector(det, psi_unflipped);
+                    for (long p = 0; p < 31; ++p)
+                    {
+                        const long first = p*plane_size;
+                        const long last = (p+1)*plane_size-1;
+                        diff(p) += sum(abs(rowm(psi_mirrored,range(first,last)) - rowm(psi_reference,range(first,last))));
+                        unflipped_diff(p) += sum(abs(rowm(psi_unflipped,range(first,last)) - rowm(psi_reference,range(first,last))));
+                        mass(p) += sum(abs(rowm(psi_reference,range(first,last))));
+                    }
+                }
+            }
+            diff = pointwise_multiply(diff, reciprocal(mass));
+            unflipped_diff = pointwise_multiply(unflipped_diff, reciprocal(mass));
+            dlog << LINFO << "relative difference of each mirrored plane: " << trans(diff);
+            dlog << LINFO << "relative difference of each unflipped plane: " << trans(unflipped_diff);
+
+            // Exactly vertical gradients, common in an 8 bit image, lie between
+            // orientation bins 4 and 5 (13 and 14 for the opposite sign) and are snapped
+            // to the lower one, so their mirror lands in the wrong bin.  That is the
+            // documented approximation and only affects those planes and their unsigned
+            // counterparts.  Every other plane must match what a real flip gives.
+            for (long p = 0; p < 31; ++p)
+            {
+                const bool vertical_tie = p == 4 || p == 5 || p == 13 || p == 14 || p == 22 || p == 23;
+                DLIB_TEST_MSG(diff(p) < (vertical_tie ? 0.15 : 0.01), "plane " << p << ": " << diff(p));
+            }
+            // And the image isn't symmetric, so not flipping at all would be far off.
+            DLIB_TEST(sum(unflipped_diff)/31 > 0.3);
+        }
+
         void perform_test (
         )
         {
             test_point_transforms();
             test_on_small();
+            test_load_left_right_flip();
 
             print_spinner();
             // load the testing data
@@ -1812,6 +1812,157 @@ namespace
 
     }
 
+// ----------------------------------------------------------------------------------------
+
+#ifdef DLIB_JPEG_SUPPORT
+    void test_jpeg_decode_options (
+    )
+    {
+        print_spinner();
+
+        // A smooth color gradient, so that the JPEG artifacts stay small and the decoded
+        // images can be compared against each other.
+        const long nr = 101;
+        const long nc = 75;
+        array2d<rgb_pixel> img(nr,nc);
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+            {
+                img[r][c].red = static_cast<unsigned char>(2*r + 20);
+                img[r][c].green = static_cast<unsigned char>(3*c + 10);
+                img[r][c].blue = static_cast<unsigned char>(r + c + 30);
+            }
+        }
+        save_jpeg(img, "test.jpg", 95);
+
+        array2d<rgb_pixel> full;
+        {
+            jpeg_loader loader("test.jpg");
+            DLIB_TEST(loader.is_rgb());
+            DLIB_TEST(loader.get_scale_denom() == 1);
+            loader.get_image(full);
+        }
+        DLIB_TEST(full.nr() == nr);
+        DLIB_TEST(full.nc() == nc);
+        array2d<unsigned char> full_gray;
+        assign_image(full_gray, full);
+
+        const unsigned long denoms[] = {1, 2, 4, 8};
+        for (unsigned long i = 0; i < 4; ++i)
+        {
+            print_spinner();
+            const unsigned long d = denoms[i];
+            const long expected_nr = (nr + d - 1)/d;
+            const long expected_nc = (nc + d - 1)/d;
+
+            jpeg_decode_options options;
+            options.scale_denom = d;
+            {
+                jpeg_loader loader("test.jpg", options);
+                DLIB_TEST(loader.is_rgb());
+                DLIB_TEST(loader.get_scale_denom() == d);
+            }
+            array2d<rgb_pixel> color;
+            load_jpeg(color, "test.jpg", options);
+            DLIB_TEST_MSG(color.nr() == expected_nr, color.nr() << " " << d);
+            DLIB_TEST_MSG(color.nc() == expected_nc, color.nc() << " " << d);
+
+            options.grayscale = true;
+            array2d<rgb_pixel> gray_as_rgb;
+            array2d<unsigned char> gray;
+            {
+                jpeg_loader loader("test.jpg", options);
+                DLIB_TEST(loader.is_gray());
+                DLIB_TEST(!loader.is_rgb());
+                DLIB_TEST(loader.get_scale_denom() == d);
+                loader.get_image(gray_as_rgb);
+                loader.get_image(gray);
+            }
+            DLIB_TEST(gray.nr() == expected_nr);
+            DLIB_TEST(gray.nc() == expected_nc);
+            DLIB_TEST(gray_as_rgb.nr() == expected_nr);
+            DLIB_TEST(gray_as_rgb.nc() == expected_nc);
+            for (long r = 0; r < gray.nr(); ++r)
+            {
+                for (long c = 0; c < gray.nc(); ++c)
+                {
+                    DLIB_TEST(gray_as_rgb[r][c].red == gray[r][c]);
+                    DLIB_TEST(gray_as_rgb[r][c].green == gray[r][c]);
+                    DLIB_TEST(gray_as_rgb[r][c].blue == gray[r][c]);
+                }
+            }
+
+            // Each pixel of a smaller decoding is about the average of the d by d block
+            // of the full image it covers (which libjpeg pads by repeating the last row
+            // and column), and the luma channel is the JPEG luma of the color image
+            // decoded at the same scale.
+            array2d<unsigned char> color_gray;
+            assign_image(color_gray, color);
+            double max_scale_error = 0;
+            for (long r = 0; r < color_gray.nr(); ++r)
+            {
+                for (long c = 0; c < color_gray.nc(); ++c)
+                {
+                    const rectangle block = rectangle(c*d, r*d, (c+1)*d-1, (r+1)*d-1).intersect(get_rect(full_gray));
+                    const double block_mean = mean(matrix_cast<double>(subm(mat(full_gray), block)));
+                    max_scale_error = std::max(max_scale_error, std::abs(block_mean - color_gray[r][c]));
+                }
+            }
+            DLIB_TEST_MSG(max_scale_error < 4, max_scale_error << " " << d);
+            double max_luma_error = 0;
+            for (long r = 0; r < gray.nr(); ++r)
+            {
+                for (long c = 0; c < gray.nc(); ++c)
+                {
+                    const double luma = 0.299*color[r][c].red + 0.587*color[r][c].green + 0.114*color[r][c].blue;
+                    max_luma_error = std::max(max_luma_error, std::abs(luma - gray[r][c]));
+                }
+            }
+            DLIB_TEST_MSG(max_luma_error < 3, max_luma_error << " " << d);
+        }
+
+        // min_nr and min_nc back the scale off until the image is big enough.
+        {
+            jpeg_decode_options options;
+            options.scale_denom = 8;
+            options.min_nr = 30;
+            array2d<rgb_pixel> temp;
+            jpeg_loader loader("test.jpg", options);
+            DLIB_TEST(loader.get_scale_denom() == 2);
+            loader.get_image(temp);
+            DLIB_TEST(temp.nr() == 51);
+            DLIB_TEST(temp.nc() == 38);
+
+            options.min_nr = 0;
+            options.min_nc = 11;
+            jpeg_loader loader2("test.jpg", options);
+            DLIB_TEST(loader2.get_scale_denom() == 4);
+
+            options.min_nr = 1000;
+            jpeg_loader loader3("test.jpg", options);
+            DLIB_TEST(loader3.get_scale_denom() == 1);
+        }
+
+        {
+            array2d<unsigned char> temp;
+            DLIB_TEST(load_image_downscaled(temp, "test.jpg", 20, 20) == 2);
+            DLIB_TEST(temp.nr() == 51);
+            DLIB_TEST(temp.nc() == 38);
+            DLIB_TEST(load_image_downscaled(temp, "test.jpg", 5, 5) == 8);
+            DLIB_TEST(temp.nr() == 13);
+            DLIB_TEST(temp.nc() == 10);
+
+            jpeg_decode_options options;
+            options.grayscale = true;
+            options.scale_denom = 4;
+            load_image(temp, "test.jpg", options);
+            DLIB_TEST(temp.nr() == 26);
+            DLIB_TEST(temp.nc() == 19);
+        }
+    }
+#endif // DLIB_JPEG_SUPPORT
+
 // ----------------------------------------------------------------------------------------
 
     class image_tester : public tester
@@ -1864,6 +2015,9 @@ namespace
             test_dng_floats<long double>(1e30);
 
             test_dng_float_int();
+#ifdef DLIB_JPEG_SUPPORT
+            test_jpeg_decode_options();
+#endif
 
             dlib::rand rnd;
             for (int i = 0; i < 10; ++i)
@@ -0,0 +1,151 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+#include "tester.h"
+#include <dlib/mapped_file.h>
+#include <dlib/threads.h>
+#include <dlib/rand.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.mapped_feature_store");
+
+// ----------------------------------------------------------------------------------------
+
+    bool file_exists (
+        const std::string& filename
+    )
+    {
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        return fin.good();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_round_trip (
+        dlib::rand& rnd
+    )
+    {
+        print_spinner();
+        const std::string filename = "mapped_feature_store_test.dat";
+        {
+            mapped_feature_store store(filename);
+            DLIB_TEST(store.get_filename() == filename);
+            DLIB_TEST(store.size() == 0);
+            DLIB_TEST(file_exists(filename));
+
+            // Blocks of all sorts of sizes, including empty ones and ones that are
+            // exactly a page.  Each is written and read back before the next one is
+            // allocated, so the store has to grow its mapping while older pointers
+            // are still held.
+            const uint64 sizes[] = {1, 4096, 0, 4097, 100, 3*4096-1, 12345, 8, 200000, 4096};
+            const unsigned long num_blocks = sizeof(sizes)/sizeof(sizes[0]);
+            std::vector<std::vector<char> > blocks(num_blocks);
+            std::vector<uint64> offsets(num_blocks);
+            std::vector<const char*> pointers(num_blocks);
+            uint64 expected_size = 0;
+            for (unsigned long i = 0; i < num_blocks; ++i)
+            {
+                blocks[i].resize(sizes[i]);
+                for (unsigned long j = 0; j < blocks[i].size(); ++j)
+                    blocks[i][j] = static_cast<char>(rnd.get_random_8bit_number());
+
+                offsets[i] = store.allocate(sizes[i]);
+                DLIB_TEST(offsets[i] == expected_size);
+                DLIB_TEST(offsets[i]%mapped_feature_store::page_size == 0);
+                expected_size += (sizes[i] + 4095)/4096*4096;
+                DLIB_TEST(store.size() == expected_size);
+
+                if (sizes[i] == 0)
+                    continue;
+
+                // Write the block in two pieces to check writes at an offset inside it.
+                const uint64 half = sizes[i]/2;
+                store.write(offsets[i], &blocks[i][0], half);
+                store.write(offsets[i] + half, &blocks[i][0] + half, sizes[i] - half);
+
+                pointers[i] = store.data(offsets[i], sizes[i]);
+                DLIB_TEST(std::memcmp(pointers[i], &blocks[i][0], sizes[i]) == 0);
+            }
+
+            // Everything still reads back, both through the old pointers and fresh ones,
+            // and visiting the blocks in the same order over and over (which is what
+            // note_access() is tuned for) doesn't disturb anything.
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                for (unsigned long i = 0; i < num_blocks; ++i)
+                {
+                    if (sizes[i] == 0)
+                        continue;
+                    store.note_access(offsets[i], sizes[i]);
+                    DLIB_TEST(std::memcmp(pointers[i], &blocks[i][0], sizes[i]) == 0);
+                    DLIB_TEST(std::memcmp(store.data(offsets[i], sizes[i]), &blocks[i][0], sizes[i]) == 0);
+                }
+            }
+
+            // Concurrent readers see the same bytes.
+            bool all_match = true;
+            dlib::mutex m;
+            parallel_for(4, 0, 4*num_blocks, [&](long k)
+            {
+                const unsigned long i = k%num_blocks;
+                if (sizes[i] == 0)
+                    return;
+                store.note_access(offsets[i], sizes[i]);
+                const bool match = std::memcmp(store.data(offsets[i], sizes[i]), &blocks[i][0], sizes[i]) == 0;
+                auto_mutex lock(m);
+                all_match = all_match && match;
+            });
+            DLIB_TEST(all_match);
+        }
+        // The destructor deletes the file.
+        DLIB_TEST(!file_exists(filename));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_create_failure (
+    )
+    {
+        print_spinner();
+        bool threw = false;
+        try
+        {
+            mapped_feature_store store("mapped_feature_store_missing_dir/store.dat");
+        }
+        catch (error&)
+        {
+            threw = true;
+        }
+        DLIB_TEST(threw);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_feature_store_tester : public tester
+    {
+    public:
+        mapped_feature_store_tester (
+        ) :
+            tester ("test_mapped_feature_store",
+                    "Runs tests on the mapped_feature_store object.")
+        {}
+
+        void perform_test (
+        )
+        {
+            dlib::rand rnd;
+            test_round_trip(rnd);
+            test_create_failure();
+        }
+    } a;
+
+}
+
@@ -4,9 +4,14 @@
 
 #include <dlib/statistics.h>
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <cstdlib>
+#include <cstdio>
+#include <cstddef>
 #include <ctime>
+#include <cmath>
+#include <limits>
 #include "tester.h"
 #include <dlib/pixel.h>
 #include <dlib/svm_threaded.h>
@@ -432,6 +437,1347 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    typedef dlib::array<dlib::array<array2d<float> > > fhog_pyramid;
+
+    void make_textured_image (
+        array2d<unsigned char>& img,
+        long nr,
+        long nc,
+        dlib::rand& rnd
+    )
+    /*!
+        ensures
+            - #img is a nr by nc image of smooth blobs, oriented stripes and noise, so
+              its gradients cover all the orientation bins and every cell of its fHOG
+              pyramid has something in it.
+    !*/
+    {
+        img.set_size(nr, nc);
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+            {
+                const double v = 128 + 50*std::sin(0.031*c + 0.017*r) + 30*std::sin(0.11*c - 0.07*r)
+                    + 20*std::cos(0.005*c*r/(1.0+r)) + 10*rnd.get_random_gaussian();
+                img[r][c] = (unsigned char)put_in_range(0, 255, v);
+            }
+        }
+    }
+
+    template <
+        typename image_scanner_type,
+        typename image_type
+        >
+    void build_fhog_pyramid (
+        const image_scanner_type& scanner,
+        const image_type& img,
+        const fhog_pyramid_approximation& approx,
+        fhog_pyramid& feats,
+        const unsigned long upsample = 1
+    )
+    /*!
+        ensures
+            - #feats == the fHOG pyramid scanner.load(img) would build if its pyramid
+              approximation were approx and it upsampled img by upsample.
+    !*/
+    {
+        typedef typename image_scanner_type::pyramid_type pyramid_type;
+        impl::create_fhog_pyramid<pyramid_type>(img, scanner.get_feature_extractor(), feats,
+            scanner.get_cell_size(), scanner.get_fhog_window_height(), scanner.get_fhog_window_width(),
+            scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+            scanner.get_max_pyramid_levels(), approx, upsample);
+    }
+
+    double max_abs_difference (
+        const dlib::array<array2d<float> >& a,
+        const dlib::array<array2d<float> >& b
+    )
+    /*!
+        ensures
+            - returns the largest absolute difference between the planes of a and b, or
+              infinity if they don't have the same shape.
+    !*/
+    {
+        if (a.size() != b.size())
+            return std::numeric_limits<double>::infinity();
+        double result = 0;
+        for (unsigned long p = 0; p < a.size(); ++p)
+        {
+            if (a[p].nr() != b[p].nr() || a[p].nc() != b[p].nc())
+                return std::numeric_limits<double>::infinity();
+            if (a[p].size() != 0)
+                result = std::max(result, (double)max(abs(mat(a[p]) - mat(b[p]))));
+        }
+        return result;
+    }
+
+    double max_abs_difference (
+        const fhog_pyramid& a,
+        const fhog_pyramid& b
+    )
+    {
+        if (a.size() != b.size())
+            return std::numeric_limits<double>::infinity();
+        double result = 0;
+        for (unsigned long l = 0; l < a.size(); ++l)
+            result = std::max(result, max_abs_difference(a[l], b[l]));
+        return result;
+    }
+
+    void test_fhog_pyramid_schedule (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_fhog_pyramid_schedule()";
+
+        dlib::rand rnd;
+        array2d<unsigned char> img;
+        make_textured_image(img, 240, 320, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        // Enough levels for the legacy rule's hybrid_level of 7 to matter.
+        scanner.set_min_pyramid_layer_size(32,32);
+        const unsigned long num_planes = scanner.get_feature_extractor().get_num_planes();
+
+        fhog_pyramid legacy;
+        build_fhog_pyramid(scanner, img, fhog_pyramid_approximation(), legacy);
+        const unsigned long num_levels = legacy.size();
+        DLIB_TEST(num_levels > 8);
+
+        // Every setting of the legacy hybrid_level/exact_every rule, run as the schedule
+        // fhog_pyramid_schedule() gives for it, builds bit identical levels.
+        for (int k = 0; k < 4; ++k)
+        {
+            print_spinner();
+            fhog_pyramid_approximation approx;
+            if (k == 1)
+                approx.downsample = FHOG_DOWNSAMPLE_DIRECT;
+            if (k == 2)
+                approx.use_simd = true;
+            if (k == 3)
+            {
+                approx.hybrid_level = 4;
+                approx.exact_every = 2;
+            }
+
+            const std::vector<fhog_level_plan> schedule = fhog_pyramid_schedule(approx, num_levels);
+            DLIB_TEST(schedule.size() == num_levels);
+            DLIB_TEST(is_valid_fhog_schedule(schedule));
+            // Level 1 is always resampled from level 0.
+            unsigned long last_recomputed = 0;
+            for (unsigned long i = 0; i < num_levels; ++i)
+            {
+                const bool recompute = i == 0 || (i >= 2 && (i >= approx.hybrid_level || i%approx.exact_every == 0));
+                DLIB_TEST(schedule[i].source == (recompute ? FHOG_LEVEL_RECOMPUTE : FHOG_LEVEL_RESAMPLE));
+                if (recompute)
+                    last_recomputed = i;
+                else if (approx.downsample == FHOG_DOWNSAMPLE_PROGRESSIVE)
+                    DLIB_TEST(schedule[i].from == i-1);
+                else
+                    DLIB_TEST(schedule[i].from == last_recomputed);
+            }
+            dlog << LINFO << approx << ": " << fhog_schedule_string(schedule);
+
+            fhog_pyramid rule, scheduled;
+            build_fhog_pyramid(scanner, img, approx, rule);
+            fhog_pyramid_approximation scheduled_approx = approx;
+            scheduled_approx.schedule = schedule;
+            build_fhog_pyramid(scanner, img, scheduled_approx, scheduled);
+            DLIB_TEST_MSG(max_abs_difference(rule, scheduled) == 0, k);
+        }
+
+        // A short schedule is padded with recomputed levels, and exact pyramids are all
+        // recomputed.
+        fhog_pyramid_approximation approx;
+        approx.schedule.push_back(fhog_level_plan());
+        approx.schedule.push_back(fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0));
+        std::vector<fhog_level_plan> all_recompute(num_levels);
+        std::vector<fhog_level_plan> padded = all_recompute;
+        padded[1] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0);
+        DLIB_TEST(fhog_pyramid_schedule(approx, num_levels) == padded);
+        fhog_pyramid short_pyramid, padded_pyramid;
+        build_fhog_pyramid(scanner, img, approx, short_pyramid);
+        approx.schedule = padded;
+        build_fhog_pyramid(scanner, img, approx, padded_pyramid);
+        DLIB_TEST(max_abs_difference(short_pyramid, padded_pyramid) == 0);
+        fhog_pyramid_approximation exact;
+        exact.exact = true;
+        DLIB_TEST(fhog_pyramid_schedule(exact, num_levels) == all_recompute);
+
+        // Skipped levels are empty and leave the others alone.  Level 1 is resampled or
+        // skipped, level 2 recomputed from the image either way, and nothing is built from
+        // the last level.
+        print_spinner();
+        std::vector<fhog_level_plan> reference_schedule = all_recompute;
+        reference_schedule[1] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0);
+        reference_schedule[3] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 2);
+        std::vector<fhog_level_plan> skipping_schedule = reference_schedule;
+        skipping_schedule[1] = fhog_level_plan(FHOG_LEVEL_SKIP);
+        skipping_schedule[num_levels-1] = fhog_level_plan(FHOG_LEVEL_SKIP);
+        DLIB_TEST(is_valid_fhog_schedule(skipping_schedule));
+        fhog_pyramid reference, skipping;
+        approx.schedule = reference_schedule;
+        build_fhog_pyramid(scanner, img, approx, reference);
+        approx.schedule = skipping_schedule;
+        build_fhog_pyramid(scanner, img, approx, skipping);
+        DLIB_TEST(skipping.size() == num_levels);
+        for (unsigned long i = 0; i < num_levels; ++i)
+        {
+            if (skipping_schedule[i].source == FHOG_LEVEL_SKIP)
+            {
+                DLIB_TEST(skipping[i].size() == num_planes);
+                for (unsigned long p = 0; p < num_planes; ++p)
+                    DLIB_TEST(skipping[i][p].size() == 0);
+            }
+            else
+            {
+                DLIB_TEST_MSG(max_abs_difference(reference[i], skipping[i]) == 0, i);
+            }
+        }
+
+        // Resampled levels have the shape of the recomputed ones.
+        fhog_pyramid recomputed;
+        approx.schedule = all_recompute;
+        build_fhog_pyramid(scanner, img, approx, recomputed);
+        for (unsigned long i = 0; i < num_levels; ++i)
+        {
+            DLIB_TEST(reference[i].size() == num_planes);
+            DLIB_TEST(reference[i][0].nr() == recomputed[i][0].nr());
+            DLIB_TEST(reference[i][0].nc() == recomputed[i][0].nc());
+        }
+
+        // Schedules that can't be built.
+        std::vector<fhog_level_plan> bad = all_recompute;
+        bad[0] = fhog_level_plan(FHOG_LEVEL_SKIP);
+        DLIB_TEST(!is_valid_fhog_schedule(bad));
+        bad = all_recompute;
+        bad[2] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 2);
+        DLIB_TEST(!is_valid_fhog_schedule(bad));
+        bad = skipping_schedule;
+        bad[2] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 1);
+        DLIB_TEST(!is_valid_fhog_schedule(bad));
+        DLIB_TEST(is_valid_fhog_schedule(std::vector<fhog_level_plan>()));
+
+        std::vector<fhog_level_plan> small(5);
+        small[1] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0);
+        small[2] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 1);
+        small[4] = fhog_level_plan(FHOG_LEVEL_SKIP);
+        DLIB_TEST(fhog_schedule_string(small) == "x 0 1 x -");
+
+        // The schedule is saved with the approximation.
+        approx.schedule = skipping_schedule;
+        ostringstream sout;
+        serialize(approx, sout);
+        istringstream sin(sout.str());
+        fhog_pyramid_approximation approx2;
+        deserialize(approx2, sin);
+        DLIB_TEST(approx2 == approx);
+        DLIB_TEST(approx2.schedule == skipping_schedule);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double power_law_fit_error (
+        const std::vector<std::vector<double> >& recomputed_sums,
+        const std::vector<std::vector<double> >& resampled_sums,
+        const unsigned long p,
+        const double lambda,
+        const double downscale
+    )
+    /*!
+        ensures
+            - returns the squared log error between the plane p sums of the recomputed
+              levels and those of the levels resampled from level 0 once corrected by
+              lambda, the quantity estimate_fhog_power_law() minimizes.
+    !*/
+    {
+        double error = 0;
+        for (unsigned long l = 1; l < recomputed_sums.size(); ++l)
+        {
+            if (recomputed_sums[l][p] <= 0 || resampled_sums[l][p] <= 0)
+                continue;
+            const double corrected = resampled_sums[l][p]*std::pow(downscale, -lambda*l);
+            error += std::pow(std::log(recomputed_sums[l][p]/corrected), 2);
+        }
+        return error;
+    }
+
+    void test_fhog_power_law (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_fhog_power_law()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images(3);
+        for (unsigned long i = 0; i < images.size(); ++i)
+            make_textured_image(images[i], 240, 320, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        scanner.set_min_pyramid_layer_size(32,32);
+        const unsigned long num_planes = scanner.get_feature_extractor().get_num_planes();
+        const double downscale = 4.0/5.0;
+
+        fhog_pyramid plain;
+        build_fhog_pyramid(scanner, images[0], fhog_pyramid_approximation(), plain);
+        const unsigned long num_levels = plain.size();
+
+        // Schedules to correct: the legacy rule in both downsampling modes and a
+        // schedule resampling across several levels and from a resampled level.
+        std::vector<fhog_pyramid_approximation> approxes(3);
+        approxes[1].downsample = FHOG_DOWNSAMPLE_DIRECT;
+        approxes[2].schedule.resize(num_levels);
+        approxes[2].schedule[2] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 1);
+        approxes[2].schedule[3] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 2);
+        approxes[2].schedule[4] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0);
+        approxes[2].schedule[6] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, 5);
+
+        std::vector<float> lambda(num_planes);
+        for (unsigned long p = 0; p < num_planes; ++p)
+            lambda[p] = rnd.get_random_float() - 0.5f;
+
+        for (unsigned long k = 0; k < approxes.size(); ++k)
+        {
+            print_spinner();
+            fhog_pyramid_approximation approx = approxes[k];
+            const std::vector<fhog_level_plan> schedule = fhog_pyramid_schedule(approx, num_levels);
+            fhog_pyramid uncorrected, zero, corrected;
+            build_fhog_pyramid(scanner, images[0], approx, uncorrected);
+            approx.power_law_lambda.assign(num_planes, 0);
+            build_fhog_pyramid(scanner, images[0], approx, zero);
+            approx.power_law_lambda = lambda;
+            build_fhog_pyramid(scanner, images[0], approx, corrected);
+
+            // Exponents of 0 change nothing.
+            DLIB_TEST(max_abs_difference(uncorrected, zero) == 0);
+
+            // Recomputed levels are left alone, and plane p of a level resampled n levels
+            // below the recomputed level its histograms came from is scaled by
+            // (4/5)^(-lambda[p]*n).
+            std::vector<unsigned long> root(num_levels);
+            DLIB_TEST(corrected.size() == num_levels);
+            for (unsigned long i = 0; i < num_levels; ++i)
+            {
+                if (schedule[i].source == FHOG_LEVEL_RECOMPUTE)
+                {
+                    root[i] = i;
+                    DLIB_TEST(max_abs_difference(uncorrected[i], corrected[i]) == 0);
+                    continue;
+                }
+                root[i] = root[schedule[i].from];
+                double max_error = 0;
+                for (unsigned long p = 0; p < num_planes; ++p)
+                {
+                    const double factor = std::pow(downscale, -(double)lambda[p]*(i - root[i]));
+                    const matrix<double> expected = factor*matrix_cast<double>(mat(uncorrected[i][p]));
+                    max_error = std::max(max_error, max(abs(expected - matrix_cast<double>(mat(corrected[i][p])))));
+                }
+                DLIB_TEST_MSG(max_error < 1e-5, k << " " << i << " " << max_error);
+            }
+
+            // The legacy rule and its schedule still build the same levels.
+            if (approx.schedule.size() == 0)
+            {
+                fhog_pyramid scheduled;
+                approx.schedule = schedule;
+                build_fhog_pyramid(scanner, images[0], approx, scheduled);
+                DLIB_TEST(max_abs_difference(corrected, scheduled) == 0);
+            }
+        }
+
+        // estimate_fhog_power_law() fits the exponents that best map the plane sums of
+        // levels resampled from level 0 onto those of the recomputed levels.
+        print_spinner();
+        const std::vector<float> fitted = estimate_fhog_power_law(scanner, images);
+        DLIB_TEST(fitted.size() == num_planes);
+
+        fhog_pyramid_approximation recomputed, resampled;
+        recomputed.schedule.assign(num_levels, fhog_level_plan());
+        resampled.schedule.assign(num_levels, fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0));
+        resampled.schedule[0] = fhog_level_plan();
+        std::vector<std::vector<double> > recomputed_sums(num_levels, std::vector<double>(num_planes, 0));
+        std::vector<std::vector<double> > resampled_sums = recomputed_sums, corrected_sums = recomputed_sums;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            fhog_pyramid a, b, c;
+            build_fhog_pyramid(scanner, images[i], recomputed, a);
+            build_fhog_pyramid(scanner, images[i], resampled, b);
+            fhog_pyramid_approximation corrected = resampled;
+            corrected.power_law_lambda = fitted;
+            build_fhog_pyramid(scanner, images[i], corrected, c);
+            for (unsigned long l = 0; l < num_levels; ++l)
+            {
+                for (unsigned long p = 0; p < num_planes; ++p)
+                {
+                    recomputed_sums[l][p] += sum(matrix_cast<double>(mat(a[l][p])));
+                    resampled_sums[l][p] += sum(matrix_cast<double>(mat(b[l][p])));
+                    corrected_sums[l][p] += sum(matrix_cast<double>(mat(c[l][p])));
+                }
+            }
+        }
+
+        double error_before = 0, error_after = 0;
+        for (unsigned long p = 0; p < num_planes; ++p)
+        {
+            DLIB_TEST(std::isfinite(fitted[p]));
+            const double error = power_law_fit_error(recomputed_sums, resampled_sums, p, fitted[p], downscale);
+            DLIB_TEST(error <= power_law_fit_error(recomputed_sums, resampled_sums, p, fitted[p] + 0.01, downscale));
+            DLIB_TEST(error <= power_law_fit_error(recomputed_sums, resampled_sums, p, fitted[p] - 0.01, downscale));
+            error_before += power_law_fit_error(recomputed_sums, resampled_sums, p, 0, downscale);
+            error_after += power_law_fit_error(recomputed_sums, corrected_sums, p, 0, downscale);
+        }
+        dlog << LINFO << "power law fit: squared log error " << error_before << " before, " << error_after << " after";
+        DLIB_TEST(error_after < error_before);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_virtual_upsampling (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_virtual_upsampling()";
+
+        dlib::rand rnd;
+        array2d<unsigned char> img, upsampled;
+        make_textured_image(img, 120, 160, rnd);
+        upsampled.set_size(2*img.nr(), 2*img.nc());
+        resize_image(img, upsampled);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        scanner.set_min_pyramid_layer_size(32,32);
+        const int cell_size = scanner.get_cell_size();
+        const long pad_rows = scanner.get_fhog_window_height();
+        const long pad_cols = scanner.get_fhog_window_width();
+        const default_fhog_feature_extractor& fe = scanner.get_feature_extractor();
+
+        DLIB_TEST(scanner.get_virtual_upsampling_factor(img) == 1);
+        scanner.set_virtual_upsampling(160, 120);
+        DLIB_TEST(scanner.get_virtual_upsampling_factor(img) == 2);
+        DLIB_TEST(scanner.get_virtual_upsampling_factor(upsampled) == 1);
+        scanner.set_virtual_upsampling(159, 120);
+        DLIB_TEST(scanner.get_virtual_upsampling_factor(img) == 1);
+        scanner.set_virtual_upsampling(320, 240);
+
+        // Exact pyramids: the levels bigger than the image are extracted from it with half
+        // sized cells, the others from it resized to them.  Their sizes are those of the
+        // levels of the real upsampled image give or take a cell, since the images
+        // pyramid_down makes can be a pixel off the rectangles it maps.
+        fhog_pyramid_approximation exact;
+        exact.exact = true;
+        fhog_pyramid virtual_exact, upsampled_exact, original_exact;
+        build_fhog_pyramid(scanner, img, exact, virtual_exact, 2);
+        build_fhog_pyramid(scanner, upsampled, exact, upsampled_exact);
+        build_fhog_pyramid(scanner, img, exact, original_exact);
+        DLIB_TEST(virtual_exact.size() == upsampled_exact.size());
+        DLIB_TEST(virtual_exact.size() == original_exact.size() + 1);
+        DLIB_TEST(virtual_exact[0][0].nr() > original_exact[0][0].nr());
+
+        pyramid_down<2> pyr;
+        rectangle level_rect = get_rect(upsampled);
+        for (unsigned long i = 0; i < virtual_exact.size(); ++i)
+        {
+            print_spinner();
+            if (i != 0)
+                level_rect = pyr.rect_down(level_rect);
+            const bool fine = level_rect.width() > img.nc() || level_rect.height() > img.nr();
+            const long f = fine ? 2 : 1;
+            array2d<unsigned char> resized(level_rect.height()/f, level_rect.width()/f);
+            if (i == 0)
+                assign_image(resized, img);
+            else
+                resize_image(img, resized);
+            dlib::array<array2d<float> > reference;
+            fe(resized, reference, cell_size/f, pad_rows, pad_cols);
+            DLIB_TEST_MSG(max_abs_difference(virtual_exact[i], reference) == 0, i);
+
+            DLIB_TEST(std::abs(virtual_exact[i][0].nr() - upsampled_exact[i][0].nr()) <= 1);
+            DLIB_TEST(std::abs(virtual_exact[i][0].nc() - upsampled_exact[i][0].nc()) <= 1);
+        }
+
+        // The hack pyramid runs as a schedule and has the same level sizes as that of the
+        // real upsampled image.  Its features follow those of the upsampled image, without
+        // matching them.
+        fhog_pyramid virtual_hack, upsampled_hack;
+        build_fhog_pyramid(scanner, img, fhog_pyramid_approximation(), virtual_hack, 2);
+        build_fhog_pyramid(scanner, upsampled, fhog_pyramid_approximation(), upsampled_hack);
+        DLIB_TEST(virtual_hack.size() == upsampled_hack.size());
+        for (unsigned long i = 0; i < virtual_hack.size(); ++i)
+        {
+            DLIB_TEST(virtual_hack[i].size() == upsampled_hack[i].size());
+            DLIB_TEST_MSG(virtual_hack[i][0].nr() == upsampled_hack[i][0].nr(), i);
+            DLIB_TEST_MSG(virtual_hack[i][0].nc() == upsampled_hack[i][0].nc(), i);
+            running_scalar_covariance<double> rc;
+            for (unsigned long p = 0; p < virtual_hack[i].size(); ++p)
+            {
+                for (long r = 0; r < virtual_hack[i][p].nr(); ++r)
+                {
+                    for (long c = 0; c < virtual_hack[i][p].nc(); ++c)
+                        rc.add(virtual_hack[i][p][r][c], upsampled_hack[i][p][r][c]);
+                }
+            }
+            dlog << LINFO << "level " << i << ": correlation with the upsampled image " << rc.correlation();
+            DLIB_TEST(rc.correlation() > 0.7);
+        }
+
+        // Loaded scanners work in the coordinates of the image they were given: a
+        // rectangle maps to the candidate location of the upsampled image, halved.
+        print_spinner();
+        image_scanner_type upsampling_scanner;
+        upsampling_scanner.copy_configuration(scanner);
+        upsampling_scanner.set_virtual_upsampling(0, 0);
+        scanner.load(img);
+        upsampling_scanner.load(upsampled);
+        for (int k = 0; k < 200; ++k)
+        {
+            const long size = 20 + rnd.get_random_32bit_number()%80;
+            const point center(rnd.get_random_32bit_number()%img.nc(), rnd.get_random_32bit_number()%img.nr());
+            const rectangle rect = centered_rect(center, size, size + rnd.get_random_32bit_number()%20);
+            const rectangle big = rectangle(2*rect.left(), 2*rect.top(), 2*rect.right()+1, 2*rect.bottom()+1);
+            const rectangle expected = upsampling_scanner.get_best_matching_rect(big);
+            const rectangle got = scanner.get_best_matching_rect(rect);
+            DLIB_TEST_MSG(std::abs(2*got.left() - expected.left()) <= 1 && std::abs(2*got.top() - expected.top()) <= 1 &&
+                std::abs(2*got.right()+1 - expected.right()) <= 1 && std::abs(2*got.bottom()+1 - expected.bottom()) <= 1,
+                rect << " " << got << " " << expected);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_fhog_training_settings (
+    )
+    {        
+        print_spinner();
+        dlog << LINFO << "test_fhog_training_settings()";
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        {
+            image_scanner_type scanner;
+            scanner.set_feature_storage(FHOG_STORE_FLOAT16);
+            scanner.set_pyramid_cache_directory("fhog_cache");
+            clear_training_settings(scanner);
+            DLIB_TEST(scanner.get_feature_storage() == FHOG_STORE_FLOAT32);
+            DLIB_TEST(scanner.get_pyramid_cache_directory() == "");
+        }
+
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        // Train on 8-bit pyramids.  The detector must not keep that storage.
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(35,35);
+        scanner.set_feature_storage(FHOG_STORE_UINT8);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);  
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+        DLIB_TEST(trainer.get_scanner().get_feature_storage() == FHOG_STORE_UINT8);
+        DLIB_TEST(detector.get_scanner().get_feature_storage() == FHOG_STORE_FLOAT32);
+
+        matrix<double> res = test_object_detection_function(detector, images, object_locations);
+        dlog << LINFO << "Test detector (precision,recall): " << res;
+        DLIB_TEST(sum(res) == 3);
+
+        ostringstream sout;
+        serialize(detector, sout);
+        istringstream sin(sout.str());
+        object_detector<image_scanner_type> d2;
+        deserialize(d2, sin);
+        DLIB_TEST(d2.get_scanner().get_feature_storage() == FHOG_STORE_FLOAT32);
+
+        // Both detect exactly like a detector made from the same weights on a float32
+        // scanner.
+        image_scanner_type float_scanner;
+        float_scanner.copy_configuration(scanner);
+        float_scanner.set_feature_storage(FHOG_STORE_FLOAT32);
+        object_detector<image_scanner_type> reference(float_scanner, detector.get_overlap_tester(), detector.get_w());
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            std::vector<std::pair<double, rectangle> > dets1, dets2, dets3;
+            detector(images[i], dets1, -0.5);
+            d2(images[i], dets2, -0.5);
+            reference(images[i], dets3, -0.5);
+            DLIB_TEST(dets1.size() != 0);
+            DLIB_TEST(dets1 == dets2);
+            DLIB_TEST(dets1 == dets3);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_fhog_feature_store (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_fhog_feature_store()";
+
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(35,35);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(1);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+        // Features written to the store and read back through the mapping are the
+        // ones the in memory training uses, so the same weights come out.
+        const std::string filename = "object_detector_feature_store.dat";
+        trainer.set_feature_store_file(filename);
+        object_detector<image_scanner_type> detector2 = trainer.train(images, object_locations);
+        DLIB_TEST(trainer.get_feature_store_file() == filename);
+        DLIB_TEST(!std::ifstream(filename.c_str()).good());
+
+        dlog << LINFO << "weight difference: " << max(abs(detector.get_w() - detector2.get_w()));
+        DLIB_TEST(max(abs(detector.get_w() - detector2.get_w())) < 1e-10);
+        DLIB_TEST(!detector2.get_scanner().get_feature_store());
+
+        matrix<double> res = test_object_detection_function(detector2, images, object_locations);
+        dlog << LINFO << "Test detector (precision,recall): " << res;
+        DLIB_TEST(sum(res) == 3);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    bool fhog_artifact_is_rejected (
+        const std::string& bytes,
+        std::size_t offset,
+        const T& value,
+        const std::string& filename
+    )
+    /*!
+        ensures
+            - writes bytes to filename with value written over it at offset, and returns
+              true if loading the result as an artifact throws a serialization_error.
+    !*/
+    {
+        std::string corrupt = bytes;
+        if (offset != std::string::npos)
+            std::memcpy(&corrupt[offset], &value, sizeof(value));
+        else
+            corrupt.resize(corrupt.size()/2);
+        {
+            std::ofstream fout(filename.c_str(), std::ios::binary);
+            fout.write(corrupt.data(), corrupt.size());
+        }
+        try
+        {
+            mapped_fhog_object_detector<pyramid_down<2> > detector(filename);
+        }
+        catch (serialization_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void test_fhog_detector_artifact (
+    )
+    {        
+        print_spinner();
+        dlog << LINFO << "test_fhog_detector_artifact()";
+
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(35,35);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);  
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        object_detector<image_scanner_type> trained = trainer.train(images, object_locations);
+
+        // Give the scanner settings away from their defaults, so a lost field shows up,
+        // and two weight vectors with low rank filters.
+        image_scanner_type scanner2;
+        scanner2.copy_configuration(trained.get_scanner());
+        scanner2.set_max_pyramid_levels(5);
+        scanner2.set_min_pyramid_layer_size(30,40);
+        scanner2.set_virtual_upsampling(450,450);
+        fhog_pyramid_approximation approx;
+        approx.exact_every = 2;
+        approx.hybrid_level = 3;
+        approx.schedule.push_back(fhog_level_plan(FHOG_LEVEL_RECOMPUTE));
+        approx.schedule.push_back(fhog_level_plan(FHOG_LEVEL_RESAMPLE, 0));
+        approx.schedule.push_back(fhog_level_plan(FHOG_LEVEL_RECOMPUTE));
+        approx.power_law_lambda.assign(scanner2.get_feature_extractor().get_num_planes(), 0.1f);
+        scanner2.set_pyramid_approximation(approx);
+        std::vector<image_scanner_type::feature_vector_type> weights;
+        weights.push_back(threshold_filter_singular_values(trained, 0.1).get_w());
+        weights.push_back(trained.get_w());
+        weights.back()(weights.back().size()-1) += 0.2;
+        object_detector<image_scanner_type> detector(scanner2, test_box_overlap(0.3, 0.9), weights);
+
+        const std::string filename = "fhog_detector_artifact_test.fhog";
+        save_fhog_detector_artifact(detector, filename);
+        mapped_fhog_object_detector<pyramid_down<2> > mapped(filename);
+
+        const image_scanner_type& s = mapped.get_scanner();
+        DLIB_TEST(mapped.num_detectors() == 2);
+        DLIB_TEST(s.get_detection_window_width() == scanner2.get_detection_window_width());
+        DLIB_TEST(s.get_detection_window_height() == scanner2.get_detection_window_height());
+        DLIB_TEST(s.get_cell_size() == scanner2.get_cell_size());
+        DLIB_TEST(s.get_padding() == scanner2.get_padding());
+        DLIB_TEST(s.get_max_pyramid_levels() == 5);
+        DLIB_TEST(s.get_min_pyramid_layer_width() == 30);
+        DLIB_TEST(s.get_min_pyramid_layer_height() == 40);
+        DLIB_TEST(s.get_virtual_upsampling_max_width() == 450);
+        DLIB_TEST(s.get_virtual_upsampling_max_height() == 450);
+        DLIB_TEST(s.get_pyramid_approximation() == approx);
+        DLIB_TEST(s.get_num_dimensions() == scanner2.get_num_dimensions());
+        DLIB_TEST(mapped.get_overlap_tester().get_iou_thresh() == 0.3);
+        DLIB_TEST(mapped.get_overlap_tester().get_percent_covered_thresh() == 0.9);
+        DLIB_TEST(mapped.num_separable_filters(0) == detector.get_processed_w(0).get_detect_argument().num_separable_filters());
+        DLIB_TEST(mapped.num_separable_filters(0) < mapped.num_separable_filters(1));
+
+        unsigned long num_dets = 0;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            std::vector<rect_detection> dets1, dets2;
+            detector(images[i], dets1, -0.5);
+            mapped(images[i], dets2, -0.5);
+            DLIB_TEST(dets1.size() == dets2.size());
+            for (unsigned long j = 0; j < std::min(dets1.size(), dets2.size()); ++j)
+            {
+                DLIB_TEST(dets1[j].rect == dets2[j].rect);
+                DLIB_TEST(dets1[j].weight_index == dets2[j].weight_index);
+                DLIB_TEST(dets1[j].detection_confidence == dets2[j].detection_confidence);
+            }
+            num_dets += dets1.size();
+        }
+        dlog << LINFO << "num detections: " << num_dets;
+        DLIB_TEST(num_dets != 0);
+
+        // Files that aren't artifacts of this version for this machine are rejected and
+        // leave the detector as it was.
+        std::string bytes;
+        {
+            std::ifstream fin(filename.c_str(), std::ios::binary);
+            std::ostringstream sout;
+            sout << fin.rdbuf();
+            bytes = sout.str();
+        }
+        const std::string bad_filename = "fhog_detector_artifact_test_bad.fhog";
+        typedef impl::fhog_artifact_header header;
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, magic), 'X', bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, endian_check), (uint32)0x04030201, bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, version), (uint32)1, bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, version), impl::fhog_artifact_version+1, bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, cell_size), (uint64)0, bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, offsetof(header, banks_offset), (uint64)bytes.size(), bad_filename));
+        DLIB_TEST(fhog_artifact_is_rejected(bytes, std::string::npos, 0, bad_filename));
+        DLIB_TEST(!fhog_artifact_is_rejected(bytes, offsetof(header, reserved), (uint32)0, bad_filename));
+
+        bool error_thrown = false;
+        try
+        {
+            mapped.load(bad_filename + ".missing");
+        }
+        catch (dlib::error&)
+        {
+            error_thrown = true;
+        }
+        DLIB_TEST(error_thrown);
+        DLIB_TEST(mapped.num_detectors() == 2);
+        std::vector<rect_detection> dets1, dets2;
+        detector(images[0], dets1, -0.5);
+        mapped(images[0], dets2, -0.5);
+        DLIB_TEST(dets1.size() == dets2.size());
+
+        std::remove(filename.c_str());
+        std::remove(bad_filename.c_str());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void make_noisy_square_data (
+        dlib::array<array2d<unsigned char> >& images,
+        std::vector<std::vector<rectangle> >& object_locations,
+        const unsigned long num_images,
+        dlib::rand& rnd
+    )
+    /*!
+        ensures
+            - #images holds num_images 200x200 images, each with one or two 40x40 white
+              squares at random places, buried in a lot of noise so detectors trained on
+              them aren't perfect.  #object_locations holds the squares.
+            - Every square can be matched by a 40x40 scan_fhog_pyramid<pyramid_down<2> >
+              detection window, so the data can be trained on with such a scanner.
+    !*/
+    {
+        scan_fhog_pyramid<pyramid_down<2> > scanner;
+        scanner.set_detection_window_size(40,40);
+        images.resize(num_images);
+        object_locations.assign(num_images, std::vector<rectangle>());
+        for (unsigned long i = 0; i < num_images; ++i)
+        {
+            images[i].set_size(200,200);
+            assign_all_pixels(images[i], 0);
+            const unsigned long num_squares = 1 + rnd.get_random_32bit_number()%2;
+            for (unsigned long j = 0; j < num_squares; ++j)
+            {
+                const point center(25 + rnd.get_random_32bit_number()%150, 25 + rnd.get_random_32bit_number()%150);
+                const rectangle rect = centered_rect(center, 40, 40);
+                bool overlaps = false;
+                for (unsigned long k = 0; k < object_locations[i].size(); ++k)
+                    overlaps = overlaps || !object_locations[i][k].intersect(rect).is_empty();
+                if (overlaps || box_intersection_over_union(scanner.get_best_matching_rect(rect), rect) <= 0.5)
+                    continue;
+                fill_rect(images[i], rect, 255);
+                object_locations[i].push_back(rect);
+            }
+            for (long r = 0; r < images[i].nr(); ++r)
+            {
+                for (long c = 0; c < images[i].nc(); ++c)
+                    images[i][r][c] = put_in_range(0,255,images[i][r][c] + 90*rnd.get_random_gaussian());
+            }
+        }
+    }
+
+    void test_select_separable_rank (
+    )
+    {        
+        print_spinner();
+        dlog << LINFO << "test_select_separable_rank()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images, images_val;
+        std::vector<std::vector<rectangle> > object_locations, object_locations_val;
+        make_noisy_square_data(images, object_locations, 8, rnd);
+        make_noisy_square_data(images_val, object_locations_val, 8, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);  
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_c(10);
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+        const double full_rank_ap = test_object_detection_function(detector, images_val, object_locations_val)(2);
+        const unsigned long full_rank_filters = num_separable_filters(detector);
+        dlog << LINFO << "full rank: ap " << full_rank_ap << ", filters " << full_rank_filters;
+
+        const double max_ap_drops[] = {0, 0.05, 0.2};
+        for (unsigned long k = 0; k < 3; ++k)
+        {
+            print_spinner();
+            separable_rank_selection_report report;
+            object_detector<image_scanner_type> compressed = select_separable_rank(detector,
+                images_val, object_locations_val, max_ap_drops[k], report);
+            dlog << LINFO << "max_ap_drop " << max_ap_drops[k] << ":\n" << report;
+
+            // The ranks are picked on the held out images, and the detector they give
+            // never loses more than max_ap_drop of the full rank detector's accuracy
+            // there.
+            const double ap = test_object_detection_function(compressed, images_val, object_locations_val)(2);
+            DLIB_TEST(report.baseline_ap == full_rank_ap);
+            DLIB_TEST(std::abs(report.ap - ap) < 1e-12);
+            DLIB_TEST(ap >= full_rank_ap - max_ap_drops[k] - 1e-12);
+            DLIB_TEST(report.baseline_num_filters == full_rank_filters);
+            DLIB_TEST(report.num_filters == num_separable_filters(compressed));
+            DLIB_TEST(report.num_filters <= full_rank_filters);
+            DLIB_TEST(report.plane_ranks.size() == (unsigned long)scanner.get_feature_extractor().get_num_planes());
+            DLIB_TEST(report.num_evaluations > 1);
+            DLIB_TEST(compressed.num_detectors() == 1);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type,
+        typename image_array_type
+        >
+    double detector_objective (
+        const object_detector<image_scanner_type>& detector,
+        const image_array_type& images,
+        const std::vector<std::vector<rectangle> >& object_locations,
+        const double C
+    )
+    /*!
+        ensures
+            - returns the value of the objective structural_object_detection_trainer
+              minimizes, 0.5*||w||^2 + C*risk(w), at the detector's weights, for the
+              trainer's default losses.  The risk comes from a fresh problem with no
+              cache, so every detector handed to this function is measured the same way.
+    !*/
+    {
+        std::vector<std::vector<full_object_detection> > truth(object_locations.size());
+        for (unsigned long i = 0; i < object_locations.size(); ++i)
+        {
+            for (unsigned long j = 0; j < object_locations[i].size(); ++j)
+                truth[i].push_back(full_object_detection(object_locations[i][j]));
+        }
+        std::vector<std::vector<rectangle> > ignore(images.size());
+
+        structural_svm_object_detection_problem<image_scanner_type,image_array_type> prob(
+            detector.get_scanner(), detector.get_overlap_tester(), false, images, truth, ignore,
+            test_box_overlap(), 4);
+        prob.set_max_cache_size(0);
+
+        // get_risk() is public in the oca_problem interface.
+        const oca_problem<matrix<double,0,1> >& problem = prob;
+        matrix<double,0,1> w = detector.get_w();
+        matrix<double,0,1> subgradient;
+        double risk;
+        problem.get_risk(w, risk, subgradient);
+        return 0.5*length_squared(w) + C*risk;
+    }
+
+    void test_train_path (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_train_path()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_noisy_square_data(images, object_locations, 6, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_epsilon(0.01);
+
+        // Not in increasing order, to check the results come back in the order of Cs.
+        std::vector<double> Cs;
+        Cs.push_back(10);
+        Cs.push_back(0.5);
+        Cs.push_back(2);
+        std::vector<object_detector<image_scanner_type> > path = trainer.train_path(Cs, images, object_locations);
+        DLIB_TEST(path.size() == Cs.size());
+
+        for (unsigned long i = 0; i < Cs.size(); ++i)
+        {
+            print_spinner();
+            trainer.set_c(Cs[i]);
+            object_detector<image_scanner_type> cold = trainer.train(images, object_locations);
+
+            // The solver stops once the average loss is within epsilon of its
+            // cutting plane model, i.e. with the objective within C*epsilon of the
+            // best it can find.  So starting from the previous C's solution and planes
+            // must not leave it any worse off than starting from scratch.  It may well
+            // end up better: the separation oracle is approximate, so the two solves
+            // don't share a true optimum to converge to.
+            const double warm = detector_objective(path[i], images, object_locations, Cs[i]);
+            const double cold_obj = detector_objective(cold, images, object_locations, Cs[i]);
+            dlog << LINFO << "C " << Cs[i] << ": warm objective " << warm << ", cold objective " << cold_obj
+                 << ", weight distance " << length(path[i].get_w() - cold.get_w());
+            DLIB_TEST(warm <= cold_obj + Cs[i]*trainer.get_epsilon());
+            DLIB_TEST(path[i].get_scanner().get_feature_storage() == FHOG_STORE_FLOAT32);
+        }
+
+        // A bigger C means a bigger (less regularized) solution.
+        DLIB_TEST(length(path[1].get_w()) < length(path[2].get_w()));
+        DLIB_TEST(length(path[2].get_w()) < length(path[0].get_w()));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_train_incremental (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_train_incremental()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > old_images, new_images, all_images;
+        std::vector<std::vector<rectangle> > old_locations, new_locations, all_locations;
+        make_noisy_square_data(old_images, old_locations, 24, rnd);
+        make_noisy_square_data(new_images, new_locations, 1, rnd);
+        // Copies, since dlib::array::push_back() would swap the images out.
+        all_images.resize(old_images.size() + new_images.size());
+        all_locations = old_locations;
+        for (unsigned long i = 0; i < old_images.size(); ++i)
+            assign_image(all_images[i], old_images[i]);
+        for (unsigned long i = 0; i < new_images.size(); ++i)
+        {
+            assign_image(all_images[old_images.size()+i], new_images[i]);
+            all_locations.push_back(new_locations[i]);
+        }
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_c(2);
+        trainer.set_epsilon(0.01);
+
+        // With an empty state train_incremental() is plain training.
+        structural_object_detection_training_state state;
+        object_detector<image_scanner_type> first = trainer.train_incremental(old_images, old_locations, state);
+        object_detector<image_scanner_type> first_full = trainer.train(old_images, old_locations);
+        DLIB_TEST(state.num_samples() == old_images.size());
+        DLIB_TEST(state.get_solution() == first.get_w());
+        DLIB_TEST(max(abs(first.get_w() - first_full.get_w())) < 1e-10);
+
+        // The state survives a trip through serialize().
+        ostringstream sout;
+        serialize(state, sout);
+        istringstream sin(sout.str());
+        structural_object_detection_training_state state2;
+        deserialize(state2, sin);
+        DLIB_TEST(state2.num_samples() == state.num_samples());
+        DLIB_TEST(state2.get_solution() == state.get_solution());
+
+        print_spinner();
+        object_detector<image_scanner_type> incremental = trainer.train_incremental(new_images, new_locations, state2);
+        object_detector<image_scanner_type> full = trainer.train(all_images, all_locations);
+        DLIB_TEST(state2.num_samples() == all_images.size());
+
+        const double C = trainer.get_c();
+        const double inc_obj = detector_objective(incremental, all_images, all_locations, C);
+        const double full_obj = detector_objective(full, all_images, all_locations, C);
+        dlog << LINFO << "incremental objective " << inc_obj << ", full retrain objective " << full_obj
+             << ", weight distance " << length(incremental.get_w() - full.get_w());
+
+        // The old images only take part through the labelings recorded in their
+        // summaries, so the incremental solve doesn't reach the full retrain's
+        // objective to within C*epsilon.  With one new image to 24 old ones it must
+        // still come close.
+        DLIB_TEST(std::abs(inc_obj - full_obj) <= 0.1*full_obj);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_window_cache (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_window_cache()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_noisy_square_data(images, object_locations, 8, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_c(2);
+        trainer.set_epsilon(0.01);
+        DLIB_TEST(trainer.get_max_window_cache_size() == 0);
+        object_detector<image_scanner_type> full_scans = trainer.train(images, object_locations);
+        const double full_obj = detector_objective(full_scans, images, object_locations, trainer.get_c());
+
+        const unsigned long cache_sizes[] = {1, 20, 200};
+        const unsigned long rescan_intervals[] = {10, 3, 1000};
+        for (unsigned long i = 0; i < 3; ++i)
+        {
+            print_spinner();
+            trainer.set_max_window_cache_size(cache_sizes[i]);
+            trainer.set_window_cache_rescan_interval(rescan_intervals[i]);
+            object_detector<image_scanner_type> cached = trainer.train(images, object_locations);
+            const double obj = detector_objective(cached, images, object_locations, trainer.get_c());
+            dlog << LINFO << "window cache " << cache_sizes[i] << ", rescan interval " << rescan_intervals[i]
+                 << ": objective " << obj << ", full scans " << full_obj
+                 << ", weight distance " << length(cached.get_w() - full_scans.get_w());
+
+            // Whether the iterations in between score cached windows or not, the
+            // optimization only ends on full scans, so it ends as close to optimal.
+            DLIB_TEST(std::abs(obj - full_obj) <= trainer.get_c()*trainer.get_epsilon());
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class recording_stats_sink : public detection_stats_sink
+    {
+    public:
+        virtual void record (
+            const detection_stats& stats
+        )
+        {
+            auto_mutex lock(m);
+            records.push_back(stats);
+        }
+
+        std::vector<detection_stats> records;
+
+    private:
+        dlib::mutex m;
+    };
+
+    void test_detection_stats (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_detection_stats()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_noisy_square_data(images, object_locations, 8, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_c(10);
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+        DLIB_TEST(get_detection_stats_sink() == 0);
+        recording_stats_sink sink;
+        detection_latency_histograms histograms;
+        const double adjust_thresholds[] = {0, -0.5};
+        unsigned long long total_candidates = 0, total_detections = 0;
+        for (unsigned long k = 0; k < 2; ++k)
+        {
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                print_spinner();
+                std::vector<rectangle> plain_dets = detector(images[i], adjust_thresholds[k]);
+
+                set_detection_stats_sink(&sink);
+                DLIB_TEST(get_detection_stats_sink() == &sink);
+                std::vector<rectangle> dets = detector(images[i], adjust_thresholds[k]);
+                set_detection_stats_sink(&histograms);
+                detector(images[i], adjust_thresholds[k]);
+                set_detection_stats_sink(0);
+
+                // Measuring a detection doesn't change what it finds.
+                DLIB_TEST(dets == plain_dets);
+
+                // One record per detection, describing the detection.
+                DLIB_TEST(sink.records.size() == k*images.size() + i + 1);
+                const detection_stats& stats = sink.records.back();
+                DLIB_TEST(stats.image_nr == images[i].nr());
+                DLIB_TEST(stats.image_nc == images[i].nc());
+                DLIB_TEST(stats.num_detections == dets.size());
+                DLIB_TEST(stats.num_candidates >= stats.num_detections);
+                DLIB_TEST(stats.levels.size() > 1);
+
+                unsigned long level_candidates = 0;
+                double level_pyramid_time = 0, level_filter_time = 0;
+                for (unsigned long l = 0; l < stats.levels.size(); ++l)
+                {
+                    const detection_level_stats& level = stats.levels[l];
+                    DLIB_TEST(level.resize >= 0 && level.histogram >= 0 && level.resample >= 0);
+                    DLIB_TEST(level.normalize >= 0 && level.filter > 0);
+                    level_candidates += level.num_candidates;
+                    level_pyramid_time += level.resize + level.histogram + level.resample + level.normalize;
+                    level_filter_time += level.filter;
+                }
+                // The detector has one filter, so its candidates are the ones the levels
+                // found.
+                DLIB_TEST(level_candidates == stats.num_candidates);
+                DLIB_TEST(stats.pyramid_time > 0);
+                DLIB_TEST(level_pyramid_time <= stats.pyramid_time*1.001 + 1e-6);
+                DLIB_TEST(stats.nms_time >= 0);
+                DLIB_TEST(stats.pyramid_time + level_filter_time + stats.nms_time <= stats.total_time*1.001 + 1e-6);
+
+                total_candidates += stats.num_candidates;
+                total_detections += stats.num_detections;
+            }
+        }
+
+        // Lowering the threshold only adds candidates.
+        for (unsigned long i = 0; i < images.size(); ++i)
+            DLIB_TEST(sink.records[images.size()+i].num_candidates >= sink.records[i].num_candidates);
+
+        // With no sink nothing is recorded.
+        detector(images[0]);
+        DLIB_TEST(sink.records.size() == 2*images.size());
+
+        DLIB_TEST(histograms.get_num_frames() == 2*images.size());
+        DLIB_TEST(histograms.get_num_candidates() == total_candidates);
+        DLIB_TEST(histograms.get_num_detections() == total_detections);
+        DLIB_TEST(histograms.total().count() == 2*images.size());
+        DLIB_TEST(histograms.total().max() >= histograms.pyramid().max());
+        dlog << LINFO << "detection latencies:\n" << histograms;
+
+        // A load() outside of a detection makes its own record.
+        set_detection_stats_sink(&sink);
+        image_scanner_type temp;
+        temp.copy_configuration(detector.get_scanner());
+        temp.load(images[0]);
+        set_detection_stats_sink(0);
+        DLIB_TEST(sink.records.size() == 2*images.size() + 1);
+        DLIB_TEST(sink.records.back().levels.size() == sink.records[0].levels.size());
+        DLIB_TEST(sink.records.back().pyramid_time > 0);
+        DLIB_TEST(sink.records.back().num_detections == 0);
+        for (unsigned long l = 0; l < sink.records.back().levels.size(); ++l)
+            DLIB_TEST(sink.records.back().levels[l].filter == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_latency_histogram (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_latency_histogram()";
+
+        latency_histogram hist;
+        DLIB_TEST(hist.count() == 0);
+        DLIB_TEST(hist.mean() == 0);
+        DLIB_TEST(hist.max() == 0);
+        DLIB_TEST(hist.percentile(50) == 0);
+
+        // 1ms, 2ms, ..., 100ms, so the exact p-th percentile is p ms.
+        latency_histogram first, second;
+        for (int i = 1; i <= 100; ++i)
+        {
+            hist.add(i*1e-3);
+            if (i%2 == 0)
+                first.add(i*1e-3);
+            else
+                second.add(i*1e-3);
+        }
+        first.merge(second);
+
+        const latency_histogram* hists[] = {&hist, &first};
+        for (int h = 0; h < 2; ++h)
+        {
+            DLIB_TEST(hists[h]->count() == 100);
+            DLIB_TEST(std::abs(hists[h]->mean() - 50.5e-3) < 1e-12);
+            DLIB_TEST(std::abs(hists[h]->max() - 100e-3) < 1e-12);
+            const double ps[] = {1, 10, 50, 90, 99, 100};
+            for (int k = 0; k < 6; ++k)
+            {
+                // Rounded up to the edge of a bucket 9% wide, never past the max.
+                const double p = hists[h]->percentile(ps[k]);
+                DLIB_TEST_MSG(p >= ps[k]*1e-3*(1 - 1e-9) && p <= ps[k]*1e-3*1.091, ps[k] << " " << p);
+            }
+            DLIB_TEST(hists[h]->percentile(100) == hists[h]->max());
+        }
+
+        hist.clear();
+        DLIB_TEST(hist.count() == 0);
+        DLIB_TEST(hist.max() == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_evaluate_object_detection_function (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_evaluate_object_detection_function()";
+
+        dlib::rand rnd;
+        dlib::array<array2d<unsigned char> > images, images_val;
+        std::vector<std::vector<rectangle> > object_locations, object_locations_val;
+        make_noisy_square_data(images, object_locations, 8, rnd);
+        make_noisy_square_data(images_val, object_locations_val, 11, rnd);
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        trainer.set_c(10);
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+        // Ignore a box in a few images, so the ignore handling is compared too.
+        std::vector<std::vector<rectangle> > ignore(images_val.size());
+        for (unsigned long i = 0; i < images_val.size(); i += 3)
+            ignore[i].push_back(centered_rect(point(100,100), 60, 60));
+
+        unsigned long total_true_targets = 0;
+        for (unsigned long i = 0; i < object_locations_val.size(); ++i)
+            total_true_targets += object_locations_val[i].size();
+
+        const double adjust_thresholds[] = {0, -0.3, 0.3};
+        const unsigned long thread_counts[] = {1, 3, 8, 100};
+        for (unsigned long k = 0; k < 3; ++k)
+        {
+            const matrix<double,1,3> expected = test_object_detection_function(detector, images_val,
+                object_locations_val, ignore, test_box_overlap(), adjust_thresholds[k]);
+            const matrix<double,1,3> expected_no_ignore = test_object_detection_function(detector,
+                images_val, object_locations_val, test_box_overlap(), adjust_thresholds[k]);
+            dlog << LINFO << "adjust_threshold " << adjust_thresholds[k] << ": " << expected;
+
+            for (unsigned long t = 0; t < 4; ++t)
+            {
+                print_spinner();
+                const object_detection_evaluation eval = evaluate_object_detection_function(detector,
+                    images_val, object_locations_val, ignore, thread_counts[t], test_box_overlap(),
+                    adjust_thresholds[k]);
+
+                // The same accuracy however many threads split the images.
+                DLIB_TEST_MSG(eval.accuracy == expected, eval.accuracy << " " << expected << " " << thread_counts[t]);
+                DLIB_TEST(eval.total_true_targets == total_true_targets);
+                DLIB_TEST(eval.correct_hits <= eval.total_hits);
+                DLIB_TEST(eval.accuracy(1) == (double)eval.correct_hits/eval.total_true_targets);
+                if (eval.total_hits != 0)
+                    DLIB_TEST(eval.accuracy(0) == (double)eval.correct_hits/eval.total_hits);
+                DLIB_TEST(eval.num_threads == std::min<unsigned long>(thread_counts[t], images_val.size()));
+
+                DLIB_TEST(eval.image_seconds.size() == images_val.size());
+                double max_seconds = 0, sum_seconds = 0;
+                for (unsigned long i = 0; i < eval.image_seconds.size(); ++i)
+                {
+                    DLIB_TEST(eval.image_seconds[i] > 0);
+                    max_seconds = std::max(max_seconds, eval.image_seconds[i]);
+                    sum_seconds += eval.image_seconds[i];
+                }
+                DLIB_TEST(eval.latency_max == max_seconds);
+                DLIB_TEST(std::abs(eval.latency_mean - sum_seconds/images_val.size()) < 1e-12);
+                DLIB_TEST(eval.latency_p50 <= eval.latency_p95);
+                DLIB_TEST(eval.latency_p95 <= eval.latency_p99);
+                DLIB_TEST(eval.latency_p99 <= eval.latency_max);
+                DLIB_TEST(eval.latency_p50 > 0);
+
+                // The fHOG scanner reports its stages, which fit in the detection times.
+                DLIB_TEST(eval.pyramid_seconds > 0);
+                DLIB_TEST(eval.histogram_seconds > 0);
+                DLIB_TEST(eval.filter_seconds > 0);
+                DLIB_TEST(eval.resize_seconds + eval.histogram_seconds + eval.resample_seconds +
+                          eval.normalize_seconds <= eval.pyramid_seconds*1.001 + 1e-6);
+                DLIB_TEST(eval.pyramid_seconds + eval.filter_seconds + eval.nms_seconds <= sum_seconds*1.001 + 1e-6);
+
+                DLIB_TEST(eval.wall_seconds > 0);
+                DLIB_TEST(std::abs(eval.images_per_second - images_val.size()/eval.wall_seconds) < 1e-9*eval.images_per_second);
+            }
+
+            const object_detection_evaluation eval = evaluate_object_detection_function(detector,
+                images_val, object_locations_val, 3, test_box_overlap(), adjust_thresholds[k]);
+            DLIB_TEST(eval.accuracy == expected_no_ignore);
+        }
+
+        // A sink set in the calling thread hears about every image.
+        detection_latency_histograms histograms;
+        set_detection_stats_sink(&histograms);
+        const object_detection_evaluation eval = evaluate_object_detection_function(detector,
+            images_val, object_locations_val, 4);
+        set_detection_stats_sink(0);
+        DLIB_TEST(histograms.get_num_frames() == images_val.size());
+        DLIB_TEST(histograms.get_num_detections() == eval.total_hits);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void test_1 (
@@ -1008,6 +2354,19 @@ namespace
         )
         {
             test_fhog_pyramid();
+            test_fhog_pyramid_schedule();
+            test_fhog_power_law();
+            test_virtual_upsampling();
+            test_fhog_training_settings();
+            test_fhog_feature_store();
+            test_fhog_detector_artifact();
+            test_select_separable_rank();
+            test_train_path();
+            test_train_incremental();
+            test_window_cache();
+            test_detection_stats();
+            test_latency_histogram();
+            test_evaluate_object_detection_function();
             test_1_boxes();
             test_1_poly_nn_boxes();
             test_3_boxes();
@@ -4,6 +4,7 @@
 #include <sstream>
 #include <string>
 #include <cstdlib>
+#include <cmath>
 #include <ctime>
 #include <dlib/svm_threaded.h>
 
@@ -33,10 +34,11 @@ namespace
 
         test_multiclass_svm_problem (
             const std::vector<sample_type>& samples_,
-            const std::vector<label_type>& labels_
+            const std::vector<label_type>& labels_,
+            const unsigned long num_threads = 2
         ) :
             structural_svm_problem_threaded<matrix_type,
-                std::vector<std::pair<unsigned long,typename matrix_type::type> > >(2),
+                std::vector<std::pair<unsigned long,typename matrix_type::type> > >(num_threads),
             samples(samples_),
             labels(labels_),
             dims(10+1) // +1 for the bias
@@ -505,6 +507,116 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename matrix_type,
+        typename sample_type,
+        typename label_type
+        >
+    class uneven_cost_svm_problem : public test_multiclass_svm_problem<matrix_type,sample_type,label_type>
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is test_multiclass_svm_problem except that the separation oracle is
+                much slower for every 7th sample, so the threads of
+                structural_svm_problem_threaded get very uneven amounts of work unless
+                they are scheduled by cost.
+        !*/
+
+    public:
+        typedef test_multiclass_svm_problem<matrix_type,sample_type,label_type> base;
+        typedef typename base::scalar_type scalar_type;
+        typedef typename base::feature_vector_type feature_vector_type;
+
+        uneven_cost_svm_problem (
+            const std::vector<sample_type>& samples_,
+            const std::vector<label_type>& labels_,
+            const unsigned long num_threads
+        ) : base(samples_, labels_, num_threads) {}
+
+        virtual void separation_oracle (
+            const long idx,
+            const matrix_type& current_solution,
+            scalar_type& loss,
+            feature_vector_type& psi
+        ) const 
+        {
+            base::separation_oracle(idx, current_solution, loss, psi);
+            if (idx%7 == 0)
+            {
+                volatile double waste = 0;
+                for (long i = 0; i < 20000; ++i)
+                    waste = waste + std::sqrt((double)i);
+            }
+        }
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    void test_compact_column_vector (
+        dlib::rand& rnd
+    )
+    {
+        print_spinner();
+        typedef matrix<double,0,1> vect;
+
+        // Vectors with no zeros, nothing but zeros, zero runs just shorter and just
+        // longer than the ones that get skipped, and zeros at either end.
+        std::vector<vect> vects;
+        vects.push_back(vect());
+        vects.push_back(zeros_matrix<double>(50,1));
+        vects.push_back(randm(50,1,rnd) + 1);
+        for (long run = 1; run <= 10; ++run)
+        {
+            vect v = randm(40,1,rnd) + 1;
+            set_rowm(v, range(0, run-1)) = 0;
+            set_rowm(v, range(15, 15+run-1)) = 0;
+            set_rowm(v, range(40-run, 39)) = 0;
+            vects.push_back(v);
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            // random sparsity patterns
+            vect v = randm(200,1,rnd) - 0.5;
+            const double density = rnd.get_random_double();
+            for (long j = 0; j < v.size(); ++j)
+            {
+                if (rnd.get_random_double() > density)
+                    v(j) = 0;
+            }
+            vects.push_back(v);
+        }
+
+        for (unsigned long i = 0; i < vects.size(); ++i)
+        {
+            const vect& v = vects[i];
+            const vect rounded = matrix_cast<double>(matrix_cast<float>(v));
+
+            impl::compact_column_vector c;
+            c.assign(v);
+
+            // get() gives back the vector, rounded to float precision.
+            vect v2 = randm(3,1,rnd);
+            c.get(v2);
+            DLIB_TEST(v2.size() == v.size());
+            DLIB_TEST(v2 == rounded);
+
+            matrix<float,0,1> vf;
+            c.get(vf);
+            DLIB_TEST(vf == matrix_cast<float>(v));
+
+            // dot() is the dot product of the rounded vector with w.
+            const vect w = randm(v.size(),1,rnd) - 0.5;
+            DLIB_TEST(std::abs(c.dot(w) - dot(rounded, w)) < 1e-12);
+
+            // Reassigning replaces the old contents.
+            c.assign(w);
+            c.get(v2);
+            DLIB_TEST(v2 == matrix_cast<double>(matrix_cast<float>(w)));
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_svm_struct : public tester
@@ -610,6 +722,63 @@ namespace
             DLIB_TEST(sum(diag(res)) == samples.size());
         }
 
+        void test_threaded_scheduling (
+            const std::vector<sample_type>& samples,
+            const std::vector<scalar_type>& labels,
+            dlib::rand& rnd
+        )
+        {
+            typedef matrix<double,0,1> w_type;
+            typedef uneven_cost_svm_problem<w_type,sample_type,scalar_type> problem_type;
+
+            problem_type reference(samples, labels, 1);
+            reference.set_max_cache_size(0);
+            const oca_problem<w_type>& ref = reference;
+
+            // However the samples are spread over the threads, and whatever order the
+            // measured costs put them in on later calls, every sample is visited exactly
+            // once per call.  So the risk and subgradient match the single threaded ones
+            // up to the order of the additions.
+            const unsigned long num_threads[] = {2, 3, 7};
+            for (unsigned long t = 0; t < 3; ++t)
+            {
+                print_spinner();
+                problem_type threaded(samples, labels, num_threads[t]);
+                threaded.set_max_cache_size(0);
+                DLIB_TEST(threaded.get_num_threads() == num_threads[t]);
+                const oca_problem<w_type>& prob = threaded;
+                for (int round = 0; round < 4; ++round)
+                {
+                    w_type w = 10*(randm(ref.get_num_dimensions(),1,rnd) - 0.5);
+                    double risk1, risk2;
+                    w_type grad1, grad2;
+                    ref.get_risk(w, risk1, grad1);
+                    prob.get_risk(w, risk2, grad2);
+                    dlog << LINFO << num_threads[t] << " threads: risk " << risk2 << " vs " << risk1;
+                    DLIB_TEST(std::abs(risk1 - risk2) < 1e-10);
+                    DLIB_TEST(max(abs(grad1 - grad2)) < 1e-10);
+                }
+            }
+
+            // And so training with several threads gives the single threaded solution,
+            // up to the accuracy asked of the solver since the rounding differs.
+            print_spinner();
+            problem_type problem1(samples, labels, 1);
+            problem_type problem4(samples, labels, 4);
+            problem1.set_c(10);
+            problem4.set_c(10);
+            problem1.set_epsilon(1e-4);
+            problem4.set_epsilon(1e-4);
+            oca solver;
+            w_type w1, w4;
+            const double obj1 = solver(problem1, w1);
+            const double obj4 = solver(problem4, w4);
+            dlog << LINFO << "objective with 1 thread: " << obj1 << ", with 4: " << obj4;
+            dlog << LINFO << "weight error: " << max(abs(w1 - w4));
+            DLIB_TEST(std::abs(obj1 - obj4) < 10*1e-4);
+            DLIB_TEST(max(abs(w1 - w4)) < 1e-2);
+        }
+
         void perform_test (
         )
         {
@@ -629,6 +798,12 @@ namespace
             dlog << LINFO << "test with 2 sample per class";
             make_dataset(samples, labels, 2, rnd);
             run_test(samples, labels, 0.444);
+
+            test_compact_column_vector(rnd);
+
+            dlog << LINFO << "test threaded oracle scheduling";
+            make_dataset(samples, labels, 20, rnd);
+            test_threaded_scheduling(samples, labels, rnd);
         }
     } a;
 
@@ -0,0 +1,210 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+#include "tester.h"
+#include <dlib/image_processing.h>
+#include <dlib/image_transforms.h>
+#include <dlib/rand.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+
+namespace
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.yuyv_image");
+
+// ----------------------------------------------------------------------------------------
+
+    void make_yuyv_frame (
+        const array2d<unsigned char>& img,
+        long row_bytes,
+        dlib::rand& rnd,
+        std::vector<unsigned char>& frame
+    )
+    /*!
+        ensures
+            - #frame is a YUYV frame whose luma is img, with rows row_bytes apart.  The
+              chroma and the padding at the end of each row are random so any read of
+              them shows up as a difference.
+    !*/
+    {
+        frame.resize(row_bytes*img.nr());
+        for (unsigned long i = 0; i < frame.size(); ++i)
+            frame[i] = rnd.get_random_8bit_number();
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+                frame[r*row_bytes + 2*c] = img[r][c];
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_yuyv_luma_image (
+        dlib::rand& rnd
+    )
+    {
+        print_spinner();
+        array2d<unsigned char> img(61, 84);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+                img[r][c] = rnd.get_random_8bit_number();
+        }
+
+        // Without and with the row padding some V4L2 drivers add.
+        const long row_bytes[] = {2*84, 2*84+24};
+        for (unsigned long k = 0; k < 2; ++k)
+        {
+            std::vector<unsigned char> frame;
+            make_yuyv_frame(img, row_bytes[k], rnd, frame);
+            const yuyv_luma_image yimg(&frame[0], img.nr(), img.nc(), k == 0 ? 0 : row_bytes[k]);
+
+            DLIB_TEST(yimg.nr() == img.nr());
+            DLIB_TEST(yimg.nc() == img.nc());
+            DLIB_TEST(num_rows(yimg) == img.nr());
+            DLIB_TEST(num_columns(yimg) == img.nc());
+            DLIB_TEST(yimg.size() == img.size());
+            DLIB_TEST(yimg.width_step() == row_bytes[k]);
+            DLIB_TEST(yimg.frame() == &frame[0]);
+
+            const_image_view<yuyv_luma_image> view(yimg);
+            bool same = true;
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                    same = same && yimg[r][c] == img[r][c] && view[r][c] == img[r][c];
+            }
+            DLIB_TEST(same);
+
+            array2d<unsigned char> copy;
+            assign_image(copy, yimg);
+            DLIB_TEST(mat(copy) == mat(img));
+            DLIB_TEST(mat(yimg) == mat(img));
+
+            array2d<unsigned char> small1(37, 50), small2(37, 50);
+            resize_image(yimg, small1);
+            resize_image(img, small2);
+            DLIB_TEST(mat(small1) == mat(small2));
+
+            array2d<matrix<float,31,1> > hog1, hog2;
+            extract_fhog_features(yimg, hog1);
+            extract_fhog_features(img, hog2);
+            DLIB_TEST(hog1.nr() == hog2.nr() && hog1.nc() == hog2.nc());
+            for (long r = 0; r < hog1.nr(); ++r)
+            {
+                for (long c = 0; c < hog1.nc(); ++c)
+                    DLIB_TEST(hog1[r][c] == hog2[r][c]);
+            }
+
+            // A detector run on the frame finds exactly what it finds on the image.
+            typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type;
+            image_scanner_type scanner;
+            scanner.set_detection_window_size(24, 24);
+            scanner.set_min_pyramid_layer_size(24, 24);
+            matrix<double,0,1> w = randm(scanner.get_num_dimensions()+1, 1, rnd) - 0.5;
+            w(w.size()-1) = 0;
+            object_detector<image_scanner_type> detector(scanner, test_box_overlap(), w);
+            std::vector<std::pair<double, rectangle> > dets1, dets2;
+            detector(yimg, dets1, -10);
+            detector(img, dets2, -10);
+            dlog << LINFO << "num detections: " << dets1.size();
+            DLIB_TEST(dets1.size() != 0);
+            DLIB_TEST(dets1 == dets2);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_yuyv_frame_file (
+        dlib::rand& rnd
+    )
+    {
+        print_spinner();
+        const long nr = 10;
+        const long nc = 16;
+        const unsigned long num_frames = 3;
+        const std::string filename = "yuyv_frame_file_test.yuyv";
+
+        dlib::array<array2d<unsigned char> > imgs(num_frames);
+        {
+            std::ofstream fout(filename.c_str(), std::ios::binary);
+            for (unsigned long i = 0; i < num_frames; ++i)
+            {
+                imgs[i].set_size(nr, nc);
+                for (long r = 0; r < nr; ++r)
+                {
+                    for (long c = 0; c < nc; ++c)
+                        imgs[i][r][c] = rnd.get_random_8bit_number();
+                }
+                std::vector<unsigned char> frame;
+                make_yuyv_frame(imgs[i], 2*nc, rnd, frame);
+                fout.write(reinterpret_cast<const char*>(&frame[0]), frame.size());
+            }
+        }
+
+        yuyv_frame_file frames;
+        DLIB_TEST(frames.is_open() == false);
+        DLIB_TEST(frames.size() == 0);
+
+        frames.open(filename, nr, nc);
+        DLIB_TEST(frames.is_open());
+        DLIB_TEST(frames.nr() == nr);
+        DLIB_TEST(frames.nc() == nc);
+        DLIB_TEST(frames.size() == num_frames);
+        for (unsigned long i = 0; i < num_frames; ++i)
+        {
+            const yuyv_luma_image yimg = frames[i];
+            DLIB_TEST(yimg.nr() == nr && yimg.nc() == nc);
+            DLIB_TEST(mat(yimg) == mat(imgs[i]));
+        }
+
+        // The file doesn't hold a whole number of frames of another size.
+        bool error_thrown = false;
+        try
+        {
+            frames.open(filename, nr, nc+2);
+        }
+        catch (dlib::error&)
+        {
+            error_thrown = true;
+        }
+        DLIB_TEST(error_thrown);
+        DLIB_TEST(frames.is_open() == false);
+        DLIB_TEST(frames.size() == 0);
+
+        frames.open(filename, nr, nc);
+        DLIB_TEST(frames.size() == num_frames);
+        frames.close();
+        DLIB_TEST(frames.is_open() == false);
+        DLIB_TEST(frames.size() == 0);
+
+        std::remove(filename.c_str());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class yuyv_image_tester : public tester
+    {
+    public:
+        yuyv_image_tester (
+        ) :
+            tester ("test_yuyv_image",
+                    "Runs tests on the yuyv_luma_image and yuyv_frame_file objects.")
+        {}
+
+        void perform_test (
+        )
+        {
+            dlib::rand rnd;
+            test_yuyv_luma_image(rnd);
+            test_yuyv_frame_file(rnd);
+        }
+    } a;
+
+}
+
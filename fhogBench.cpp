@@ -0,0 +1,691 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/image_processing.h>
+#include <dlib/image_transforms.h>
+#include <dlib/data_io.h>
+#include <dlib/rand.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Times every stage of the fHOG detection pipeline in isolation: the frameUtils kernels
+// (scalar and simd), img_to_histo_dlib, the histogram downsampling, the hack feature
+// extraction, whole pyramids for each approximation strategy, the dense and separable
+// filter paths of apply_filters_to_fhog and the non-max suppression.  Each stage is run
+// a few times to warm up and then repetitions times, and the median, the 95th percentile
+// and (where it means something) the GB/s are printed and written to a JSON file so runs
+// against different library versions can be diffed.
+//
+// The pyramid strategies are
+//    - baseline:  dlib's exact pyramid, every level extracted from a resized image.
+//    - hybrid:    create_fhog_pyramid() with the default fhog_pyramid_approximation.
+//    - power-law: every third level (about an octave at 4/5) is extracted from a resized
+//                 image, the levels in between downsample the histograms of the last
+//                 exact level and correct them by s^-power_law_lambda.
+// The hybrid pyramid lives in the fixed size HogBackend buffers, so it is skipped for
+// images bigger than FRAME_WIDTH x FRAME_HEIGHT.
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+typedef image_scanner_type::fhog_filterbank fhog_filterbank;
+typedef dlib::array<dlib::array<array2d<float> > > fhog_pyramid;
+typedef array2d<matrix<float,18,1> > histogram_image;
+
+const float pyramid_downscale = 4.f/5.f;
+const int power_law_exact_every = 3;
+const float power_law_lambda = 0.1f;
+
+const long warm_up_runs = 3;
+
+struct bench_result
+{
+    std::string stage;
+    std::string config;
+    std::string image;
+    long width;
+    long height;
+    double median_ms;
+    double p95_ms;
+    double bytes;
+    std::string note;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class stage_timer
+{
+public:
+    stage_timer (
+        long repetitions_,
+        std::vector<bench_result>& results_
+    ) : repetitions(repetitions_), results(results_) {}
+
+    template <typename funct_type>
+    void run (
+        const std::string& stage,
+        const std::string& config,
+        const std::string& image,
+        long width,
+        long height,
+        double bytes,
+        funct_type funct
+    )
+    {
+        for (long i = 0; i < warm_up_runs; ++i)
+            funct();
+
+        std::vector<double> times(repetitions);
+        for (long i = 0; i < repetitions; ++i)
+        {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            funct();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            times[i] = 1.e-6*std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        }
+        std::sort(times.begin(), times.end());
+
+        bench_result r;
+        r.stage = stage;
+        r.config = config;
+        r.image = image;
+        r.width = width;
+        r.height = height;
+        r.median_ms = times[times.size()/2];
+        r.p95_ms = times[std::min<size_t>(times.size()-1, (size_t)std::ceil(0.95*times.size())-1)];
+        r.bytes = bytes;
+        print(r);
+        results.push_back(r);
+    }
+
+    void skip (
+        const std::string& stage,
+        const std::string& config,
+        const std::string& image,
+        long width,
+        long height,
+        const std::string& note
+    )
+    {
+        bench_result r;
+        r.stage = stage;
+        r.config = config;
+        r.image = image;
+        r.width = width;
+        r.height = height;
+        r.median_ms = r.p95_ms = r.bytes = 0;
+        r.note = note;
+        print(r);
+        results.push_back(r);
+    }
+
+private:
+    static void print (
+        const bench_result& r
+    )
+    {
+        cout << left << setw(24) << r.stage << setw(11) << r.config << setw(10) << r.image
+             << right << setw(5) << r.width << "x" << left << setw(6) << r.height << right;
+        if (r.note.size() != 0)
+        {
+            cout << "  skipped: " << r.note << endl;
+            return;
+        }
+        cout << fixed << setprecision(3) << setw(10) << r.median_ms << " ms" << setw(10) << r.p95_ms << " ms p95";
+        if (r.bytes != 0)
+            cout << setw(9) << setprecision(2) << r.bytes/(r.median_ms*1e6) << " GB/s";
+        cout << endl;
+        cout.unsetf(std::ios::floatfield);
+    }
+
+    const long repetitions;
+    std::vector<bench_result>& results;
+};
+
+// ----------------------------------------------------------------------------------------
+
+static std::string json_string (
+    const std::string& s
+)
+{
+    std::ostringstream sout;
+    sout << '"';
+    for (unsigned long i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            sout << '\\' << s[i];
+        else if ((unsigned char)s[i] < 0x20)
+            sout << "\\u" << hex << setw(4) << setfill('0') << (int)(unsigned char)s[i] << dec << setfill(' ');
+        else
+            sout << s[i];
+    }
+    sout << '"';
+    return sout.str();
+}
+
+static void save_results_json (
+    const std::vector<bench_result>& results,
+    const std::string& filename,
+    long repetitions
+)
+{
+    std::ofstream fout(filename.c_str());
+    if (!fout)
+        throw error("Unable to open " + filename + " for writing.");
+
+    fout << "{\n";
+    fout << "  \"library\": " << json_string("dlib-19.4-modified") << ",\n";
+    fout << "  \"pyramid_strategy\": " << json_string(cast_to_string(fhog_pyramid_approximation())) << ",\n";
+    fout << "  \"compiler\": " << json_string(__VERSION__) << ",\n";
+    fout << "  \"repetitions\": " << repetitions << ",\n";
+    fout << "  \"warm_up_runs\": " << warm_up_runs << ",\n";
+    fout << "  \"results\": [\n";
+    fout << setprecision(6);
+    for (unsigned long i = 0; i < results.size(); ++i)
+    {
+        const bench_result& r = results[i];
+        fout << "    {\"stage\": " << json_string(r.stage) << ", \"config\": " << json_string(r.config)
+             << ", \"image\": " << json_string(r.image) << ", \"width\": " << r.width << ", \"height\": " << r.height;
+        if (r.note.size() != 0)
+        {
+            fout << ", \"skipped\": " << json_string(r.note);
+        }
+        else
+        {
+            fout << ", \"median_ms\": " << r.median_ms << ", \"p95_ms\": " << r.p95_ms;
+            if (r.bytes != 0)
+                fout << ", \"bytes\": " << r.bytes << ", \"gb_per_s\": " << r.bytes/(r.median_ms*1e6);
+        }
+        fout << "}" << (i+1 < results.size() ? "," : "") << "\n";
+    }
+    fout << "  ]\n}\n";
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void make_synthetic_image (
+    array2d<unsigned char>& img,
+    long width,
+    long height
+)
+{
+    // Smooth blobs plus oriented stripes plus noise, so the gradients cover all the
+    // orientation bins and every cell has something in it.
+    dlib::rand rnd(width*height);
+    img.set_size(height, width);
+    for (long r = 0; r < height; ++r)
+    {
+        for (long c = 0; c < width; ++c)
+        {
+            const double v = 128 + 50*std::sin(0.031*c + 0.017*r) + 30*std::sin(0.11*c - 0.07*r)
+                + 20*std::cos(0.005*c*r/(1.0+r)) + rnd.get_random_gaussian()*10;
+            img[r][c] = (unsigned char)std::max(0.0, std::min(255.0, v));
+        }
+    }
+}
+
+static unsigned long num_pyramid_levels (
+    const image_scanner_type& scanner,
+    long width,
+    long height
+)
+{
+    // The same count create_fhog_pyramid() comes up with.
+    unsigned long levels = 0;
+    rectangle rect(width, height);
+    pyramid_down<5> pyr;
+    do
+    {
+        rect = pyr.rect_down(rect);
+        ++levels;
+    } while (rect.width() >= scanner.get_min_pyramid_layer_width() && rect.height() >= scanner.get_min_pyramid_layer_height() &&
+        levels < scanner.get_max_pyramid_levels());
+    return levels;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void baseline_pyramid (
+    const array2d<unsigned char>& img,
+    const image_scanner_type& scanner,
+    fhog_pyramid& feats
+)
+{
+    const unsigned long levels = num_pyramid_levels(scanner, img.nc(), img.nr());
+    feats.set_max_size(levels);
+    feats.set_size(levels);
+    const default_fhog_feature_extractor& fe = scanner.get_feature_extractor();
+    const int cell_size = scanner.get_cell_size();
+    const int rows_padding = scanner.get_fhog_window_height();
+    const int cols_padding = scanner.get_fhog_window_width();
+
+    pyramid_down<5> pyr;
+    array2d<unsigned char> temp1, temp2;
+    fe(img, feats[0], cell_size, rows_padding, cols_padding);
+    for (unsigned long i = 1; i < levels; ++i)
+    {
+        if (i == 1)
+            pyr(img, temp1);
+        else
+            pyr(temp2, temp1);
+        fe(temp1, feats[i], cell_size, rows_padding, cols_padding);
+        swap(temp1, temp2);
+    }
+}
+
+class power_law_pyramid
+{
+public:
+    void operator() (
+        const array2d<unsigned char>& img,
+        const image_scanner_type& scanner,
+        fhog_pyramid& feats
+    )
+    {
+        const unsigned long levels = num_pyramid_levels(scanner, img.nc(), img.nr());
+        feats.set_max_size(levels);
+        feats.set_size(levels);
+        const default_fhog_feature_extractor& fe = scanner.get_feature_extractor();
+        const int cell_size = scanner.get_cell_size();
+        const int rows_padding = scanner.get_fhog_window_height();
+        const int cols_padding = scanner.get_fhog_window_width();
+
+        const int cells_nr = (int)((float)img.nr()/(float)cell_size + 0.5);
+        const int cells_nc = (int)((float)img.nc()/(float)cell_size + 0.5);
+        const int count = (cells_nr+2)*(cells_nc+2)*HISTO_BIN_COUNT;
+        if (count > capacity)
+        {
+            ref_storage = storage<float>(count);
+            down_storage = storage<float>(count);
+            capacity = count;
+        }
+        float* ref = aligned(ref_storage.get());
+        float* down = aligned(down_storage.get());
+
+        int pyr_nr = img.nr();
+        int pyr_nc = img.nc();
+        int ref_cells_nr = cells_nr;
+        int ref_cells_nc = cells_nc;
+        float ref_scale = 1;
+        float scale = 1;
+        for (unsigned long i = 0; i < levels; ++i)
+        {
+            if (i != 0)
+            {
+                pyr_nr = pyr_nr*pyramid_downscale;
+                pyr_nc = pyr_nc*pyramid_downscale;
+                scale *= pyramid_downscale;
+            }
+            const int pyr_cells_nr = (int)((float)pyr_nr/(float)cell_size + 0.5);
+            const int pyr_cells_nc = (int)((float)pyr_nc/(float)cell_size + 0.5);
+            hist.set_size(pyr_cells_nr+2, pyr_cells_nc+2);
+
+            if (i%power_law_exact_every == 0)
+            {
+                if (i == 0)
+                {
+                    impl::makeHist(img, hist, cell_size, rows_padding, cols_padding, ref);
+                }
+                else
+                {
+                    resized.set_size(pyr_nr, pyr_nc);
+                    resize_image(img, resized);
+                    impl::makeHist(resized, hist, cell_size, rows_padding, cols_padding, ref);
+                }
+                ref_cells_nr = pyr_cells_nr;
+                ref_cells_nc = pyr_cells_nc;
+                ref_scale = scale;
+            }
+            else
+            {
+                // extract_histo() sums the source cells, so undo the area factor and
+                // apply the power law for the scale relative to the exact level.
+                scalar_extract_histo(down, ref, pyr_cells_nc, pyr_cells_nr, 0, 0, ref_cells_nc, ref_cells_nr, ref_cells_nc, ref_cells_nr);
+                const float s = scale/ref_scale;
+                const float correction = ((float)pyr_cells_nr*pyr_cells_nc)/((float)ref_cells_nr*ref_cells_nc)*std::pow(s, -power_law_lambda);
+                const int n = pyr_cells_nr*pyr_cells_nc*HISTO_BIN_COUNT;
+                for (int k = 0; k < n; ++k)
+                    down[k] *= correction;
+                impl::fab2dlib_hist(hist, down);
+            }
+            fe(hist, feats[i], pyr_cells_nr, pyr_cells_nc, rows_padding, cols_padding);
+        }
+    }
+
+private:
+    std::unique_ptr<float[]> ref_storage, down_storage;
+    int capacity = 0;
+    histogram_image hist;
+    array2d<unsigned char> resized;
+};
+
+// ----------------------------------------------------------------------------------------
+
+static rectangle apply_dense_filters (
+    const fhog_filterbank& w,
+    const dlib::array<array2d<float> >& feats,
+    array2d<float>& saliency_image
+)
+{
+    rectangle area = spatially_filter_image(feats[0], saliency_image, w.filters[0]);
+    for (unsigned long i = 1; i < w.filters.size(); ++i)
+        spatially_filter_image(feats[i], saliency_image, w.filters[i], 1, false, true);
+    return area;
+}
+
+static rectangle apply_separable_filters (
+    const fhog_filterbank& w,
+    const dlib::array<array2d<float> >& feats,
+    array2d<float>& saliency_image,
+    array2d<float>& scratch
+)
+{
+    rectangle area;
+    saliency_image.clear();
+    for (unsigned long i = 0; i < w.row_filters.size(); ++i)
+    {
+        for (unsigned long j = 0; j < w.row_filters[i].size(); ++j)
+            area = float_spatially_filter_image_separable(feats[i], saliency_image, w.row_filters[i][j], w.col_filters[i][j], scratch, saliency_image.size() != 0);
+    }
+    return area;
+}
+
+static double pyramid_bytes (
+    const fhog_pyramid& feats
+)
+{
+    double bytes = 0;
+    for (unsigned long i = 0; i < feats.size(); ++i)
+        for (unsigned long j = 0; j < feats[i].size(); ++j)
+            bytes += feats[i][j].size()*sizeof(float);
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void bench_image (
+    const array2d<unsigned char>& img,
+    const std::string& image_name,
+    const image_scanner_type& scanner,
+    const fhog_filterbank& fb,
+    stage_timer& timer
+)
+{
+    const long width = img.nc();
+    const long height = img.nr();
+    const double pixels = width*height;
+    const int cell_size = scanner.get_cell_size();
+    const int rows_padding = scanner.get_fhog_window_height();
+    const int cols_padding = scanner.get_fhog_window_width();
+    const int cells_nr = (int)((float)height/(float)cell_size + 0.5);
+    const int cells_nc = (int)((float)width/(float)cell_size + 0.5);
+    const double histo_bytes = (double)cells_nr*cells_nc*HISTO_BIN_COUNT*sizeof(float);
+
+    // ---------------- frameUtils kernels ----------------
+    // The kernels work on whole 8x8 cells of a FRAME_ALIGNMENT aligned frame.
+    std::unique_ptr<uint8_t[]> v4l_storage(storage(2*width*height)), yuv_storage(storage(3*width*height));
+    std::unique_ptr<uint8_t[]> dxy_storage(storage(2*width*height)), ma_storage(storage(2*width*height));
+    std::unique_ptr<float[]> histo_storage(storage<float>(cells_nr*cells_nc*HISTO_BIN_COUNT));
+    std::unique_ptr<float[]> extract_storage(storage<float>(cells_nr*cells_nc*HISTO_BIN_COUNT));
+    uint8_t* v4l = aligned(v4l_storage.get());
+    uint8_t* yuv = aligned(yuv_storage.get());
+    uint8_t* dxy = aligned(dxy_storage.get());
+    uint8_t* ma = aligned(ma_storage.get());
+    float* histo = aligned(histo_storage.get());
+    float* extract = aligned(extract_storage.get());
+    for (long r = 0; r < height; ++r)
+    {
+        for (long c = 0; c < width; ++c)
+        {
+            v4l[2*(r*width+c)] = img[r][c];
+            v4l[2*(r*width+c)+1] = 128;
+        }
+    }
+    const long w = width, h = height;
+    const int down_nc = (int)(cells_nc*pyramid_downscale);
+    const int down_nr = (int)(cells_nr*pyramid_downscale);
+    const double down_bytes = histo_bytes + (double)down_nr*down_nc*HISTO_BIN_COUNT*sizeof(float);
+
+    timer.run("V4L_to_YUV", "scalar", image_name, width, height, 5*pixels,
+        [&]{ scalar_V4L_to_YUV(yuv, yuv+w*h, yuv+2*w*h, v4l, w, h); });
+    timer.run("V4L_to_YUV", "simd", image_name, width, height, 5*pixels,
+        [&]{ simd_V4L_to_YUV(yuv, yuv+w*h, yuv+2*w*h, v4l, w, h); });
+    timer.run("Y_to_DXY", "scalar", image_name, width, height, 3*pixels,
+        [&]{ scalar_Y_to_DXY(dxy, dxy+w*h, yuv, w, h); });
+    timer.run("Y_to_DXY", "simd", image_name, width, height, 3*pixels,
+        [&]{ simd_Y_to_DXY(dxy, dxy+w*h, yuv, w, h); });
+    timer.run("DXY_to_MA", "scalar", image_name, width, height, 4*pixels,
+        [&]{ scalar_DXY_to_MA(ma, ma+w*h, dxy, dxy+w*h, w, h); });
+    timer.run("DXY_to_MA", "simd", image_name, width, height, 4*pixels,
+        [&]{ simd_DXY_to_MA(ma, ma+w*h, dxy, dxy+w*h, w, h); });
+    timer.run("MA_to_histo", "scalar", image_name, width, height, 2*pixels + histo_bytes,
+        [&]{ scalar_MA_to_histo(histo, ma, ma+w*h, w, h); });
+    // The cell size 4 rows are the finest levels of a virtually upsampled pyramid.
+    const long histo4_values = ((h+3)/4)*((w+3)/4)*HISTO_BIN_COUNT;
+    std::unique_ptr<float[]> histo4_storage(storage<float>(histo4_values));
+    float* histo4 = aligned(histo4_storage.get());
+    const double histo4_bytes = (double)histo4_values*sizeof(float);
+    timer.run("MA_to_histo_cell4", "scalar", image_name, width, height, 2*pixels + histo4_bytes,
+        [&]{ scalar_MA_to_histo(histo4, ma, ma+w*h, w, h, 4); });
+    if (w%SIMD_VECTOR_SIZE == 0 && w%HISTO_CELL_SIZE == 0)
+    {
+        timer.run("MA_to_histo", "simd", image_name, width, height, 2*pixels + histo_bytes,
+            [&]{ simd_MA_to_histo(histo, ma, ma+w*h, w, h); });
+        timer.run("MA_to_histo_cell4", "simd", image_name, width, height, 2*pixels + histo4_bytes,
+            [&]{ simd_MA_to_histo(histo4, ma, ma+w*h, w, h, 4); });
+    }
+    else
+    {
+        timer.skip("MA_to_histo", "simd", image_name, width, height, "width isn't a multiple of SIMD_VECTOR_SIZE");
+        timer.skip("MA_to_histo_cell4", "simd", image_name, width, height, "width isn't a multiple of SIMD_VECTOR_SIZE");
+    }
+    timer.run("extract_histo", "scalar", image_name, width, height, down_bytes,
+        [&]{ scalar_extract_histo(extract, histo, down_nc, down_nr, 0, 0, cells_nc, cells_nr, cells_nc, cells_nr); });
+    timer.run("extract_histo", "simd", image_name, width, height, down_bytes,
+        [&]{ simd_extract_histo(extract, histo, down_nc, down_nr, 0, 0, cells_nc, cells_nr, cells_nc, cells_nr); });
+
+    // ---------------- dlib histograms and features ----------------
+    histogram_image hist(cells_nr+2, cells_nc+2);
+    timer.run("img_to_histo_dlib", "-", image_name, width, height, pixels + histo_bytes,
+        [&]{ impl_fhog::img_to_histo_dlib(img, hist, cell_size, rows_padding, cols_padding); });
+
+    dlib::array<array2d<float> > hog;
+    impl_fhog::impl_extract_fhog_features_hack2(hist, hog, cells_nr, cells_nc, rows_padding, cols_padding);
+    const double hog_bytes = (double)hog.size()*hog[0].size()*sizeof(float);
+    timer.run("extract_fhog_hack2", "-", image_name, width, height, histo_bytes + hog_bytes,
+        [&]{ impl_fhog::impl_extract_fhog_features_hack2(hist, hog, cells_nr, cells_nc, rows_padding, cols_padding); });
+
+    // ---------------- whole pyramids ----------------
+    fhog_pyramid feats;
+    baseline_pyramid(img, scanner, feats);
+    timer.run("pyramid", "baseline", image_name, width, height, pixels + pyramid_bytes(feats),
+        [&]{ baseline_pyramid(img, scanner, feats); });
+
+    if (cells_nr*cells_nc*HISTO_BIN_COUNT <= HogBackend::histoValueCount)
+    {
+        fhog_pyramid hybrid_feats;
+        auto hybrid = [&]{
+            impl::create_fhog_pyramid<pyramid_down<5> >(img, scanner.get_feature_extractor(), hybrid_feats,
+                cell_size, rows_padding, cols_padding, scanner.get_min_pyramid_layer_width(),
+                scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels(),
+                scanner.get_pyramid_approximation());
+        };
+        hybrid();
+        timer.run("pyramid", "hybrid", image_name, width, height, pixels + pyramid_bytes(hybrid_feats), hybrid);
+
+        // The same pyramid from the YUYV frame in v4l, once copying the luma out first
+        // like capture code feeding an array2d does and once reading it in place.
+        array2d<unsigned char> luma(height, width);
+        const yuyv_luma_image frame(v4l, height, width);
+        timer.run("pyramid", "yuyv-copy", image_name, width, height, 3*pixels + pyramid_bytes(hybrid_feats),
+            [&]{
+                for (long r = 0; r < h; ++r)
+                {
+                    const uint8_t* src = v4l + 2*r*w;
+                    unsigned char* dst = &luma[r][0];
+                    for (long c = 0; c < w; ++c)
+                        dst[c] = src[2*c];
+                }
+                impl::create_fhog_pyramid<pyramid_down<5> >(luma, scanner.get_feature_extractor(), hybrid_feats,
+                    cell_size, rows_padding, cols_padding, scanner.get_min_pyramid_layer_width(),
+                    scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels(),
+                    scanner.get_pyramid_approximation());
+            });
+        timer.run("pyramid", "yuyv-view", image_name, width, height, 2*pixels + pyramid_bytes(hybrid_feats),
+            [&]{
+                impl::create_fhog_pyramid<pyramid_down<5> >(frame, scanner.get_feature_extractor(), hybrid_feats,
+                    cell_size, rows_padding, cols_padding, scanner.get_min_pyramid_layer_width(),
+                    scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels(),
+                    scanner.get_pyramid_approximation());
+            });
+    }
+    else
+    {
+        timer.skip("pyramid", "hybrid", image_name, width, height, "larger than the HogBackend frame");
+        timer.skip("pyramid", "yuyv-copy", image_name, width, height, "larger than the HogBackend frame");
+        timer.skip("pyramid", "yuyv-view", image_name, width, height, "larger than the HogBackend frame");
+    }
+
+    power_law_pyramid power_law;
+    fhog_pyramid power_law_feats;
+    power_law(img, scanner, power_law_feats);
+    timer.run("pyramid", "power-law", image_name, width, height, pixels + pyramid_bytes(power_law_feats),
+        [&]{ power_law(img, scanner, power_law_feats); });
+
+    // ---------------- filtering and non-max suppression ----------------
+    array2d<float> saliency, scratch;
+    timer.run("apply_filters_to_fhog", "dense", image_name, width, height, pyramid_bytes(feats),
+        [&]{
+            for (unsigned long i = 0; i < feats.size(); ++i)
+                apply_dense_filters(fb, feats[i], saliency);
+        });
+    timer.run("apply_filters_to_fhog", "separable", image_name, width, height, pyramid_bytes(feats),
+        [&]{
+            for (unsigned long i = 0; i < feats.size(); ++i)
+                apply_separable_filters(fb, feats[i], saliency, scratch);
+        });
+
+    // The 1000 best windows of the pyramid, whatever their score, so every image size
+    // has the same amount of work for the suppression.
+    std::vector<std::pair<double, rectangle> > windows;
+    impl::detect_from_fhog_pyramid<pyramid_down<5> >(feats, scanner.get_feature_extractor(), fb,
+        -std::numeric_limits<double>::infinity(),
+        scanner.get_fhog_window_height()-2*scanner.get_padding(),
+        scanner.get_fhog_window_width()-2*scanner.get_padding(),
+        cell_size, rows_padding, cols_padding, windows);
+    windows.resize(std::min<size_t>(windows.size(), 1000));
+    std::vector<rect_detection> candidates(windows.size()), dets;
+    for (unsigned long i = 0; i < windows.size(); ++i)
+    {
+        candidates[i].detection_confidence = windows[i].first;
+        candidates[i].weight_index = 0;
+        candidates[i].rect = windows[i].second;
+    }
+    const test_box_overlap tester;
+    timer.run("nms", "1000 boxes", image_name, width, height, 0,
+        [&]{
+            dets.clear();
+            for (unsigned long i = 0; i < candidates.size(); ++i)
+            {
+                if (!impl::overlaps_any_box(tester, dets, candidates[i]))
+                    dets.push_back(candidates[i]);
+            }
+        });
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc > 4)
+        {
+            cout << "Please use :   ./prog [dir_dataset] [json_file] [repetitions]" << endl;
+            cout << endl;
+            cout << "dir_dataset/training.xml supplies the dataset image (synthetic images only if" << endl;
+            cout << "it is missing or \"-\"), results go to json_file (default fhog_bench.json)." << endl;
+            return 0;
+        }
+        const std::string dataset_directory = argc > 1 ? argv[1] : "-";
+        const std::string json_file = argc > 2 ? argv[2] : "fhog_bench.json";
+        const long repetitions = argc > 3 ? std::max(1l, atol(argv[3])) : 20;
+
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40, 60);
+
+        // Use the trained detector if there is one, the filters only change the separable
+        // rank and the number of windows above threshold, not the work per window.
+        fhog_filterbank fb;
+        if (file_exists("robot_detector.svm"))
+        {
+            object_detector<image_scanner_type> detector;
+            deserialize("robot_detector.svm") >> detector;
+            scanner.copy_configuration(detector.get_scanner());
+            fb = scanner.build_fhog_filterbank(detector.get_w());
+        }
+        else
+        {
+            dlib::rand rnd;
+            matrix<double,0,1> w(scanner.get_num_dimensions()+1);
+            for (long i = 0; i < w.size(); ++i)
+                w(i) = rnd.get_random_gaussian();
+            fb = scanner.build_fhog_filterbank(w);
+        }
+        cout << "pyramid strategy: " << scanner.get_pyramid_approximation() << endl;
+        cout << "separable filters: " << fb.num_separable_filters() << " of " << fb.get_filters().size() << " planes" << endl;
+        cout << "repetitions: " << repetitions << " after " << warm_up_runs << " warm up runs" << endl << endl;
+
+        array2d<unsigned char> dataset_image;
+        if (dataset_directory != "-")
+        {
+            image_dataset_metadata::dataset data;
+            image_dataset_metadata::load_image_dataset_metadata(data, dataset_directory+"/training.xml");
+            if (data.images.size() == 0)
+                throw error("No images in " + dataset_directory + "/training.xml");
+            locally_change_current_dir chdir(get_parent_directory(file(dataset_directory+"/training.xml")));
+            load_image(dataset_image, data.images[0].filename);
+        }
+
+        const long sizes[][2] = {{320,240}, {640,480}, {1280,960}, {1920,1080}};
+        std::vector<bench_result> results;
+        stage_timer timer(repetitions, results);
+        for (unsigned long s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+        {
+            array2d<unsigned char> img;
+            make_synthetic_image(img, sizes[s][0], sizes[s][1]);
+            bench_image(img, "synthetic", scanner, fb, timer);
+            if (dataset_image.size() != 0)
+            {
+                img.set_size(sizes[s][1], sizes[s][0]);
+                resize_image(dataset_image, img);
+                bench_image(img, "dataset", scanner, fb, timer);
+            }
+            cout << endl;
+        }
+
+        save_results_json(results, json_file, repetitions);
+        cout << "results written to " << json_file << endl;
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,643 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/image_processing.h>
+#include <dlib/image_transforms.h>
+#include <dlib/data_io.h>
+#include <dlib/rand.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#include "robotDataset.h"
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Measures how far the hack pyramid (makeHist + extract_histo + the hack feature
+// extraction) drifts from dlib's exact extract_fhog_features() pyramid, and checks that
+// the simd kernels compute what their scalar versions compute.
+//
+//    - drift:  for every image both pyramids are built and compared level by level and
+//              plane by plane over the cells both have (the hack levels can be a cell
+//              bigger or smaller).  The max absolute error, the RMS error and the
+//              correlation of every level and plane go to the JSON file.  This is a
+//              report, not a check, since the drift is what the approximation trades
+//              for speed.
+//    - kernel: simd_extract_histo and scalar_extract_histo are run on random histograms
+//              of several sizes, scales and extraction windows, and simd_MA_to_histo
+//              and scalar_MA_to_histo on random gradients with 8 and 4 pixel cells.
+//    - simd:   every hack pyramid is built once with use_simd and once without.
+//    - yuyv:   every image is written as a YUYV frame with varying chroma, read back with
+//              yuyv_frame_file, and its exact and hack pyramids built from the
+//              yuyv_luma_image must match those of the image.
+//
+// The program exits with 1 if a kernel, simd or yuyv comparison differs by more than the
+// tolerance, so it can gate changes to the frameUtils kernels.
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+typedef dlib::array<dlib::array<array2d<float> > > fhog_pyramid;
+
+// Large enough that every level after the first is downsampled from the histograms.
+const unsigned long resample_only = 1000;
+
+class plane_error
+{
+public:
+    plane_error(
+    ) : n(0), sum_a(0), sum_b(0), sum_aa(0), sum_bb(0), sum_ab(0), sum_sq_diff(0), max_abs_diff(0) {}
+
+    void add (
+        double a,
+        double b
+    )
+    {
+        ++n;
+        sum_a += a;
+        sum_b += b;
+        sum_aa += a*a;
+        sum_bb += b*b;
+        sum_ab += a*b;
+        sum_sq_diff += (a-b)*(a-b);
+        max_abs_diff = std::max(max_abs_diff, std::abs(a-b));
+    }
+
+    unsigned long long count (
+    ) const { return n; }
+
+    double max (
+    ) const { return max_abs_diff; }
+
+    double rms (
+    ) const { return n == 0 ? 0 : std::sqrt(sum_sq_diff/n); }
+
+    double correlation (
+    ) const
+    {
+        // Pearson correlation.  Two constant planes count as perfectly correlated if
+        // they are equal.
+        if (n == 0)
+            return 1;
+        const double var_a = sum_aa - sum_a*sum_a/n;
+        const double var_b = sum_bb - sum_b*sum_b/n;
+        if (var_a <= 0 || var_b <= 0)
+            return sum_sq_diff == 0 ? 1 : 0;
+        return (sum_ab - sum_a*sum_b/n)/std::sqrt(var_a*var_b);
+    }
+
+private:
+    unsigned long long n;
+    double sum_a, sum_b, sum_aa, sum_bb, sum_ab;
+    double sum_sq_diff;
+    double max_abs_diff;
+};
+
+struct drift_config
+{
+    std::string name;
+    fhog_pyramid_approximation approx;
+    // errors[level][plane]
+    std::vector<std::vector<plane_error> > errors;
+    std::vector<unsigned long> size_mismatches;
+};
+
+struct simd_check
+{
+    std::string name;
+    std::string image;
+    double max_abs_diff;
+    bool passed;
+};
+
+// ----------------------------------------------------------------------------------------
+
+static void make_synthetic_image (
+    array2d<unsigned char>& img,
+    long width,
+    long height
+)
+{
+    // Smooth blobs plus oriented stripes plus noise, so the gradients cover all the
+    // orientation bins and every cell has something in it.
+    dlib::rand rnd(width*height);
+    img.set_size(height, width);
+    for (long r = 0; r < height; ++r)
+    {
+        for (long c = 0; c < width; ++c)
+        {
+            const double v = 128 + 50*std::sin(0.031*c + 0.017*r) + 30*std::sin(0.11*c - 0.07*r)
+                + 20*std::cos(0.005*c*r/(1.0+r)) + rnd.get_random_gaussian()*10;
+            img[r][c] = (unsigned char)std::max(0.0, std::min(255.0, v));
+        }
+    }
+}
+
+template <typename image_type>
+static void build_pyramid (
+    const image_type& img,
+    const image_scanner_type& scanner,
+    const fhog_pyramid_approximation& approx,
+    fhog_pyramid& feats
+)
+{
+    impl::create_fhog_pyramid<pyramid_down<5> >(img, scanner.get_feature_extractor(), feats,
+        scanner.get_cell_size(), scanner.get_fhog_window_height(), scanner.get_fhog_window_width(),
+        scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+        scanner.get_max_pyramid_levels(), approx);
+}
+
+static bool fits_hog_backend (
+    const array2d<unsigned char>& img,
+    const image_scanner_type& scanner
+)
+{
+    // The hack pyramid keeps its histograms in the fixed size HogBackend buffers.
+    const int cell_size = scanner.get_cell_size();
+    const long cells_nr = (long)((float)img.nr()/(float)cell_size + 0.5);
+    const long cells_nc = (long)((float)img.nc()/(float)cell_size + 0.5);
+    return cells_nr*cells_nc*HISTO_BIN_COUNT <= HogBackend::histoValueCount;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void compare_pyramids (
+    const fhog_pyramid& exact,
+    const fhog_pyramid& approx,
+    drift_config& config
+)
+{
+    const unsigned long levels = std::min(exact.size(), approx.size());
+    if (config.errors.size() < levels)
+    {
+        config.errors.resize(levels);
+        config.size_mismatches.resize(levels, 0);
+    }
+    for (unsigned long l = 0; l < levels; ++l)
+    {
+        const unsigned long planes = std::min(exact[l].size(), approx[l].size());
+        if (config.errors[l].size() < planes)
+            config.errors[l].resize(planes);
+        if (planes == 0)
+            continue;
+        if (exact[l][0].nr() != approx[l][0].nr() || exact[l][0].nc() != approx[l][0].nc())
+            ++config.size_mismatches[l];
+        for (unsigned long p = 0; p < planes; ++p)
+        {
+            const long nr = std::min(exact[l][p].nr(), approx[l][p].nr());
+            const long nc = std::min(exact[l][p].nc(), approx[l][p].nc());
+            for (long r = 0; r < nr; ++r)
+            {
+                for (long c = 0; c < nc; ++c)
+                    config.errors[l][p].add(exact[l][p][r][c], approx[l][p][r][c]);
+            }
+        }
+    }
+}
+
+static double max_abs_difference (
+    const fhog_pyramid& a,
+    const fhog_pyramid& b
+)
+{
+    // Pyramids of different shapes never match.
+    if (a.size() != b.size())
+        return std::numeric_limits<double>::infinity();
+    double result = 0;
+    for (unsigned long l = 0; l < a.size(); ++l)
+    {
+        if (a[l].size() != b[l].size())
+            return std::numeric_limits<double>::infinity();
+        for (unsigned long p = 0; p < a[l].size(); ++p)
+        {
+            if (a[l][p].nr() != b[l][p].nr() || a[l][p].nc() != b[l][p].nc())
+                return std::numeric_limits<double>::infinity();
+            for (long r = 0; r < a[l][p].nr(); ++r)
+            {
+                for (long c = 0; c < a[l][p].nc(); ++c)
+                    result = std::max(result, (double)std::abs(a[l][p][r][c] - b[l][p][r][c]));
+            }
+        }
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void check_extract_histo_kernels (
+    double tolerance,
+    std::vector<simd_check>& checks
+)
+{
+    // {full_width, full_height, extract_x, extract_y, extract_width, extract_height,
+    //  target_width, target_height}, covering the 4/5 pyramid step, odd sizes, identity
+    // and windows that don't start at the origin.
+    const int cases[][8] = {
+        {80, 60, 0, 0, 80, 60, 64, 48},
+        {160, 120, 0, 0, 160, 120, 128, 96},
+        {41, 31, 0, 0, 41, 31, 32, 24},
+        {33, 17, 0, 0, 33, 17, 16, 8},
+        {20, 20, 0, 0, 20, 20, 20, 20},
+        {80, 60, 5, 3, 60, 40, 48, 32},
+        {79, 61, 7, 2, 51, 37, 13, 11}
+    };
+
+    dlib::rand rnd;
+    for (unsigned long i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i)
+    {
+        const int* k = cases[i];
+        const int in_count = k[0]*k[1]*HISTO_BIN_COUNT;
+        const int out_count = k[6]*k[7]*HISTO_BIN_COUNT;
+        std::unique_ptr<float[]> in_storage(storage<float>(in_count));
+        std::unique_ptr<float[]> scalar_storage(storage<float>(out_count));
+        std::unique_ptr<float[]> simd_storage(storage<float>(out_count));
+        float* in = aligned(in_storage.get());
+        float* scalar_out = aligned(scalar_storage.get());
+        float* simd_out = aligned(simd_storage.get());
+        for (int j = 0; j < in_count; ++j)
+            in[j] = 100*rnd.get_random_float();
+
+        scalar_extract_histo(scalar_out, in, k[6], k[7], k[2], k[3], k[4], k[5], k[0], k[1]);
+        simd_extract_histo(simd_out, in, k[6], k[7], k[2], k[3], k[4], k[5], k[0], k[1]);
+
+        // Relative to the largest output value, since the sums grow with the scale.
+        double largest = 0, diff = 0;
+        for (int j = 0; j < out_count; ++j)
+        {
+            largest = std::max(largest, (double)std::abs(scalar_out[j]));
+            diff = std::max(diff, (double)std::abs(scalar_out[j] - simd_out[j]));
+        }
+        if (largest > 0)
+            diff /= largest;
+
+        std::ostringstream name;
+        name << "extract_histo " << k[4] << "x" << k[5] << "+" << k[2] << "+" << k[3]
+             << " of " << k[0] << "x" << k[1] << " -> " << k[6] << "x" << k[7];
+        simd_check check;
+        check.name = name.str();
+        check.image = "random";
+        check.max_abs_diff = diff;
+        check.passed = diff <= tolerance;
+        checks.push_back(check);
+    }
+}
+
+static void check_MA_to_histo_kernels (
+    double tolerance,
+    std::vector<simd_check>& checks
+)
+{
+    // {width, height, cell_size}.  The widths are multiples of SIMD_VECTOR_SIZE as the
+    // simd kernel requires.
+    const int cases[][3] = {
+        {320, 240, 8},
+        {320, 240, 4},
+        {64, 48, 8},
+        {48, 16, 4}
+    };
+
+    dlib::rand rnd;
+    for (unsigned long i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i)
+    {
+        const int* k = cases[i];
+        const int pixels = k[0]*k[1];
+        const int out_count = (k[0]/k[2])*(k[1]/k[2])*HISTO_BIN_COUNT;
+        std::unique_ptr<uint8_t[]> ma_storage(storage(2*pixels));
+        std::unique_ptr<float[]> scalar_storage(storage<float>(out_count));
+        std::unique_ptr<float[]> simd_storage(storage<float>(out_count));
+        uint8_t* ma = aligned(ma_storage.get());
+        float* scalar_out = aligned(scalar_storage.get());
+        float* simd_out = aligned(simd_storage.get());
+        for (int j = 0; j < 2*pixels; ++j)
+            ma[j] = rnd.get_random_8bit_number();
+
+        scalar_MA_to_histo(scalar_out, ma, ma+pixels, k[0], k[1], k[2]);
+        simd_MA_to_histo(simd_out, ma, ma+pixels, k[0], k[1], k[2]);
+
+        double largest = 0, diff = 0;
+        for (int j = 0; j < out_count; ++j)
+        {
+            largest = std::max(largest, (double)std::abs(scalar_out[j]));
+            diff = std::max(diff, (double)std::abs(scalar_out[j] - simd_out[j]));
+        }
+        if (largest > 0)
+            diff /= largest;
+
+        std::ostringstream name;
+        name << "MA_to_histo " << k[0] << "x" << k[1] << " cell " << k[2];
+        simd_check check;
+        check.name = name.str();
+        check.image = "random";
+        check.max_abs_diff = diff;
+        check.passed = diff <= tolerance;
+        checks.push_back(check);
+    }
+}
+
+static void write_yuyv_frame (
+    const array2d<unsigned char>& img,
+    const std::string& filename
+)
+{
+    // Chroma that varies across the frame, so reading it as luma anywhere would show.
+    std::ofstream fout(filename.c_str(), std::ios::binary);
+    for (long r = 0; r < img.nr(); ++r)
+    {
+        for (long c = 0; c < img.nc(); ++c)
+        {
+            fout.put(img[r][c]);
+            fout.put((unsigned char)(7*r + 13*c));
+        }
+    }
+    if (!fout)
+        throw error("Unable to write " + filename);
+}
+
+static void check_yuyv_frame (
+    const array2d<unsigned char>& img,
+    const std::string& image_name,
+    const image_scanner_type& scanner,
+    const std::vector<fhog_pyramid_approximation>& approxes,
+    const std::string& filename,
+    double tolerance,
+    std::vector<simd_check>& checks
+)
+{
+    write_yuyv_frame(img, filename);
+    yuyv_frame_file frames(filename, img.nr(), img.nc());
+    for (unsigned long i = 0; i < approxes.size(); ++i)
+    {
+        fhog_pyramid from_image, from_frame;
+        build_pyramid(img, scanner, approxes[i], from_image);
+        build_pyramid(frames[0], scanner, approxes[i], from_frame);
+
+        simd_check check;
+        check.name = std::string("yuyv ") + (approxes[i].exact ? "exact" : "hack") + " pyramid";
+        check.image = image_name;
+        check.max_abs_diff = max_abs_difference(from_image, from_frame);
+        check.passed = check.max_abs_diff <= tolerance;
+        checks.push_back(check);
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+static std::string json_string (
+    const std::string& s
+)
+{
+    std::ostringstream sout;
+    sout << '"';
+    for (unsigned long i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            sout << '\\' << s[i];
+        else
+            sout << s[i];
+    }
+    sout << '"';
+    return sout.str();
+}
+
+static std::string json_number (
+    double v
+)
+{
+    if (std::isinf(v))
+        return "1e308";
+    return cast_to_string(v);
+}
+
+static void save_report_json (
+    const std::vector<drift_config>& configs,
+    const std::vector<simd_check>& checks,
+    unsigned long num_images,
+    double tolerance,
+    bool passed,
+    const std::string& filename
+)
+{
+    std::ofstream fout(filename.c_str());
+    if (!fout)
+        throw error("Unable to open " + filename + " for writing.");
+
+    fout << setprecision(6);
+    fout << "{\n";
+    fout << "  \"images\": " << num_images << ",\n";
+    fout << "  \"tolerance\": " << tolerance << ",\n";
+    fout << "  \"passed\": " << (passed ? "true" : "false") << ",\n";
+    fout << "  \"drift\": [\n";
+    for (unsigned long i = 0; i < configs.size(); ++i)
+    {
+        const drift_config& config = configs[i];
+        fout << "    {\"name\": " << json_string(config.name) << ", \"approximation\": "
+             << json_string(cast_to_string(config.approx)) << ", \"levels\": [\n";
+        for (unsigned long l = 0; l < config.errors.size(); ++l)
+        {
+            fout << "      {\"level\": " << l << ", \"size_mismatches\": " << config.size_mismatches[l] << ", \"planes\": [";
+            for (unsigned long p = 0; p < config.errors[l].size(); ++p)
+            {
+                const plane_error& e = config.errors[l][p];
+                fout << (p == 0 ? "" : ", ") << "{\"max\": " << e.max() << ", \"rms\": " << e.rms()
+                     << ", \"correlation\": " << e.correlation() << "}";
+            }
+            fout << "]}" << (l+1 < config.errors.size() ? "," : "") << "\n";
+        }
+        fout << "    ]}" << (i+1 < configs.size() ? "," : "") << "\n";
+    }
+    fout << "  ],\n";
+    fout << "  \"simd\": [\n";
+    for (unsigned long i = 0; i < checks.size(); ++i)
+    {
+        fout << "    {\"name\": " << json_string(checks[i].name) << ", \"image\": " << json_string(checks[i].image)
+             << ", \"max_abs_diff\": " << json_number(checks[i].max_abs_diff)
+             << ", \"passed\": " << (checks[i].passed ? "true" : "false") << "}"
+             << (i+1 < checks.size() ? "," : "") << "\n";
+    }
+    fout << "  ]\n}\n";
+}
+
+static void print_drift (
+    const drift_config& config
+)
+{
+    cout << config.name << " (" << config.approx << ") vs exact:" << endl;
+    cout << "  level   worst max     mean rms   worst corr  worst plane  size mismatches" << endl;
+    for (unsigned long l = 0; l < config.errors.size(); ++l)
+    {
+        double worst_max = 0, mean_rms = 0, worst_corr = 1;
+        unsigned long worst_plane = 0;
+        for (unsigned long p = 0; p < config.errors[l].size(); ++p)
+        {
+            const plane_error& e = config.errors[l][p];
+            worst_max = std::max(worst_max, e.max());
+            mean_rms += e.rms();
+            if (e.correlation() < worst_corr)
+            {
+                worst_corr = e.correlation();
+                worst_plane = p;
+            }
+        }
+        if (config.errors[l].size() != 0)
+            mean_rms /= config.errors[l].size();
+        cout << "  " << setw(5) << l << fixed << setprecision(5)
+             << setw(12) << worst_max << setw(12) << mean_rms << setw(13) << worst_corr
+             << setw(13) << worst_plane << setw(17) << config.size_mismatches[l] << endl;
+        cout.unsetf(std::ios::floatfield);
+    }
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc > 5)
+        {
+            cout << "Please use :   ./prog [dir_testing] [json_file] [tolerance] [max_images]" << endl;
+            cout << endl;
+            cout << "Compares the hack fHOG pyramids against the exact ones on synthetic images and" << endl;
+            cout << "the first max_images (default 20) images of dir_testing/testing.xml (none if" << endl;
+            cout << "it is \"-\"), writes the report to json_file (default fhog_equivalence.json)" << endl;
+            cout << "and exits with 1 if a simd kernel differs from its scalar version, or a" << endl;
+            cout << "pyramid built from a YUYV frame from the one of the same image, by more than" << endl;
+            cout << "tolerance (default 1e-4)." << endl;
+            return 0;
+        }
+        const std::string testing_directory = argc > 1 ? argv[1] : "-";
+        const std::string json_file = argc > 2 ? argv[2] : "fhog_equivalence.json";
+        const double tolerance = argc > 3 ? atof(argv[3]) : 1e-4;
+        const unsigned long max_images = argc > 4 ? atol(argv[4]) : 20;
+
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40, 60);
+        if (file_exists("robot_detector.svm"))
+        {
+            object_detector<image_scanner_type> detector;
+            deserialize("robot_detector.svm") >> detector;
+            scanner.copy_configuration(detector.get_scanner());
+        }
+
+        std::vector<array2d<unsigned char> > images;
+        std::vector<std::string> image_names;
+        const long sizes[][2] = {{320,240}, {640,480}, {1280,960}};
+        for (unsigned long s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+        {
+            images.push_back(array2d<unsigned char>());
+            make_synthetic_image(images.back(), sizes[s][0], sizes[s][1]);
+            image_names.push_back("synthetic " + cast_to_string(sizes[s][0]) + "x" + cast_to_string(sizes[s][1]));
+        }
+        if (testing_directory != "-")
+        {
+            dlib::array<array2d<unsigned char> > images_test;
+            std::vector<std::vector<rectangle> > boxes_test;
+            load_robot_dataset(images_test, boxes_test, testing_directory+"/testing.xml",
+                "robot_testing.cache", std::max(1u, std::thread::hardware_concurrency()));
+            for (unsigned long i = 0; i < images_test.size() && i < max_images; ++i)
+            {
+                images.push_back(array2d<unsigned char>());
+                swap(images.back(), images_test[i]);
+                image_names.push_back("testing " + cast_to_string(i));
+            }
+        }
+
+        std::vector<drift_config> configs(3);
+        configs[0].name = "configured";
+        configs[0].approx = scanner.get_pyramid_approximation();
+        configs[0].approx.exact = false;
+        configs[1].name = "direct resample only";
+        configs[1].approx.downsample = FHOG_DOWNSAMPLE_DIRECT;
+        configs[1].approx.hybrid_level = resample_only;
+        configs[1].approx.exact_every = resample_only;
+        configs[2].name = "progressive resample only";
+        configs[2].approx.downsample = FHOG_DOWNSAMPLE_PROGRESSIVE;
+        configs[2].approx.hybrid_level = resample_only;
+        configs[2].approx.exact_every = resample_only;
+
+        std::vector<simd_check> checks;
+        check_extract_histo_kernels(tolerance, checks);
+        check_MA_to_histo_kernels(tolerance, checks);
+
+        fhog_pyramid_approximation exact_approx;
+        exact_approx.exact = true;
+        std::vector<fhog_pyramid_approximation> yuyv_approxes;
+        yuyv_approxes.push_back(exact_approx);
+        yuyv_approxes.push_back(configs[0].approx);
+        const std::string yuyv_file = json_file + ".yuyv";
+        unsigned long num_images = 0;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            if (!fits_hog_backend(images[i], scanner))
+            {
+                cout << "skipping " << image_names[i] << ", larger than the HogBackend frame" << endl;
+                continue;
+            }
+            ++num_images;
+
+            fhog_pyramid exact, scalar, simd;
+            build_pyramid(images[i], scanner, exact_approx, exact);
+            for (unsigned long j = 0; j < configs.size(); ++j)
+            {
+                fhog_pyramid_approximation approx = configs[j].approx;
+                approx.use_simd = false;
+                build_pyramid(images[i], scanner, approx, scalar);
+                approx.use_simd = true;
+                build_pyramid(images[i], scanner, approx, simd);
+
+                compare_pyramids(exact, configs[j].approx.use_simd ? simd : scalar, configs[j]);
+
+                simd_check check;
+                check.name = "pyramid " + configs[j].name;
+                check.image = image_names[i];
+                check.max_abs_diff = max_abs_difference(scalar, simd);
+                check.passed = check.max_abs_diff <= tolerance;
+                checks.push_back(check);
+            }
+
+            if (images[i].nc()%2 == 0)
+                check_yuyv_frame(images[i], image_names[i], scanner, yuyv_approxes, yuyv_file, tolerance, checks);
+        }
+        std::remove(yuyv_file.c_str());
+        cout << "images: " << num_images << endl << endl;
+
+        for (unsigned long j = 0; j < configs.size(); ++j)
+            print_drift(configs[j]);
+
+        bool passed = true;
+        for (unsigned long i = 0; i < checks.size(); ++i)
+        {
+            if (!checks[i].passed)
+            {
+                passed = false;
+                cout << "FAILED: " << checks[i].name << " on " << checks[i].image << ": the two versions differ by "
+                     << checks[i].max_abs_diff << " (tolerance " << tolerance << ")" << endl;
+            }
+        }
+        cout << checks.size() << " simd and yuyv checks " << (passed ? "passed" : "did NOT pass") << endl;
+
+        save_report_json(configs, checks, num_images, tolerance, passed, json_file);
+        cout << "results written to " << json_file << endl;
+        return passed ? 0 : 1;
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
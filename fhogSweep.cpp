@@ -0,0 +1,299 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/svm_threaded.h>
+#include <dlib/image_processing.h>
+#include <dlib/data_io.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#include "robotDataset.h"
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Runs a trained detector over the testing set once for every combination of pyramid
+// approximation settings (exact or hack, Direct or Progressive downsampling, SIMD on or
+// off, hybrid level, exact level period) and pyramid scale ratio, and records the average
+// precision and the per frame latency of each.  Every point goes to a CSV and a JSON file
+// along with the Pareto frontier, the points no other point beats on both AP and latency.
+// That is the list to pick a robot's settings from: the fastest point whose AP is good
+// enough on the CPU it runs on.
+//
+// The detector is always run on one thread so the latency is what a single camera stream
+// sees.  The weights are reused as they are for the other scale ratios, only the pyramid
+// around them changes, while the virtual upsampling and power law exponents of the
+// detector are kept.  Settings that turn out best can be stored in the detector with
+// scan_fhog_pyramid::set_pyramid_approximation().
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+
+const unsigned long sweep_hybrid_levels[] = {2, 3, 4, 5, 7, 10};
+// 1000 means no level below hybrid_level is extracted from a resized image.
+const unsigned long sweep_exact_every[] = {2, 3, 1000};
+
+struct sweep_point
+{
+    std::string pyramid;
+    fhog_pyramid_approximation approx;
+    matrix<double,1,3> accuracy;
+    double latency_p50;
+    double latency_mean;
+    double latency_p95;
+    bool pareto;
+};
+
+// ----------------------------------------------------------------------------------------
+
+template <unsigned int N>
+void sweep_pyramid (
+    const object_detector<image_scanner_type>& trained,
+    const dlib::array<array2d<unsigned char> >& images,
+    const std::vector<std::vector<rectangle> >& boxes,
+    std::vector<sweep_point>& points
+)
+{
+    typedef scan_fhog_pyramid<pyramid_down<N> > scanner_type;
+    const image_scanner_type& trained_scanner = trained.get_scanner();
+    scanner_type scanner;
+    scanner.set_detection_window_size(trained_scanner.get_detection_window_width(), trained_scanner.get_detection_window_height());
+    scanner.set_padding(trained_scanner.get_padding());
+    scanner.set_cell_size(trained_scanner.get_cell_size());
+    scanner.set_max_pyramid_levels(trained_scanner.get_max_pyramid_levels());
+    scanner.set_min_pyramid_layer_size(trained_scanner.get_min_pyramid_layer_width(), trained_scanner.get_min_pyramid_layer_height());
+    scanner.set_virtual_upsampling(trained_scanner.get_virtual_upsampling_max_width(), trained_scanner.get_virtual_upsampling_max_height());
+
+    std::vector<matrix<double,0,1> > w;
+    for (unsigned long i = 0; i < trained.num_detectors(); ++i)
+        w.push_back(trained.get_w(i));
+
+    // The power law exponents the detector was calibrated with are kept for every
+    // point, only the settings swept below change.
+    std::vector<fhog_pyramid_approximation> settings;
+    fhog_pyramid_approximation approx;
+    approx.power_law_lambda = trained_scanner.get_pyramid_approximation().power_law_lambda;
+    approx.exact = true;
+    settings.push_back(approx);
+    approx.exact = false;
+    for (int downsample = 0; downsample < 2; ++downsample)
+    {
+        approx.downsample = downsample == 0 ? FHOG_DOWNSAMPLE_DIRECT : FHOG_DOWNSAMPLE_PROGRESSIVE;
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            approx.use_simd = simd == 1;
+            for (unsigned long h = 0; h < sizeof(sweep_hybrid_levels)/sizeof(sweep_hybrid_levels[0]); ++h)
+            {
+                approx.hybrid_level = sweep_hybrid_levels[h];
+                for (unsigned long e = 0; e < sizeof(sweep_exact_every)/sizeof(sweep_exact_every[0]); ++e)
+                {
+                    approx.exact_every = sweep_exact_every[e];
+                    settings.push_back(approx);
+                }
+            }
+        }
+    }
+
+    std::ostringstream name;
+    name << "pyramid_down<" << N << ">";
+    for (unsigned long i = 0; i < settings.size(); ++i)
+    {
+        scanner.set_pyramid_approximation(settings[i]);
+        const object_detector<scanner_type> detector(scanner, trained.get_overlap_tester(), w);
+        const object_detection_evaluation eval = evaluate_object_detection_function(detector, images, boxes, 1);
+
+        sweep_point p;
+        p.pyramid = name.str();
+        p.approx = settings[i];
+        p.accuracy = eval.accuracy;
+        p.latency_p50 = eval.latency_p50;
+        p.latency_mean = eval.latency_mean;
+        p.latency_p95 = eval.latency_p95;
+        p.pareto = false;
+        points.push_back(p);
+
+        cout << setw(18) << left << p.pyramid << setw(86) << cast_to_string(p.approx) << right
+             << " AP " << fixed << setprecision(4) << p.accuracy(2)
+             << "  p50 " << setprecision(2) << 1000*p.latency_p50 << "ms" << endl;
+        cout.unsetf(std::ios::floatfield);
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void mark_pareto_frontier (
+    std::vector<sweep_point>& points
+)
+{
+    // Walk the points from fastest to slowest and keep each one that is more accurate
+    // than everything faster than it.
+    std::vector<unsigned long> order(points.size());
+    for (unsigned long i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](unsigned long a, unsigned long b) {
+        if (points[a].latency_p50 != points[b].latency_p50)
+            return points[a].latency_p50 < points[b].latency_p50;
+        return points[a].accuracy(2) > points[b].accuracy(2);
+    });
+
+    double best_ap = -1;
+    for (unsigned long i = 0; i < order.size(); ++i)
+    {
+        sweep_point& p = points[order[i]];
+        if (p.accuracy(2) > best_ap)
+        {
+            p.pareto = true;
+            best_ap = p.accuracy(2);
+        }
+    }
+}
+
+static std::string json_string (
+    const std::string& s
+)
+{
+    std::ostringstream sout;
+    sout << '"';
+    for (unsigned long i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            sout << '\\' << s[i];
+        else
+            sout << s[i];
+    }
+    sout << '"';
+    return sout.str();
+}
+
+static void save_points (
+    const std::vector<sweep_point>& points,
+    const std::string& prefix,
+    const std::string& detector_file,
+    unsigned long num_images
+)
+{
+    std::ofstream csv((prefix + ".csv").c_str());
+    std::ofstream json((prefix + ".json").c_str());
+    if (!csv || !json)
+        throw error("Unable to open " + prefix + ".csv and " + prefix + ".json for writing.");
+
+    csv << "pyramid,exact,downsample,simd,hybrid_level,exact_every,power_law_lambda,precision,recall,average_precision,"
+        << "latency_p50_ms,latency_mean_ms,latency_p95_ms,pareto\n";
+    json << "{\n";
+    json << "  \"detector\": " << json_string(detector_file) << ",\n";
+    json << "  \"images\": " << num_images << ",\n";
+    json << "  \"points\": [\n";
+    csv << setprecision(6);
+    json << setprecision(6);
+    for (unsigned long i = 0; i < points.size(); ++i)
+    {
+        const sweep_point& p = points[i];
+        const std::string downsample = fhog_downsample_mode_name(p.approx.downsample);
+        // The power law exponents, one per plane, space separated in the CSV.
+        std::ostringstream lambda_csv, lambda_json;
+        lambda_csv << setprecision(6);
+        lambda_json << setprecision(6) << "[";
+        for (unsigned long j = 0; j < p.approx.power_law_lambda.size(); ++j)
+        {
+            lambda_csv << (j == 0 ? "" : " ") << p.approx.power_law_lambda[j];
+            lambda_json << (j == 0 ? "" : ", ") << p.approx.power_law_lambda[j];
+        }
+        lambda_json << "]";
+        csv << p.pyramid << "," << p.approx.exact << "," << downsample << "," << p.approx.use_simd << ","
+            << p.approx.hybrid_level << "," << p.approx.exact_every << "," << lambda_csv.str() << ","
+            << p.accuracy(0) << "," << p.accuracy(1) << "," << p.accuracy(2) << ","
+            << 1000*p.latency_p50 << "," << 1000*p.latency_mean << "," << 1000*p.latency_p95 << ","
+            << p.pareto << "\n";
+        json << "    {\"pyramid\": " << json_string(p.pyramid) << ", \"exact\": " << (p.approx.exact ? "true" : "false")
+             << ", \"downsample\": " << json_string(downsample) << ", \"simd\": " << (p.approx.use_simd ? "true" : "false")
+             << ", \"hybrid_level\": " << p.approx.hybrid_level << ", \"exact_every\": " << p.approx.exact_every
+             << ", \"power_law_lambda\": " << lambda_json.str()
+             << ", \"precision\": " << p.accuracy(0) << ", \"recall\": " << p.accuracy(1)
+             << ", \"average_precision\": " << p.accuracy(2)
+             << ", \"latency_p50_ms\": " << 1000*p.latency_p50 << ", \"latency_mean_ms\": " << 1000*p.latency_mean
+             << ", \"latency_p95_ms\": " << 1000*p.latency_p95
+             << ", \"pareto\": " << (p.pareto ? "true" : "false") << "}"
+             << (i+1 < points.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 2 || argc > 5)
+        {
+            cout << "Please use :   ./prog dir_testing [detector_file] [output_prefix] [max_images]" << endl;
+            cout << endl;
+            cout << "Sweeps the pyramid approximation settings of detector_file (default" << endl;
+            cout << "robot_detector.svm) over dir_testing/testing.xml and writes every point and" << endl;
+            cout << "the Pareto frontier to output_prefix.csv and .json (default fhog_sweep)." << endl;
+            return 0;
+        }
+        const std::string robots_directory_testing = argv[1];
+        const std::string detector_file = argc > 2 ? argv[2] : "robot_detector.svm";
+        const std::string prefix = argc > 3 ? argv[3] : "fhog_sweep";
+        const unsigned long max_images = argc > 4 ? atol(argv[4]) : 0;
+
+        dlib::array<array2d<unsigned char> > images_test;
+        std::vector<std::vector<rectangle> > robot_boxes_test;
+        load_robot_dataset(images_test, robot_boxes_test, robots_directory_testing+"/testing.xml",
+            "robot_testing.cache", std::max(1u, std::thread::hardware_concurrency()));
+        if (max_images != 0 && max_images < images_test.size())
+        {
+            images_test.resize(max_images);
+            robot_boxes_test.resize(max_images);
+        }
+
+        object_detector<image_scanner_type> detector;
+        deserialize(detector_file) >> detector;
+        cout << "detector: " << detector_file << " (" << detector.get_scanner().get_pyramid_approximation() << ")" << endl;
+        cout << "testing images: " << images_test.size() << endl << endl;
+
+        std::vector<sweep_point> points;
+        sweep_pyramid<4>(detector, images_test, robot_boxes_test, points);
+        sweep_pyramid<5>(detector, images_test, robot_boxes_test, points);
+        sweep_pyramid<6>(detector, images_test, robot_boxes_test, points);
+
+        mark_pareto_frontier(points);
+        save_points(points, prefix, detector_file, images_test.size());
+
+        std::vector<sweep_point> frontier;
+        for (unsigned long i = 0; i < points.size(); ++i)
+        {
+            if (points[i].pareto)
+                frontier.push_back(points[i]);
+        }
+        std::sort(frontier.begin(), frontier.end(), [](const sweep_point& a, const sweep_point& b) {
+            return a.latency_p50 < b.latency_p50;
+        });
+        cout << endl << "Pareto frontier, fastest first:" << endl;
+        for (unsigned long i = 0; i < frontier.size(); ++i)
+        {
+            cout << setw(18) << left << frontier[i].pyramid << setw(86) << cast_to_string(frontier[i].approx) << right
+                 << " AP " << fixed << setprecision(4) << frontier[i].accuracy(2)
+                 << "  p50 " << setprecision(2) << 1000*frontier[i].latency_p50 << "ms" << endl;
+            cout.unsetf(std::ios::floatfield);
+        }
+        cout << endl << "results written to " << prefix << ".csv and " << prefix << ".json" << endl;
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
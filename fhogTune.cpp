@@ -0,0 +1,345 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/svm_threaded.h>
+#include <dlib/image_processing.h>
+#include <dlib/data_io.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#include "robotDataset.h"
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Tunes the per level schedule of the fHOG pyramid (see fhog_level_plan in
+// scan_fhog_pyramid_abstract.h) of a trained detector for the CPU it runs on.  Every level
+// after the first is either recomputed from a resized image, resampled from the histograms
+// of an earlier level or skipped, and the goal is the most accurate schedule whose 95th
+// percentile frame time on a validation set is within the target.
+//
+// The search starts from recomputing every level and greedily makes one level cheaper at a
+// time, always taking the change that loses the least AP per millisecond saved, until the
+// target is met.  Then it tries to make each level more accurate again as long as the
+// target still holds, and finally keeps use_simd on if it is faster here.  Every candidate
+// is measured for real, AP and latency, on one thread.  The tuned schedule is saved in the
+// scanner of the output detector, so a robot loading that file gets it.
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+
+struct tune_point
+{
+    fhog_pyramid_approximation approx;
+    double average_precision;
+    double latency;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class schedule_tuner
+{
+public:
+    schedule_tuner (
+        const object_detector<image_scanner_type>& trained_,
+        const dlib::array<array2d<unsigned char> >& images_,
+        const std::vector<std::vector<rectangle> >& boxes_
+    ) : trained(trained_), images(images_), boxes(boxes_), num_measurements(0)
+    {
+        for (unsigned long i = 0; i < trained.num_detectors(); ++i)
+            w.push_back(trained.get_w(i));
+    }
+
+    tune_point measure (
+        const fhog_pyramid_approximation& approx
+    )
+    {
+        image_scanner_type scanner;
+        scanner.copy_configuration(trained.get_scanner());
+        scanner.set_pyramid_approximation(approx);
+        object_detector<image_scanner_type> detector(scanner, trained.get_overlap_tester(), w);
+        // Once untimed, so the buffers the pyramid allocates on first use aren't counted.
+        if (images.size() != 0)
+            detector(images[0]);
+        const object_detection_evaluation eval = evaluate_object_detection_function(detector, images, boxes, 1);
+        ++num_measurements;
+
+        tune_point p;
+        p.approx = approx;
+        p.average_precision = eval.accuracy(2);
+        p.latency = eval.latency_p95;
+        return p;
+    }
+
+    unsigned long get_num_measurements (
+    ) const { return num_measurements; }
+
+    object_detector<image_scanner_type> make_detector (
+        const fhog_pyramid_approximation& approx
+    ) const
+    {
+        image_scanner_type scanner;
+        scanner.copy_configuration(trained.get_scanner());
+        scanner.set_pyramid_approximation(approx);
+        return object_detector<image_scanner_type>(scanner, trained.get_overlap_tester(), w);
+    }
+
+private:
+    const object_detector<image_scanner_type>& trained;
+    const dlib::array<array2d<unsigned char> >& images;
+    const std::vector<std::vector<rectangle> >& boxes;
+    std::vector<matrix<double,0,1> > w;
+    unsigned long num_measurements;
+};
+
+// ----------------------------------------------------------------------------------------
+
+static unsigned long num_pyramid_levels (
+    const image_scanner_type& scanner,
+    const dlib::array<array2d<unsigned char> >& images
+)
+{
+    // The most levels create_fhog_pyramid() builds for any of the images, counted from
+    // the virtually upsampled size of those the scanner upsamples.
+    unsigned long most = 1;
+    pyramid_down<5> pyr;
+    for (unsigned long i = 0; i < images.size(); ++i)
+    {
+        unsigned long levels = 0;
+        const long upsample = scanner.get_virtual_upsampling_factor(images[i]);
+        rectangle rect(0, 0, images[i].nc()*upsample-1, images[i].nr()*upsample-1);
+        do
+        {
+            rect = pyr.rect_down(rect);
+            ++levels;
+        } while (rect.width() >= scanner.get_min_pyramid_layer_width() && rect.height() >= scanner.get_min_pyramid_layer_height() &&
+            levels < scanner.get_max_pyramid_levels());
+        most = std::max(most, levels);
+    }
+    return most;
+}
+
+static bool is_resampled_from (
+    const std::vector<fhog_level_plan>& schedule,
+    unsigned long level
+)
+{
+    for (unsigned long j = level+1; j < schedule.size(); ++j)
+    {
+        if (schedule[j].source == FHOG_LEVEL_RESAMPLE && schedule[j].from == level)
+            return true;
+    }
+    return false;
+}
+
+static unsigned long nearest_computed_level (
+    const std::vector<fhog_level_plan>& schedule,
+    unsigned long level,
+    bool recomputed_only
+)
+{
+    // Level 0 is always recomputed, so this always finds one.
+    unsigned long k = level-1;
+    while (k > 0 && (schedule[k].source == FHOG_LEVEL_SKIP ||
+        (recomputed_only && schedule[k].source != FHOG_LEVEL_RECOMPUTE)))
+        --k;
+    return k;
+}
+
+static std::vector<std::vector<fhog_level_plan> > cheaper_schedules (
+    const std::vector<fhog_level_plan>& schedule
+)
+{
+    // One level made cheaper: recomputed -> resampled from the level before it or from
+    // the last recomputed level, anything -> skipped unless a later level resamples it.
+    std::vector<std::vector<fhog_level_plan> > result;
+    for (unsigned long i = 1; i < schedule.size(); ++i)
+    {
+        std::vector<fhog_level_plan> s = schedule;
+        if (schedule[i].source == FHOG_LEVEL_RECOMPUTE)
+        {
+            const unsigned long previous = nearest_computed_level(schedule, i, false);
+            const unsigned long recomputed = nearest_computed_level(schedule, i, true);
+            s[i] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, previous);
+            result.push_back(s);
+            if (recomputed != previous)
+            {
+                s[i] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, recomputed);
+                result.push_back(s);
+            }
+        }
+        if (schedule[i].source != FHOG_LEVEL_SKIP && !is_resampled_from(schedule, i))
+        {
+            s[i] = fhog_level_plan(FHOG_LEVEL_SKIP);
+            result.push_back(s);
+        }
+    }
+    return result;
+}
+
+static std::vector<std::vector<fhog_level_plan> > better_schedules (
+    const std::vector<fhog_level_plan>& schedule,
+    unsigned long i
+)
+{
+    // Level i made more accurate: skipped -> resampled from the level before it,
+    // anything -> recomputed.
+    std::vector<std::vector<fhog_level_plan> > result;
+    std::vector<fhog_level_plan> s = schedule;
+    if (schedule[i].source == FHOG_LEVEL_SKIP)
+    {
+        s[i] = fhog_level_plan(FHOG_LEVEL_RESAMPLE, nearest_computed_level(schedule, i, false));
+        result.push_back(s);
+    }
+    if (schedule[i].source != FHOG_LEVEL_RECOMPUTE)
+    {
+        s[i] = fhog_level_plan(FHOG_LEVEL_RECOMPUTE);
+        result.push_back(s);
+    }
+    return result;
+}
+
+static void print_point (
+    const std::string& what,
+    const tune_point& p
+)
+{
+    cout << setw(10) << left << what << right << " AP " << fixed << setprecision(4) << p.average_precision
+         << "  p95 " << setprecision(2) << 1000*p.latency << "ms  " << p.approx << endl;
+    cout.unsetf(std::ios::floatfield);
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 3 || argc > 6)
+        {
+            cout << "Please use :   ./prog validation.xml target_ms [detector_file] [output_file] [max_images]" << endl;
+            cout << endl;
+            cout << "Finds the most accurate per level pyramid schedule for detector_file (default" << endl;
+            cout << "robot_detector.svm) whose 95th percentile frame time on validation.xml is at" << endl;
+            cout << "most target_ms on this machine, and saves the detector with that schedule to" << endl;
+            cout << "output_file (default robot_detector_tuned.svm).  Exits with 1 if the target" << endl;
+            cout << "can't be met, after saving the fastest schedule found." << endl;
+            return 0;
+        }
+        const std::string validation_file = argv[1];
+        const double budget = atof(argv[2])/1000;
+        const std::string detector_file = argc > 3 ? argv[3] : "robot_detector.svm";
+        const std::string output_file = argc > 4 ? argv[4] : "robot_detector_tuned.svm";
+        const unsigned long max_images = argc > 5 ? atol(argv[5]) : 0;
+
+        dlib::array<array2d<unsigned char> > images;
+        std::vector<std::vector<rectangle> > boxes;
+        load_robot_dataset(images, boxes, validation_file, "", std::max(1u, std::thread::hardware_concurrency()));
+        if (max_images != 0 && max_images < images.size())
+        {
+            images.resize(max_images);
+            boxes.resize(max_images);
+        }
+
+        object_detector<image_scanner_type> trained;
+        deserialize(detector_file) >> trained;
+        const unsigned long levels = num_pyramid_levels(trained.get_scanner(), images);
+        cout << "detector: " << detector_file << " (" << trained.get_scanner().get_pyramid_approximation() << ")" << endl;
+        cout << "validation images: " << images.size() << ", pyramid levels: " << levels << endl;
+        cout << "target: p95 frame time <= " << 1000*budget << "ms" << endl << endl;
+
+        schedule_tuner tuner(trained, images, boxes);
+        print_point("configured", tuner.measure(trained.get_scanner().get_pyramid_approximation()));
+
+        fhog_pyramid_approximation approx;
+        approx.use_simd = trained.get_scanner().get_pyramid_approximation().use_simd;
+        approx.power_law_lambda = trained.get_scanner().get_pyramid_approximation().power_law_lambda;
+        approx.schedule.assign(levels, fhog_level_plan());
+        tune_point current = tuner.measure(approx);
+        print_point("start", current);
+
+        // Make levels cheaper until the target is met.
+        while (current.latency > budget)
+        {
+            const std::vector<std::vector<fhog_level_plan> > candidates = cheaper_schedules(current.approx.schedule);
+            bool found = false;
+            tune_point best;
+            double best_cost = 0;
+            for (unsigned long i = 0; i < candidates.size(); ++i)
+            {
+                fhog_pyramid_approximation a = current.approx;
+                a.schedule = candidates[i];
+                const tune_point p = tuner.measure(a);
+                if (p.latency >= current.latency)
+                    continue;
+                const double cost = (current.average_precision - p.average_precision)/(current.latency - p.latency);
+                if (!found || cost < best_cost)
+                {
+                    found = true;
+                    best = p;
+                    best_cost = cost;
+                }
+            }
+            if (!found)
+                break;
+            current = best;
+            print_point("cheaper", current);
+        }
+
+        // Buy back accuracy with whatever time is left.
+        if (current.latency <= budget)
+        {
+            for (unsigned long i = 1; i < levels; ++i)
+            {
+                const std::vector<std::vector<fhog_level_plan> > candidates = better_schedules(current.approx.schedule, i);
+                for (unsigned long j = 0; j < candidates.size(); ++j)
+                {
+                    fhog_pyramid_approximation a = current.approx;
+                    a.schedule = candidates[j];
+                    const tune_point p = tuner.measure(a);
+                    if (p.latency <= budget && p.average_precision > current.average_precision)
+                    {
+                        current = p;
+                        print_point("better", current);
+                    }
+                }
+            }
+        }
+
+        // The simd kernels compute the same histograms, so only the time can differ.
+        fhog_pyramid_approximation flipped = current.approx;
+        flipped.use_simd = !flipped.use_simd;
+        const tune_point other = tuner.measure(flipped);
+        if (other.latency < current.latency)
+        {
+            current = other;
+            print_point("simd", current);
+        }
+
+        serialize(output_file) << tuner.make_detector(current.approx);
+        cout << endl;
+        print_point("tuned", current);
+        cout << "schedule: " << fhog_schedule_string(current.approx.schedule)
+             << "  (x: recomputed, k: resampled from level k, -: skipped)" << endl;
+        cout << tuner.get_num_measurements() << " measurements, detector written to " << output_file << endl;
+        if (current.latency > budget)
+        {
+            cout << "the target of " << 1000*budget << "ms was NOT met, the fastest schedule found was saved" << endl;
+            return 1;
+        }
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -19,14 +19,24 @@
   type * __restrict__ var=         \
   (type *)__builtin_assume_aligned(addr,FRAME_ALIGNMENT)
 
-inline
-void
-enterSimd()
+class SimdRounding
 {
-// adjust rounding mode in order to minimise differences
-// with scalar code while converting from v4sf to v4si
-_MM_SET_ROUNDING_MODE(_MM_ROUND_TOWARD_ZERO);
-}
+public:
+
+  // adjust rounding mode in order to minimise differences
+  // with scalar code while converting from v4sf to v4si,
+  // and put the caller's mode back on exit since MXCSR is
+  // per thread and every later float operation depends on it
+  SimdRounding()
+  : m_mode(_MM_GET_ROUNDING_MODE())
+  { _MM_SET_ROUNDING_MODE(_MM_ROUND_TOWARD_ZERO); }
+
+  ~SimdRounding()
+  { _MM_SET_ROUNDING_MODE(m_mode); }
+
+private:
+  unsigned int m_mode;
+};
 
 //----------------------------------------------------------------------------
 
@@ -84,7 +94,7 @@ simd_V4L_to_YUV(uint8_t *y_out_aligned,
                 int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstY, y_out_aligned );
 ALIGNED_PTR( v16qu, dstU, u_out_aligned );
 ALIGNED_PTR( v16qu, dstV, v_out_aligned );
@@ -201,7 +211,7 @@ simd_Y_to_DX(uint8_t *dx_out_aligned,
              int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 const v16qu offset=make_v16qu(128);
 ALIGNED_PTR( v16qu, dst, dx_out_aligned );
 ALIGNED_PTR( const v16qu, src, y_in_aligned );
@@ -229,7 +239,7 @@ simd_Y_to_DY(uint8_t *dy_out_aligned,
              int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 const v16qu offset=make_v16qu(128);
 ALIGNED_PTR( v16qu, dst, dy_out_aligned );
 ALIGNED_PTR( const v16qu, src0, y_in_aligned );
@@ -303,7 +313,7 @@ simd_DXY_to_MA(uint8_t *m_out_aligned,
                int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 const v16qu offset=make_v16qu(128);
 const v8hi cOne=make_v8hi(1);
 const v8hi c256=make_v8hi(256);
@@ -355,21 +365,22 @@ scalar_MA_to_histo(float *histo_out_aligned,
                    const uint8_t *m_in_aligned,
                    const uint8_t *a_in_aligned,
                    int width,
-                   int height)
+                   int height,
+                   int cell_size)
 {
 ALIGNED_PTR( float, dstHisto, histo_out_aligned );
 ALIGNED_PTR( const uint8_t, srcM0, m_in_aligned );
 ALIGNED_PTR( const uint8_t, srcA0, a_in_aligned );
-for(int yId=0;yId<height;yId+=HISTO_CELL_SIZE)
+for(int yId=0;yId<height;yId+=cell_size)
   {
-  for(int xId=0;xId<width;xId+=HISTO_CELL_SIZE)
+  for(int xId=0;xId<width;xId+=cell_size)
     {
     ALIGNED_PTR( const uint8_t, srcM1, srcM0 );
     ALIGNED_PTR( const uint8_t, srcA1, srcA0 );
     float histo[HISTO_BIN_COUNT]={0.0f};
-    for(int yi=0;yi<HISTO_CELL_SIZE;++yi)
+    for(int yi=0;yi<cell_size;++yi)
       {
-      for(int xi=0;xi<HISTO_CELL_SIZE;++xi)
+      for(int xi=0;xi<cell_size;++xi)
         {
         const int id=xId+xi;
         const int m=srcM1[id];
@@ -394,8 +405,8 @@ for(int yId=0;yId<height;yId+=HISTO_CELL_SIZE)
       { dstHisto[i]=histo[i]; }
     dstHisto+=HISTO_BIN_COUNT;
     }
-  srcM0+=width*HISTO_CELL_SIZE;
-  srcA0+=width*HISTO_CELL_SIZE;
+  srcM0+=width*cell_size;
+  srcA0+=width*cell_size;
   }
 }
 
@@ -404,28 +415,33 @@ simd_MA_to_histo(float *histo_out_aligned,
                  const uint8_t *m_in_aligned,
                  const uint8_t *a_in_aligned,
                  int width,
-                 int height)
+                 int height,
+                 int cell_size)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-assert(SIMD_VECTOR_SIZE==2*HISTO_BIN_COUNT);
-assert(SIMD_VECTOR_SIZE==2*HISTO_CELL_SIZE);
-enterSimd();
-ALIGNED_PTR( v4sf, dstHisto, histo_out_aligned );
+assert(width%cell_size==0);
+const SimdRounding simdRounding;
+ALIGNED_PTR( float, dstHisto, histo_out_aligned );
 ALIGNED_PTR( const v16qu, srcM0, m_in_aligned );
 ALIGNED_PTR( const v16qu, srcA0, a_in_aligned );
 const int vWidth=width/SIMD_VECTOR_SIZE;
-for(int yId=0;yId<height;yId+=HISTO_CELL_SIZE)
+const int rowValueCount=(width/cell_size)*HISTO_BIN_COUNT;
+const v4sf div=make_v4sf(float(HISTO_BIN_WIDTH_MASK));
+const v4sf top=make_v4sf(float(HISTO_BIN_WIDTH+HISTO_BIN_WIDTH_MASK)/
+                         float(HISTO_BIN_WIDTH_MASK));
+for(int yId=0;yId<height;yId+=cell_size)
   {
-  for(int xId=0;xId<vWidth;++xId)
+  // a row of cells is accumulated in place, pixel after pixel in the
+  // same order as the scalar version, so any cell size works
+  for(int i=0;i<rowValueCount;++i)
+    { dstHisto[i]=0.0f; }
+  for(int yi=0;yi<cell_size;++yi)
     {
-    ALIGNED_PTR( const v16qu, srcM1, srcM0 );
-    ALIGNED_PTR( const v16qu, srcA1, srcA0 );
-    __attribute__((__aligned__(SIMD_VECTOR_SIZE)))
-      union { v4sf v[4]; float f[16]; } histo;
-    histo.v[0]=histo.v[1]=histo.v[2]=histo.v[3]=v4sf(all_zeros());
-    for(int yi=0;yi<HISTO_CELL_SIZE;++yi)
+    float *histo=dstHisto;
+    int xi=0;
+    for(int xId=0;xId<vWidth;++xId)
       {
-      const v16qu m=load_a(srcM1+xId), a=load_a(srcA1+xId);
+      const v16qu m=load_a(srcM0+xId), a=load_a(srcA0+xId);
       const v16qu binA=rshift<HISTO_BIN_WIDTH_SHIFT>(a);
       const v16qu da=(a&make_v16qu(HISTO_BIN_WIDTH_MASK))+
                      make_v16qu(HISTO_BIN_WIDTH>>1);
@@ -433,48 +449,37 @@ for(int yId=0;yId<height;yId+=HISTO_CELL_SIZE)
       const v16qu binB=(binA+select(low,make_v16qu(HISTO_BIN_COUNT_MASK),
                                         make_v16qu(1)))
                        &make_v16qu(HISTO_BIN_COUNT_MASK);
-      const v4sf div=make_v4sf(1.0f/float(HISTO_BIN_WIDTH_MASK));
-      const v4sf top=make_v4sf(float(HISTO_BIN_WIDTH+HISTO_BIN_WIDTH_MASK)/
-                               float(HISTO_BIN_WIDTH_MASK));
-      const v4sf x0=make_v4sf(make_v4si_0u(da))*div,
-                 m0=make_v4sf(make_v4si_0u(m)),
-                 hA0=m0*select(v16qu(make_v4si_0s(low)),x0,top-x0),
-                 hB0=m0-hA0;
-      const v4sf x1=make_v4sf(make_v4si_1u(da))*div,
-                 m1=make_v4sf(make_v4si_1u(m)),
-                 hA1=m1*select(v16qu(make_v4si_1s(low)),x1,top-x1),
-                 hB1=m1-hA1;
-      const v4sf x2=make_v4sf(make_v4si_2u(da))*div,
-                 m2=make_v4sf(make_v4si_2u(m)),
-                 hA2=m2*select(v16qu(make_v4si_2s(low)),x2,top-x2),
-                 hB2=m2-hA2;
-      const v4sf x3=make_v4sf(make_v4si_3u(da))*div,
-                 m3=make_v4sf(make_v4si_3u(m)),
-                 hA3=m3*select(v16qu(make_v4si_3s(low)),x3,top-x3),
-                 hB3=m3-hA3;
-      for(int i=0;i<4;++i)
+      __attribute__((__aligned__(SIMD_VECTOR_SIZE)))
+        union { v4sf v[4]; float f[16]; } hA, hB;
+      const v4sf x0=make_v4sf(make_v4si_0u(da))/div,
+                 m0=make_v4sf(make_v4si_0u(m));
+      hA.v[0]=m0*select(v16qu(make_v4si_0s(low)),x0,top-x0);
+      hB.v[0]=m0-hA.v[0];
+      const v4sf x1=make_v4sf(make_v4si_1u(da))/div,
+                 m1=make_v4sf(make_v4si_1u(m));
+      hA.v[1]=m1*select(v16qu(make_v4si_1s(low)),x1,top-x1);
+      hB.v[1]=m1-hA.v[1];
+      const v4sf x2=make_v4sf(make_v4si_2u(da))/div,
+                 m2=make_v4sf(make_v4si_2u(m));
+      hA.v[2]=m2*select(v16qu(make_v4si_2s(low)),x2,top-x2);
+      hB.v[2]=m2-hA.v[2];
+      const v4sf x3=make_v4sf(make_v4si_3u(da))/div,
+                 m3=make_v4sf(make_v4si_3u(m));
+      hA.v[3]=m3*select(v16qu(make_v4si_3s(low)),x3,top-x3);
+      hB.v[3]=m3-hA.v[3];
+      for(int i=0;i<16;++i)
         {
         // this ugly serial loop is inherent to the histogram problem!
-        histo.f[0+vec_at(binA, 0+i)]+=vec_at(hA0,i);
-        histo.f[0+vec_at(binB, 0+i)]+=vec_at(hB0,i);
-        histo.f[0+vec_at(binA, 4+i)]+=vec_at(hA1,i);
-        histo.f[0+vec_at(binB, 4+i)]+=vec_at(hB1,i);
-        histo.f[8+vec_at(binA, 8+i)]+=vec_at(hA2,i);
-        histo.f[8+vec_at(binB, 8+i)]+=vec_at(hB2,i);
-        histo.f[8+vec_at(binA,12+i)]+=vec_at(hA3,i);
-        histo.f[8+vec_at(binB,12+i)]+=vec_at(hB3,i);
+        histo[vec_at(binA,i)]+=hA.f[i];
+        histo[vec_at(binB,i)]+=hB.f[i];
+        if(++xi==cell_size)
+          { xi=0; histo+=HISTO_BIN_COUNT; }
         }
-      srcM1+=vWidth;
-      srcA1+=vWidth;
       }
-    store_a(dstHisto+0,load_a(histo.v+0));
-    store_a(dstHisto+1,load_a(histo.v+1));
-    store_a(dstHisto+2,load_a(histo.v+2));
-    store_a(dstHisto+3,load_a(histo.v+3));
-    dstHisto+=4;
+    srcM0+=vWidth;
+    srcA0+=vWidth;
     }
-  srcM0+=vWidth*HISTO_CELL_SIZE;
-  srcA0+=vWidth*HISTO_CELL_SIZE;
+  dstHisto+=rowValueCount;
   }
 }
 
@@ -583,6 +588,29 @@ for(int yId=0;yId<extract_height;++yId)
   }
 }
 
+inline
+void
+accum_histo_cell(float *dst,
+                 const float *src,
+                 float weightA,
+                 float weightB)
+{
+// HISTO_BIN_COUNT (18) is not a multiple of the vector size, so a cell
+// neither starts on a vector boundary nor fills whole vectors: the first
+// bins go through unaligned vectors and the last ones through scalars.
+const int vSize=int(sizeof(v4sf)/sizeof(float));
+const int vBinEnd=HISTO_BIN_COUNT-HISTO_BIN_COUNT%vSize;
+const v4sf vWeightA=make_v4sf(weightA), vWeightB=make_v4sf(weightB);
+for(int hId=0;hId<vBinEnd;hId+=vSize)
+  {
+  accum_u((v4sf *)(dst+hId),load_u((const v4sf *)(src+hId))*vWeightA*vWeightB);
+  }
+for(int hId=vBinEnd;hId<HISTO_BIN_COUNT;++hId)
+  {
+  dst[hId]+=src[hId]*weightA*weightB;
+  }
+}
+
 void
 simd_extract_histo(float *histo_out_aligned,
                    const float *histo_in_aligned,
@@ -600,19 +628,18 @@ assert(extract_width>=target_width);
 assert(extract_height>=target_height);
 assert(extract_x+extract_width<=full_width);
 assert(extract_y+extract_height<=full_height);
-enterSimd();
-ALIGNED_PTR( v4sf, dstHisto, histo_out_aligned );
-ALIGNED_PTR( const v4sf, srcHisto, histo_in_aligned );
+const SimdRounding simdRounding;
+ALIGNED_PTR( float, dstHisto, histo_out_aligned );
+ALIGNED_PTR( const float, srcHisto, histo_in_aligned );
 const float scaleX=float(target_width)/float(extract_width),
             invScaleX=float(extract_width)/float(target_width);
 const float scaleY=float(target_height)/float(extract_height),
             invScaleY=float(extract_height)/float(target_height);
-const int vBinCount=HISTO_BIN_COUNT/(sizeof(v4sf)/sizeof(float));
 std::memset(dstHisto,0,target_width*target_height*
-                       vBinCount*sizeof(v4sf));
+                       HISTO_BIN_COUNT*sizeof(float));
 for(int yId=0;yId<extract_height;++yId)
   {
-  int srcId=((extract_y+yId)*full_width+extract_x)*vBinCount;
+  int srcId=((extract_y+yId)*full_width+extract_x)*HISTO_BIN_COUNT;
   const float yA=float(yId)*scaleY, yB=yA+scaleY;
   const int tyA=int(yA), tyB=tyA+1;
   float remainingY=yB-float(tyB);
@@ -620,42 +647,30 @@ for(int yId=0;yId<extract_height;++yId)
     {
     remainingY*=invScaleY;
     const float complementY=1.0f-remainingY;
-    const v4sf vRemainingY=make_v4sf(remainingY);
-    const v4sf vComplementY=make_v4sf(complementY);
     for(int xId=0;xId<extract_width;++xId)
       {
       const float xA=float(xId)*scaleX, xB=xA+scaleX;
       const int txA=int(xA), txB=txA+1;
-      const int dstIdAA=(tyA*target_width+txA)*vBinCount;
-      const int dstIdBA=(tyB*target_width+txA)*vBinCount;
+      const int dstIdAA=(tyA*target_width+txA)*HISTO_BIN_COUNT;
+      const int dstIdBA=(tyB*target_width+txA)*HISTO_BIN_COUNT;
       float remainingX=xB-float(txB);
       if((remainingX>0.0f)&&(txB<target_width))
         {
         remainingX*=invScaleX;
         const float complementX=1.0f-remainingX;
-        const v4sf vRemainingX=make_v4sf(remainingX);
-        const v4sf vComplementX=make_v4sf(complementX);
-        const int dstIdAB=(tyA*target_width+txB)*vBinCount;
-        const int dstIdBB=(tyB*target_width+txB)*vBinCount;
-        for(int hId=0;hId<vBinCount;++hId)
-          {
-          const v4sf value=load_a(srcHisto+srcId+hId);
-          accum_a(dstHisto+dstIdAA+hId,value*vComplementY*vComplementX);
-          accum_a(dstHisto+dstIdBA+hId,value*vRemainingY*vComplementX);
-          accum_a(dstHisto+dstIdAB+hId,value*vComplementY*vRemainingX);
-          accum_a(dstHisto+dstIdBB+hId,value*vRemainingY*vRemainingX);
-          }
+        const int dstIdAB=(tyA*target_width+txB)*HISTO_BIN_COUNT;
+        const int dstIdBB=(tyB*target_width+txB)*HISTO_BIN_COUNT;
+        accum_histo_cell(dstHisto+dstIdAA,srcHisto+srcId,complementY,complementX);
+        accum_histo_cell(dstHisto+dstIdBA,srcHisto+srcId,remainingY,complementX);
+        accum_histo_cell(dstHisto+dstIdAB,srcHisto+srcId,complementY,remainingX);
+        accum_histo_cell(dstHisto+dstIdBB,srcHisto+srcId,remainingY,remainingX);
         }
       else
         {
-        for(int hId=0;hId<vBinCount;++hId)
-          {
-          const v4sf value=load_a(srcHisto+srcId+hId);
-          accum_a(dstHisto+dstIdAA+hId,value*vComplementY);
-          accum_a(dstHisto+dstIdBA+hId,value*vRemainingY);
-          }
+        accum_histo_cell(dstHisto+dstIdAA,srcHisto+srcId,complementY,1.0f);
+        accum_histo_cell(dstHisto+dstIdBA,srcHisto+srcId,remainingY,1.0f);
         }
-      srcId+=vBinCount;
+      srcId+=HISTO_BIN_COUNT;
       }
     }
   else
@@ -664,31 +679,21 @@ for(int yId=0;yId<extract_height;++yId)
       {
       const float xA=float(xId)*scaleX, xB=xA+scaleX;
       const int txA=int(xA), txB=txA+1;
-      const int dstIdAA=(tyA*target_width+txA)*vBinCount;
+      const int dstIdAA=(tyA*target_width+txA)*HISTO_BIN_COUNT;
       float remainingX=xB-float(txB);
       if((remainingX>0.0f)&&(txB<target_width))
         {
         remainingX*=invScaleX;
         const float complementX=1.0f-remainingX;
-        const v4sf vRemainingX=make_v4sf(remainingX);
-        const v4sf vComplementX=make_v4sf(complementX);
-        const int dstIdAB=(tyA*target_width+txB)*vBinCount;
-        for(int hId=0;hId<vBinCount;++hId)
-          {
-          const v4sf value=load_a(srcHisto+srcId+hId);
-          accum_a(dstHisto+dstIdAA+hId,value*vComplementX);
-          accum_a(dstHisto+dstIdAB+hId,value*vRemainingX);
-          }
+        const int dstIdAB=(tyA*target_width+txB)*HISTO_BIN_COUNT;
+        accum_histo_cell(dstHisto+dstIdAA,srcHisto+srcId,complementX,1.0f);
+        accum_histo_cell(dstHisto+dstIdAB,srcHisto+srcId,remainingX,1.0f);
         }
       else
         {
-        for(int hId=0;hId<vBinCount;++hId)
-          {
-          const v4sf value=load_a(srcHisto+srcId+hId);
-          accum_a(dstHisto+dstIdAA+hId,value);
-          }
+        accum_histo_cell(dstHisto+dstIdAA,srcHisto+srcId,1.0f,1.0f);
         }
-      srcId+=vBinCount;
+      srcId+=HISTO_BIN_COUNT;
       }
     }
   }
@@ -753,7 +758,7 @@ simd_equalise_histo(float *histo_out_aligned,
 {
 assert(block<=width);
 assert(block<=height);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v4sf, dstHisto, histo_out_aligned );
 ALIGNED_PTR( const v4sf, srcHisto, histo_in_aligned );
 const int vBinCount=HISTO_BIN_COUNT/(sizeof(v4sf)/sizeof(float));
@@ -1066,7 +1071,7 @@ assert(y+height<=full_height);
 assert(x%SIMD_VECTOR_SIZE==0);
 assert(width%SIMD_VECTOR_SIZE==0);
 assert(full_width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( const v16qu, srcY, y_in_aligned );
 ALIGNED_PTR( const v16qu, srcU, u_in_aligned );
 ALIGNED_PTR( const v16qu, srcV, v_in_aligned );
@@ -1200,7 +1205,7 @@ assert(y+height<=full_height);
 assert(x%SIMD_VECTOR_SIZE==0);
 assert(width%SIMD_VECTOR_SIZE==0);
 assert(full_width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstH, h_out_aligned );
 ALIGNED_PTR( v16qu, dstS, s_out_aligned );
 ALIGNED_PTR( v16qu, dstV, v_out_aligned );
@@ -1315,7 +1320,7 @@ simd_V4L_to_YHSV(uint8_t *y_out_aligned,
                  int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstY, y_out_aligned );
 ALIGNED_PTR( v16qu, dstH, h_out_aligned );
 ALIGNED_PTR( v16qu, dstS, s_out_aligned );
@@ -1475,7 +1480,7 @@ simd_V4L_to_YRGB(uint8_t *y_out_aligned,
                  int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstY, y_out_aligned );
 ALIGNED_PTR( v16qu, dstR, r_out_aligned );
 ALIGNED_PTR( v16qu, dstG, g_out_aligned );
@@ -1596,7 +1601,7 @@ simd_YUV_to_RGB(uint8_t *r_out_aligned,
                 int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstR, r_out_aligned );
 ALIGNED_PTR( v16qu, dstG, g_out_aligned );
 ALIGNED_PTR( v16qu, dstB, b_out_aligned );
@@ -1663,7 +1668,7 @@ simd_RGB_to_HSV(uint8_t *h_out_aligned,
                 int height)
 {
 assert(width%SIMD_VECTOR_SIZE==0);
-enterSimd();
+const SimdRounding simdRounding;
 ALIGNED_PTR( v16qu, dstH, h_out_aligned );
 ALIGNED_PTR( v16qu, dstS, s_out_aligned );
 ALIGNED_PTR( v16qu, dstV, v_out_aligned );
@@ -0,0 +1,167 @@
+#ifndef ROBOT_DATASET_H
+#define ROBOT_DATASET_H
+
+#include <dlib/image_transforms.h>
+#include <dlib/data_io.h>
+#include <dlib/misc_api.h>
+#include <dlib/md5.h>
+#include <dlib/threads.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// ----------------------------------------------------------------------------------------
+
+namespace dlib {
+template <
+    typename pyramid_type,
+    typename image_array_type
+    >
+void upsample_image_dataset_if_small (
+    image_array_type& images,
+    std::vector<std::vector<rectangle> >& objects,
+    unsigned long num_threads = 1
+)
+{
+    // make sure requires clause is not broken
+    DLIB_ASSERT( images.size() == objects.size(),
+        "\t void upsample_image_dataset()"
+        << "\n\t Invalid inputs were given to this function."
+        << "\n\t images.size():   " << images.size()
+        << "\n\t objects.size():  " << objects.size()
+        );
+
+    auto upsample = [&](long i)
+    {
+        if (images[i].nc() == 320 && images[i].nr() == 240)
+        {
+            typename image_array_type::value_type temp;
+            pyramid_type pyr;
+            pyramid_up(images[i], temp, pyr);
+            swap(temp, images[i]);
+            for (unsigned long j = 0; j < objects[i].size(); ++j)
+            {
+                objects[i][j] = pyr.rect_up(objects[i][j]);
+            }
+        }
+    };
+    if (num_threads > 1)
+        parallel_for(num_threads, 0, images.size(), upsample);
+    else
+        for (unsigned long i = 0; i < images.size(); ++i)
+            upsample(i);
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <
+    typename array_type
+    >
+void load_robot_dataset (
+    array_type& images,
+    std::vector<std::vector<rectangle> >& object_locations,
+    const std::string& filename,
+    const std::string& cache_filename = "",
+    unsigned long num_threads = 1,
+    bool upsample_small = true
+)
+{
+    // Loads the dataset the way all the robot programs use it: the images listed in
+    // filename, with the 320x240 ones upsampled by upsample_image_dataset_if_small().
+    // With upsample_small == false they are left as they are, for detectors whose
+    // scanner upsamples them virtually (see scan_fhog_pyramid::set_virtual_upsampling()).
+    // With a cache_filename the result is stored there as an image dataset cache the
+    // first time, and later calls read that instead of decoding again.  The cache is
+    // keyed on the contents of the metadata file, so editing the labels invalidates it
+    // (replacing an image file without touching the metadata does not).
+    std::string key;
+    if (cache_filename.size() != 0)
+    {
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        key = std::string("robot dataset, ") + (upsample_small ? "upsample_image_dataset_if_small<pyramid_down<2> >, " : "") + md5(fin);
+
+        std::vector<std::vector<rectangle> > ignore;
+        if (load_image_dataset_cache(images, object_locations, ignore, cache_filename, key))
+            return;
+    }
+
+    load_image_dataset(images, object_locations, image_dataset_file(filename).use_threads(num_threads));
+    if (upsample_small)
+        upsample_image_dataset_if_small<pyramid_down<2> >(images, object_locations, num_threads);
+
+    if (cache_filename.size() != 0)
+    {
+        // The robot programs don't use ignore boxes, so none are stored.
+        try
+        {
+            save_image_dataset_cache(images, object_locations, 
+                std::vector<std::vector<rectangle> >(images.size()), cache_filename, key);
+        }
+        catch (serialization_error& e)
+        {
+            // The cache only saves time.  Not being able to write it isn't an error.
+            std::cerr << "Not caching the dataset: " << e.what() << std::endl;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <
+    typename array_type
+    >
+std::vector<std::vector<rectangle> > load_image_dataset_shard (
+    array_type& images,
+    std::vector<std::vector<rectangle> >& object_locations,
+    const std::string& filename,
+    unsigned long shard,
+    unsigned long num_shards
+)
+{
+    // Like load_image_dataset(images, object_locations, filename) but only loads the
+    // images i of the dataset with i%num_shards == shard.  So processes that each train
+    // on one shard never hold the whole image set.
+    DLIB_ASSERT( shard < num_shards,
+        "\t void load_image_dataset_shard()"
+        << "\n\t Invalid inputs were given to this function."
+        << "\n\t shard:      " << shard
+        << "\n\t num_shards: " << num_shards
+        );
+
+    images.clear();
+    object_locations.clear();
+    std::vector<std::vector<rectangle> > ignored_rects;
+
+    image_dataset_metadata::dataset data;
+    image_dataset_metadata::load_image_dataset_metadata(data, filename);
+
+    // The file names in the metadata are relative to its folder.
+    locally_change_current_dir chdir(get_parent_directory(file(filename)));
+
+    typename array_type::value_type img;
+    std::vector<rectangle> rects, ignored;
+    for (unsigned long i = shard; i < data.images.size(); i += num_shards)
+    {
+        rects.clear();
+        ignored.clear();
+        for (unsigned long j = 0; j < data.images[i].boxes.size(); ++j)
+        {
+            if (data.images[i].boxes[j].ignore)
+                ignored.push_back(data.images[i].boxes[j].rect);
+            else
+                rects.push_back(data.images[i].boxes[j].rect);
+        }
+
+        load_image(img, data.images[i].filename);
+        images.push_back(img);
+        object_locations.push_back(rects);
+        ignored_rects.push_back(ignored);
+    }
+
+    return ignored_rects;
+}
+}
+
+// ----------------------------------------------------------------------------------------
+
+#endif // ROBOT_DATASET_H
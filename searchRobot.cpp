@@ -0,0 +1,300 @@
+#define DLIB_PNG_SUPPORT
+#define DLIB_JPEG_SUPPORT
+
+#include <dlib/svm_threaded.h>
+#include <dlib/image_processing.h>
+#include <dlib/data_io.h>
+#include <dlib/threads.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <thread>
+
+#include "robotDataset.h"
+
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+// Hyperparameter search over the settings learnRobot used to be tuned by hand.  Every
+// window size gets one set of loaded scanners, feature pyramids of the training images
+// and their mirror images, which all the trainers for that window size read from
+// concurrently.  So feature extraction and feature memory are paid once per window size
+// instead of once per config (and per cross-validation fold).
+
+typedef scan_fhog_pyramid<pyramid_down<5> > image_scanner_type;
+
+struct search_config
+{
+    long window_width;
+    long window_height;
+    double c;
+    double epsilon;
+    double match_eps;
+};
+
+struct search_result
+{
+    search_result() : cv(zeros_matrix<double>(1,3)), test(zeros_matrix<double>(1,3)), train_seconds(0), detect_ms(0) {}
+
+    matrix<double,1,3> cv;
+    matrix<double,1,3> test;
+    double train_seconds;
+    double detect_ms;
+    std::string error;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class shared_scanner_trainer
+{
+    /*!
+        Presents a trainer that trains on the shared, already loaded scanners as a
+        regular trainer so it can be handed to cross_validate_object_detection_trainer().
+        The folds it gets are subsets of the full training array, so the elements of the
+        images it's given are the images of the full array and their addresses identify
+        the scanners they were loaded into.
+    !*/
+public:
+    typedef object_detector<image_scanner_type> trained_function_type;
+
+    shared_scanner_trainer (
+        const structural_object_detection_trainer<image_scanner_type>& trainer_,
+        const std::map<const void*,unsigned long>& image_index_,
+        const std::vector<const image_scanner_type*>& loaded_scanners_
+    ) : trainer(trainer_), image_index(image_index_), loaded_scanners(loaded_scanners_) {}
+
+    template <typename image_array_type>
+    const trained_function_type train (
+        const image_array_type& images,
+        const std::vector<std::vector<full_object_detection> >& truth,
+        const std::vector<std::vector<rectangle> >& ignore,
+        const test_box_overlap& ignore_overlap_tester
+    ) const
+    {
+        const unsigned long num_images = loaded_scanners.size()/2;
+        std::vector<const image_scanner_type*> subset(2*images.size());
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            const unsigned long idx = image_index.find(&images[i])->second;
+            subset[i] = loaded_scanners[idx];
+            subset[images.size()+i] = loaded_scanners[num_images+idx];
+        }
+        return trainer.train(images, truth, ignore, ignore_overlap_tester, subset);
+    }
+
+private:
+    const structural_object_detection_trainer<image_scanner_type>& trainer;
+    const std::map<const void*,unsigned long>& image_index;
+    const std::vector<const image_scanner_type*>& loaded_scanners;
+};
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+
+    try
+    {
+        if (argc != 3 && argc != 4)
+        {
+            cout << "Please use :   ./prog dir_training dir_testing [num_folds]" << endl;
+            cout << endl;
+            cout << "With num_folds > 1 every config is also cross-validated on the training set." << endl;
+            return 0;
+        }
+        const std::string robots_directory_training = argv[1];
+        const std::string robots_directory_testing = argv[2];
+        const long num_folds = argc == 4 ? atol(argv[3]) : 0;
+
+        dlib::array<array2d<unsigned char> > images_train, images_test;
+        std::vector<std::vector<rectangle> > robot_boxes_train, robot_boxes_test;
+
+        // **************** Load the data. ********************
+        // Decoded on all cores the first time, then mapped in from the caches learnRobot
+        // uses too.
+        const unsigned long num_load_threads = std::max(1u, std::thread::hardware_concurrency());
+        load_robot_dataset(images_train, robot_boxes_train, robots_directory_training+"/training.xml",
+            "robot_training.cache", num_load_threads);
+        load_robot_dataset(images_test, robot_boxes_test, robots_directory_testing+"/testing.xml",
+            "robot_testing.cache", num_load_threads);
+
+        // The mirror images are added by the trainers, from the shared scanners.
+        cout << "num training images: " << images_train.size() << " (x2 with flips)" << endl;
+        cout << "num testing images:  " << images_test.size() << endl;
+
+        std::vector<std::vector<full_object_detection> > truth_train(robot_boxes_train.size());
+        for (unsigned long i = 0; i < robot_boxes_train.size(); ++i)
+            for (unsigned long j = 0; j < robot_boxes_train[i].size(); ++j)
+                truth_train[i].push_back(full_object_detection(robot_boxes_train[i][j]));
+        const std::vector<std::vector<rectangle> > no_ignore(images_train.size());
+
+        std::map<const void*,unsigned long> image_index;
+        for (unsigned long i = 0; i < images_train.size(); ++i)
+            image_index[&images_train[i]] = i;
+
+
+        // **************** The search space. ********************
+        // Centered on the best configs found by the grid and random searches recorded in
+        // learnRobot.cpp.
+        std::vector<std::pair<long,long> > window_sizes;
+        window_sizes.push_back(std::make_pair(40,60));
+        window_sizes.push_back(std::make_pair(48,72));
+        const double cs[] = {16, 30, 64};
+        const double epsilons[] = {0.015625, 0.058};
+        const double match_epss[] = {0.00738, 0.0625};
+
+        // Configs train concurrently and each trainer gets a share of the remaining
+        // cores for its separation oracle.  Running whole configs side by side scales
+        // better than the oracle threads do, so configs get the cores first.
+        const unsigned long num_cores = std::max(1u, std::thread::hardware_concurrency());
+
+        std::vector<search_config> configs;
+        std::vector<search_result> results;
+
+        for (unsigned long w = 0; w < window_sizes.size(); ++w)
+        {
+            image_scanner_type scanner;
+            scanner.set_detection_window_size(window_sizes[w].first, window_sizes[w].second);
+
+            std::vector<search_config> window_configs;
+            for (auto c : cs)
+            {
+                for (auto epsilon : epsilons)
+                {
+                    for (auto match_eps : match_epss)
+                    {
+                        search_config cfg = {window_sizes[w].first, window_sizes[w].second, c, epsilon, match_eps};
+                        window_configs.push_back(cfg);
+                    }
+                }
+            }
+
+            // **************** Load the shared scanners. ********************
+            auto load_t0 = std::chrono::high_resolution_clock::now();
+            const unsigned long num_images = images_train.size();
+            dlib::array<image_scanner_type> scanners;
+            scanners.set_max_size(2*num_images);
+            scanners.set_size(2*num_images);
+            for (unsigned long i = 0; i < scanners.size(); ++i)
+                scanners[i].copy_configuration(scanner);
+            parallel_for(num_cores, 0, num_images, [&](long i) {
+                scanners[i].load(images_train[i]);
+                load_left_right_flip(scanners[num_images+i], scanners[i], images_train[i]);
+            });
+            std::vector<const image_scanner_type*> loaded_scanners(scanners.size());
+            for (unsigned long i = 0; i < scanners.size(); ++i)
+                loaded_scanners[i] = &scanners[i];
+            auto load_t1 = std::chrono::high_resolution_clock::now();
+
+            const unsigned long config_threads = std::min<unsigned long>(num_cores, window_configs.size());
+            const unsigned long oracle_threads = std::max<unsigned long>(1, num_cores/config_threads);
+            cout << "window " << window_sizes[w].first << "x" << window_sizes[w].second
+                 << ": loaded in " << 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(load_t1-load_t0).count()
+                 << "s, training " << window_configs.size() << " configs, " << config_threads
+                 << " at a time with " << oracle_threads << " oracle threads each" << endl;
+
+            // **************** Train. ********************
+            std::vector<search_result> window_results(window_configs.size());
+            std::vector<object_detector<image_scanner_type> > detectors(window_configs.size());
+            parallel_for(config_threads, 0, window_configs.size(), [&](long k) {
+                const search_config& cfg = window_configs[k];
+                search_result& res = window_results[k];
+                try
+                {
+                    structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+                    trainer.set_num_threads(oracle_threads);
+                    trainer.set_c(cfg.c);
+                    trainer.set_epsilon(cfg.epsilon);
+                    trainer.set_match_eps(cfg.match_eps);
+                    trainer.set_add_left_right_flips(true);
+
+                    auto train_t0 = std::chrono::high_resolution_clock::now();
+                    if (num_folds > 1)
+                    {
+                        shared_scanner_trainer cv_trainer(trainer, image_index, loaded_scanners);
+                        res.cv = cross_validate_object_detection_trainer(cv_trainer, images_train, truth_train, no_ignore, num_folds);
+                    }
+                    detectors[k] = trainer.train(images_train, truth_train, no_ignore, test_box_overlap(), loaded_scanners);
+                    auto train_t1 = std::chrono::high_resolution_clock::now();
+                    res.train_seconds = 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(train_t1-train_t0).count();
+                }
+                catch (std::exception& e)
+                {
+                    res.error = e.what();
+                }
+            }, 1);
+
+            // **************** Test. ********************
+            // One detector at a time so the timings aren't disturbed by other work.
+            for (unsigned long k = 0; k < window_configs.size(); ++k)
+            {
+                search_result& res = window_results[k];
+                if (res.error.size() != 0)
+                    continue;
+                auto detect_t0 = std::chrono::high_resolution_clock::now();
+                res.test = test_object_detection_function(detectors[k], images_test, robot_boxes_test);
+                auto detect_t1 = std::chrono::high_resolution_clock::now();
+                res.detect_ms = 1.e-6*std::chrono::duration_cast<std::chrono::nanoseconds>(detect_t1-detect_t0).count()/images_test.size();
+            }
+
+            configs.insert(configs.end(), window_configs.begin(), window_configs.end());
+            results.insert(results.end(), window_results.begin(), window_results.end());
+        }
+
+
+        // **************** Report. ********************
+        cout << endl;
+        cout << "window   C          epsilon    match_eps  ";
+        if (num_folds > 1)
+            cout << "cv AP    ";
+        cout << "test P   test R   test AP  ms/image  train s" << endl;
+        unsigned long best = configs.size();
+        for (unsigned long k = 0; k < configs.size(); ++k)
+        {
+            const search_config& cfg = configs[k];
+            const search_result& res = results[k];
+            cout << setw(2) << cfg.window_width << "x" << setw(3) << left << cfg.window_height << right << "   "
+                 << left << setw(11) << cfg.c << setw(11) << cfg.epsilon << setw(11) << cfg.match_eps << right;
+            if (res.error.size() != 0)
+            {
+                cout << "failed: " << res.error.substr(0, res.error.find('.')) << endl;
+                continue;
+            }
+            cout << fixed << setprecision(4);
+            if (num_folds > 1)
+                cout << res.cv(2) << "   ";
+            cout << res.test(0) << "   " << res.test(1) << "   " << res.test(2) << "   "
+                 << setprecision(2) << setw(7) << res.detect_ms << "   " << setw(7) << res.train_seconds << endl;
+            cout.unsetf(ios_base::floatfield);
+            cout << setprecision(6);
+
+            // Pick by cross-validation when there is one, so the test set stays unseen.
+            if (best == configs.size() ||
+                (num_folds > 1 ? res.cv(2) > results[best].cv(2) : res.test(2) > results[best].test(2)))
+                best = k;
+        }
+
+        if (best != configs.size())
+        {
+            const search_config& cfg = configs[best];
+            cout << endl << "Best config tested (" << (num_folds > 1 ? "cv" : "test") << " AP = "
+                 << (num_folds > 1 ? results[best].cv(2) : results[best].test(2)) << "): hog_window_size =("
+                 << cfg.window_width << "," << cfg.window_height << "); Cost=" << cfg.c
+                 << "; epsilon=" << cfg.epsilon << "; eps=" << cfg.match_eps << endl;
+        }
+    }
+    catch (exception& e)
+    {
+        cout << "\nexception thrown!" << endl;
+        cout << e.what() << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+